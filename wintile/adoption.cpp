@@ -0,0 +1,126 @@
+#include "adoption.h"
+
+#include "watchdog.h"
+
+#include <algorithm>
+#include <cwchar>
+
+AdoptedWindow ClassifyWindow(WindowSystem* system, WindowId window, const AdoptionSettings& settings) {
+    AdoptedWindow result;
+    result.window = window;
+
+    // Same order as IsManageableWindow: the cheap style checks reject most of EnumWindows
+    if (!system->IsVisible(window)) return result;
+    unsigned long style = system->Style(window);
+    if (!(style & WINDOW_STYLE_CAPTION) && !(style & WINDOW_STYLE_POPUP)) return result;
+    if (system->ExStyle(window) & WINDOW_EXSTYLE_TOOLWINDOW) return result;
+    if (system->IsMinimized(window) || system->IsMaximized(window)) return result;
+
+    wchar_t className[256];
+    if (system->ClassName(window, className, sizeof(className) / sizeof(wchar_t))) {
+        for (const std::wstring& excluded : settings.excludedClasses) {
+            if (wcscmp(className, excluded.c_str()) == 0) return result;
+        }
+    }
+
+    Rect rect;
+    if (!system->WindowRect(window, &rect)) return result;
+    if (RectWidth(rect) < 100 || RectHeight(rect) < 50) return result;
+    if (system->IsCloaked(window)) return result;
+
+    MonitorId monitor = system->MonitorOfWindow(window);
+    const AdoptionMonitor* found = nullptr;
+    for (const AdoptionMonitor& candidate : settings.monitors) {
+        if (candidate.monitor == monitor) found = &candidate;
+    }
+    if (!found) return result;
+
+    // Fullscreen windows are not tiled
+    const Rect& bounds = found->info.monitor;
+    if (rect.left <= bounds.left && rect.top <= bounds.top && rect.right >= bounds.right && rect.bottom >= bounds.bottom) {
+        return result;
+    }
+
+    // The tiler places window rects; Windows Snap places the visible frame, which is smaller
+    // by the invisible resize borders
+    const Rect& work = found->info.work;
+    result.state = InferSnapState(rect, work, found->lines, settings.padding, settings.tolerance);
+    Rect frame;
+    if (result.state == WindowState::Unknown && system->FrameRect(window, &frame) && frame != rect) {
+        result.state = InferSnapState(frame, work, found->lines, settings.padding, settings.tolerance);
+    }
+    if (result.state != WindowState::Unknown) result.monitor = monitor;
+    return result;
+}
+
+void AdoptionScan::Start(WindowSystem* system, std::vector<WindowId> windows, AdoptionSettings settings, int workers,
+                         AdoptionNotify notify) {
+    Stop();
+    system_ = system;
+    windows_ = std::move(windows);
+    settings_ = std::move(settings);
+    notify_ = notify;
+    next_.store(0, std::memory_order_relaxed);
+    scanned_.store(0, std::memory_order_relaxed);
+    stopping_.store(false, std::memory_order_relaxed);
+    results_.clear();
+    taken_ = 0;
+
+    int count = static_cast<int>(std::min(static_cast<size_t>(std::max(workers, 1)), windows_.size()));
+    running_.store(count, std::memory_order_release);
+    for (int i = 0; i < count; ++i) {
+        workers_.emplace_back(&AdoptionScan::Work, this);
+    }
+}
+
+void AdoptionScan::Work() {
+    WatchdogIgnoreThread();
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+        if (i >= windows_.size()) break;
+
+        AdoptedWindow adopted = ClassifyWindow(system_, windows_[i], settings_);
+        scanned_.fetch_add(1, std::memory_order_relaxed);
+        if (adopted.state == WindowState::Unknown) continue;
+
+        bool first;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            first = taken_ == results_.size();
+            results_.push_back(adopted);
+        }
+        if (first && notify_) notify_();
+    }
+
+    // The last worker out tells the main thread it can finish up
+    if (running_.fetch_sub(1, std::memory_order_acq_rel) == 1 && notify_ && !stopping_.load(std::memory_order_relaxed)) {
+        notify_();
+    }
+}
+
+size_t AdoptionScan::Take(AdoptedWindow* out, size_t max) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = std::min(max, results_.size() - taken_);
+    std::copy(results_.begin() + taken_, results_.begin() + taken_ + count, out);
+    taken_ += count;
+    if (taken_ == results_.size()) {
+        results_.clear();
+        taken_ = 0;
+    }
+    return count;
+}
+
+void AdoptionScan::Stop() {
+    stopping_.store(true, std::memory_order_relaxed);
+    for (std::thread& worker : workers_) worker.join();
+    workers_.clear();
+    running_.store(0, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_.clear();
+    taken_ = 0;
+}
+
+bool AdoptionScan::Waiting() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return taken_ < results_.size();
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+// Startup adoption of the windows that were open before the tiler started. A window that sits
+// at one of its monitor's layout rects (snapped by an earlier run, or by hand) is tracked in
+// that state, so the first hotkey on it makes the right transition. The per-window OS queries
+// run on a few worker threads while the main thread already handles hotkeys; it takes the
+// classified windows in small batches between messages (AdoptScannedWindows in tiler.h).
+
+#include "layout.h"
+#include "window_system.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define ADOPTION_WORKERS 4
+#define ADOPTION_BATCH 64      // Windows adopted per main loop turn
+#define ADOPTION_TOLERANCE 10  // Pixels an edge may be off its layout rect (resize borders, rounding)
+
+// A monitor as the workers see it: its layout rects come from the work area and split lines
+struct AdoptionMonitor {
+    MonitorId monitor;
+    MonitorInfo info;
+    SplitLines lines;
+};
+
+// What the workers need from the tiler and the config, copied so they read neither
+struct AdoptionSettings {
+    std::vector<AdoptionMonitor> monitors;
+    std::vector<std::wstring> excludedClasses;
+    long padding = 0;
+    long tolerance = ADOPTION_TOLERANCE;
+};
+
+// A window found at a layout rect
+struct AdoptedWindow {
+    WindowId window = 0;
+    MonitorId monitor = 0;
+    WindowState state = WindowState::Unknown;
+};
+
+// The checks of the tiler's IsManageableWindow, then the layout rect the window sits at; state
+// Unknown if it is not a tiling candidate or sits at none. Windows maximized by the OS are left
+// to it. Only makes the window system's read-only queries, so it runs on any thread.
+AdoptedWindow ClassifyWindow(WindowSystem* system, WindowId window, const AdoptionSettings& settings);
+
+// Notification from a worker: results are waiting or the scan has finished
+typedef void (*AdoptionNotify)();
+
+class AdoptionScan {
+public:
+    ~AdoptionScan() { Stop(); }
+
+    // Classify `windows` on `workers` threads. `notify` (may be null) is called when the first
+    // result after a Take is waiting and when the last worker is done.
+    void Start(WindowSystem* system, std::vector<WindowId> windows, AdoptionSettings settings, int workers,
+               AdoptionNotify notify);
+
+    // Move up to `max` classified windows to `out`, in the order they were found
+    size_t Take(AdoptedWindow* out, size_t max);
+
+    // Cancel and join the workers; results not taken yet are dropped
+    void Stop();
+
+    // Workers still classifying / results not taken yet. Check Running first: once it is
+    // false, Waiting sees every result.
+    bool Running() const { return running_.load(std::memory_order_acquire) > 0; }
+    bool Waiting();
+
+    size_t Scanned() const { return scanned_.load(std::memory_order_relaxed); }
+
+private:
+    void Work();
+
+    WindowSystem* system_ = nullptr;
+    std::vector<WindowId> windows_;
+    AdoptionSettings settings_;
+    AdoptionNotify notify_ = nullptr;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_{ 0 };     // Next window to classify
+    std::atomic<size_t> scanned_{ 0 };
+    std::atomic<int> running_{ 0 };     // Workers not done yet
+    std::atomic<bool> stopping_{ false };
+
+    std::mutex mutex_;                  // Guards results_
+    std::vector<AdoptedWindow> results_;
+    size_t taken_ = 0;                  // results_ before this index were taken
+};
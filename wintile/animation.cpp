@@ -0,0 +1,225 @@
+#include "animation.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+double EaseOutCubic(double t) {
+    double r = 1.0 - t;
+    return 1.0 - r * r * r;
+}
+
+static long LerpEdge(long from, long to, double t) {
+    return from + std::lround((to - from) * t);
+}
+
+Rect LerpRect(const Rect& from, const Rect& to, double t) {
+    return {
+        LerpEdge(from.left, to.left, t),
+        LerpEdge(from.top, to.top, t),
+        LerpEdge(from.right, to.right, t),
+        LerpEdge(from.bottom, to.bottom, t),
+    };
+}
+
+// Finished coroutine frames, linked through their first bytes. Every animation runs the same
+// coroutine, so they all have one size; the first request fixes it.
+static void* freeFrames = nullptr;
+static size_t frameSize = 0;
+
+void* AnimationTask::promise_type::operator new(size_t size) {
+    if (size == frameSize && freeFrames) {
+        void* frame = freeFrames;
+        freeFrames = *static_cast<void**>(frame);
+        return frame;
+    }
+    if (!frameSize) frameSize = size;
+    return ::operator new(size);
+}
+
+void AnimationTask::promise_type::operator delete(void* frame, size_t size) {
+    if (size != frameSize) {
+        ::operator delete(frame);
+        return;
+    }
+    *static_cast<void**>(frame) = freeFrames;
+    freeFrames = frame;
+}
+
+void AnimationTask::promise_type::unhandled_exception() {
+    std::abort();  // Nothing in an animation throws
+}
+
+AnimationTask& AnimationTask::operator=(AnimationTask&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        handle_ = other.handle_;
+        other.handle_ = nullptr;
+    }
+    return *this;
+}
+
+bool AnimationTask::Resume() {
+    if (!handle_ || handle_.done()) return false;
+    handle_.resume();
+    return !handle_.done();
+}
+
+void AnimationTask::Reset() {
+    if (handle_) handle_.destroy();
+    handle_ = nullptr;
+}
+
+Animator::Animator() : animations_(ANIMATION_MAX_ACTIVE) {
+    batch_.reserve(ANIMATION_MAX_ACTIVE);
+    arrivals_.reserve(ANIMATION_MAX_ACTIVE);
+}
+
+void Animator::Init(WindowSystem* system, long long frameNs, AnimationWake wake) {
+    system_ = system;
+    frameNs_ = frameNs > 0 ? frameNs : ANIMATION_DEFAULT_FRAME_NS;
+    wake_ = wake;
+}
+
+void Animator::SetDoneCallback(AnimationDone done, void* context) {
+    done_ = done;
+    doneContext_ = context;
+}
+
+// One animation: wait for a frame, move by the time it took, repeat until the target is reached
+AnimationTask Animator::Interpolate(Animator* animator, Rect from, Rect to, long long durationNs) {
+    double progress = 0.0;
+    while (progress < 1.0) {
+        FrameTime frame = co_await animator->NextFrame();
+        progress += frame.deltaNs / (durationNs * frame.budgetScale);
+        animator->Emit(LerpRect(from, to, EaseOutCubic(progress < 1.0 ? progress : 1.0)));
+    }
+}
+
+const Animator::Animation* Animator::Find(WindowId window) const {
+    for (size_t i = 0; i < count_; ++i) {
+        if (animations_[i].window == window) return &animations_[i];
+    }
+    return nullptr;
+}
+
+// Swap the last animation into `index`
+void Animator::Remove(size_t index) {
+    animations_[index].task.Reset();
+    if (index != count_ - 1) animations_[index] = std::move(animations_[count_ - 1]);
+    count_ -= 1;
+}
+
+bool Animator::Animate(WindowId window, const Rect& from, const Rect& to, long long durationNs) {
+    Cancel(window);
+    if (from == to || durationNs <= 0 || count_ == animations_.size()) return false;
+
+    if (count_ == 0) {
+        // A new run: its first frame counts as on time
+        lastFrameNs_ = -1;
+        if (wake_) wake_();
+    }
+    Animation& animation = animations_[count_++];
+    animation.window = window;
+    animation.current = from;
+    animation.target = to;
+    animation.task = Interpolate(this, from, to, durationNs);  // Runs to its first NextFrame
+    stats_.started += 1;
+    return true;
+}
+
+void Animator::Cancel(WindowId window) {
+    for (size_t i = 0; i < count_; ++i) {
+        if (animations_[i].window == window) {
+            Remove(i);
+            stats_.cancelled += 1;
+            return;
+        }
+    }
+}
+
+void Animator::Finish() {
+    batch_.clear();
+    for (size_t i = 0; i < count_; ++i) {
+        Placement placement;
+        placement.window = animations_[i].window;
+        placement.rect = animations_[i].target;
+        batch_.push_back(placement);
+        animations_[i].task.Reset();
+    }
+    stats_.cancelled += static_cast<long long>(count_);
+    count_ = 0;
+    Place();
+}
+
+bool Animator::Position(WindowId window, Rect* rect) const {
+    const Animation* animation = Find(window);
+    if (animation) *rect = animation->current;
+    return animation != nullptr;
+}
+
+bool Animator::Target(WindowId window, Rect* rect) const {
+    const Animation* animation = Find(window);
+    if (animation) *rect = animation->target;
+    return animation != nullptr;
+}
+
+void Animator::Emit(const Rect& rect) {
+    resuming_->current = rect;
+    Placement placement;
+    placement.window = resuming_->window;
+    placement.rect = rect;
+    batch_.push_back(placement);
+}
+
+// One transaction for the frame, individual moves if it is dropped (as ApplyPlacements does)
+void Animator::Place() {
+    if (batch_.empty() || !system_) return;
+    if (batch_.size() == 1) {
+        system_->Place(batch_[0]);
+        return;
+    }
+    if (system_->PlaceBatch(batch_.data(), batch_.size())) return;
+    for (const Placement& placement : batch_) system_->Place(placement);
+}
+
+bool Animator::Frame(long long nowNs) {
+    if (count_ == 0) return false;
+
+    // A frame over half an interval late halves the budget; on-time frames win it back slowly
+    long long deltaNs = lastFrameNs_ < 0 ? frameNs_ : nowNs - lastFrameNs_;
+    if (deltaNs < 0) deltaNs = 0;
+    lastFrameNs_ = nowNs;
+    if (deltaNs > frameNs_ + frameNs_ / 2) {
+        budgetScale_ = budgetScale_ / 2 > ANIMATION_MIN_BUDGET ? budgetScale_ / 2 : ANIMATION_MIN_BUDGET;
+        stats_.lateFrames += 1;
+    } else {
+        budgetScale_ += (1.0 - budgetScale_) / 16;
+    }
+    frame_.deltaNs = static_cast<double>(deltaNs);
+    frame_.budgetScale = budgetScale_;
+
+    batch_.clear();
+    arrivals_.clear();
+    for (size_t i = 0; i < count_;) {
+        resuming_ = &animations_[i];
+        if (resuming_->task.Resume()) {
+            ++i;
+            continue;
+        }
+        arrivals_.push_back({ resuming_->window, resuming_->target });
+        Remove(i);  // The last one moves here and is resumed next
+    }
+    resuming_ = nullptr;
+
+    Place();
+    stats_.frames += 1;
+    stats_.placements += static_cast<long long>(batch_.size());
+    stats_.completed += static_cast<long long>(arrivals_.size());
+
+    // After the batch: a callback may start or cancel animations
+    for (const Arrival& arrival : arrivals_) {
+        if (done_) done_(doneContext_, arrival.window, arrival.target);
+    }
+    return count_ > 0;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+// Snap and move animations. Each animation is a coroutine that suspends once per display frame
+// and interpolates its window from where it was to its target with an ease-out curve. Frame
+// resumes every animation in flight and places all of them in one PlaceBatch transaction.
+//
+// Time is whatever the caller passes to Frame, so the scheduler runs headless on a virtual
+// clock. Progress follows the frame time, not the frame count: a late frame moves further. If
+// frames keep coming late, the animator shortens every duration (down to 1/8), and it lengthens
+// them again while frames are on time. Main thread only; coroutine frames are recycled, so an
+// animation allocates nothing once the first ones have finished.
+
+#include "window_system.h"
+
+#include <coroutine>
+#include <vector>
+
+#define ANIMATION_MAX_ACTIVE 256            // Animations in flight; more are placed directly
+#define ANIMATION_DEFAULT_FRAME_NS 16666667  // 60 Hz
+#define ANIMATION_MIN_BUDGET 0.125          // Shortest duration scale under late frames
+
+// Ease-out cubic: fast start, gentle arrival. 0 at 0 and exactly 1 at 1.
+double EaseOutCubic(double t);
+
+// Rect at `t` (0..1) of the way from `from` to `to`, each edge rounded; exact at both ends
+Rect LerpRect(const Rect& from, const Rect& to, double t);
+
+// Called once the frame after an animation has placed its window at `target`; not for
+// cancelled animations
+typedef void (*AnimationDone)(void* context, WindowId window, const Rect& target);
+
+// Called when the first animation starts while none is in flight; Frame has to be called from
+// the next display frame on, for as long as it returns true
+typedef void (*AnimationWake)();
+
+struct AnimationStats {
+    long long started;
+    long long cancelled;  // Cancelled, replaced by a new animation of the window, or finished early
+    long long completed;
+    long long frames;
+    long long lateFrames;   // Frames that came more than half an interval late
+    long long placements;   // Window moves over all frames
+};
+
+// Owned coroutine handle of one animation
+class AnimationTask {
+public:
+    struct promise_type {
+        AnimationTask get_return_object() { return AnimationTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception();
+
+        // Frames come from a free list
+        static void* operator new(size_t size);
+        static void operator delete(void* frame, size_t size);
+    };
+
+    AnimationTask() = default;
+    AnimationTask(AnimationTask&& other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+    AnimationTask& operator=(AnimationTask&& other) noexcept;
+    ~AnimationTask() { Reset(); }
+
+    // Run to the next frame; false once the animation has finished
+    bool Resume();
+    void Reset();
+
+private:
+    explicit AnimationTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_ = nullptr;
+};
+
+class Animator {
+public:
+    Animator();
+    Animator(const Animator&) = delete;
+    Animator& operator=(const Animator&) = delete;
+
+    // Place through `system`; frames arrive every `frameNs`. `wake` may be null.
+    void Init(WindowSystem* system, long long frameNs, AnimationWake wake);
+    void SetDoneCallback(AnimationDone done, void* context);
+
+    // Move `window` from `from` to `to` over `durationNs`, replacing an animation it has in
+    // flight. False (and nothing started) if the rects are equal, the duration is not positive
+    // or ANIMATION_MAX_ACTIVE are in flight; the caller places the window itself then.
+    bool Animate(WindowId window, const Rect& from, const Rect& to, long long durationNs);
+
+    // Stop the window's animation where it is; no-op if it has none
+    void Cancel(WindowId window);
+
+    // Place every window at its target in one transaction and stop all animations, without
+    // done callbacks (shutdown)
+    void Finish();
+
+    // Advance every animation to `nowNs` and place them. True while animations are in flight.
+    bool Frame(long long nowNs);
+
+    bool Animating(WindowId window) const { return Find(window) != nullptr; }
+    // Where the window's animation placed it last and where it is going
+    bool Position(WindowId window, Rect* rect) const;
+    bool Target(WindowId window, Rect* rect) const;
+
+    size_t Active() const { return count_; }
+    double BudgetScale() const { return budgetScale_; }
+    const AnimationStats& Stats() const { return stats_; }
+
+private:
+    struct Animation {
+        WindowId window = 0;
+        Rect current = {};
+        Rect target = {};
+        AnimationTask task;
+    };
+
+    // What an animation sees of the frame it is resumed in
+    struct FrameTime {
+        double deltaNs;
+        double budgetScale;
+    };
+
+    // `co_await animator->NextFrame()`: suspend until the next Frame
+    struct NextFrameAwaiter {
+        Animator* animator;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) const noexcept {}
+        FrameTime await_resume() const noexcept { return animator->frame_; }
+    };
+    NextFrameAwaiter NextFrame() { return { this }; }
+
+    static AnimationTask Interpolate(Animator* animator, Rect from, Rect to, long long durationNs);
+
+    // The animation being resumed placed its window at `rect` this frame
+    void Emit(const Rect& rect);
+
+    const Animation* Find(WindowId window) const;
+    void Remove(size_t index);
+    void Place();
+
+    WindowSystem* system_ = nullptr;
+    long long frameNs_ = ANIMATION_DEFAULT_FRAME_NS;
+    AnimationWake wake_ = nullptr;
+    AnimationDone done_ = nullptr;
+    void* doneContext_ = nullptr;
+
+    std::vector<Animation> animations_;  // [0, count_) in flight; capacity fixed at construction
+    size_t count_ = 0;
+    Animation* resuming_ = nullptr;
+
+    FrameTime frame_ = {};
+    long long lastFrameNs_ = -1;  // -1 before the first frame of a run
+    double budgetScale_ = 1.0;
+
+    std::vector<Placement> batch_;  // The current frame's moves
+    struct Arrival {
+        WindowId window;
+        Rect target;
+    };
+    std::vector<Arrival> arrivals_;  // Finished this frame, reported after the batch
+    AnimationStats stats_ = {};
+};
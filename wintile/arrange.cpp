@@ -0,0 +1,126 @@
+#include "arrange.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Bounds of cell `index` when [start, end] is divided into `parts` cells separated by `gap`.
+// Rounding remainders are spread over the cells so they fill the span exactly.
+static void DivideSpan(long start, long end, size_t parts, long gap, size_t index, long* cellStart, long* cellEnd) {
+    long usable = (end - start) - static_cast<long>(parts - 1) * gap;
+    long n = static_cast<long>(parts);
+    long i = static_cast<long>(index);
+    *cellStart = start + usable * i / n + i * gap;
+    *cellEnd = start + usable * (i + 1) / n + i * gap;
+}
+
+void ComputeArrangeSlots(const Rect& work, ArrangeLayout layout, size_t count, long padding,
+                         float masterRatio, std::vector<Rect>* slots) {
+    slots->clear();
+    if (count == 0) return;
+    slots->reserve(count);
+
+    Rect outer = { work.left + padding, work.top + padding, work.right - padding, work.bottom - padding };
+    if (count == 1) {
+        slots->push_back(outer);
+        return;
+    }
+
+    if (layout == ArrangeLayout::MasterStack) {
+        // Same split line convention as the snap layout
+        long splitX = work.left + static_cast<long>(RectWidth(work) * masterRatio);
+        slots->push_back({ outer.left, outer.top, splitX - padding / 2, outer.bottom });
+
+        size_t stacked = count - 1;
+        for (size_t i = 0; i < stacked; ++i) {
+            Rect slot = { splitX + padding / 2, 0, outer.right, 0 };
+            DivideSpan(outer.top, outer.bottom, stacked, padding, i, &slot.top, &slot.bottom);
+            slots->push_back(slot);
+        }
+        return;
+    }
+
+    size_t columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    size_t rows = (count + columns - 1) / columns;
+    for (size_t row = 0; row < rows; ++row) {
+        size_t cells = (row == rows - 1) ? count - columns * (rows - 1) : columns;
+        for (size_t column = 0; column < cells; ++column) {
+            Rect slot;
+            DivideSpan(outer.top, outer.bottom, rows, padding, row, &slot.top, &slot.bottom);
+            DivideSpan(outer.left, outer.right, cells, padding, column, &slot.left, &slot.right);
+            slots->push_back(slot);
+        }
+    }
+}
+
+double CenterDistance(const Rect& a, const Rect& b) {
+    double dx = (a.left + a.right) * 0.5 - (b.left + b.right) * 0.5;
+    double dy = (a.top + a.bottom) * 0.5 - (b.top + b.bottom) * 0.5;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+void AssignSlots(const Rect* windows, const Rect* slots, size_t count, std::vector<size_t>* assignment) {
+    assignment->assign(count, 0);
+    if (count == 0) return;
+
+    size_t n = count;
+    std::vector<double> cost(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            cost[i * n + j] = CenterDistance(windows[i], slots[j]);
+        }
+    }
+
+    // Hungarian algorithm with row/column potentials; rows and columns are 1-based and
+    // column 0 is the virtual start of each augmenting path
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> u(n + 1, 0.0), v(n + 1, 0.0), minv(n + 1);
+    std::vector<size_t> p(n + 1, 0), way(n + 1, 0);
+    std::vector<char> used(n + 1);
+
+    for (size_t i = 1; i <= n; ++i) {
+        p[0] = i;
+        size_t j0 = 0;
+        std::fill(minv.begin(), minv.end(), inf);
+        std::fill(used.begin(), used.end(), 0);
+
+        do {
+            used[j0] = 1;
+            size_t i0 = p[j0];
+            size_t j1 = 0;
+            double delta = inf;
+            for (size_t j = 1; j <= n; ++j) {
+                if (used[j]) continue;
+                double reduced = cost[(i0 - 1) * n + (j - 1)] - u[i0] - v[j];
+                if (reduced < minv[j]) {
+                    minv[j] = reduced;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (size_t j = 0; j <= n; ++j) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+
+        // Flip the augmenting path
+        do {
+            size_t j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    for (size_t j = 1; j <= n; ++j) {
+        (*assignment)[p[j] - 1] = j - 1;
+    }
+}
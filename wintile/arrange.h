@@ -0,0 +1,23 @@
+#pragma once
+
+#include "geometry.h"
+
+#include <cstddef>
+#include <vector>
+
+enum class ArrangeLayout {
+    Grid,        // Near-square grid, the last row stretched to fill the width
+    MasterStack  // One master column, the rest stacked in the other column
+};
+
+// Tile the work area into `count` slots. For MasterStack, slot 0 is the master and
+// `masterRatio` is its share of the width.
+void ComputeArrangeSlots(const Rect& work, ArrangeLayout layout, size_t count, long padding,
+                         float masterRatio, std::vector<Rect>* slots);
+
+// Assign every window to a distinct slot so the summed distance between window and slot
+// centers is minimal (Hungarian algorithm, O(n^3)). `assignment[i]` is the slot of window i.
+void AssignSlots(const Rect* windows, const Rect* slots, size_t count, std::vector<size_t>* assignment);
+
+// Distance between the centers of two rects
+double CenterDistance(const Rect& a, const Rect& b);
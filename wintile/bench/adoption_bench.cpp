@@ -0,0 +1,241 @@
+// Startup adoption on a simulated two-monitor desktop with 1000 windows open: halves, quarters
+// and padded maximized windows (exact, a few pixels off, or with the invisible resize borders
+// around a snapped frame), plus minimized, tool, cloaked, OS-maximized, excluded, no_tile and
+// floating windows and near misses. 2% belong to busy apps whose every call takes 1 ms.
+//
+// A blocking scan on the main thread is timed as the baseline: no hotkey runs before it is
+// done. The worker scan is then timed from start-up to the first hotkey handled (one arrives
+// right after the scan starts), to the last window adopted, and per main-thread batch. Every
+// window's tracked state must be the expected one. Exits non-zero on any mismatch.
+
+#include "bench_util.h"
+#include "config.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+static const int WINDOWS = 1000;
+static const int RUNS = 5;
+static const long long SLOW_REPLY_NS = 1000000;  // 1 ms per call
+
+static const WindowState states[] = {
+    WindowState::LeftHalf, WindowState::RightHalf, WindowState::TopHalf, WindowState::BottomHalf,
+    WindowState::TopLeftQuarter, WindowState::TopRightQuarter, WindowState::BottomLeftQuarter,
+    WindowState::BottomRightQuarter, WindowState::Maximized,
+};
+
+static const char BENCH[] = "adoption_bench";
+
+// Worker notifications, standing in for the posted WM_APP_ADOPT_WINDOWS
+static std::mutex notifyMutex;
+static std::condition_variable notifyWake;
+static bool notified = false;
+
+static void Notify() {
+    std::lock_guard<std::mutex> lock(notifyMutex);
+    notified = true;
+    notifyWake.notify_one();
+}
+
+static void WaitForNotify() {
+    std::unique_lock<std::mutex> lock(notifyMutex);
+    notifyWake.wait_for(lock, std::chrono::milliseconds(1), [] { return notified; });
+    notified = false;
+}
+
+struct Desktop {
+    SimWindowSystem sim;
+    MonitorId monitors[2];
+    std::vector<WindowId> windows;
+    std::vector<WindowState> expected;
+    WindowId hotkeyTarget = 0;
+    long long adoptable = 0;
+
+    Desktop() {
+        monitors[0] = sim.AddMonitor({ 0, 0, 2560, 1440 });
+        monitors[1] = sim.AddMonitor({ 2560, 0, 5120, 1440 });
+        long padding = CurrentConfig().padding;
+        unsigned seed = 12345;
+        auto next = [&seed](unsigned range) {
+            seed = seed * 1103515245u + 12345u;
+            return static_cast<long>((seed >> 8) % range);
+        };
+
+        for (int i = 0; i < WINDOWS; ++i) {
+            MonitorId monitor = monitors[i % 2];
+            MonitorInfo info;
+            sim.QueryMonitor(monitor, &info);
+            WindowState state = states[(i / 2) % 9];
+            Rect rect;
+            ComputeSnapRect(info.work, state, SplitRatio(), padding, &rect);
+            WindowState want = state;
+            int kind = i % 20;
+
+            WindowId window = sim.AddWindow(rect);
+            SimWindow& w = sim.Window(window);
+            w.className = L"AppWindow";
+            if (kind < 8) {
+                if (i % 3 == 1) {
+                    // A few pixels off: rounding, a DPI change
+                    rect.left += next(7) - 3;
+                    rect.top += next(7) - 3;
+                    rect.right += next(7) - 3;
+                    rect.bottom += next(7) - 3;
+                } else if (i % 3 == 2) {
+                    // Snapped by Windows: the window rect has the invisible borders around the frame
+                    rect.left -= 7;
+                    rect.right += 7;
+                    rect.bottom += 7;
+                }
+                if (i % 50 == 7) w.replyNs = SLOW_REPLY_NS;
+            } else if (kind < 10) {
+                w.minimized = true;
+                want = WindowState::Unknown;
+            } else if (kind == 10) {
+                w.exStyle = WINDOW_EXSTYLE_TOOLWINDOW;
+                want = WindowState::Unknown;
+            } else if (kind == 11) {
+                w.cloaked = true;
+                want = WindowState::Unknown;
+            } else if (kind == 12) {
+                w.maximized = true;
+                rect = { info.work.left - 8, info.work.top - 8, info.work.right + 8, info.work.bottom + 8 };
+                want = WindowState::Unknown;
+            } else if (kind == 13) {
+                w.className = i % 40 == 13 ? L"Shell_TrayWnd" : L"NoTileApp";
+                want = WindowState::Unknown;
+            } else if (kind == 14) {
+                rect.left += 25;  // Moved by hand, past the tolerance
+                rect.right += 25;
+                want = WindowState::Unknown;
+            } else {
+                long x = info.work.left + 50 + next(1200);
+                long y = info.work.top + 50 + next(600);
+                rect = { x, y, x + 300 + next(600), y + 200 + next(400) };
+                want = WindowState::Unknown;
+            }
+            w.rect = rect;
+            windows.push_back(window);
+            expected.push_back(want);
+            adoptable += want != WindowState::Unknown ? 1 : 0;
+        }
+
+        // The first hotkey snaps this one (topmost, under the cursor) to the left half
+        hotkeyTarget = sim.AddWindow({ 800, 300, 1500, 900 });
+        sim.Window(hotkeyTarget).className = L"AppWindow";
+        sim.SetForeground(hotkeyTarget);
+        Reset();
+        windows.push_back(hotkeyTarget);
+        expected.push_back(WindowState::LeftHalf);
+    }
+
+    // Hotkey target and cursor back where the next run expects them
+    void Reset() {
+        sim.Window(hotkeyTarget).rect = { 800, 300, 1500, 900 };
+        sim.SetCursorPoint({ 1000, 500 });
+    }
+
+    void CheckStates(const char* what) {
+        for (size_t i = 0; i < windows.size(); ++i) {
+            if (TrackedWindowState(windows[i]) != expected[i]) {
+                BenchCheck(BENCH, false, what);
+                return;
+            }
+        }
+    }
+};
+
+int main() {
+    // One no_tile rule, so adoption honors the rules
+    std::string text = "rule = class=NoTileApp no_tile\n";
+    std::unique_ptr<Config> config = std::make_unique<Config>();
+    std::string error;
+    BenchCheck(BENCH, ParseConfig(text.data(), text.size(), config.get(), &error), "config rejected");
+    PublishConfig(std::move(config));
+
+    Desktop d;
+    char params[192];
+
+    // Blocking baseline: classify everything on the main thread, then handle the hotkey
+    std::vector<long long> blocking;
+    for (int run = 0; run < RUNS; ++run) {
+        InitTiler(&d.sim);
+        RefreshMonitorCache();
+        BenchClock::time_point start = BenchClock::now();
+        AdoptionSettings settings;
+        for (MonitorId monitor : d.monitors) {
+            AdoptionMonitor m;
+            m.monitor = monitor;
+            d.sim.QueryMonitor(monitor, &m.info);
+            m.lines = SplitLinesFromRatio(m.info.work, SplitRatio());
+            settings.monitors.push_back(m);
+        }
+        settings.excludedClasses = CurrentConfig().excludedClasses;
+        settings.padding = CurrentConfig().padding;
+        std::vector<WindowId> enumerated;
+        d.sim.EnumerateWindows(&enumerated);
+        long long matched = 0;
+        for (WindowId window : enumerated) {
+            matched += ClassifyWindow(&d.sim, window, settings).state != WindowState::Unknown ? 1 : 0;
+        }
+        HandleSnapRequest(SnapDirection::Left);
+        blocking.push_back(ElapsedNs(start));
+        BenchCheck(BENCH, matched >= d.adoptable, "blocking scan missed windows");
+        d.Reset();
+    }
+
+    // Worker scan; the hotkey arrives right after start-up
+    d.sim.concurrentCalls = true;
+    std::vector<long long> firstHotkey, done, batches;
+    AdoptionStats stats = {};
+    for (int run = 0; run < RUNS; ++run) {
+        InitTiler(&d.sim);
+        RefreshMonitorCache();
+        d.sim.ResetCalls();
+        BenchClock::time_point start = BenchClock::now();
+        StartWindowAdoption(ADOPTION_WORKERS, Notify);
+
+        HandleSnapRequest(SnapDirection::Left);
+        firstHotkey.push_back(ElapsedNs(start));
+
+        // The message loop: one batch per notification or re-post
+        for (;;) {
+            BenchClock::time_point batchStart = BenchClock::now();
+            bool more = AdoptScannedWindows(ADOPTION_BATCH);
+            batches.push_back(ElapsedNs(batchStart));
+            if (!more) {
+                if (WindowAdoptionStats().finished) break;
+                WaitForNotify();
+            }
+        }
+        done.push_back(ElapsedNs(start));
+        stats = WindowAdoptionStats();
+
+        d.CheckStates("adopted state differs from the expected one");
+        BenchCheck(BENCH, stats.scanned == static_cast<long long>(d.windows.size()), "not every window was classified");
+        BenchCheck(BENCH, stats.adopted == d.adoptable, "wrong number of windows adopted");
+        d.Reset();
+    }
+    d.sim.concurrentCalls = false;
+    ShutdownTiler();
+
+    std::snprintf(params, sizeof(params), "op=time_to_first_hotkey scan=blocking windows=%d", WINDOWS + 1);
+    ReportSamples("adoption", params, blocking);
+    long long blockingP50 = Percentile(blocking, 0.50);
+    std::snprintf(params, sizeof(params), "op=time_to_first_hotkey scan=workers workers=%d windows=%d", ADOPTION_WORKERS, WINDOWS + 1);
+    ReportSamples("adoption", params, firstHotkey);
+    long long firstHotkeyP50 = Percentile(firstHotkey, 0.50);
+    std::snprintf(params, sizeof(params), "op=adoption_done scan=workers workers=%d scanned=%lld matched=%lld adopted=%lld",
+                  ADOPTION_WORKERS, stats.scanned, stats.matched, stats.adopted);
+    ReportSamples("adoption", params, done);
+    std::snprintf(params, sizeof(params), "op=main_thread_batch batch=%d", ADOPTION_BATCH);
+    ReportSamples("adoption", params, batches);
+
+    BenchCheck(BENCH, firstHotkeyP50 < blockingP50 / 4, "the first hotkey waited for the scan");
+    std::printf("bench=adoption_check windows=%d adoptable=%lld first_hotkey_p50_ns=%lld blocking_p50_ns=%lld failures=%d\n",
+                WINDOWS + 1, d.adoptable, firstHotkeyP50, blockingP50, benchFailures);
+    return benchFailures ? 1 : 0;
+}
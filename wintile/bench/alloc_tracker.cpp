@@ -0,0 +1,86 @@
+#include "alloc_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#include <new>
+
+static std::atomic<bool> tracking(false);
+static std::atomic<long long> allocations(0);
+static std::atomic<long long> allocationBytes(0);
+static std::atomic<size_t> firstAllocationSize(0);
+
+void StartAllocationTracking() {
+    allocations.store(0);
+    allocationBytes.store(0);
+    firstAllocationSize.store(0);
+    tracking.store(true);
+}
+
+void StopAllocationTracking() {
+    tracking.store(false);
+}
+
+long long TrackedAllocations() {
+    return allocations.load();
+}
+
+long long TrackedAllocationBytes() {
+    return allocationBytes.load();
+}
+
+size_t FirstTrackedAllocationSize() {
+    return firstAllocationSize.load();
+}
+
+static void CountAllocation(size_t size) {
+    if (!tracking.load(std::memory_order_relaxed)) return;
+    if (allocations.fetch_add(1, std::memory_order_relaxed) == 0) {
+        firstAllocationSize.store(size, std::memory_order_relaxed);
+    }
+    allocationBytes.fetch_add(static_cast<long long>(size), std::memory_order_relaxed);
+}
+
+static void* Allocate(size_t size) {
+    CountAllocation(size);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+static void* AllocateAligned(size_t size, std::align_val_t alignment) {
+    CountAllocation(size);
+    size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+    void* p = _aligned_malloc(size ? size : 1, align);
+#else
+    size_t rounded = size ? (size + align - 1) / align * align : align;  // aligned_alloc wants a multiple
+    void* p = std::aligned_alloc(align, rounded);
+#endif
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+static void FreeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(size_t size) { return Allocate(size); }
+void* operator new[](size_t size) { return Allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { FreeAligned(p); }
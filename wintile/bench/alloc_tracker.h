@@ -0,0 +1,15 @@
+#pragma once
+
+// Test-only allocation hook. Linking alloc_tracker.cpp into a benchmark replaces the global
+// operator new/delete with versions that count every allocation made while tracking is on,
+// on any thread.
+
+#include <cstddef>
+
+void StartAllocationTracking();
+void StopAllocationTracking();
+
+// Allocations since the last StartAllocationTracking
+long long TrackedAllocations();
+long long TrackedAllocationBytes();
+size_t FirstTrackedAllocationSize();  // 0 if nothing was allocated
@@ -0,0 +1,382 @@
+// Snap animations on a virtual clock. The animator runs against the simulated desktop with
+// frames stepped by hand, on its own and behind the tiler's commands:
+//
+//   easing      ease-out and rect interpolation are exact at both ends and never overshoot
+//   frames      every frame places all animations in flight as one transaction, and a run
+//               takes ceil(duration / frame interval) frames
+//   retarget    a new animation of a moving window starts where the old one got to, and the
+//               old one never reports arriving; Cancel leaves the window where it is
+//   late        frames three intervals apart shrink the budget and finish early; on-time
+//               frames win it back
+//   alloc       after warm-up, runs of 40 animations allocate nothing
+//   tiler       snaps, batched snaps and a retargeting snap animate; the cursor goes to the
+//               target at once, a window that refuses its slot settles when it arrives, hides
+//               and closes cancel, and detaching jumps every window to its target
+//
+// Also times a frame with 40 and 256 animations in flight. Exits non-zero on any mismatch.
+
+#include "alloc_tracker.h"
+#include "animation.h"
+#include "bench_util.h"
+#include "config.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+static const long long FRAME_NS = 16666667;       // 60 Hz
+static const long long DURATION_NS = 150000000;   // 150 ms
+static const int WINDOWS = 40;
+
+static const char BENCH[] = "animation_bench";
+
+static int wakes = 0;
+static void Wake() {
+    wakes += 1;
+}
+
+struct Arrival {
+    WindowId window;
+    Rect target;
+};
+static std::vector<Arrival> arrivals;
+
+static void RecordArrival(void*, WindowId window, const Rect& target) {
+    arrivals.push_back({ window, target });
+}
+
+static Rect Slot(int i) {
+    long x = (i % 8) * 300;
+    long y = (i / 8) * 250;
+    return { x, y, x + 280, y + 230 };
+}
+
+static Rect Offset(const Rect& r, long dx, long dy) {
+    return { r.left + dx, r.top + dy, r.right + dx, r.bottom + dy };
+}
+
+// Desktop for the animator alone: WINDOWS windows in a grid on one large monitor
+struct Scene {
+    SimWindowSystem sim;
+    Animator animator;
+    std::vector<WindowId> windows;
+    long long nowNs = 0;
+
+    Scene() {
+        sim.AddMonitor({ 0, 0, 7680, 4320 });
+        for (int i = 0; i < ANIMATION_MAX_ACTIVE; ++i) windows.push_back(sim.AddWindow(Slot(i % WINDOWS)));
+        animator.Init(&sim, FRAME_NS, Wake);
+        animator.SetDoneCallback(RecordArrival, nullptr);
+    }
+
+    // Start `count` animations, each window to its slot moved right/down by `shift`
+    void Start(int count, long shift) {
+        for (int i = 0; i < count; ++i) {
+            WindowId window = windows[i];
+            animator.Animate(window, sim.Window(window).rect, Offset(Slot(i % WINDOWS), shift, shift), DURATION_NS);
+        }
+    }
+
+    // Frames until nothing is in flight; checks one transaction per frame. Returns the count.
+    int Run(long long intervalNs = FRAME_NS) {
+        int frames = 0;
+        while (animator.Active() && frames < 1000) {
+            size_t active = animator.Active();
+            sim.ResetCalls();
+            nowNs += intervalNs;
+            animator.Frame(nowNs);
+            frames += 1;
+            bool single = active == 1 && sim.Calls(SimCall::SetWindowPos) == 1 && sim.Transactions() == 0;
+            bool batched = active > 1 && sim.Transactions() == 1 && sim.Calls(SimCall::SetWindowPos) == 0 &&
+                           sim.Calls(SimCall::DeferWindowPos) == static_cast<long long>(active);
+            BenchCheck(BENCH, single || batched, "a frame was not one placement call for every animation");
+        }
+        return frames;
+    }
+};
+
+static void CheckEasing() {
+    BenchCheck(BENCH, EaseOutCubic(0.0) == 0.0 && EaseOutCubic(1.0) == 1.0, "easing is not exact at its ends");
+    double last = 0.0;
+    for (int i = 1; i <= 1000; ++i) {
+        double e = EaseOutCubic(i / 1000.0);
+        BenchCheck(BENCH, e >= last && e <= 1.0, "easing overshoots or goes back");
+        last = e;
+    }
+    BenchCheck(BENCH, EaseOutCubic(0.5) > 0.5, "easing is not ease-out");
+
+    Rect from = { -300, 17, 501, 999 };
+    Rect to = { 1280, -40, 2560, 1400 };
+    BenchCheck(BENCH, LerpRect(from, to, 0.0) == from && LerpRect(from, to, 1.0) == to, "interpolation is not exact at its ends");
+    Rect half = LerpRect(from, to, 0.5);
+    BenchCheck(BENCH, half.left == 490 && half.right == 1531, "interpolation halfway is off");
+}
+
+static void CheckFrames(Scene& s) {
+    wakes = 0;
+    arrivals.clear();
+    s.Start(WINDOWS, 40);
+    BenchCheck(BENCH, wakes == 1, "starting a run did not wake the frame pacer exactly once");
+    BenchCheck(BENCH, s.sim.Window(s.windows[0]).rect == Slot(0), "a window moved before the first frame");
+    int frames = s.Run();
+    int expected = static_cast<int>((DURATION_NS + FRAME_NS - 1) / FRAME_NS);
+    std::printf("bench=animation case=frames animations=%d duration_ms=%lld frames=%d expected=%d\n", WINDOWS,
+                DURATION_NS / 1000000, frames, expected);
+    BenchCheck(BENCH, frames == expected, "a run took the wrong number of frames");
+    BenchCheck(BENCH, arrivals.size() == static_cast<size_t>(WINDOWS), "not every animation reported arriving");
+    for (int i = 0; i < WINDOWS; ++i) {
+        if (s.sim.Window(s.windows[i]).rect != Offset(Slot(i), 40, 40)) {
+            BenchCheck(BENCH, false, "a window did not end exactly at its target");
+            break;
+        }
+    }
+}
+
+// Moves of `to - from` on each edge never point away from the target and never pass it
+static bool Toward(const Rect& from, const Rect& next, const Rect& to) {
+    long a[4] = { from.left, from.top, from.right, from.bottom };
+    long b[4] = { next.left, next.top, next.right, next.bottom };
+    long c[4] = { to.left, to.top, to.right, to.bottom };
+    for (int i = 0; i < 4; ++i) {
+        long step = b[i] - a[i];
+        long rest = c[i] - a[i];
+        if ((rest >= 0 && (step < 0 || step > rest)) || (rest < 0 && (step > 0 || step < rest))) return false;
+    }
+    return true;
+}
+
+static void CheckRetarget(Scene& s) {
+    arrivals.clear();
+    WindowId window = s.windows[0];
+    Rect first = Offset(Slot(0), 1200, 0);
+    Rect second = Offset(Slot(0), 0, 900);
+    s.animator.Animate(window, s.sim.Window(window).rect, first, DURATION_NS);
+    for (int i = 0; i < 3; ++i) s.animator.Frame(s.nowNs += FRAME_NS);
+    Rect reached = s.sim.Window(window).rect;
+    Rect position;
+    BenchCheck(BENCH, s.animator.Position(window, &position) && position == reached, "the animation lost track of its window");
+
+    // The new command takes over from where the window is, without a jump
+    BenchCheck(BENCH, s.animator.Animate(window, position, second, DURATION_NS), "retargeting did not start");
+    BenchCheck(BENCH, s.animator.Active() == 1, "the replaced animation is still in flight");
+    s.animator.Frame(s.nowNs += FRAME_NS);
+    BenchCheck(BENCH, Toward(reached, s.sim.Window(window).rect, second), "the retargeted window jumped");
+    s.Run();
+    BenchCheck(BENCH, arrivals.size() == 1 && arrivals[0].target == second, "the replaced animation reported arriving");
+    BenchCheck(BENCH, s.sim.Window(window).rect == second, "the retargeted window did not arrive");
+
+    // Cancel stops the window where it is
+    arrivals.clear();
+    s.animator.Animate(window, second, first, DURATION_NS);
+    s.animator.Frame(s.nowNs += FRAME_NS);
+    Rect stopped = s.sim.Window(window).rect;
+    s.animator.Cancel(window);
+    BenchCheck(BENCH, !s.animator.Animating(window) && s.animator.Active() == 0, "cancel left the animation in flight");
+    s.sim.ResetCalls();
+    BenchCheck(BENCH, !s.animator.Frame(s.nowNs += FRAME_NS), "a frame after cancelling reported work");
+    BenchCheck(BENCH, s.sim.Calls(SimCall::SetWindowPos) == 0 && s.sim.Transactions() == 0, "a cancelled animation still moved");
+    BenchCheck(BENCH, s.sim.Window(window).rect == stopped && arrivals.empty(), "a cancelled animation moved or arrived");
+
+    // Nothing to animate: the caller places it
+    BenchCheck(BENCH, !s.animator.Animate(window, stopped, stopped, DURATION_NS), "animated a window that is already there");
+    s.sim.Place({ window, Slot(0) });
+}
+
+static void CheckLateFrames(Scene& s) {
+    arrivals.clear();
+    long long slowNs = 3 * FRAME_NS;
+    long long longNs = 2 * DURATION_NS;
+    s.animator.Animate(s.windows[1], s.sim.Window(s.windows[1]).rect, Offset(Slot(1), 600, 600), longNs);
+    long long startNs = s.nowNs;
+    int frames = s.Run(slowNs);
+    long long tookNs = s.nowNs - startNs;
+    double shrunk = s.animator.BudgetScale();
+    std::printf("bench=animation case=late_frames interval_ms=%lld duration_ms=%lld frames=%d took_ms=%lld budget_scale=%.3f\n",
+                slowNs / 1000000, longNs / 1000000, frames, tookNs / 1000000, shrunk);
+    BenchCheck(BENCH, shrunk <= 0.5, "late frames did not shrink the budget");
+    BenchCheck(BENCH, frames < longNs / slowNs, "late frames did not shorten the animation");
+    BenchCheck(BENCH, s.sim.Window(s.windows[1]).rect == Offset(Slot(1), 600, 600), "the shortened animation missed its target");
+
+    // On time again: a long animation wins the budget back
+    s.animator.Animate(s.windows[1], s.sim.Window(s.windows[1]).rect, Slot(1), 10 * longNs);
+    s.Run();
+    std::printf("bench=animation case=recovered budget_scale=%.3f\n", s.animator.BudgetScale());
+    BenchCheck(BENCH, s.animator.BudgetScale() > 0.95, "on-time frames did not restore the budget");
+}
+
+static void CheckAllocations(Scene& s) {
+    s.Start(WINDOWS, 0);
+    s.Run();
+    arrivals.reserve(WINDOWS);
+    StartAllocationTracking();
+    for (int round = 0; round < 100; ++round) {
+        arrivals.clear();
+        s.Start(WINDOWS, (round % 2) ? 0 : 25);
+        s.Run();
+    }
+    StopAllocationTracking();
+    std::printf("bench=animation case=alloc rounds=100 animations=%d allocations=%lld bytes=%lld\n", 100 * WINDOWS,
+                TrackedAllocations(), TrackedAllocationBytes());
+    BenchCheck(BENCH, TrackedAllocations() == 0, "animations allocated after warm-up");
+}
+
+static void TimeFrames(Scene& s, int count) {
+    std::vector<long long> samples;
+    for (int round = 0; round < 200; ++round) {
+        arrivals.clear();
+        s.Start(count, (round % 2) ? 0 : 25);
+        while (s.animator.Active()) {
+            s.nowNs += FRAME_NS;
+            BenchClock::time_point start = BenchClock::now();
+            s.animator.Frame(s.nowNs);
+            samples.push_back(ElapsedNs(start));
+        }
+    }
+    char params[64];
+    std::snprintf(params, sizeof(params), "case=frame animations=%d", count);
+    ReportSamples("animation", params, samples);
+}
+
+// The tiler's snaps through an attached animator
+static void CheckTiler() {
+    std::string text = "animation_ms = 150\n";
+    std::unique_ptr<Config> config = std::make_unique<Config>();
+    BenchCheck(BENCH, ParseConfig(text.data(), text.size(), config.get(), nullptr), "config rejected");
+    PublishConfig(std::move(config));
+
+    SimWindowSystem sim;
+    sim.AddMonitor({ 0, 0, 2560, 1440 });
+    sim.AddMonitor({ 2560, 0, 5120, 1440 });
+    std::vector<WindowId> windows;
+    for (int i = 0; i < 6; ++i) {
+        long x = 200 + 60 * i;
+        windows.push_back(sim.AddWindow({ x, 150, x + 900, 850 }));
+    }
+    sim.Window(windows[5]).limits.minWidth = 1500;  // Refuses a half of the first monitor
+
+    Animator animator;
+    animator.Init(&sim, FRAME_NS, Wake);
+    InitTiler(&sim);
+    RefreshMonitorCache();
+    AttachAnimator(&animator);
+    long long nowNs = 0;
+    auto runFrames = [&] {
+        int frames = 0;
+        while (AdvanceAnimations(nowNs += FRAME_NS) && frames < 1000) frames += 1;
+        return frames + 1;
+    };
+
+    // A hotkey snap: nothing moves until the first frame, the cursor goes to the target at once
+    WindowId window = windows[0];
+    const Rect& start = sim.Window(window).rect;
+    sim.SetForeground(window);
+    sim.SetCursorPoint({ start.left + 10, start.top + 10 });
+    UpdateFocusedWindow();
+    Rect before = start;
+    wakes = 0;
+    HandleSnapRequest(SnapDirection::Left);
+    Rect target;
+    BenchCheck(BENCH, animator.Target(window, &target), "a snap did not animate");
+    BenchCheck(BENCH, sim.Window(window).rect == before && wakes == 1, "a snap moved before its first frame");
+    Point cursor;
+    sim.CursorPosition(&cursor);
+    BenchCheck(BENCH, cursor.x == target.left + RectWidth(target) / 2 && cursor.y == target.top + RectHeight(target) / 2,
+               "the cursor did not go to the snap target");
+    runFrames();
+    BenchCheck(BENCH, sim.Window(window).rect == target && TrackedWindowState(window) == WindowState::LeftHalf,
+               "the snapped window did not arrive");
+    Rect frame = sim.Window(window).rect;
+    int width = CurrentConfig().borderWidth;
+    Rect around = { frame.left - width, frame.top - width, frame.right + width, frame.bottom + width };
+    bool bordered = false;
+    for (WindowId id = 1; id <= sim.WindowCount(); ++id) {
+        if (sim.Window(id).border && sim.Window(id).alive) bordered = sim.Window(id).rect == around;
+    }
+    BenchCheck(BENCH, bordered, "the focus border did not follow the animation");
+
+    // A batch: one transaction per frame for all four windows
+    SnapTarget targets[] = {
+        { windows[1], WindowState::TopLeftQuarter, 2 },
+        { windows[2], WindowState::TopRightQuarter, 2 },
+        { windows[3], WindowState::BottomLeftQuarter, 2 },
+        { windows[4], WindowState::BottomRightQuarter, 2 },
+    };
+    BenchCheck(BENCH, SnapWindows(targets, 4) == 4, "the batch was not snapped");
+    BenchCheck(BENCH, animator.Active() == 4, "the batch did not animate every window");
+    for (int i = 0; i < 3; ++i) {
+        sim.ResetCalls();
+        AdvanceAnimations(nowNs += FRAME_NS);
+        BenchCheck(BENCH, sim.Transactions() == 1 && sim.Calls(SimCall::DeferWindowPos) == 4,
+                   "a frame of the batch was not one transaction");
+    }
+
+    // A new command for a moving window takes over from where it is
+    Rect reached = sim.Window(windows[1]).rect;
+    SnapTarget retarget = { windows[1], WindowState::LeftHalf, 2 };
+    BenchCheck(BENCH, SnapWindows(&retarget, 1) == 1, "the retargeting snap failed");
+    Rect moved;
+    BenchCheck(BENCH, animator.Target(windows[1], &moved) && animator.Active() == 4, "the retargeting snap did not replace the animation");
+    AdvanceAnimations(nowNs += FRAME_NS);
+    BenchCheck(BENCH, Toward(reached, sim.Window(windows[1]).rect, moved), "the retargeted window jumped");
+    runFrames();
+    BenchCheck(BENCH, sim.Window(windows[1]).rect == moved && TrackedWindowState(windows[1]) == WindowState::LeftHalf,
+               "the retargeted window did not arrive");
+
+    // A window that refuses its slot settles when it arrives
+    SnapTarget wide[] = { { windows[5], WindowState::LeftHalf, 1 } };
+    SnapWindows(wide, 1);
+    runFrames();
+    const Rect& left = sim.Window(windows[5]).rect;
+    const Rect& right = sim.Window(windows[0]).rect;
+    BenchCheck(BENCH, RectWidth(left) >= 1500, "the simulator let a window below its minimum width");
+    BenchCheck(BENCH, !animator.Active(), "settling did not finish");
+    SnapWindow(windows[0], WindowState::RightHalf, 0);
+    runFrames();
+    BenchCheck(BENCH, right.left >= left.right, "the refused slot was not settled on arrival");
+
+    // Hides and closes cancel
+    SnapWindow(windows[2], WindowState::RightHalf, 0);
+    const Rect& moving = sim.Window(windows[2]).rect;
+    sim.SetCursorPoint({ moving.left + 10, moving.top + 10 });
+    HandleMoveToWorkspace(1);
+    BenchCheck(BENCH, !animator.Animating(windows[2]), "a hidden window kept animating");
+    SnapWindow(windows[3], WindowState::TopHalf, 0);
+    sim.CloseWindow(windows[3]);
+    HandleWindowDestroyed(windows[3]);
+    BenchCheck(BENCH, !animator.Animating(windows[3]), "a closed window kept animating");
+
+    // Off: immediate again
+    SnapWindow(windows[4], WindowState::BottomHalf, 0);
+    std::unique_ptr<Config> off = std::make_unique<Config>();
+    PublishConfig(std::move(off));
+    SnapWindow(windows[1], WindowState::RightHalf, 0);
+    BenchCheck(BENCH, !animator.Animating(windows[1]), "a snap animated with animations off");
+
+    // Detaching jumps the rest to their targets
+    Rect last;
+    BenchCheck(BENCH, animator.Target(windows[4], &last), "the last animation ended early");
+    DetachAnimator();
+    BenchCheck(BENCH, !animator.Active() && sim.Window(windows[4]).rect == last, "detaching did not finish the animations");
+    ShutdownTiler();
+}
+
+int main() {
+    CheckEasing();
+    {
+        Scene s;
+        CheckFrames(s);
+        CheckRetarget(s);
+        CheckLateFrames(s);
+        CheckAllocations(s);
+        TimeFrames(s, WINDOWS);
+        TimeFrames(s, ANIMATION_MAX_ACTIVE);
+        const AnimationStats& stats = s.animator.Stats();
+        std::printf("bench=animation_stats started=%lld completed=%lld cancelled=%lld frames=%lld late_frames=%lld placements=%lld\n",
+                    stats.started, stats.completed, stats.cancelled, stats.frames, stats.lateFrames, stats.placements);
+    }
+    CheckTiler();
+    std::printf("bench=animation_check failures=%d\n", benchFailures);
+    return benchFailures ? 1 : 0;
+}
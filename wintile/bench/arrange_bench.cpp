@@ -0,0 +1,110 @@
+// Benchmark for the auto-arrange core: slot generation plus min-movement assignment,
+// with a brute-force optimality cross-check on small window counts.
+
+#include "arrange.h"
+#include "bench_util.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+
+static double TotalMovement(const std::vector<Rect>& windows, const std::vector<Rect>& slots, const std::vector<size_t>& assignment) {
+    double total = 0.0;
+    for (size_t i = 0; i < windows.size(); ++i) {
+        total += CenterDistance(windows[i], slots[assignment[i]]);
+    }
+    return total;
+}
+
+// Reference: minimum over all permutations, O(n!)
+static double BruteForceMovement(const std::vector<Rect>& windows, const std::vector<Rect>& slots) {
+    std::vector<size_t> permutation(windows.size());
+    std::iota(permutation.begin(), permutation.end(), 0);
+    double best = TotalMovement(windows, slots, permutation);
+    while (std::next_permutation(permutation.begin(), permutation.end())) {
+        best = std::min(best, TotalMovement(windows, slots, permutation));
+    }
+    return best;
+}
+
+static std::vector<Rect> RandomWindows(std::mt19937& rng, const Rect& work, size_t count) {
+    std::uniform_int_distribution<long> width(300, 1200);
+    std::uniform_int_distribution<long> height(200, 800);
+    std::uniform_int_distribution<long> x(work.left, work.right - 300);
+    std::uniform_int_distribution<long> y(work.top, work.bottom - 200);
+
+    std::vector<Rect> windows;
+    windows.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        long left = x(rng);
+        long top = y(rng);
+        windows.push_back({ left, top, left + width(rng), top + height(rng) });
+    }
+    return windows;
+}
+
+int main() {
+    const Rect work = { 0, 0, 2560, 1400 };
+    const long padding = 6;
+    std::mt19937 rng(4242);
+
+    // Optimality against exhaustive search
+    const int trials = 300;
+    int mismatches = 0;
+    for (int trial = 0; trial < trials; ++trial) {
+        size_t count = 1 + trial % 7;
+        ArrangeLayout layout = (trial % 2) ? ArrangeLayout::Grid : ArrangeLayout::MasterStack;
+        std::vector<Rect> windows = RandomWindows(rng, work, count);
+        std::vector<Rect> slots;
+        std::vector<size_t> assignment;
+        ComputeArrangeSlots(work, layout, count, padding, 0.5f, &slots);
+        AssignSlots(windows.data(), slots.data(), count, &assignment);
+
+        std::vector<char> taken(count, 0);
+        bool valid = true;
+        for (size_t slot : assignment) {
+            if (slot >= count || taken[slot]) valid = false;
+            else taken[slot] = 1;
+        }
+        if (!valid || TotalMovement(windows, slots, assignment) > BruteForceMovement(windows, slots) + 1e-6) {
+            ++mismatches;
+        }
+    }
+    std::printf("bench=arrange_check trials=%d mismatches=%d\n", trials, mismatches);
+
+    const size_t counts[] = { 4, 16, 50, 100, 200 };
+    const ArrangeLayout layouts[] = { ArrangeLayout::Grid, ArrangeLayout::MasterStack };
+    for (ArrangeLayout layout : layouts) {
+        for (size_t count : counts) {
+            std::vector<long long> samples;
+            double movement = 0.0;
+            double naiveMovement = 0.0;
+            int iterations = count <= 50 ? 500 : 50;
+            for (int i = 0; i < iterations; ++i) {
+                std::vector<Rect> windows = RandomWindows(rng, work, count);
+                std::vector<Rect> slots;
+                std::vector<size_t> assignment;
+
+                BenchClock::time_point start = BenchClock::now();
+                ComputeArrangeSlots(work, layout, count, padding, 0.5f, &slots);
+                AssignSlots(windows.data(), slots.data(), count, &assignment);
+                samples.push_back(ElapsedNs(start));
+
+                // Compare against filling the slots in enumeration order
+                std::vector<size_t> naive(count);
+                std::iota(naive.begin(), naive.end(), 0);
+                movement += TotalMovement(windows, slots, assignment);
+                naiveMovement += TotalMovement(windows, slots, naive);
+            }
+
+            char params[160];
+            std::snprintf(params, sizeof(params), "layout=%s windows=%zu movement_px=%.0f naive_movement_px=%.0f",
+                          layout == ArrangeLayout::Grid ? "grid" : "master_stack", count,
+                          movement / iterations, naiveMovement / iterations);
+            ReportSamples("arrange", params, samples);
+        }
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// Shared helpers for the portable benchmarks. Every result is printed as one line of
+// space-separated key=value pairs starting with "bench=<name>", so runs can be diffed
+// and parsed by scripts.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+typedef std::chrono::steady_clock BenchClock;
+
+// Checks failed so far; a bench exits non-zero if any did
+inline int benchFailures = 0;
+
+// Count a failed check of `bench`; the first ten are described on stderr
+inline void BenchCheck(const char* bench, bool ok, const char* what) {
+    if (!ok && benchFailures++ < 10) std::fprintf(stderr, "%s: %s\n", bench, what);
+}
+
+// Nanoseconds elapsed since `start`
+inline long long ElapsedNs(BenchClock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+}
+
+// Value at percentile `p` (0..1) of an already sorted sample set
+inline long long Percentile(const std::vector<long long>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Print latency statistics of one benchmark case. `params` is a preformatted
+// "key=value ..." string describing the case (may be empty).
+inline void ReportSamples(const char* name, const char* params, std::vector<long long>& samples) {
+    std::sort(samples.begin(), samples.end());
+    long long total = 0;
+    for (long long s : samples) total += s;
+    long long mean = samples.empty() ? 0 : total / static_cast<long long>(samples.size());
+
+    std::printf("bench=%s %s samples=%zu mean_ns=%lld p50_ns=%lld p90_ns=%lld p99_ns=%lld p999_ns=%lld max_ns=%lld\n",
+                name, params, samples.size(), mean,
+                Percentile(samples, 0.50), Percentile(samples, 0.90),
+                Percentile(samples, 0.99), Percentile(samples, 0.999),
+                samples.empty() ? 0 : samples.back());
+}
@@ -0,0 +1,126 @@
+// Live border tracking during drag and resize. The focused window is dragged (and resized)
+// for one second of virtual time with a location change per 1 kHz mouse report, while
+// another window animates in the background. Frames arrive on a 60 Hz and a 144 Hz display
+// clock. Each case runs once moving the border on every event and once through the border
+// tracker; the tracker must issue at most one reposition per frame, keep the border at most
+// one frame behind and end exactly around the window. Exits non-zero on any mismatch.
+
+#include "bench_util.h"
+#include "border_tracker.h"
+#include "config.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+static const long long DURATION_NS = 1000000000;  // 1 s
+static const long long MOUSE_NS = 1000000;        // 1 kHz mouse reports
+
+struct Drag {
+    SimWindowSystem sim;
+    WindowId window;
+    WindowId background;
+
+    Drag() {
+        sim.AddMonitor({ 0, 0, 2560, 1440 });
+        background = sim.AddWindow({ 1600, 800, 2400, 1300 });
+        window = sim.AddWindow({ 100, 100, 900, 700 });
+        InitTiler(&sim);
+        ClearBorderTrack();
+        RefreshMonitorCache();
+        sim.SetForeground(window);
+        UpdateFocusedWindow();
+    }
+
+    ~Drag() { ShutdownTiler(); }
+
+    // Window rect `t` ns into the drag: moves along a diagonal, and grows when resizing
+    Rect At(long long t, bool resize) const {
+        long step = static_cast<long>(t / MOUSE_NS);
+        long dx = step % 800;
+        long dy = (step / 2) % 400;
+        long grow = resize ? (step % 300) : 0;
+        return { 100 + dx, 100 + dy, 900 + dx + grow, 700 + dy + grow / 2 };
+    }
+
+    bool BorderAround() {
+        const Rect& r = sim.Window(window).rect;
+        int width = CurrentConfig().borderWidth;
+        Rect expected = { r.left - width, r.top - width, r.right + width, r.bottom + width };
+        for (WindowId id = 1; id <= sim.WindowCount(); ++id) {
+            const SimWindow& w = sim.Window(id);
+            if (w.border && w.alive) return w.rect == expected;
+        }
+        return false;
+    }
+};
+
+struct Result {
+    long long events = 0;
+    long long repositions = 0;  // Border SetWindowPos calls
+    long long frames = 0;       // Display frames in the drag
+    long long maxLagNs = 0;     // Oldest location change not yet shown, at a frame
+    bool borderAround = false;
+};
+
+static void Run(bool resize, long long frameNs, bool tracked, Result* result) {
+    Drag drag;
+    drag.sim.ResetCalls();
+    ResetBorderTrackStats();
+
+    long long nextFrame = frameNs;
+    long long dirtySince = -1;  // Time of the first change the border does not show yet
+    for (long long t = MOUSE_NS; t <= DURATION_NS; t += MOUSE_NS) {
+        // Frames due before this report
+        for (; nextFrame <= t; nextFrame += frameNs) {
+            result->frames += 1;
+            if (tracked && BorderTrackDirty()) {
+                result->maxLagNs = std::max(result->maxLagNs, nextFrame - dirtySince);
+                TrackBorderFrame();
+                dirtySince = -1;
+            }
+        }
+
+        drag.sim.Window(drag.window).rect = drag.At(t, resize);
+        result->events += 1;
+        if (tracked) {
+            if (NoteLocationChange(drag.window)) dirtySince = t;
+            NoteLocationChange(drag.background);  // Animating, not focused
+        } else {
+            TrackFocusedBorder();
+        }
+    }
+    // The frame after the last report
+    if (tracked && BorderTrackDirty()) {
+        result->frames += 1;
+        result->maxLagNs = std::max(result->maxLagNs, nextFrame - dirtySince);
+        TrackBorderFrame();
+    }
+
+    result->repositions = drag.sim.Calls(SimCall::SetWindowPos);
+    result->borderAround = drag.BorderAround();
+}
+
+int main() {
+    const long long frameRates[] = { 60, 144 };
+    int failures = 0;
+    for (int resize = 0; resize < 2; ++resize) {
+        for (long long hz : frameRates) {
+            long long frameNs = 1000000000 / hz;
+            Result naive, tracked;
+            Run(resize != 0, frameNs, false, &naive);
+            Run(resize != 0, frameNs, true, &tracked);
+
+            const BorderTrackStats& stats = BorderTrackStatistics();
+            bool ok = naive.borderAround && tracked.borderAround && tracked.repositions <= tracked.frames &&
+                      stats.repositions == tracked.repositions && stats.events == tracked.events &&
+                      stats.ignored == tracked.events && tracked.maxLagNs <= frameNs;
+            std::printf("bench=border_track case=%s refresh_hz=%lld events=%lld ignored=%lld naive_repositions=%lld tracked_repositions=%lld frames=%lld max_lag_ms=%.2f ok=%d\n",
+                        resize ? "resize" : "drag", hz, tracked.events, stats.ignored, naive.repositions,
+                        tracked.repositions, tracked.frames, tracked.maxLagNs / 1e6, ok ? 1 : 0);
+            if (!ok) {
+                ++failures;
+                std::fprintf(stderr, "border_track: %s at %lld Hz failed\n", resize ? "resize" : "drag", hz);
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
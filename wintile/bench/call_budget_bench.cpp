@@ -0,0 +1,219 @@
+// OS-call budgets: runs every tiler command against the simulated window system and checks
+// the number of user32/dwmapi calls it makes against a stated maximum. Commands that walk
+// all top-level windows get a per-window allowance and run at two desktop sizes, so a
+// change that adds calls to the per-window path is caught as well.
+// Exits non-zero if any scenario exceeds its budget.
+
+#include "bench_util.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+#include <string>
+
+// Two side-by-side 1080p monitors. `windows` managed windows cascade over the left monitor
+// (the last one added is topmost, focused and under the cursor); as many background windows
+// (hidden or tool windows) sit below them, since EnumWindows visits those too.
+struct Desktop {
+    SimWindowSystem sim;
+    MonitorId left = 0;
+    MonitorId right = 0;
+    std::vector<WindowId> background;
+    std::vector<WindowId> windows;  // Bottom to top
+    WindowId top = 0;
+
+    explicit Desktop(int count) {
+        left = sim.AddMonitor({ 0, 0, 1920, 1080 });
+        right = sim.AddMonitor({ 1920, 0, 3840, 1080 });
+        for (int i = 0; i < count; ++i) {
+            WindowId window = sim.AddWindow({ 0, 0, 300, 200 });
+            if (i % 2 == 0) {
+                sim.Window(window).visible = false;
+            } else {
+                sim.Window(window).exStyle = WINDOW_EXSTYLE_TOOLWINDOW;
+            }
+            background.push_back(window);
+        }
+        for (int i = 0; i < count; ++i) {
+            long x = 100 + 20 * i;
+            long y = 80 + 15 * i;
+            windows.push_back(sim.AddWindow({ x, y, x + 800, y + 600 }));
+        }
+        top = windows.back();
+
+        InitTiler(&sim);
+        RefreshMonitorCache();
+        Focus(top);
+    }
+
+    // Give a window focus the way the shell does, then let the tiler see the focus event
+    void Focus(WindowId window) {
+        sim.SetForeground(window);
+        const Rect& r = sim.Window(window).rect;
+        sim.SetCursorPoint({ r.left + RectWidth(r) / 2, r.top + RectHeight(r) / 2 });
+        UpdateFocusedWindow();
+    }
+};
+
+struct Scenario {
+    const char* name;
+    const char* command;
+    long long budget;     // Fixed part of the budget
+    long long perWindow;  // Allowance per managed window on the desktop
+    void (*run)(Desktop& d);  // Prepares the desktop, calls ResetCalls, runs the command
+};
+
+static void SnapUntracked(Desktop& d) {
+    d.sim.ResetCalls();
+    HandleSnapRequest(SnapDirection::Left);
+}
+
+static void SnapTracked(Desktop& d) {
+    HandleSnapRequest(SnapDirection::Left);
+    d.sim.ResetCalls();
+    HandleSnapRequest(SnapDirection::Up);
+}
+
+static void SnapLearnsLimits(Desktop& d) {
+    d.sim.Window(d.top).limits.minWidth = 1200;
+    d.sim.ResetCalls();
+    HandleSnapRequest(SnapDirection::Left);
+}
+
+static void SnapAcrossMonitors(Desktop& d) {
+    HandleSnapRequest(SnapDirection::Right);
+    HandleSnapRequest(SnapDirection::Right);  // Maximize
+    HandleSnapRequest(SnapDirection::Right);  // Back to the right half
+    d.sim.ResetCalls();
+    HandleSnapRequest(SnapDirection::Right);  // Over the edge onto the right monitor
+}
+
+static void Maximize(Desktop& d) {
+    d.sim.ResetCalls();
+    MaximizeWindow(d.top);
+}
+
+static void MaximizeRestore(Desktop& d) {
+    MaximizeWindow(d.top);
+    d.sim.ResetCalls();
+    MaximizeWindow(d.top);
+}
+
+static void MoveTrackedToMonitor(Desktop& d) {
+    SnapWindow(d.top, WindowState::LeftHalf, d.left);
+    d.sim.ResetCalls();
+    MoveWindowToMonitor(d.top, d.right);
+}
+
+static void MoveUntrackedToMonitor(Desktop& d) {
+    d.sim.ResetCalls();
+    MoveWindowToMonitor(d.top, d.right);
+}
+
+static void MonitorSwitchHotkey(Desktop& d) {
+    d.sim.ResetCalls();
+    HandleMonitorSwitch(SnapDirection::Right);
+}
+
+static void FocusChange(Desktop& d) {
+    d.sim.SetForeground(d.windows[0]);
+    d.sim.ResetCalls();
+    UpdateFocusedWindow();
+}
+
+static void FocusUnchanged(Desktop& d) {
+    d.sim.ResetCalls();
+    UpdateFocusedWindow();
+}
+
+static void FocusToToolWindow(Desktop& d) {
+    d.sim.SetForeground(d.background[1]);  // A tool window
+    d.sim.ResetCalls();
+    UpdateFocusedWindow();
+}
+
+static void SplitResize(Desktop& d) {
+    SnapWindow(d.windows[0], WindowState::RightHalf, d.left);
+    SnapWindow(d.top, WindowState::LeftHalf, d.left);
+    d.sim.ResetCalls();
+    QueueSplitResize(SplitAxis::X, 1);
+    QueueSplitResize(SplitAxis::X, 1);
+    QueueSplitResize(SplitAxis::X, 1);
+    ApplyPendingSplitResize();
+}
+
+static void Fill(Desktop& d) {
+    d.sim.ResetCalls();
+    HandleFillRequest();
+}
+
+static void ArrangeGrid(Desktop& d) {
+    d.sim.ResetCalls();
+    HandleArrangeRequest(ArrangeLayout::Grid);
+}
+
+static void WorkspaceSwitch(Desktop& d) {
+    d.sim.ResetCalls();
+    HandleWorkspaceSwitch(1);
+}
+
+static void WorkspaceSwitchBack(Desktop& d) {
+    HandleWorkspaceSwitch(1);
+    d.sim.ResetCalls();
+    HandleWorkspaceSwitch(0);
+}
+
+static void MoveToWorkspace(Desktop& d) {
+    d.sim.ResetCalls();
+    HandleMoveToWorkspace(2);
+}
+
+// Budgets are the measured counts; raise one only together with the change that needs it
+static const Scenario scenarios[] = {
+    { "snap_untracked", "HandleSnapRequest", 14, 0, SnapUntracked },
+    { "snap_tracked", "HandleSnapRequest", 14, 0, SnapTracked },
+    { "snap_learns_limits", "HandleSnapRequest", 16, 0, SnapLearnsLimits },
+    { "snap_across_monitors", "HandleSnapRequest", 16, 0, SnapAcrossMonitors },
+    { "maximize", "MaximizeWindow", 11, 0, Maximize },
+    { "maximize_restore", "MaximizeWindow", 11, 0, MaximizeRestore },
+    { "move_tracked", "MoveWindowToMonitor", 9, 0, MoveTrackedToMonitor },
+    { "move_untracked", "MoveWindowToMonitor", 13, 0, MoveUntrackedToMonitor },
+    { "monitor_switch", "HandleMonitorSwitch", 18, 0, MonitorSwitchHotkey },
+    { "focus_change", "UpdateFocusedWindow", 14, 0, FocusChange },
+    { "focus_unchanged", "UpdateFocusedWindow", 1, 0, FocusUnchanged },
+    { "focus_tool_window", "UpdateFocusedWindow", 5, 0, FocusToToolWindow },
+    { "split_resize", "ApplyPendingSplitResize", 17, 0, SplitResize },
+    { "fill", "HandleFillRequest", 16, 11, Fill },
+    { "arrange_grid", "HandleArrangeRequest", 18, 14, ArrangeGrid },
+    { "workspace_switch", "HandleWorkspaceSwitch", 10, 13, WorkspaceSwitch },
+    { "workspace_switch_back", "HandleWorkspaceSwitch", 6, 4, WorkspaceSwitchBack },
+    { "move_to_workspace", "HandleMoveToWorkspace", 14, 0, MoveToWorkspace },
+};
+
+int main() {
+    const int desktopSizes[] = { 8, 32 };
+    int failures = 0;
+
+    for (const Scenario& scenario : scenarios) {
+        for (int windows : desktopSizes) {
+            Desktop desktop(windows);
+            scenario.run(desktop);
+
+            long long calls = desktop.sim.TotalCalls();
+            long long budget = scenario.budget + scenario.perWindow * windows;
+            bool ok = calls <= budget;
+            if (!ok) ++failures;
+
+            std::string detail;
+            desktop.sim.FormatCalls(&detail);
+            std::printf("bench=call_budget scenario=%s command=%s windows=%d calls=%lld budget=%lld status=%s calls_by_api=%s\n",
+                        scenario.name, scenario.command, windows, calls, budget, ok ? "ok" : "OVER",
+                        detail.empty() ? "none" : detail.c_str());
+        }
+    }
+
+    if (failures) {
+        std::fprintf(stderr, "call_budget: %d scenario(s) over budget\n", failures);
+        return 1;
+    }
+    return 0;
+}
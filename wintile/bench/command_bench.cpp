@@ -0,0 +1,241 @@
+// Scripts driving the tiler over the command channel (a Unix domain socket here, the named pipe
+// on Windows) on a simulated desktop with 40 windows on two monitors. The main thread is the
+// tiler's message loop: it serves each request the channel hands it, as WM_APP_RUN_COMMANDS
+// does. A client thread sends snap commands three ways:
+//
+//   round_trip  one line, wait for its reply, next line
+//   pipelined   every line in one write, then read every reply
+//   batched     begin / 5 snap lines / commit, pipelined; each batch one placement transaction
+//
+// and the protocol is checked: errors pair up with their lines, a batch with a bad line changes
+// nothing, queries report the tracked state, and every window ends up where the last command put
+// it. Exits non-zero on any mismatch.
+
+#include "bench_util.h"
+#include "command_channel.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include <unistd.h>
+
+static const int WINDOWS = 40;
+static const int COMMANDS = 4000;
+static const int BATCH = 5;  // "snap these five windows to these slots"
+
+static const WindowState states[] = {
+    WindowState::LeftHalf, WindowState::RightHalf, WindowState::TopLeftQuarter, WindowState::TopRightQuarter,
+    WindowState::BottomLeftQuarter, WindowState::BottomRightQuarter, WindowState::TopHalf, WindowState::BottomHalf,
+};
+
+static const char BENCH[] = "command_bench";
+
+// Channel notifications, standing in for the posted WM_APP_RUN_COMMANDS
+static std::mutex notifyMutex;
+static std::condition_variable notifyWake;
+static bool notified = false;
+static bool clientDone = false;
+
+static void Notify() {
+    std::lock_guard<std::mutex> lock(notifyMutex);
+    notified = true;
+    notifyWake.notify_one();
+}
+
+// Run `client` on its own thread while this one serves its requests, like the message loop
+static void RunClient(CommandServer& server, const std::function<void()>& client) {
+    clientDone = false;
+    std::thread thread([&client] {
+        client();
+        std::lock_guard<std::mutex> lock(notifyMutex);
+        clientDone = true;
+        notifyWake.notify_one();
+    });
+    for (;;) {
+        bool done;
+        {
+            std::unique_lock<std::mutex> lock(notifyMutex);
+            notifyWake.wait(lock, [] { return notified || clientDone; });
+            notified = false;
+            done = clientDone;
+        }
+        while (server.Serve()) {
+        }
+        if (done) break;
+    }
+    thread.join();
+}
+
+// Snap command `i`: windows in turn, each to a different slot than its last one
+static void AppendSnap(const std::vector<WindowId>& windows, int i, std::vector<WindowState>* last, std::string* text) {
+    int w = i % WINDOWS;
+    int monitor = 1 + (w % 2);
+    WindowState state = states[(i / WINDOWS + w) % 8];
+    (*last)[w] = state;
+    char line[96];
+    std::snprintf(line, sizeof(line), "snap 0x%llx %d,%s\n", static_cast<unsigned long long>(windows[w]), monitor,
+                  SnapStateName(state));
+    *text += line;
+}
+
+int main() {
+    SimWindowSystem sim;
+    sim.AddMonitor({ 0, 0, 2560, 1440 });
+    sim.AddMonitor({ 2560, 0, 5120, 1440 });
+    std::vector<WindowId> windows;
+    for (int i = 0; i < WINDOWS; ++i) {
+        long x = (i % 2) * 2560 + 100 + (i % 10) * 40;
+        windows.push_back(sim.AddWindow({ x, 100, x + 900, 800 }));
+        sim.Window(windows.back()).className = L"AppWindow";
+    }
+    std::vector<WindowState> last(WINDOWS, WindowState::Unknown);
+
+    InitTiler(&sim);
+    RefreshMonitorCache();
+
+    char endpoint[64];
+    std::snprintf(endpoint, sizeof(endpoint), "/tmp/wintile-command-%d.sock", static_cast<int>(getpid()));
+    CommandServer server;
+    if (!server.Start(endpoint, Notify)) {
+        std::fprintf(stderr, "command_bench: cannot listen on %s\n", endpoint);
+        return 1;
+    }
+    CommandServer second;
+    BenchCheck(BENCH, !second.Start(endpoint, Notify), "a second server took over a live endpoint");
+
+    char params[128];
+
+    // One round trip per command
+    std::vector<long long> roundTrips;
+    long long roundTripNs = 0;
+    RunClient(server, [&] {
+        CommandClient client;
+        BenchCheck(BENCH, client.Connect(endpoint), "connect failed");
+        std::string line, reply;
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < COMMANDS; ++i) {
+            line.clear();
+            AppendSnap(windows, i, &last, &line);
+            BenchClock::time_point sent = BenchClock::now();
+            client.Send(line);
+            bool got = client.ReadLine(&reply);
+            roundTrips.push_back(ElapsedNs(sent));
+            if (!got || reply != "ok") BenchCheck(BENCH, false, "round trip snap failed");
+        }
+        roundTripNs = ElapsedNs(start);
+    });
+    std::snprintf(params, sizeof(params), "op=round_trip commands=%d", COMMANDS);
+    ReportSamples("command", params, roundTrips);
+
+    // Everything in one write
+    std::string pipelined;
+    for (int i = 0; i < COMMANDS; ++i) AppendSnap(windows, COMMANDS + i, &last, &pipelined);
+    long long pipelinedNs = 0;
+    long long requestsBefore = server.Requests();
+    RunClient(server, [&] {
+        CommandClient client;
+        BenchCheck(BENCH, client.Connect(endpoint), "connect failed");
+        BenchClock::time_point start = BenchClock::now();
+        client.Send(pipelined);
+        std::string reply;
+        for (int i = 0; i < COMMANDS; ++i) {
+            if (!client.ReadLine(&reply) || reply != "ok") BenchCheck(BENCH, false, "pipelined snap failed");
+        }
+        pipelinedNs = ElapsedNs(start);
+    });
+    long long pipelinedRequests = server.Requests() - requestsBefore;
+
+    // Batches of five, as one transaction each
+    std::string batched;
+    for (int b = 0; b < COMMANDS / BATCH; ++b) {
+        batched += "begin\n";
+        for (int i = 0; i < BATCH; ++i) AppendSnap(windows, 2 * COMMANDS + b * BATCH + i, &last, &batched);
+        batched += "commit\n";
+    }
+    long long batchedNs = 0;
+    sim.ResetCalls();
+    long long transactionsBefore = sim.Transactions();
+    RunClient(server, [&] {
+        CommandClient client;
+        BenchCheck(BENCH, client.Connect(endpoint), "connect failed");
+        BenchClock::time_point start = BenchClock::now();
+        client.Send(batched);
+        std::string reply;
+        for (int b = 0; b < COMMANDS / BATCH; ++b) {
+            if (!client.ReadLine(&reply) || reply != "ok 5") BenchCheck(BENCH, false, "batch not applied whole");
+        }
+        batchedNs = ElapsedNs(start);
+    });
+    long long batchTransactions = sim.Transactions() - transactionsBefore;
+    BenchCheck(BENCH, batchTransactions == COMMANDS / BATCH, "a batch took more than one placement transaction");
+    BenchCheck(BENCH, sim.Calls(SimCall::SetWindowPos) == 0, "a batched snap was placed on its own");
+
+    auto perSecond = [](long long commands, long long ns) { return ns ? commands * 1000000000LL / ns : 0; };
+    std::printf("bench=command op=round_trip commands=%d commands_per_s=%lld\n", COMMANDS, perSecond(COMMANDS, roundTripNs));
+    std::printf("bench=command op=pipelined commands=%d requests=%lld commands_per_s=%lld\n", COMMANDS,
+                pipelinedRequests, perSecond(COMMANDS, pipelinedNs));
+    std::printf("bench=command op=batched commands=%d batch=%d transactions=%lld commands_per_s=%lld\n", COMMANDS,
+                BATCH, batchTransactions, perSecond(COMMANDS, batchedNs));
+    BenchCheck(BENCH, pipelinedNs < roundTripNs, "pipelining was not faster than round trips");
+
+    // Protocol: replies pair up with lines, a failed batch changes nothing, queries
+    std::vector<std::string> replies;
+    RunClient(server, [&] {
+        CommandClient client;
+        BenchCheck(BENCH, client.Connect(endpoint), "connect failed");
+        char window[32];
+        std::snprintf(window, sizeof(window), "0x%llx", static_cast<unsigned long long>(windows[0]));
+        std::string text;
+        text += "# a comment, no reply\n\n";
+        text += "bogus\n";
+        text += "snap " + std::string(window) + " sideways\n";
+        text += "snap 0x7fffffff left_half\n";
+        text += "dump_latency\n";
+        text += std::string(COMMAND_MAX_LINE + 10, 'x') + "\n";
+        text += "begin\nsnap " + std::string(window) + " maximized\nfill\ncommit\n";
+        text += "commit\n";
+        text += "query " + std::string(window) + "\r\n";
+        text += "focus " + std::string(window) + "\n";
+        client.Send(text);
+        std::string reply;
+        for (int i = 0; i < 9 && client.ReadLine(&reply); ++i) replies.push_back(reply);
+    });
+    const char* expected[] = {
+        "error unknown command 'bogus'",
+        "error unknown snap state 'sideways'",
+        "error window not snapped",
+        "error 'dump_latency' is a hotkey only",
+        "error line longer than 256 characters",
+        "error line 10: only snap lines in a batch",
+        "error commit without begin",
+        nullptr,  // query: the last state of window 0
+        "ok",
+    };
+    std::string query = std::string("ok ") + SnapStateName(last[0]);
+    BenchCheck(BENCH, replies.size() == 9, "wrong number of protocol replies");
+    for (size_t i = 0; i < replies.size() && i < 9; ++i) {
+        const char* want = expected[i] ? expected[i] : query.c_str();
+        if (replies[i] != want) {
+            std::fprintf(stderr, "command_bench: reply %zu is '%s', want '%s'\n", i, replies[i].c_str(), want);
+            BenchCheck(BENCH, false, "protocol reply differs");
+        }
+    }
+    BenchCheck(BENCH, sim.ForegroundWindow() == windows[0], "focus did not activate the window");
+
+    for (int w = 0; w < WINDOWS; ++w) {
+        if (TrackedWindowState(windows[w]) != last[w]) {
+            BenchCheck(BENCH, false, "a window is not in the state its last command gave it");
+            break;
+        }
+    }
+
+    server.Stop();
+    ShutdownTiler();
+    BenchCheck(BENCH, access(endpoint, F_OK) != 0, "the socket file was left behind");
+    std::printf("bench=command_check requests=%lld commands=%lld failures=%d\n", server.Requests(), server.Commands(), benchFailures);
+    return benchFailures ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+// Config parser fuzz run. Mutates a seed corpus (the formatted defaults plus hand-written
+// files with every kind of line) by flipping, inserting and deleting bytes, splicing files and
+// inserting dictionary tokens, and feeds each result to ParseConfig. Every accepted file must
+// yield a snapshot within the validation limits that formats and re-parses to the same
+// settings; every rejected file must leave the output untouched and name the offending line.
+// Deterministic (fixed seed); exits non-zero on the first violations.
+//
+// Usage: config_fuzz [iterations]   (default 200000)
+
+#include "bench_util.h"
+#include "config.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+static const char* const seeds[] = {
+    "border_width = 3\npadding = 0\nborder_color = #ff8800\nanimation_ms = 150\n",
+    "# comment\n\n  exclude_class = Chrome_WidgetWin_1  \r\nexclude_class = \xc3\xa9t\xc3\xa9\n",
+    "bind = ctrl+alt+h snap_left\nbind = Win+Shift+F12 fill\nbind = alt+period grow_width\n",
+    "bind =\nexclude_class =\n",
+    "padding = 128\nborder_width = 32\nbind = ctrl+space arrange_grid\nbind = ctrl+alt+0 workspace_4\n",
+    "bind = ctrl+alt+left monitor_left\nbind = ctrl+alt+backslash dump_timeline\n",
+    "rule = process=steam.exe title=\"Friends List\" no_tile no_border\nrule = class=Chrome_* place=2,right_half\n",
+    "rule = title=\"* - Notepad\" place=maximized\nrule = process=*.tmp.exe no_border\nrule =\n",
+    "session = coding process=code.exe place=1,left_half\nsession = coding class=CASCADIA* place=top_right\n"
+    "session = review-2 title=\"Pull request*\" place=maximized\n",
+};
+
+static const char* const tokens[] = {
+    "\n", "=", " ", "\t", "\r\n", "#", "+", "\0", "border_width", "padding", "border_color",
+    "animation_ms",
+    "exclude_class", "bind", "ctrl+", "alt+", "shift+", "win+", "ctrl+alt+", "snap_left",
+    "move_to_workspace_3", "f24", "f25", "f0", "pagedown", "#00FF00", "#12345", "999", "0033",
+    "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xc0\xaf", "\xed\xa0\x80", "\xff", "\x80",
+    "exclude_class = ", "bind = ctrl+alt+", " snap_up\n",
+    "rule = ", "process=", "class=", "title=", "\"", " no_tile", " no_border", " place=", "3,", "top_left",
+    "*", "?", "rule = process=a.exe no_tile\n",
+    "session = ", "session = a ", "coding", "session = b process=x.exe place=left_half\n",
+};
+
+static bool SameConfig(const Config& a, const Config& b) {
+    return a.borderWidth == b.borderWidth && a.padding == b.padding && a.borderColor == b.borderColor &&
+           a.animationMs == b.animationMs && a.excludedClasses == b.excludedClasses && a.hotkeys == b.hotkeys && a.rules == b.rules &&
+           a.sessions == b.sessions;
+}
+
+// What ParseConfig promises about an accepted file
+static bool WithinLimits(const Config& config, std::string* why) {
+    if (config.borderWidth < 0 || config.borderWidth > CONFIG_MAX_BORDER_WIDTH) *why = "border_width out of range";
+    if (config.padding < 0 || config.padding > CONFIG_MAX_PADDING) *why = "padding out of range";
+    if (config.borderColor > 0xFFFFFF) *why = "border_color out of range";
+    if (config.animationMs < 0 || config.animationMs > CONFIG_MAX_ANIMATION_MS) *why = "animation_ms out of range";
+    for (const std::wstring& name : config.excludedClasses) {
+        if (name.empty() || name.size() > CONFIG_MAX_CLASS_NAME) *why = "bad exclude_class length";
+        for (wchar_t c : name) {
+            if (static_cast<unsigned>(c) < 0x20) *why = "control character in exclude_class";
+        }
+    }
+    if (config.hotkeys.size() > CONFIG_MAX_BINDINGS) *why = "too many bindings";
+    for (size_t i = 0; i < config.hotkeys.size(); ++i) {
+        const HotkeyBinding& binding = config.hotkeys[i];
+        if (!(binding.modifiers & (CONFIG_MOD_CONTROL | CONFIG_MOD_ALT | CONFIG_MOD_WIN))) *why = "binding without modifier";
+        if (binding.command >= HotkeyCommand::Count) *why = "bad command";
+        if (binding.key == 0 || binding.key > 0xFF) *why = "bad key";
+        for (size_t j = 0; j < i; ++j) {
+            if (config.hotkeys[j].modifiers == binding.modifiers && config.hotkeys[j].key == binding.key) {
+                *why = "chord bound twice";
+            }
+        }
+    }
+    if (config.rules.size() > CONFIG_MAX_RULES) *why = "too many rules";
+    for (const WindowRule& rule : config.rules) {
+        if (rule.process.empty() && rule.className.empty() && rule.title.empty()) *why = "rule matches nothing";
+        for (const std::wstring* pattern : { &rule.process, &rule.className, &rule.title }) {
+            if (pattern->size() > CONFIG_MAX_PATTERN) *why = "rule pattern too long";
+            if (pattern->find(L'"') != std::wstring::npos) *why = "quote in rule pattern";
+        }
+        if (!rule.actions || rule.actions > (RULE_NO_TILE | RULE_NO_BORDER | RULE_PLACE)) *why = "bad rule actions";
+        if ((rule.actions & RULE_PLACE) && (rule.state == WindowState::Unknown || rule.monitor < 0 ||
+                                            rule.monitor > CONFIG_MAX_RULE_MONITOR)) {
+            *why = "bad rule placement";
+        }
+    }
+    if (config.sessions.size() > CONFIG_MAX_SESSIONS) *why = "too many sessions";
+    for (const LayoutSession& session : config.sessions) {
+        if (session.name.empty() || session.name.size() > CONFIG_MAX_SESSION_NAME) *why = "bad session name length";
+        if (session.entries.empty() || session.entries.size() > CONFIG_MAX_SESSION_ENTRIES) *why = "bad session size";
+        for (const WindowRule& entry : session.entries) {
+            if (entry.actions != RULE_PLACE || entry.state == WindowState::Unknown) *why = "session entry without a placement";
+        }
+    }
+    return why->empty();
+}
+
+static void Mutate(std::mt19937_64& rng, const std::vector<std::string>& corpus, std::string* text) {
+    int steps = 1 + static_cast<int>(rng() % 4);
+    for (int step = 0; step < steps; ++step) {
+        size_t at = text->empty() ? 0 : static_cast<size_t>(rng() % (text->size() + 1));
+        switch (rng() % 6) {
+            case 0:  // Flip a byte
+                if (!text->empty()) (*text)[at % text->size()] ^= static_cast<char>(1 << (rng() % 8));
+                break;
+            case 1:  // Random byte
+                text->insert(at, 1, static_cast<char>(rng() % 256));
+                break;
+            case 2:  // Delete a range
+                if (!text->empty()) text->erase(at % text->size(), 1 + rng() % 8);
+                break;
+            case 3: {  // Dictionary token
+                const char* token = tokens[rng() % (sizeof(tokens) / sizeof(tokens[0]))];
+                text->insert(at, token, std::max<size_t>(1, std::strlen(token)));
+                break;
+            }
+            case 4: {  // Splice in part of another file
+                const std::string& other = corpus[rng() % corpus.size()];
+                size_t from = other.empty() ? 0 : static_cast<size_t>(rng() % other.size());
+                text->insert(at, other, from, 1 + rng() % 40);
+                break;
+            }
+            case 5:  // Repeat a line (duplicate settings and bindings)
+                if (!text->empty()) {
+                    size_t begin = text->rfind('\n', at % text->size());
+                    begin = begin == std::string::npos ? 0 : begin + 1;
+                    size_t end = text->find('\n', begin);
+                    std::string line = text->substr(begin, end == std::string::npos ? std::string::npos : end - begin + 1);
+                    text->insert(begin, line);
+                }
+                break;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    long long iterations = argc > 1 ? std::atoll(argv[1]) : 200000;
+
+    std::vector<std::string> corpus;
+    Config defaults;
+    DefaultConfig(&defaults);
+    corpus.emplace_back();
+    FormatConfig(defaults, &corpus.back());
+    for (const char* seed : seeds) corpus.emplace_back(seed);
+
+    // Every seed is a valid file
+    int failures = 0;
+    for (const std::string& seed : corpus) {
+        Config config;
+        std::string error;
+        if (!ParseConfig(seed.data(), seed.size(), &config, &error)) {
+            std::fprintf(stderr, "config_fuzz: seed rejected: %s\n", error.c_str());
+            ++failures;
+        }
+    }
+
+    std::mt19937_64 rng(41);
+    long long accepted = 0, rejected = 0, bytes = 0;
+    BenchClock::time_point start = BenchClock::now();
+    for (long long i = 0; i < iterations && failures < 10; ++i) {
+        std::string text = corpus[rng() % corpus.size()];
+        Mutate(rng, corpus, &text);
+        bytes += static_cast<long long>(text.size());
+
+        Config config;
+        config.borderWidth = -1;  // Never produced by the parser, so any write shows
+        std::string error, why;
+        if (!ParseConfig(text.data(), text.size(), &config, &error)) {
+            ++rejected;
+            if (error.compare(0, 5, "line ") != 0) why = "error does not name a line: " + error;
+            if (config.borderWidth != -1) why = "rejected file changed the output";
+        } else {
+            ++accepted;
+            if (WithinLimits(config, &why)) {
+                std::string formatted;
+                FormatConfig(config, &formatted);
+                Config reparsed;
+                if (!ParseConfig(formatted.data(), formatted.size(), &reparsed, &error)) {
+                    why = "formatted config rejected: " + error;
+                } else if (!SameConfig(config, reparsed)) {
+                    why = "formatted config parses differently";
+                }
+            }
+            // Keep interesting accepted files as seeds, so mutations go deeper
+            if (corpus.size() < 256 && rng() % 64 == 0) corpus.push_back(text);
+        }
+
+        if (!why.empty()) {
+            ++failures;
+            std::fprintf(stderr, "config_fuzz: iteration %lld: %s\n--- input (%zu bytes) ---\n%s\n---\n", i,
+                         why.c_str(), text.size(), text.c_str());
+        }
+    }
+    long long elapsedNs = ElapsedNs(start);
+
+    std::printf("bench=config_fuzz iterations=%lld accepted=%lld rejected=%lld corpus=%zu mb_per_s=%.1f failures=%d\n",
+                accepted + rejected, accepted, rejected, corpus.size(),
+                elapsedNs > 0 ? bytes * 1000.0 / elapsedNs : 0.0, failures);
+    return failures ? 1 : 0;
+}
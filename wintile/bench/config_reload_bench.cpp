@@ -0,0 +1,183 @@
+// Config reload against hotkey handling. Hotkeys (snaps and monitor switches on a simulated
+// two-monitor desktop) run on one thread while a second thread re-parses and publishes a large
+// config (200 excluded classes, every binding) every 250 us, far more often than any editor
+// saves. Each hotkey reads the settings through the published snapshot and must always see a
+// consistent one. For contrast the same reload is also run inline, on the hotkey thread
+// before every 10th press, the way a reload handled in the message loop would delay hotkeys.
+// At the end a new border width must reach the focus border. Exits non-zero on any mismatch.
+
+#include "bench_util.h"
+#include "config.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+#include <atomic>
+#include <thread>
+
+static const int PRESSES = 20000;
+static const int CLASSES = 200;
+
+static const SnapDirection directions[] = {
+    SnapDirection::Left, SnapDirection::Up, SnapDirection::Right, SnapDirection::Down
+};
+
+// Config file of reload `i`: padding and border width change together, so a reader can tell a
+// consistent snapshot from a mix of two
+static std::string ConfigText(int i) {
+    int odd = i % 2;
+    std::string text = "border_width = " + std::to_string(2 + odd) + "\n";
+    text += "padding = " + std::to_string(4 + 4 * odd) + "\n";
+    text += "border_color = #6495ED\n";
+    for (int c = 0; c < CLASSES; ++c) text += "exclude_class = VendorToolWindow" + std::to_string(c) + "\n";
+    Config defaults;
+    DefaultConfig(&defaults);
+    for (const HotkeyBinding& binding : defaults.hotkeys) {
+        text += "bind = ";
+        FormatHotkey(binding, &text);
+        text += " ";
+        text += HotkeyCommandName(binding.command);
+        text += "\n";
+    }
+    return text;
+}
+
+static bool Reload(const std::string& text) {
+    std::unique_ptr<Config> config = std::make_unique<Config>();
+    if (!ParseConfig(text.data(), text.size(), config.get(), nullptr)) return false;
+    PublishConfig(std::move(config));
+    return true;
+}
+
+struct Desktop {
+    SimWindowSystem sim;
+    std::vector<WindowId> windows;
+
+    Desktop() {
+        sim.AddMonitor({ 0, 0, 1920, 1080 });
+        sim.AddMonitor({ 1920, 0, 3840, 1080 });
+        for (int i = 0; i < 24; ++i) {
+            long x = 1920L * (i % 2) + 40L * (i % 12);
+            windows.push_back(sim.AddWindow({ x, 60, x + 800, 660 }));
+        }
+        InitTiler(&sim);
+        RefreshMonitorCache();
+        Focus(windows.back());
+    }
+
+    ~Desktop() { ShutdownTiler(); }
+
+    void Focus(WindowId window) {
+        sim.SetForeground(window);
+        const Rect& r = sim.Window(window).rect;
+        sim.SetCursorPoint({ r.left + RectWidth(r) / 2, r.top + RectHeight(r) / 2 });
+        UpdateFocusedWindow();
+    }
+
+    void Press(int i) {
+        if (i % 50 == 49) Focus(windows[(i / 50) % windows.size()]);
+        SnapDirection direction = directions[(i * 7 / 3) % 4];
+        if (i % 10 == 7) {
+            HandleMonitorSwitch(direction == SnapDirection::Left ? SnapDirection::Left : SnapDirection::Right);
+        } else {
+            HandleSnapRequest(direction);
+        }
+    }
+};
+
+struct Run {
+    std::vector<long long> samples;
+    long long reloads = 0;
+    long long inconsistent = 0;  // Hotkeys that saw padding and border width of different reloads
+};
+
+// mode 0: no reloads, 1: reload thread, 2: reload inline before every 10th press
+static void RunPresses(int mode, const std::string texts[2], Run* run) {
+    Desktop desktop;
+    std::atomic<bool> stop(false);
+    std::atomic<long long> reloads(0);
+    std::thread reloader;
+    if (mode == 1) {
+        reloader = std::thread([&] {
+            for (int i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+                if (Reload(texts[i % 2])) reloads.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::sleep_for(std::chrono::microseconds(250));
+            }
+        });
+    }
+
+    run->samples.reserve(PRESSES);
+    for (int i = 0; i < PRESSES; ++i) {
+        BenchClock::time_point start = BenchClock::now();
+        if (mode == 2 && i % 10 == 0 && Reload(texts[(i / 10) % 2])) reloads.fetch_add(1, std::memory_order_relaxed);
+        desktop.Press(i);
+        const Config& config = CurrentConfig();
+        bool consistent = config.borderWidth - 2 == (config.padding - 4) / 4;
+        run->samples.push_back(ElapsedNs(start));
+
+        if (!consistent) ++run->inconsistent;
+        ReleaseRetiredConfigs();  // Between messages, as the main loop does
+    }
+
+    stop = true;
+    if (reloader.joinable()) reloader.join();
+    ReleaseRetiredConfigs();
+    run->reloads = reloads.load();
+}
+
+int main() {
+    const std::string texts[2] = { ConfigText(0), ConfigText(1) };
+    int failures = 0;
+
+    // Cost of one reload on its own
+    std::vector<long long> parses;
+    for (int i = 0; i < 2000; ++i) {
+        Config config;
+        BenchClock::time_point start = BenchClock::now();
+        if (!ParseConfig(texts[i % 2].data(), texts[i % 2].size(), &config, nullptr)) ++failures;
+        parses.push_back(ElapsedNs(start));
+    }
+    char params[128];
+    std::snprintf(params, sizeof(params), "op=parse bytes=%zu classes=%d bindings=%zu", texts[0].size(), CLASSES,
+                  CurrentConfig().hotkeys.size());
+    ReportSamples("config_reload", params, parses);
+
+    Run quiet, threaded, inlined;
+    RunPresses(0, texts, &quiet);
+    RunPresses(1, texts, &threaded);
+    RunPresses(2, texts, &inlined);
+
+    const char* names[] = { "none", "watcher_thread", "inline" };
+    Run* runs[] = { &quiet, &threaded, &inlined };
+    for (int mode = 0; mode < 3; ++mode) {
+        std::snprintf(params, sizeof(params), "op=hotkey reload=%s reloads=%lld inconsistent=%lld", names[mode],
+                      runs[mode]->reloads, runs[mode]->inconsistent);
+        ReportSamples("config_reload", params, runs[mode]->samples);  // Sorts the samples
+        if (runs[mode]->inconsistent) ++failures;
+    }
+
+    // Off the hot path the p99 hotkey stays below the one that pays for reloads; only
+    // meaningful when the reload thread has a core of its own
+    long long threadedP99 = Percentile(threaded.samples, 0.99);
+    long long inlineP99 = Percentile(inlined.samples, 0.99);
+    bool latencyOk = std::thread::hardware_concurrency() < 2 || threadedP99 < inlineP99;
+    if (threaded.reloads == 0 || !latencyOk) ++failures;
+
+    // A new border width reaches the focus border
+    Desktop desktop;
+    std::string text = "border_width = 5\n";
+    bool reloaded = Reload(text);
+    RefreshFocusedBorder();
+    ReleaseRetiredConfigs();
+    const Rect& r = desktop.sim.Window(desktop.windows.back()).rect;
+    Rect expected = { r.left - 5, r.top - 5, r.right + 5, r.bottom + 5 };
+    bool borderOk = false;
+    for (WindowId id = 1; id <= desktop.sim.WindowCount(); ++id) {
+        const SimWindow& w = desktop.sim.Window(id);
+        if (w.border && w.alive) borderOk = w.rect == expected;
+    }
+    if (!reloaded || !borderOk) ++failures;
+
+    std::printf("bench=config_reload_check threaded_p99_ns=%lld inline_p99_ns=%lld latency_ok=%d border_follows=%d failures=%d\n",
+                threadedP99, inlineP99, latencyOk ? 1 : 0, borderOk ? 1 : 0, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,263 @@
+// Hotkey latency under a window-event storm. A browser restoring 30 windows fires a show, a
+// move/size end and a foreground event per window within a couple of milliseconds; hotkeys
+// arrive in the middle of it. The storm is replayed on a virtual clock twice: handled strictly
+// in arrival order, and through the two-level dispatch of the message loop (hotkeys first,
+// queued event work in batches of EVENT_BATCH_SIZE). A quiet run without events gives the
+// baseline. The clock advances by OS_CALL_NS per recorded OS call, roughly what a
+// cross-process user32 call costs on a busy desktop; the handlers' own time is orders of
+// magnitude below that and is left out, so preemption of the bench cannot skew the result.
+//
+// Fails if a hotkey under two-level dispatch ever waits longer than the longest single batch
+// of event work, i.e. for more than the batch already running when it arrived. Also fails if
+// an overflowing storm reorders events: the focused window is hidden, enough other events
+// arrive to fill the queue, and its re-show (which overflows it) must leave it with a border.
+
+#include "bench_util.h"
+#include "event_queue.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+#include <deque>
+
+static const int BROWSER_WINDOWS = 30;
+static const int STORMS = 200;
+static const long long EVENT_GAP_NS = 20000;    // A storm event every 20 us
+static const long long HOTKEY_GAP_NS = 400000;  // A keypress every 0.4 ms during the storm
+static const long long OS_CALL_NS = 20000;
+
+enum class Dispatch { Quiet, InOrder, TwoLevel };
+
+static const char* DispatchName(Dispatch dispatch) {
+    switch (dispatch) {
+        case Dispatch::Quiet: return "quiet";
+        case Dispatch::InOrder: return "in_order";
+        default: return "two_level";
+    }
+}
+
+struct Item {
+    long long arrivalNs;
+    bool hotkey;
+    WindowEvent event;
+    WindowId window;
+    SnapDirection direction;
+};
+
+struct Storm {
+    SimWindowSystem sim;
+    std::vector<WindowId> browser;
+    std::vector<WindowId> others;
+
+    Storm() {
+        sim.AddMonitor({ 0, 0, 1920, 1080 });
+        sim.AddMonitor({ 1920, 0, 3840, 1080 });
+        for (int i = 0; i < 10; ++i) {
+            long x = 1920 + 50 * i;
+            others.push_back(sim.AddWindow({ x, 100, x + 800, 700 }));
+        }
+        for (int i = 0; i < BROWSER_WINDOWS; ++i) {
+            long x = 20 * i;
+            browser.push_back(sim.AddWindow({ x, 50 + 10 * i, x + 900, 750 + 10 * i }));
+        }
+        InitTiler(&sim);
+        ClearWindowEvents();
+        RefreshMonitorCache();
+    }
+
+    ~Storm() { ShutdownTiler(); }
+
+    // Minimize the browser again between storms, with the cursor on another window
+    void Reset(int round) {
+        for (WindowId window : browser) {
+            sim.Window(window).visible = false;
+            HandleWindowHidden(window);
+        }
+        WindowId target = others[round % others.size()];
+        sim.SetForeground(target);
+        const Rect& r = sim.Window(target).rect;
+        sim.SetCursorPoint({ r.left + RectWidth(r) / 2, r.top + RectHeight(r) / 2 });
+        UpdateFocusedWindow();
+    }
+
+    // One storm in arrival order: show, move/size end and foreground per browser window, with
+    // hotkeys interleaved. The quiet variant has the hotkeys only.
+    std::vector<Item> Script(int round, bool events) {
+        std::vector<Item> items;
+        long long end = 3LL * BROWSER_WINDOWS * EVENT_GAP_NS;
+        if (events) {
+            long long t = 0;
+            for (WindowId window : browser) {
+                items.push_back({ t, false, WindowEvent::Shown, window, SnapDirection::Left });
+                items.push_back({ t + EVENT_GAP_NS, false, WindowEvent::Shown, window, SnapDirection::Left });
+                items.push_back({ t + 2 * EVENT_GAP_NS, false, WindowEvent::Foreground, window, SnapDirection::Left });
+                t += 3 * EVENT_GAP_NS;
+            }
+        }
+        int presses = 0;
+        for (long long t = HOTKEY_GAP_NS / 2; t < end; t += HOTKEY_GAP_NS, ++presses) {
+            SnapDirection direction = static_cast<SnapDirection>((round + presses) % 4);
+            items.push_back({ t, true, WindowEvent::Count, 0, direction });
+        }
+        std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.arrivalNs < b.arrivalNs; });
+        return items;
+    }
+
+    // What the OS did when the item arrived: the window became visible / took focus
+    void Arrive(const Item& item) {
+        if (item.hotkey) return;
+        if (item.event == WindowEvent::Shown) sim.Window(item.window).visible = true;
+        if (item.event == WindowEvent::Foreground) sim.SetForeground(item.window);
+    }
+};
+
+struct Result {
+    std::vector<long long> latency;  // Hotkey arrival to hotkey done, ns
+    long long maxWaitNs = 0;         // Longest a hotkey waited before it started
+    long long maxEventStepNs = 0;    // Longest single event handler / drain batch
+    long long eventsHandled = 0;
+};
+
+// Whether the focused window's border is up
+static bool BorderShown(SimWindowSystem& sim) {
+    for (size_t i = 1; i <= sim.WindowCount(); ++i) {
+        const SimWindow& w = sim.Window(static_cast<WindowId>(i));
+        if (w.border && w.alive && w.visible) return true;
+    }
+    return false;
+}
+
+// Hide and re-show the focused window with a full queue between the two events
+static bool OverflowKeepsOrder(Storm& storm) {
+    storm.Reset(0);
+    WindowId focused = storm.others[0];
+    if (!BorderShown(storm.sim)) return false;
+    ClearWindowEvents();
+    ResetWindowEventStats();
+
+    storm.sim.Window(focused).visible = false;
+    QueueWindowEvent(WindowEvent::Hidden, focused);
+    for (int i = 0; i < EVENT_QUEUE_CAPACITY; ++i) {
+        QueueWindowEvent(WindowEvent::Renamed, storm.browser[i % 2]);  // Alternating, so none coalesce
+    }
+    storm.sim.Window(focused).visible = true;
+    QueueWindowEvent(WindowEvent::Shown, focused);
+    while (DrainWindowEvents(EVENT_BATCH_SIZE)) {
+    }
+    std::printf("bench=event_storm_overflow overflowed=%lld border=%d\n", WindowEventStats().overflowed,
+                BorderShown(storm.sim) ? 1 : 0);
+    return WindowEventStats().overflowed > 0 && BorderShown(storm.sim);
+}
+
+static void Run(Storm& storm, Dispatch dispatch, Result* result) {
+    for (int round = 0; round < STORMS; ++round) {
+        storm.Reset(round);
+        ResetWindowEventStats();
+        std::vector<Item> items = storm.Script(round, dispatch != Dispatch::Quiet);
+
+        long long clock = 0;
+        long long handled = 0;  // Events handled so far this storm
+        size_t arrived = 0;
+        std::deque<Item*> inOrder;  // Arrived, not yet handled (in-order dispatch)
+        std::deque<Item*> hotkeys;  // Arrived hotkeys (two-level dispatch)
+
+        auto advance = [&] {
+            while (arrived < items.size() && items[arrived].arrivalNs <= clock) {
+                Item& item = items[arrived++];
+                storm.Arrive(item);
+                if (dispatch == Dispatch::TwoLevel && !item.hotkey) {
+                    QueueWindowEvent(item.event, item.window);
+                } else if (dispatch == Dispatch::TwoLevel) {
+                    hotkeys.push_back(&item);
+                } else {
+                    inOrder.push_back(&item);
+                }
+            }
+        };
+
+        // Run a handler and advance the clock by its OS calls; returns that time
+        auto step = [&](auto fn) {
+            long long calls = storm.sim.TotalCalls();
+            fn();
+            long long ns = (storm.sim.TotalCalls() - calls) * OS_CALL_NS;
+            clock += ns;
+            return ns;
+        };
+
+        auto runHotkey = [&](Item* item) {
+            result->maxWaitNs = std::max(result->maxWaitNs, clock - item->arrivalNs);
+            step([&] { HandleSnapRequest(item->direction); });
+            result->latency.push_back(clock - item->arrivalNs);
+        };
+
+        auto runEvents = [&](auto fn) {
+            result->maxEventStepNs = std::max(result->maxEventStepNs, step(fn));
+        };
+
+        for (;;) {
+            advance();
+            if (dispatch == Dispatch::TwoLevel) {
+                if (!hotkeys.empty()) {
+                    Item* item = hotkeys.front();
+                    hotkeys.pop_front();
+                    runHotkey(item);
+                } else if (WindowEventsPending()) {
+                    runEvents([&] { handled += static_cast<long long>(DrainWindowEvents(EVENT_BATCH_SIZE)); });
+                } else if (arrived < items.size()) {
+                    clock = items[arrived].arrivalNs;  // Idle until the next arrival
+                } else {
+                    break;
+                }
+            } else {
+                if (!inOrder.empty()) {
+                    Item* item = inOrder.front();
+                    inOrder.pop_front();
+                    if (item->hotkey) {
+                        runHotkey(item);
+                    } else {
+                        runEvents([&] { ApplyWindowEvent(item->event, item->window); });
+                        handled += 1;
+                    }
+                } else if (arrived < items.size()) {
+                    clock = items[arrived].arrivalNs;
+                } else {
+                    break;
+                }
+            }
+        }
+        result->eventsHandled += handled + WindowEventStats().overflowed;
+    }
+}
+
+int main() {
+    Storm storm;
+    Result results[3];
+    const Dispatch dispatches[] = { Dispatch::Quiet, Dispatch::InOrder, Dispatch::TwoLevel };
+    for (int i = 0; i < 3; ++i) Run(storm, dispatches[i], &results[i]);
+
+    long long quietP99 = 0;
+    for (int i = 0; i < 3; ++i) {
+        Result& result = results[i];
+        std::sort(result.latency.begin(), result.latency.end());
+        long long p99 = Percentile(result.latency, 0.99);
+        if (dispatches[i] == Dispatch::Quiet) quietP99 = p99;
+
+        char params[256];
+        std::snprintf(params, sizeof(params), "dispatch=%s storms=%d browser_windows=%d events_handled=%lld max_wait_ns=%lld max_event_step_ns=%lld p99_vs_quiet=%.2f",
+                      DispatchName(dispatches[i]), STORMS, BROWSER_WINDOWS, result.eventsHandled,
+                      result.maxWaitNs, result.maxEventStepNs,
+                      quietP99 ? static_cast<double>(p99) / quietP99 : 0.0);
+        ReportSamples("event_storm_hotkey", params, result.latency);
+    }
+
+    const Result& twoLevel = results[2];
+    if (twoLevel.maxWaitNs > twoLevel.maxEventStepNs) {
+        std::fprintf(stderr, "dispatch: a hotkey waited %lld ns, longer than one event batch (%lld ns)\n",
+                     twoLevel.maxWaitNs, twoLevel.maxEventStepNs);
+        return 1;
+    }
+    if (!OverflowKeepsOrder(storm)) {
+        std::fprintf(stderr, "dispatch: an overflowing queue lost the border of a re-shown window\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+// Focus-flap replay: foreground sequences recorded from Alt+Tab (tap, cancel, held, rapid
+// switching), UWP app activation and a notification toast, replayed on a virtual clock
+// against the simulated window system. Each sequence runs once with the border following
+// every foreground change and once through the focus settle timer; the settled run must end
+// with the border on the final window, update it once per burst and suppress the rest.
+// Exits non-zero on any mismatch.
+
+#include "config.h"
+#include "focus_settle.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+#include <cstdio>
+
+static const long long SETTLE_NS = 40000000;  // 40 ms
+
+enum Role { AppA, AppB, AppC, Switcher, Toast, UwpFrame, UwpCore, RoleCount };
+
+struct Step {
+    int atMs;
+    Role role;
+};
+
+struct Sequence {
+    const char* name;
+    Step steps[8];
+    int stepCount;
+    // Expected with a 40 ms settle time; every sequence starts with AppA settled
+    long long settled;
+    long long suppressed;
+    long long reverted;
+};
+
+static const Sequence sequences[] = {
+    // Alt+Tab tapped: the switcher takes the foreground for a few ms
+    { "alt_tab_tap", { { 0, Switcher }, { 6, AppB } }, 2, 1, 1, 0 },
+    // Alt+Tab released on the window it started from
+    { "alt_tab_cancel", { { 0, Switcher }, { 9, AppA } }, 2, 1, 1, 1 },
+    // Alt held while Tab cycles inside the switcher, released on C
+    { "alt_tab_held", { { 0, Switcher }, { 420, AppC } }, 2, 2, 0, 0 },
+    // Three quick Alt+Tabs in a row, ending where they started
+    { "alt_tab_rapid", { { 0, Switcher }, { 5, AppB }, { 30, Switcher }, { 36, AppC }, { 60, Switcher }, { 66, AppA } }, 6, 1, 5, 1 },
+    // Frame host, core window, frame host again
+    { "uwp_activation", { { 0, UwpFrame }, { 2, UwpCore }, { 5, UwpFrame } }, 3, 1, 2, 0 },
+    // A toast grabs the foreground and hands it back
+    { "toast", { { 0, Toast }, { 14, AppA } }, 2, 1, 1, 1 },
+    // Deliberate switching, slower than the settle time: nothing to suppress
+    { "deliberate", { { 0, AppB }, { 250, AppC }, { 500, AppA } }, 3, 3, 0, 0 },
+};
+
+struct Replay {
+    SimWindowSystem sim;
+    WindowId windows[RoleCount];
+
+    Replay() {
+        sim.AddMonitor({ 0, 0, 1920, 1080 });
+        windows[AppA] = sim.AddWindow({ 100, 100, 900, 700 });
+        windows[AppB] = sim.AddWindow({ 200, 150, 1000, 750 });
+        windows[AppC] = sim.AddWindow({ 1000, 100, 1800, 700 });
+        windows[Switcher] = sim.AddWindow({ 300, 400, 1600, 680 });
+        sim.Window(windows[Switcher]).exStyle = WINDOW_EXSTYLE_TOOLWINDOW;
+        sim.Window(windows[Switcher]).className = L"XamlExplorerHostIslandWindow";
+        windows[Toast] = sim.AddWindow({ 1500, 900, 1900, 1040 });
+        sim.Window(windows[Toast]).exStyle = WINDOW_EXSTYLE_TOOLWINDOW;
+        windows[UwpFrame] = sim.AddWindow({ 400, 200, 1400, 900 });
+        sim.Window(windows[UwpFrame]).className = L"ApplicationFrameWindow";
+        windows[UwpCore] = sim.AddWindow({ 400, 232, 1400, 900 });
+        sim.Window(windows[UwpCore]).style = 0;
+        sim.Window(windows[UwpCore]).className = L"Windows.UI.Core.CoreWindow";
+        InitTiler(&sim);
+        RefreshMonitorCache();
+    }
+
+    ~Replay() { ShutdownTiler(); }
+
+    // AppA focused with its border, nothing pending
+    void Start() {
+        ClearFocusSettle();
+        sim.SetForeground(windows[AppA]);
+        UpdateFocusedWindow();
+        SettleFocus(NoteForegroundChange(windows[AppA], 0));
+        ResetFocusSettleStats();
+        sim.ResetCalls();
+    }
+
+    // Borders created plus destroyed
+    long long BorderRebuilds() const {
+        return sim.Calls(SimCall::CreateWindowExW) + sim.Calls(SimCall::DestroyWindow);
+    }
+
+    // The single live border surrounds `window`, or there is none if it gets no border
+    bool BorderOn(WindowId window) {
+        int borders = 0;
+        bool around = false;
+        const Rect& r = sim.Window(window).rect;
+        int width = CurrentConfig().borderWidth;
+        Rect expected = { r.left - width, r.top - width, r.right + width, r.bottom + width };
+        for (WindowId id = 1; id <= sim.WindowCount(); ++id) {
+            const SimWindow& w = sim.Window(id);
+            if (!w.border || !w.alive) continue;
+            ++borders;
+            around = w.rect == expected;
+        }
+        return ShouldWindowHaveBorder(window) ? borders == 1 && around : borders == 0;
+    }
+
+    // Border follows every foreground change
+    void PlayImmediate(const Sequence& sequence) {
+        for (int i = 0; i < sequence.stepCount; ++i) {
+            sim.SetForeground(windows[sequence.steps[i].role]);
+            UpdateFocusedWindow();
+        }
+    }
+
+    // Border follows once the settle timer fires; the timer fires at its deadline unless the
+    // next change comes first and re-arms it
+    void PlaySettled(const Sequence& sequence) {
+        for (int i = 0; i < sequence.stepCount; ++i) {
+            long long now = 1000000LL * sequence.steps[i].atMs;
+            if (FocusSettlePending() && FocusSettleDeadline() <= now) {
+                if (SettleFocus(FocusSettleDeadline())) UpdateFocusedWindow();
+            }
+            WindowId window = windows[sequence.steps[i].role];
+            sim.SetForeground(window);
+            NoteForegroundChange(window, now);
+        }
+        if (SettleFocus(FocusSettleDeadline())) UpdateFocusedWindow();
+    }
+};
+
+int main() {
+    Replay replay;
+    SetFocusSettleTime(SETTLE_NS);
+
+    int failures = 0;
+    long long totalTransitions = 0, totalSuppressed = 0, immediateRebuilds = 0, settledRebuilds = 0;
+    for (const Sequence& sequence : sequences) {
+        WindowId last = replay.windows[sequence.steps[sequence.stepCount - 1].role];
+
+        replay.Start();
+        replay.PlayImmediate(sequence);
+        long long immediate = replay.BorderRebuilds();
+        bool immediateOk = replay.BorderOn(last);
+
+        replay.Start();
+        replay.PlaySettled(sequence);
+        long long settledRun = replay.BorderRebuilds();
+        const FocusSettleStats& stats = FocusSettleStatistics();
+        bool ok = immediateOk && replay.BorderOn(last) && stats.transitions == sequence.stepCount &&
+                  stats.settled == sequence.settled && stats.suppressed == sequence.suppressed &&
+                  stats.reverted == sequence.reverted && !FocusSettlePending() &&
+                  settledRun <= immediate;
+
+        std::printf("bench=focus_replay sequence=%s settle_ms=%.0f transitions=%lld settled=%lld suppressed=%lld reverted=%lld border_rebuilds_immediate=%lld border_rebuilds_settled=%lld ok=%d\n",
+                    sequence.name, SETTLE_NS / 1e6, stats.transitions, stats.settled, stats.suppressed,
+                    stats.reverted, immediate, settledRun, ok ? 1 : 0);
+        if (!ok) {
+            ++failures;
+            std::fprintf(stderr, "focus_bench: %s: expected settled=%lld suppressed=%lld reverted=%lld\n",
+                         sequence.name, sequence.settled, sequence.suppressed, sequence.reverted);
+        }
+        totalTransitions += stats.transitions;
+        totalSuppressed += stats.suppressed;
+        immediateRebuilds += immediate;
+        settledRebuilds += settledRun;
+    }
+
+    std::printf("bench=focus_replay_total sequences=%zu transitions=%lld suppressed=%lld border_rebuilds_immediate=%lld border_rebuilds_settled=%lld failures=%d\n",
+                sizeof(sequences) / sizeof(sequences[0]), totalTransitions, totalSuppressed,
+                immediateRebuilds, settledRebuilds, failures);
+    return failures ? 1 : 0;
+}
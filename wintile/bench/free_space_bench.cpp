@@ -0,0 +1,107 @@
+// Benchmark and brute-force cross-check for FindLargestEmptyRect.
+
+#include "bench_util.h"
+#include "free_space.h"
+
+#include <random>
+#include <string>
+
+// Reference: try every rect spanned by the candidate edges and keep the largest empty one.
+// O(n^5), only usable for a handful of obstacles.
+static long long BruteForceLargestArea(const Rect& bounds, const std::vector<Rect>& obstacles) {
+    std::vector<long> xs = { bounds.left, bounds.right };
+    std::vector<long> ys = { bounds.top, bounds.bottom };
+    for (const Rect& r : obstacles) {
+        if (r.left > bounds.left && r.left < bounds.right) xs.push_back(r.left);
+        if (r.right > bounds.left && r.right < bounds.right) xs.push_back(r.right);
+        if (r.top > bounds.top && r.top < bounds.bottom) ys.push_back(r.top);
+        if (r.bottom > bounds.top && r.bottom < bounds.bottom) ys.push_back(r.bottom);
+    }
+
+    long long best = 0;
+    for (size_t x0 = 0; x0 < xs.size(); ++x0) {
+        for (size_t x1 = 0; x1 < xs.size(); ++x1) {
+            if (xs[x1] <= xs[x0]) continue;
+            for (size_t y0 = 0; y0 < ys.size(); ++y0) {
+                for (size_t y1 = 0; y1 < ys.size(); ++y1) {
+                    if (ys[y1] <= ys[y0]) continue;
+                    Rect candidate = { xs[x0], ys[y0], xs[x1], ys[y1] };
+                    bool empty = true;
+                    for (const Rect& r : obstacles) {
+                        if (RectsIntersect(candidate, r)) {
+                            empty = false;
+                            break;
+                        }
+                    }
+                    long long area = static_cast<long long>(RectWidth(candidate)) * RectHeight(candidate);
+                    if (empty && area > best) best = area;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+// Random desktop-like windows; some hang over the edges of the work area
+static std::vector<Rect> RandomWindows(std::mt19937& rng, const Rect& bounds, int count) {
+    std::uniform_int_distribution<long> width(150, 900);
+    std::uniform_int_distribution<long> height(100, 700);
+    std::uniform_int_distribution<long> x(bounds.left - 100, bounds.right - 50);
+    std::uniform_int_distribution<long> y(bounds.top - 100, bounds.bottom - 50);
+
+    std::vector<Rect> windows;
+    windows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        long left = x(rng);
+        long top = y(rng);
+        windows.push_back({ left, top, left + width(rng), top + height(rng) });
+    }
+    return windows;
+}
+
+static bool CheckResult(const Rect& bounds, const std::vector<Rect>& obstacles) {
+    Rect found;
+    bool ok = FindLargestEmptyRect(bounds, obstacles.data(), obstacles.size(), &found);
+    long long expected = BruteForceLargestArea(bounds, obstacles);
+    if (!ok) return expected == 0;
+
+    if (found.left < bounds.left || found.top < bounds.top || found.right > bounds.right || found.bottom > bounds.bottom) {
+        return false;
+    }
+    for (const Rect& r : obstacles) {
+        if (RectsIntersect(found, r)) return false;
+    }
+    return static_cast<long long>(RectWidth(found)) * RectHeight(found) == expected;
+}
+
+int main() {
+    const Rect bounds = { 0, 0, 1920, 1040 };
+    std::mt19937 rng(20240611);
+
+    // Correctness against the brute-force reference on small desktops
+    const int trials = 2000;
+    int mismatches = 0;
+    for (int trial = 0; trial < trials; ++trial) {
+        std::vector<Rect> windows = RandomWindows(rng, bounds, trial % 10);
+        if (!CheckResult(bounds, windows)) ++mismatches;
+    }
+    std::printf("bench=free_space_check trials=%d mismatches=%d\n", trials, mismatches);
+
+    // Latency at realistic and extreme window counts
+    const int counts[] = { 10, 50, 100, 200, 500 };
+    for (int count : counts) {
+        std::vector<long long> samples;
+        int iterations = count <= 100 ? 2000 : 200;
+        for (int i = 0; i < iterations; ++i) {
+            std::vector<Rect> windows = RandomWindows(rng, bounds, count);
+            Rect found;
+            BenchClock::time_point start = BenchClock::now();
+            FindLargestEmptyRect(bounds, windows.data(), windows.size(), &found);
+            samples.push_back(ElapsedNs(start));
+        }
+        std::string params = "windows=" + std::to_string(count);
+        ReportSamples("free_space", params.c_str(), samples);
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
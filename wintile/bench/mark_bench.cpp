@@ -0,0 +1,241 @@
+// Vim-style marks on simulated desktops of 100, 1000 and 5000 windows: 26 marks are set and
+// jumped to in turn. Each jump's OS calls are counted: the same number at every desktop size
+// and never an EnumWindows (the time still grows a little, as the simulator's raise walks its
+// z-order list). For scale, the marked windows found without marks, by enumerating the desktop
+// and matching process ids. With 900 of the 1000 windows parked on other workspaces, a jump
+// makes the same calls and its median time at most doubles (a search through the parked
+// windows would show here). Then, on the 1000-window desktop: the jumped-to window is
+// foreground with the cursor on its center, the window under the cursor can be marked, a
+// handle reused by another process or after a destroy event does not answer for its mark, a
+// jump brings back a window parked on another workspace but not one its app showed again, and
+// the command channel's mark, jump and 'a targets reply as documented. Exits non-zero on any
+// mismatch.
+
+#include "bench_util.h"
+#include "command.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+#include "workspace.h"
+
+#include <algorithm>
+#include <string>
+
+static const int SIZES[] = { 100, 1000, 5000 };
+static const int JUMPS = 20000;
+static const int LOOKUPS = 200;
+static const int PARKED = 900;  // Of the 1000-window desktop, below MAX_TRACKED_WINDOWS
+static const unsigned long FIRST_PID = 1000;
+
+static const char BENCH[] = "mark_bench";
+
+struct Desktop {
+    SimWindowSystem sim;
+    std::vector<WindowId> windows;
+    WindowId marked[MARK_COUNT];
+
+    explicit Desktop(int count) {
+        sim.AddMonitor({ 0, 0, 1920, 1080 });
+        sim.AddMonitor({ 1920, 0, 3840, 1080 });
+        for (int w = 0; w < count; ++w) {
+            long x = 1920L * (w % 2) + 37L * (w % 37);
+            long y = 23L * (w % 29);
+            WindowId window = sim.AddWindow({ x, y, x + 640, y + 400 });
+            sim.Window(window).pid = FIRST_PID + w;
+            windows.push_back(window);
+        }
+        InitTiler(&sim);
+        RefreshMonitorCache();
+        for (int m = 0; m < MARK_COUNT; ++m) {
+            marked[m] = windows[static_cast<size_t>(m) * windows.size() / MARK_COUNT];
+            BenchCheck(BENCH, SetMark(static_cast<char>('a' + m), marked[m]), "a window could not be marked");
+        }
+    }
+
+    ~Desktop() { ShutdownTiler(); }
+};
+
+// Reply of one script run through the parser and runner
+static std::string Run(const std::string& script) {
+    CommandRequest request;
+    CommandParser parser;
+    parser.Feed(script.data(), script.size(), &request);
+    std::string reply;
+    RunCommands(request, &reply);
+    return reply;
+}
+
+static Point Center(const Rect& rect) {
+    return { (rect.left + rect.right) / 2, (rect.top + rect.bottom) / 2 };
+}
+
+static std::string Hex(WindowId window) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "0x%llx", static_cast<unsigned long long>(window));
+    return text;
+}
+
+// JUMPS jumps through the marks in turn, each timed (sorted, as ReportSamples leaves them)
+static void TimeJumps(std::vector<long long>* samples) {
+    samples->clear();
+    for (int i = 0; i < JUMPS; ++i) {
+        BenchClock::time_point start = BenchClock::now();
+        JumpToMark(static_cast<char>('a' + i % MARK_COUNT));
+        samples->push_back(ElapsedNs(start));
+    }
+    std::sort(samples->begin(), samples->end());
+}
+
+static void CheckBehaviour() {
+    Desktop desktop(1000);
+    SimWindowSystem& sim = desktop.sim;
+
+    // A jump focuses the window and puts the cursor on its center
+    for (int m = 0; m < MARK_COUNT; ++m) {
+        WindowId window = desktop.marked[m];
+        BenchCheck(BENCH, JumpToMark(static_cast<char>('a' + m)), "jump failed");
+        Point cursor;
+        sim.CursorPosition(&cursor);
+        BenchCheck(BENCH, sim.ForegroundWindow() == window, "the jumped-to window is not foreground");
+        Point center = Center(sim.Window(window).rect);
+        BenchCheck(BENCH, cursor.x == center.x && cursor.y == center.y, "the cursor is not on the window's center");
+    }
+    BenchCheck(BENCH, !JumpToMark('A') && !SetMark('{', desktop.windows[0]), "a non-letter mark was accepted");
+
+    // The window under the cursor
+    WindowId under = desktop.windows[500];
+    sim.SetForeground(under);
+    sim.SetCursorPoint(Center(sim.Window(under).rect));
+    BenchCheck(BENCH, SetMark('x', 0) && MarkedWindow('x') == under, "the window under the cursor was not marked");
+
+    // The handle now belongs to another process: the mark is gone
+    WindowId reused = desktop.marked[1];
+    sim.Window(reused).pid = FIRST_PID + 99999;
+    WindowId foreground = sim.ForegroundWindow();
+    BenchCheck(BENCH, !JumpToMark('b') && MarkedWindow('b') == 0, "a mark followed a handle to another process");
+    BenchCheck(BENCH, sim.ForegroundWindow() == foreground, "a failed jump changed the foreground");
+
+    // Destroyed, then the handle comes back in the same process: the destroy event cleared it
+    HandleWindowDestroyed(desktop.marked[2]);
+    BenchCheck(BENCH, MarkedWindow('c') == 0, "a mark survived its window's destroy event");
+
+    // Closed without an event reaching the tiler
+    sim.CloseWindow(desktop.marked[3]);
+    BenchCheck(BENCH, !JumpToMark('d') && MarkedWindow('d') == 0, "a mark of a closed window answered");
+
+    // Parked on workspace 2: the jump switches back to it
+    WindowId parked = desktop.marked[4];
+    sim.SetForeground(parked);
+    sim.SetCursorPoint(Center(sim.Window(parked).rect));
+    HandleMoveToWorkspace(1);
+    BenchCheck(BENCH, !sim.Window(parked).visible, "the window was not parked");
+    BenchCheck(BENCH, JumpToMark('e'), "jump to a parked window failed");
+    BenchCheck(BENCH, sim.Window(parked).visible && sim.ForegroundWindow() == parked, "the parked window was not brought back");
+
+    // Parked, then shown again by its app: the jump leaves the monitor's workspace alone, with
+    // the show event handled and with the jump coming first
+    WindowId reshown = desktop.marked[6];
+    WindowId witness = desktop.windows[0];  // Shown on the same monitor
+    for (int handled = 1; handled >= 0; --handled) {
+        sim.SetForeground(reshown);
+        sim.SetCursorPoint(Center(sim.Window(reshown).rect));
+        HandleMoveToWorkspace(2);
+        BenchCheck(BENCH, !sim.Window(reshown).visible, "the window to re-show was not parked");
+        sim.Window(reshown).visible = true;
+        if (handled) HandleWindowShown(reshown);
+        BenchCheck(BENCH, JumpToMark('g') && sim.ForegroundWindow() == reshown, "jump to a re-shown window failed");
+        BenchCheck(BENCH, sim.Window(witness).visible && sim.Window(reshown).visible,
+                   "a jump to a re-shown window switched the workspace");
+    }
+
+    // The command channel
+    std::string reply = Run("snap 'a right_half\nquery 'a\nfocus 'f\nsnap 'c left_half\nquery 'b\n");
+    BenchCheck(BENCH, reply == "ok\nok right_half\nok\nerror mark 'c' is not set\nerror mark 'b' is not set\n",
+               "snap/query/focus replies differ");
+    BenchCheck(BENCH, TrackedWindowState(desktop.marked[0]) == WindowState::RightHalf, "snap 'a did not snap the marked window");
+    reply = Run("begin\nsnap 'a left_half\nsnap " + Hex(desktop.windows[7]) + " 2,right_half\nsnap 'f top_left\ncommit\n");
+    BenchCheck(BENCH, reply == "ok 3\n", "batch with marks not applied");
+    BenchCheck(BENCH, TrackedWindowState(desktop.marked[5]) == WindowState::TopLeftQuarter, "batch missed a marked window");
+    reply = Run("begin\nsnap 'a right_half\nsnap 'd left_half\ncommit\n");
+    BenchCheck(BENCH, reply == "error mark 'd' is not set\n", "batch with an unset mark replies differ");
+    BenchCheck(BENCH, TrackedWindowState(desktop.marked[0]) == WindowState::LeftHalf, "batch with an unset mark was applied");
+    reply = Run("mark g " + Hex(desktop.windows[42]) + "\njump g\nmark\njump 1\nmark A\njump c\nmark h 0x0\n");
+    BenchCheck(BENCH, reply == "ok\nok\nerror mark needs a letter a-z\nerror jump needs a letter a-z\n"
+                        "error mark needs a letter a-z\nerror cannot jump to mark 'c'\nerror bad window handle '0x0'\n",
+               "mark/jump replies differ");
+    BenchCheck(BENCH, sim.ForegroundWindow() == desktop.windows[42], "jump g did not focus the window");
+}
+
+int main() {
+    long long callsPerJump[3] = {};
+    for (int s = 0; s < 3; ++s) {
+        Desktop desktop(SIZES[s]);
+        SimWindowSystem& sim = desktop.sim;
+        char params[128];
+
+        // Finding the marked windows without marks: walk the desktop for their process
+        std::vector<long long> samples;
+        sim.ResetCalls();
+        std::vector<WindowId> listed;
+        for (int i = 0; i < LOOKUPS; ++i) {
+            WindowId target = desktop.marked[i % MARK_COUNT];
+            unsigned long pid = sim.Window(target).pid;
+            BenchClock::time_point start = BenchClock::now();
+            listed.clear();
+            sim.EnumerateWindows(&listed);
+            WindowId found = 0;
+            for (WindowId window : listed) {
+                if (sim.ProcessId(window) == pid) {
+                    found = window;
+                    break;
+                }
+            }
+            samples.push_back(ElapsedNs(start));
+            BenchCheck(BENCH, found == target, "the enumeration found another window");
+        }
+        std::snprintf(params, sizeof(params), "windows=%d calls_per_lookup=%lld", SIZES[s], sim.TotalCalls() / LOOKUPS);
+        ReportSamples("mark_enum_lookup", params, samples);
+
+
+        // The jumps
+        sim.ResetCalls();
+        TimeJumps(&samples);
+        callsPerJump[s] = sim.TotalCalls() / JUMPS;
+        std::snprintf(params, sizeof(params), "windows=%d marks=%d calls_per_jump=%lld enum_calls=%lld", SIZES[s],
+                      MARK_COUNT, callsPerJump[s], sim.Calls(SimCall::EnumWindows));
+        ReportSamples("mark_jump", params, samples);
+        BenchCheck(BENCH, sim.Calls(SimCall::EnumWindows) == 0, "a jump enumerated the windows");
+        BenchCheck(BENCH, sim.TotalCalls() == callsPerJump[s] * JUMPS, "jumps made different numbers of calls");
+    }
+    BenchCheck(BENCH, callsPerJump[0] == callsPerJump[1] && callsPerJump[1] == callsPerJump[2], "jump calls grow with the desktop");
+
+    // The same jumps before and after parking most windows on other workspaces: a jump looks its
+    // window up in the parked table, it never walks the parked windows
+    {
+        Desktop desktop(SIZES[1]);
+        SimWindowSystem& sim = desktop.sim;
+        std::vector<long long> samples;
+        TimeJumps(&samples);
+        long long unparkedNs = Percentile(samples, 0.5);
+        int parked = 0;
+        for (size_t w = 0; w < desktop.windows.size() && parked < PARKED; ++w) {
+            WindowId window = desktop.windows[w];
+            if (std::find(desktop.marked, desktop.marked + MARK_COUNT, window) != desktop.marked + MARK_COUNT) continue;
+            sim.SetForeground(window);
+            sim.SetCursorPoint(Center(sim.Window(window).rect));
+            HandleMoveToWorkspace(1 + parked % (WORKSPACE_COUNT - 1));
+            parked += 1;
+        }
+        sim.ResetCalls();
+        TimeJumps(&samples);
+        char params[128];
+        std::snprintf(params, sizeof(params), "windows=%d parked=%d calls_per_jump=%lld unparked_p50_ns=%lld", SIZES[1], parked,
+                      sim.TotalCalls() / JUMPS, unparkedNs);
+        ReportSamples("mark_jump_parked", params, samples);
+        BenchCheck(BENCH, sim.TotalCalls() == callsPerJump[1] * JUMPS, "parked windows changed the calls of a jump");
+        BenchCheck(BENCH, Percentile(samples, 0.5) < 2 * unparkedNs, "a jump slowed down with the parked windows");
+    }
+
+    CheckBehaviour();
+    std::printf("bench=mark_check failures=%d\n", benchFailures);
+    return benchFailures ? 1 : 0;
+}
@@ -0,0 +1,278 @@
+// Per-application rules: 500 rules (exact and wildcard process names, classes, title globs)
+// against 1000 windows of 200 processes on a simulated two-monitor desktop. Times the first
+// verdict of every window (executable name resolved once per process), the memoized verdict
+// the border and snap paths then pay, and the compiled matcher against a plain scan of every
+// rule. Verdicts are checked against that scan, and the caches against process exit with pid
+// reuse, title changes and a config reload; the place, no_tile and no_border actions are run
+// through the tiler. Exits non-zero on any mismatch.
+
+#include "bench_util.h"
+#include "config.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+#include <string>
+
+static const int WINDOWS = 1000;
+static const int PROCESSES = 200;
+static const int RULES = 500;
+static const int MEMO_PASSES = 20;
+static const unsigned long FIRST_PID = 1000;
+static const unsigned long PLACED_PID = 5000;
+
+static const char* const actionNames[] = { "no_tile", "no_border", "no_tile no_border" };
+
+static std::string RulesText() {
+    std::string text;
+    for (int i = 0; i < RULES - 1; ++i) {
+        text += "rule = ";
+        switch (i % 10) {
+            case 0: case 1: case 2: case 3: case 4: case 5:
+                // Exact names, some of processes that are not running, some in upper case
+                text += (i % 4 ? "process=app" : "process=APP") + std::to_string((i * 7) % 250) +
+                        (i % 4 ? ".exe " : ".EXE ") + actionNames[i % 3];
+                break;
+            case 6: case 7:
+                text += "class=WindowClass" + std::to_string((i * 11) % 400) + " no_border";
+                break;
+            case 8:
+                text += "process=app" + std::to_string(i % 20) + "?.exe class=WindowClass* no_tile";
+                break;
+            default:
+                text += "title=\"*Report " + std::to_string(i % 50) + "? - *\" no_border";
+                break;
+        }
+        text += "\n";
+    }
+    text += "rule = process=placed.exe place=2,right_half\n";
+    return text;
+}
+
+// What the rules say, by scanning all of them in file order
+static RuleVerdict ReferenceVerdict(const std::vector<WindowRule>& rules, const wchar_t* process,
+                                    const wchar_t* className, const wchar_t* title) {
+    RuleVerdict verdict;
+    for (const WindowRule& rule : rules) {
+        if (!rule.process.empty() && !GlobMatch(rule.process.data(), rule.process.size(), process)) continue;
+        if (!rule.className.empty() && !GlobMatch(rule.className.data(), rule.className.size(), className)) continue;
+        if (!rule.title.empty() && !GlobMatch(rule.title.data(), rule.title.size(), title)) continue;
+        verdict.actions |= rule.actions;
+        if (rule.actions & RULE_PLACE) {
+            verdict.monitor = rule.monitor;
+            verdict.state = rule.state;
+        }
+    }
+    return verdict;
+}
+
+static bool SameVerdict(const RuleVerdict& a, const RuleVerdict& b) {
+    return a.actions == b.actions && a.monitor == b.monitor && a.state == b.state;
+}
+
+struct Desktop {
+    SimWindowSystem sim;
+    std::vector<WindowId> windows;
+    std::vector<std::wstring> classNames;        // SimWindow keeps a pointer
+    std::vector<std::wstring> processNames;      // By pid - FIRST_PID
+    int failures = 0;
+
+    Desktop() {
+        sim.AddMonitor({ 0, 0, 1920, 1080 });
+        sim.AddMonitor({ 1920, 0, 3840, 1080 });
+        for (int p = 0; p < PROCESSES; ++p) {
+            processNames.push_back(L"app" + std::to_wstring(p) + L".exe");
+            sim.SetProcessPath(FIRST_PID + p, L"C:\\Program Files\\Vendor" + std::to_wstring(p % 7) + L"\\" + processNames.back());
+        }
+        sim.SetProcessPath(PLACED_PID, L"C:\\Tools\\placed.exe");
+        classNames.reserve(400);
+        for (int c = 0; c < 400; ++c) classNames.push_back(L"WindowClass" + std::to_wstring(c));
+        for (int w = 0; w < WINDOWS; ++w) Add(FIRST_PID + w % PROCESSES, w);
+        InitTiler(&sim);
+        RefreshMonitorCache();
+    }
+
+    ~Desktop() { ShutdownTiler(); }
+
+    WindowId Add(unsigned long pid, int w) {
+        long x = 1920L * (w % 2) + 10L * (w % 50);
+        WindowId window = sim.AddWindow({ x, 60, x + 800, 660 });
+        SimWindow& record = sim.Window(window);
+        record.pid = pid;
+        record.className = classNames[w % 400].c_str();
+        record.title = L"Report " + std::to_wstring(w) + L" - Editor";
+        windows.push_back(window);
+        return window;
+    }
+
+    RuleVerdict Reference(WindowId window, const std::wstring& process) {
+        const SimWindow& record = sim.Window(window);
+        return ReferenceVerdict(CurrentConfig().rules, process.c_str(), record.className, record.title.c_str());
+    }
+
+    std::wstring ProcessOf(WindowId window) {
+        unsigned long pid = sim.Window(window).pid;
+        return pid == PLACED_PID ? L"placed.exe" : processNames[pid - FIRST_PID];
+    }
+
+    void Check(bool ok, const char* what) {
+        if (!ok && failures++ < 10) std::fprintf(stderr, "rules_bench: %s\n", what);
+    }
+
+    // Verdict of every window against the reference
+    void CheckVerdicts(const char* what) {
+        for (WindowId window : windows) {
+            if (!sim.Window(window).alive) continue;
+            if (!SameVerdict(WindowRuleVerdict(window), Reference(window, ProcessOf(window)))) {
+                Check(false, what);
+                return;
+            }
+        }
+    }
+};
+
+static bool Publish(const std::string& text) {
+    std::unique_ptr<Config> config = std::make_unique<Config>();
+    std::string error;
+    if (!ParseConfig(text.data(), text.size(), config.get(), &error)) {
+        std::fprintf(stderr, "rules_bench: config rejected: %s\n", error.c_str());
+        return false;
+    }
+    PublishConfig(std::move(config));
+    return true;
+}
+
+int main() {
+    std::string text = RulesText();
+    Desktop d;
+    d.Check(Publish(text), "rules did not parse");
+    const Config& config = CurrentConfig();
+    char params[160];
+
+    // First verdict of every window: one executable lookup per process
+    std::vector<long long> samples;
+    d.sim.ResetCalls();
+    for (WindowId window : d.windows) {
+        BenchClock::time_point start = BenchClock::now();
+        WindowRuleVerdict(window);
+        samples.push_back(ElapsedNs(start));
+    }
+    long long coldCalls = d.sim.TotalCalls();
+    long long opens = d.sim.Calls(SimCall::OpenProcess);
+    std::snprintf(params, sizeof(params), "op=first_verdict rules=%d windows=%d processes=%d os_calls=%lld open_process=%lld",
+                  RULES, WINDOWS, PROCESSES, coldCalls, opens);
+    ReportSamples("rules", params, samples);
+    d.Check(opens == PROCESSES && WindowRuleStats().processLookups == PROCESSES, "executable resolved more than once per process");
+    d.CheckVerdicts("first verdict differs from the reference");
+
+    // Memoized verdicts, as ShouldWindowHaveBorder and the snap path see them
+    samples.clear();
+    long long verdicts = WindowRuleStats().verdicts;
+    d.sim.ResetCalls();
+    for (int pass = 0; pass < MEMO_PASSES; ++pass) {
+        for (WindowId window : d.windows) {
+            BenchClock::time_point start = BenchClock::now();
+            WindowRuleVerdict(window);
+            samples.push_back(ElapsedNs(start));
+        }
+    }
+    std::snprintf(params, sizeof(params), "op=memoized_verdict rules=%d windows=%d os_calls=%lld recomputed=%lld",
+                  RULES, WINDOWS, d.sim.TotalCalls(), WindowRuleStats().verdicts - verdicts);
+    ReportSamples("rules", params, samples);
+    d.Check(d.sim.TotalCalls() == 0 && WindowRuleStats().verdicts == verdicts, "memoized verdict was recomputed");
+
+    // Compiled matcher against scanning every rule, without the OS calls
+    std::vector<long long> compiled, scanned;
+    for (int pass = 0; pass < 5; ++pass) {
+        for (WindowId window : d.windows) {
+            std::wstring process = d.ProcessOf(window);
+            const SimWindow& record = d.sim.Window(window);
+            BenchClock::time_point start = BenchClock::now();
+            RuleVerdict fast = config.ruleMatcher.Match(process.c_str(), record.className, record.title.c_str());
+            compiled.push_back(ElapsedNs(start));
+            start = BenchClock::now();
+            RuleVerdict slow = ReferenceVerdict(config.rules, process.c_str(), record.className, record.title.c_str());
+            scanned.push_back(ElapsedNs(start));
+            d.Check(SameVerdict(fast, slow), "compiled matcher differs from the rule scan");
+        }
+    }
+    std::snprintf(params, sizeof(params), "op=match matcher=compiled rules=%d", RULES);
+    ReportSamples("rules", params, compiled);
+    std::snprintf(params, sizeof(params), "op=match matcher=scan rules=%d", RULES);
+    ReportSamples("rules", params, scanned);
+
+    // A reload recomputes every verdict, but executable names stay cached
+    d.Check(Publish(text), "reload did not parse");
+    verdicts = WindowRuleStats().verdicts;
+    d.CheckVerdicts("verdict after reload differs");
+    d.Check(WindowRuleStats().verdicts == verdicts + WINDOWS, "reload did not recompute each verdict once");
+    d.Check(WindowRuleStats().processLookups == PROCESSES, "reload dropped cached executable names");
+
+    // Process exit with pid reuse: the new process's windows see the new executable
+    unsigned long reused = FIRST_PID;
+    for (WindowId window : d.windows) {
+        if (d.sim.Window(window).pid != reused) continue;
+        d.sim.CloseWindow(window);
+        HandleWindowDestroyed(window);
+    }
+    d.sim.SetProcessPath(reused, L"C:\\Other\\app7.exe");
+    d.processNames[0] = L"app7.exe";
+    HandleProcessExited(reused);
+    WindowId successor = d.Add(reused, 7);
+    d.Check(SameVerdict(WindowRuleVerdict(successor), d.Reference(successor, L"app7.exe")), "stale executable after pid reuse");
+    d.Check(WindowRuleStats().processLookups == PROCESSES + 1, "exited process was not resolved again");
+
+    // Title change: title rules see the new title
+    WindowId renamed = d.windows[1];
+    d.sim.Window(renamed).title = L"Weekly Report 19x - Editor";
+    HandleWindowRenamed(renamed);
+    d.Check(SameVerdict(WindowRuleVerdict(renamed), d.Reference(renamed, d.ProcessOf(renamed))), "stale verdict after title change");
+    d.Check((WindowRuleVerdict(renamed).actions & RULE_NO_BORDER) != 0, "title rule did not match the new title");
+
+    // place=2,right_half: snapped on monitor 2 when first shown, without moving the cursor;
+    // moved back by hand it stays there
+    Point cursor;
+    d.sim.SetCursorPoint({ 5, 5 });
+    WindowId placed = d.Add(PLACED_PID, 3);
+    HandleWindowShown(placed);
+    Rect rect = d.sim.Window(placed).rect;
+    d.sim.CursorPosition(&cursor);
+    d.Check(TrackedWindowState(placed) == WindowState::RightHalf && rect.left >= 1920 + 900 && rect.right <= 3840,
+            "place rule did not snap the window");
+    d.Check(cursor.x == 5 && cursor.y == 5, "place rule moved the cursor");
+    d.sim.Window(placed).rect = { 100, 100, 900, 700 };
+    HandleWindowShown(placed);
+    d.Check(d.sim.Window(placed).rect == Rect{ 100, 100, 900, 700 }, "place rule ran twice");
+
+    // no_tile: the snap hotkey leaves the window alone; no_border: no focus border
+    WindowId untiled = 0, unbordered = 0;
+    for (WindowId window : d.windows) {
+        if (!d.sim.Window(window).alive) continue;
+        unsigned actions = WindowRuleVerdict(window).actions;
+        if (!untiled && actions == RULE_NO_TILE) untiled = window;
+        if (!unbordered && actions == RULE_NO_BORDER) unbordered = window;
+    }
+    d.Check(untiled && unbordered, "no window with a single no_tile or no_border verdict");
+    if (untiled) {
+        d.sim.SetForeground(untiled);
+        Rect before = d.sim.Window(untiled).rect;
+        d.sim.SetCursorPoint({ before.left + 50, before.top + 50 });
+        HandleSnapRequest(SnapDirection::Left);
+        d.Check(d.sim.Window(untiled).rect == before && TrackedWindowState(untiled) == WindowState::Unknown,
+                "no_tile window was snapped");
+        d.Check(ShouldWindowHaveBorder(untiled), "no_tile window lost its border");
+    }
+    if (unbordered) {
+        d.sim.SetForeground(unbordered);
+        UpdateFocusedWindow();
+        bool border = false;
+        for (WindowId id = 1; id <= d.sim.WindowCount(); ++id) {
+            border |= d.sim.Window(id).border && d.sim.Window(id).alive;
+        }
+        d.Check(!border, "no_border window got a border");
+    }
+
+    const RuleStats& stats = WindowRuleStats();
+    std::printf("bench=rules_check rules=%d windows=%d verdicts=%lld memo_hits=%lld process_lookups=%lld process_hits=%lld failures=%d\n",
+                RULES, WINDOWS, stats.verdicts, stats.memoHits, stats.processLookups, stats.processHits, d.failures);
+    return d.failures ? 1 : 0;
+}
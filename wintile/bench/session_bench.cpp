@@ -0,0 +1,218 @@
+// Layout sessions on a simulated two-monitor desktop with 300 windows of 60 processes: two
+// 30-entry sessions ("coding" and "review", the same windows in other slots) are applied in
+// turn. Each apply is timed against the 60 Hz frame budget and its OS calls are counted: one
+// EnumWindows and one placement transaction, no individual SetWindowPos. Which window each
+// entry took is checked against a plain scan (topmost window first, first free entry it matches
+// in file order), and every taken window's tracked state and monitor against its entry. For
+// scale, the same moves as 29 separate SnapWindow calls. Last, the greedy rule: a catch-all
+// entry listed before a specific one takes that one's only window, listed after it takes
+// another. Exits non-zero on any mismatch.
+
+#include "bench_util.h"
+#include "command.h"
+#include "config.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+static const int WINDOWS = 300;
+static const int PROCESSES = 60;
+static const int CLASSES = 100;
+static const int ENTRIES = 30;
+static const int APPLIES = 400;
+static const unsigned long FIRST_PID = 1000;
+static const long long FRAME_NS = 16666667;
+
+static const char* const stateNames[] = {
+    "left_half", "right_half", "top_left", "top_right", "bottom_left", "bottom_right", "top_half", "bottom_half",
+};
+
+static const char BENCH[] = "session_bench";
+
+// Entries by process, by class, by title glob, two more of one process (its next windows) and
+// one that matches nothing. `shift` moves every entry to another slot and monitor.
+static void AppendSession(const char* name, int shift, std::string* text) {
+    for (int k = 0; k < ENTRIES; ++k) {
+        *text += "session = ";
+        *text += name;
+        if (k < 10) {
+            *text += " process=app" + std::to_string(k) + ".exe";
+        } else if (k < 20) {
+            *text += " class=WindowClass" + std::to_string(k * 3);
+        } else if (k < 27) {
+            *text += " title=\"Doc " + std::to_string(k - 10) + "? - *\"";
+        } else if (k < 29) {
+            *text += " process=APP5.exe";
+        } else {
+            *text += " process=missing.exe";
+        }
+        *text += " place=" + std::to_string((k + shift) % 2 + 1) + "," + stateNames[(k + shift) % 8] + "\n";
+    }
+}
+
+struct Desktop {
+    SimWindowSystem sim;
+    std::vector<WindowId> windows;
+    std::vector<std::wstring> classNames;  // SimWindow keeps a pointer
+    std::vector<std::wstring> processNames;
+
+    Desktop() {
+        sim.AddMonitor({ 0, 0, 1920, 1080 });
+        sim.AddMonitor({ 1920, 0, 3840, 1080 });
+        for (int p = 0; p < PROCESSES; ++p) {
+            processNames.push_back(L"app" + std::to_wstring(p) + L".exe");
+            sim.SetProcessPath(FIRST_PID + p, L"C:\\Program Files\\" + processNames.back());
+        }
+        for (int c = 0; c < CLASSES; ++c) classNames.push_back(L"WindowClass" + std::to_wstring(c));
+        for (int w = 0; w < WINDOWS; ++w) {
+            long x = 1920L * (w % 2) + 10L * (w % 50);
+            WindowId window = sim.AddWindow({ x, 60, x + 800, 660 });
+            SimWindow& record = sim.Window(window);
+            record.pid = FIRST_PID + w % PROCESSES;
+            record.className = classNames[w % CLASSES].c_str();
+            record.title = L"Doc " + std::to_wstring(w) + L" - Editor";
+            windows.push_back(window);
+        }
+        InitTiler(&sim);
+        RefreshMonitorCache();
+    }
+
+    ~Desktop() { ShutdownTiler(); }
+
+    // The window each entry should take: windows topmost first (the last added), each to the
+    // first entry in file order that matches it and has no window yet
+    std::vector<WindowId> ReferenceClaims(const LayoutSession& session) {
+        std::vector<WindowId> claims(session.entries.size(), 0);
+        for (int w = WINDOWS - 1; w >= 0; --w) {
+            const SimWindow& record = sim.Window(windows[w]);
+            const std::wstring& process = processNames[record.pid - FIRST_PID];
+            for (size_t e = 0; e < session.entries.size(); ++e) {
+                const WindowRule& entry = session.entries[e];
+                if (claims[e]) continue;
+                if (!entry.process.empty() && !GlobMatch(entry.process.data(), entry.process.size(), process.c_str())) continue;
+                if (!entry.className.empty() && !GlobMatch(entry.className.data(), entry.className.size(), record.className)) continue;
+                if (!entry.title.empty() && !GlobMatch(entry.title.data(), entry.title.size(), record.title.c_str())) continue;
+                claims[e] = windows[w];
+                break;
+            }
+        }
+        return claims;
+    }
+
+    void CheckApplied(const LayoutSession& session, size_t placed) {
+        std::vector<WindowId> claims = ReferenceClaims(session);
+        size_t expected = 0;
+        for (size_t e = 0; e < claims.size(); ++e) {
+            if (!claims[e]) continue;
+            expected += 1;
+            const WindowRule& entry = session.entries[e];
+            BenchCheck(BENCH, TrackedWindowState(claims[e]) == entry.state, "a window is not in its entry's slot");
+            BenchCheck(BENCH, sim.MonitorOfWindow(claims[e]) == static_cast<MonitorId>(entry.monitor),
+                       "a window is not on its entry's monitor");
+        }
+        BenchCheck(BENCH, placed == expected, "snapped count differs from the matching windows");
+        BenchCheck(BENCH, expected == ENTRIES - 1, "the reference scan found an unexpected number of windows");
+    }
+};
+
+int main() {
+    Desktop desktop;
+    std::string text;
+    AppendSession("coding", 0, &text);
+    AppendSession("review", 3, &text);
+    // One app's windows and one of them by title, in both orders
+    text += "session = catchall_first process=app7.exe place=1,left_half\n"
+            "session = catchall_first title=\"Doc 7 - Editor\" place=2,right_half\n"
+            "session = specific_first title=\"Doc 7 - Editor\" place=2,right_half\n"
+            "session = specific_first process=app7.exe place=1,left_half\n";
+    std::unique_ptr<Config> config = std::make_unique<Config>();
+    std::string error;
+    if (!ParseConfig(text.data(), text.size(), config.get(), &error)) {
+        std::fprintf(stderr, "session_bench: config rejected: %s\n", error.c_str());
+        return 1;
+    }
+    PublishConfig(std::move(config));
+    const char* names[2] = { "coding", "review" };
+    const LayoutSession* sessions[2];
+    for (int s = 0; s < 2; ++s) {
+        sessions[s] = FindLayoutSession(CurrentConfig(), names[s], names[s] + std::strlen(names[s]));
+        if (!sessions[s] || sessions[s]->entries.size() != ENTRIES) {
+            std::fprintf(stderr, "session_bench: session %s missing\n", names[s]);
+            return 1;
+        }
+    }
+
+    // Applies, alternating so every one moves all the windows
+    std::vector<long long> samples;
+    long long maxEnums = 0, maxTransactions = 0, maxSingles = 0, totalCalls = 0;
+    for (int i = 0; i < APPLIES; ++i) {
+        const LayoutSession& session = *sessions[i % 2];
+        desktop.sim.ResetCalls();
+        long long transactions = desktop.sim.Transactions();
+        BenchClock::time_point start = BenchClock::now();
+        size_t placed = ApplyLayoutSession(session);
+        samples.push_back(ElapsedNs(start));
+        maxEnums = std::max(maxEnums, desktop.sim.Calls(SimCall::EnumWindows));
+        maxTransactions = std::max(maxTransactions, desktop.sim.Transactions() - transactions);
+        maxSingles = std::max(maxSingles, desktop.sim.Calls(SimCall::SetWindowPos));
+        totalCalls += desktop.sim.TotalCalls();
+        if (i < 4) desktop.CheckApplied(session, placed);
+    }
+    char params[160];
+    std::snprintf(params, sizeof(params), "windows=%d entries=%d enum_calls=%lld transactions=%lld set_window_pos=%lld calls_per_apply=%lld",
+                  WINDOWS, ENTRIES, maxEnums, maxTransactions, maxSingles, totalCalls / APPLIES);
+    ReportSamples("session_apply", params, samples);
+    BenchCheck(BENCH, maxEnums == 1, "an apply enumerated the windows more than once");
+    BenchCheck(BENCH, maxTransactions == 1, "an apply took more than one placement transaction");
+    BenchCheck(BENCH, maxSingles == 0, "an apply placed windows one by one");
+    BenchCheck(BENCH, Percentile(samples, 0.99) < FRAME_NS, "applying a session took longer than a frame");
+
+    // The same moves one command at a time
+    std::vector<WindowId> claims[2] = { desktop.ReferenceClaims(*sessions[0]), desktop.ReferenceClaims(*sessions[1]) };
+    samples.clear();
+    desktop.sim.ResetCalls();
+    for (int i = 0; i < APPLIES; ++i) {
+        const LayoutSession& session = *sessions[i % 2];
+        BenchClock::time_point start = BenchClock::now();
+        for (size_t e = 0; e < session.entries.size(); ++e) {
+            if (!claims[i % 2][e]) continue;
+            // Simulator monitor ids are their 1-based enumeration order
+            SnapWindow(claims[i % 2][e], session.entries[e].state, static_cast<MonitorId>(session.entries[e].monitor));
+        }
+        samples.push_back(ElapsedNs(start));
+    }
+    std::snprintf(params, sizeof(params), "windows=%d entries=%d calls_per_apply=%lld", WINDOWS, ENTRIES,
+                  desktop.sim.TotalCalls() / APPLIES);
+    ReportSamples("session_individual_snaps", params, samples);
+
+    // Through the command channel's parser and runner
+    CommandRequest request;
+    CommandParser parser;
+    const char script[] = "session coding\nsession nonexistent\nsession\n";
+    parser.Feed(script, sizeof(script) - 1, &request);
+    std::string reply;
+    RunCommands(request, &reply);
+    BenchCheck(BENCH, reply == "ok 29\nerror unknown session 'nonexistent'\nerror session needs a name\n", "command replies differ");
+    desktop.CheckApplied(*sessions[0], 29);
+
+    // Window 7 topmost of its app: the catch-all listed first takes it and the title entry
+    // stays empty; listed after, the catch-all takes the app's next window
+    WindowId titled = desktop.windows[7];
+    WindowId next = desktop.windows[WINDOWS - PROCESSES + 7];
+    desktop.sim.SetForeground(titled);
+    const char* greedy[2] = { "catchall_first", "specific_first" };
+    const LayoutSession* catchallFirst = FindLayoutSession(CurrentConfig(), greedy[0], greedy[0] + std::strlen(greedy[0]));
+    const LayoutSession* specificFirst = FindLayoutSession(CurrentConfig(), greedy[1], greedy[1] + std::strlen(greedy[1]));
+    BenchCheck(BENCH, catchallFirst && ApplyLayoutSession(*catchallFirst) == 1, "catch-all first: more than one window placed");
+    BenchCheck(BENCH, TrackedWindowState(titled) == WindowState::LeftHalf, "catch-all first: the catch-all did not take the titled window");
+    BenchCheck(BENCH, specificFirst && ApplyLayoutSession(*specificFirst) == 2, "specific first: an entry stayed empty");
+    BenchCheck(BENCH, TrackedWindowState(titled) == WindowState::RightHalf && desktop.sim.MonitorOfWindow(titled) == 2,
+               "specific first: the title entry did not take its window");
+    BenchCheck(BENCH, TrackedWindowState(next) == WindowState::LeftHalf, "specific first: the catch-all did not take the next window");
+
+    std::printf("bench=session_check failures=%d\n", benchFailures);
+    return benchFailures ? 1 : 0;
+}
@@ -0,0 +1,450 @@
+#include "sim_window_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+#include <thread>
+
+#include "watchdog.h"
+
+const char* SimCallName(SimCall call) {
+    switch (call) {
+        case SimCall::GetCursorPos: return "GetCursorPos";
+        case SimCall::SetCursorPos: return "SetCursorPos";
+        case SimCall::WindowFromPoint: return "WindowFromPoint";
+        case SimCall::GetAncestor: return "GetAncestor";
+        case SimCall::GetForegroundWindow: return "GetForegroundWindow";
+        case SimCall::SetForegroundWindow: return "SetForegroundWindow";
+        case SimCall::EnumWindows: return "EnumWindows";
+        case SimCall::IsWindow: return "IsWindow";
+        case SimCall::IsWindowVisible: return "IsWindowVisible";
+        case SimCall::IsIconic: return "IsIconic";
+        case SimCall::IsZoomed: return "IsZoomed";
+        case SimCall::GetClassNameW: return "GetClassNameW";
+        case SimCall::GetWindowTextW: return "GetWindowTextW";
+        case SimCall::GetWindowThreadProcessId: return "GetWindowThreadProcessId";
+        case SimCall::OpenProcess: return "OpenProcess";
+        case SimCall::QueryFullProcessImageNameW: return "QueryFullProcessImageNameW";
+        case SimCall::RegisterWaitForSingleObject: return "RegisterWaitForSingleObject";
+        case SimCall::GetWindowLongW: return "GetWindowLongW";
+        case SimCall::DwmGetWindowAttribute: return "DwmGetWindowAttribute";
+        case SimCall::GetWindowRect: return "GetWindowRect";
+        case SimCall::SetWindowPos: return "SetWindowPos";
+        case SimCall::BeginDeferWindowPos: return "BeginDeferWindowPos";
+        case SimCall::DeferWindowPos: return "DeferWindowPos";
+        case SimCall::EndDeferWindowPos: return "EndDeferWindowPos";
+        case SimCall::MonitorFromWindow: return "MonitorFromWindow";
+        case SimCall::MonitorFromPoint: return "MonitorFromPoint";
+        case SimCall::GetMonitorInfoW: return "GetMonitorInfoW";
+        case SimCall::EnumDisplayMonitors: return "EnumDisplayMonitors";
+        case SimCall::CreateWindowExW: return "CreateWindowExW";
+        case SimCall::SetLayeredWindowAttributes: return "SetLayeredWindowAttributes";
+        case SimCall::ShowWindow: return "ShowWindow";
+        case SimCall::InvalidateRect: return "InvalidateRect";
+        case SimCall::DestroyWindow: return "DestroyWindow";
+        default: return "Unknown";
+    }
+}
+
+MonitorId SimWindowSystem::AddMonitor(const Rect& bounds, long taskbarHeight) {
+    MonitorInfo info;
+    info.monitor = bounds;
+    info.work = bounds;
+    info.work.bottom -= taskbarHeight;
+    monitors_.push_back(info);
+    return static_cast<MonitorId>(monitors_.size());
+}
+
+WindowId SimWindowSystem::AddWindow(const Rect& rect) {
+    SimWindow window;
+    window.rect = rect;
+    windows_.push_back(window);
+    WindowId id = static_cast<WindowId>(windows_.size());
+    zOrder_.insert(zOrder_.begin(), id);
+    return id;
+}
+
+void SimWindowSystem::SetForeground(WindowId window) {
+    foreground_ = window;
+    Raise(window);
+}
+
+void SimWindowSystem::CloseWindow(WindowId window) {
+    if (!Exists(window)) return;
+    Window(window).alive = false;
+    Window(window).visible = false;
+    Unlink(window);
+    if (foreground_ == window) foreground_ = 0;
+}
+
+void SimWindowSystem::SetProcessPath(unsigned long pid, const std::wstring& path) {
+    if (path.empty()) {
+        processes_.erase(pid);
+    } else {
+        processes_[pid] = path;
+    }
+}
+
+void SimWindowSystem::InjectStall(SimCall call, long long durationNs) {
+    stallCall_ = call;
+    stallNs_ = durationNs;
+}
+
+// Block like a call stuck on an unresponsive window, marked for the watchdog the way the
+// Win32 backend marks its calls
+void SimWindowSystem::Stall(SimCall call, WindowId window) {
+    long long durationNs = stallNs_;
+    stallCall_ = SimCall::Count;
+    WatchdogCall mark(SimCallName(call), window);
+    std::this_thread::sleep_for(std::chrono::nanoseconds(durationNs));
+}
+
+SimWindowSystem::SimLock SimWindowSystem::Enter(WindowId window) {
+    SimLock lock(mutex_, std::defer_lock);
+    if (concurrentCalls) lock.lock();
+    long long replyNs = Exists(window) ? Window(window).replyNs : 0;
+    if (replyNs) {
+        if (lock.owns_lock()) lock.unlock();
+        std::this_thread::sleep_for(std::chrono::nanoseconds(replyNs));
+        if (concurrentCalls) lock.lock();
+    }
+    return lock;
+}
+
+void SimWindowSystem::ResetCalls() {
+    std::fill(std::begin(calls_), std::end(calls_), 0);
+    transactions_ = 0;
+}
+
+long long SimWindowSystem::TotalCalls() const {
+    long long total = 0;
+    for (long long count : calls_) total += count;
+    return total;
+}
+
+void SimWindowSystem::FormatCalls(std::string* out) const {
+    for (int i = 0; i < static_cast<int>(SimCall::Count); ++i) {
+        if (calls_[i] == 0) continue;
+        char item[64];
+        std::snprintf(item, sizeof(item), "%s%s=%lld", out->empty() ? "" : ",", SimCallName(static_cast<SimCall>(i)), calls_[i]);
+        out->append(item);
+    }
+}
+
+bool SimWindowSystem::Exists(WindowId window) const {
+    return window >= 1 && window <= windows_.size() && windows_[window - 1].alive;
+}
+
+void SimWindowSystem::Raise(WindowId window) {
+    auto it = std::find(zOrder_.begin(), zOrder_.end(), window);
+    if (it == zOrder_.end()) return;
+    zOrder_.erase(it);
+    zOrder_.insert(zOrder_.begin(), window);
+}
+
+void SimWindowSystem::Unlink(WindowId window) {
+    auto it = std::find(zOrder_.begin(), zOrder_.end(), window);
+    if (it != zOrder_.end()) zOrder_.erase(it);
+}
+
+// Clamp a requested extent to an app's limits (0 = no limit)
+static long ClampExtent(long requested, long minimum, long maximum) {
+    if (maximum > 0 && requested > maximum) requested = maximum;
+    if (minimum > 0 && requested < minimum) requested = minimum;
+    return requested;
+}
+
+void SimWindowSystem::Apply(const Placement& p) {
+    if (!Exists(p.window)) return;
+    SimWindow& w = Window(p.window);
+    if (p.flags & PLACEMENT_HIDE) {
+        w.visible = false;
+        return;
+    }
+    if (p.flags & PLACEMENT_SHOW) w.visible = true;
+
+    // Like a real app, keep the requested origin and clamp the size to the app's limits
+    long width = ClampExtent(RectWidth(p.rect), w.limits.minWidth, w.limits.maxWidth);
+    long height = ClampExtent(RectHeight(p.rect), w.limits.minHeight, w.limits.maxHeight);
+    w.rect = { p.rect.left, p.rect.top, p.rect.left + width, p.rect.top + height };
+}
+
+bool SimWindowSystem::CursorPosition(Point* point) {
+    SimLock lock = Enter();
+    Record(SimCall::GetCursorPos);
+    *point = cursor_;
+    return true;
+}
+
+bool SimWindowSystem::MoveCursor(const Point& point) {
+    SimLock lock = Enter();
+    Record(SimCall::SetCursorPos);
+    cursor_ = point;
+    return true;
+}
+
+WindowId SimWindowSystem::WindowAt(const Point& point) {
+    SimLock lock = Enter();
+    Record(SimCall::WindowFromPoint);
+    for (WindowId id : zOrder_) {
+        const SimWindow& w = Window(id);
+        // Borders are click-through (HTTRANSPARENT)
+        if (!w.visible || w.minimized || w.cloaked || w.border) continue;
+        if (RectContains(w.rect, point)) return id;
+    }
+    return 0;
+}
+
+WindowId SimWindowSystem::RootWindow(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::GetAncestor, window);
+    return Exists(window) ? window : 0;  // Every simulated window is top-level
+}
+
+WindowId SimWindowSystem::ForegroundWindow() {
+    SimLock lock = Enter();
+    Record(SimCall::GetForegroundWindow);
+    return foreground_;
+}
+
+bool SimWindowSystem::Activate(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::SetForegroundWindow, window);
+    if (!Exists(window)) return false;
+    SetForeground(window);
+    return true;
+}
+
+void SimWindowSystem::EnumerateWindows(std::vector<WindowId>* windows) {
+    SimLock lock = Enter();
+    Record(SimCall::EnumWindows);
+    windows->insert(windows->end(), zOrder_.begin(), zOrder_.end());
+}
+
+bool SimWindowSystem::IsAlive(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::IsWindow, window);
+    return Exists(window);
+}
+
+bool SimWindowSystem::IsVisible(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::IsWindowVisible, window);
+    return Exists(window) && Window(window).visible;
+}
+
+bool SimWindowSystem::IsMinimized(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::IsIconic, window);
+    return Exists(window) && Window(window).minimized;
+}
+
+bool SimWindowSystem::IsMaximized(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::IsZoomed, window);
+    return Exists(window) && Window(window).maximized;
+}
+
+bool SimWindowSystem::ClassName(WindowId window, wchar_t* buffer, int size) {
+    SimLock lock = Enter(window);
+    Record(SimCall::GetClassNameW, window);
+    if (!Exists(window) || size <= 0) return false;
+    std::wcsncpy(buffer, Window(window).className, static_cast<size_t>(size) - 1);
+    buffer[size - 1] = L'\0';
+    return true;
+}
+
+bool SimWindowSystem::WindowTitle(WindowId window, wchar_t* buffer, int size) {
+    SimLock lock = Enter(window);
+    Record(SimCall::GetWindowTextW, window);
+    if (size <= 0) return false;
+    buffer[0] = L'\0';
+    if (Exists(window)) {
+        std::wcsncpy(buffer, Window(window).title.c_str(), static_cast<size_t>(size) - 1);
+        buffer[size - 1] = L'\0';
+    }
+    return true;
+}
+
+unsigned long SimWindowSystem::ProcessId(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::GetWindowThreadProcessId, window);
+    return Exists(window) ? Window(window).pid : 0;
+}
+
+bool SimWindowSystem::ProcessImagePath(unsigned long pid, wchar_t* buffer, int size) {
+    SimLock lock = Enter();
+    Record(SimCall::OpenProcess);
+    auto process = processes_.find(pid);
+    if (process == processes_.end() || size <= 0) return false;
+    Record(SimCall::QueryFullProcessImageNameW);
+    if (process->second.size() >= static_cast<size_t>(size)) return false;  // Buffer too small
+    std::wcscpy(buffer, process->second.c_str());
+    Record(SimCall::RegisterWaitForSingleObject);
+    return true;
+}
+
+unsigned long SimWindowSystem::Style(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::GetWindowLongW, window);
+    return Exists(window) ? Window(window).style : 0;
+}
+
+unsigned long SimWindowSystem::ExStyle(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::GetWindowLongW, window);
+    return Exists(window) ? Window(window).exStyle : 0;
+}
+
+bool SimWindowSystem::IsCloaked(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::DwmGetWindowAttribute, window);
+    return Exists(window) && Window(window).cloaked;
+}
+
+bool SimWindowSystem::WindowRect(WindowId window, Rect* rect) {
+    SimLock lock = Enter(window);
+    Record(SimCall::GetWindowRect, window);
+    if (!Exists(window)) return false;
+    *rect = Window(window).rect;
+    return true;
+}
+
+bool SimWindowSystem::FrameRect(WindowId window, Rect* rect) {
+    SimLock lock = Enter(window);
+    Record(SimCall::DwmGetWindowAttribute, window);
+    if (!Exists(window)) return false;
+    *rect = Window(window).rect;
+    return true;
+}
+
+bool SimWindowSystem::Place(const Placement& placement) {
+    SimLock lock = Enter(placement.window);
+    Record(SimCall::SetWindowPos, placement.window);
+    if (!Exists(placement.window)) return false;
+    Apply(placement);
+    return true;
+}
+
+bool SimWindowSystem::PlaceBatch(const Placement* batch, size_t count) {
+    SimLock lock = Enter();
+    Record(SimCall::BeginDeferWindowPos);
+    RecordCount(SimCall::DeferWindowPos, static_cast<long long>(count));
+    Record(SimCall::EndDeferWindowPos, count ? batch[0].window : 0);
+    if (failNextBatch) {
+        failNextBatch = false;
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!Exists(batch[i].window)) return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        Apply(batch[i]);
+    }
+    transactions_ += 1;
+    return true;
+}
+
+// Monitor containing the point, or the nearest one
+static MonitorId NearestMonitor(const std::vector<MonitorInfo>& monitors, const Point& point) {
+    MonitorId best = monitors.empty() ? 0 : 1;
+    long long bestDistance = -1;
+    for (size_t i = 0; i < monitors.size(); ++i) {
+        const Rect& r = monitors[i].monitor;
+        long dx = point.x < r.left ? r.left - point.x : (point.x >= r.right ? point.x - r.right + 1 : 0);
+        long dy = point.y < r.top ? r.top - point.y : (point.y >= r.bottom ? point.y - r.bottom + 1 : 0);
+        long long distance = static_cast<long long>(dx) * dx + static_cast<long long>(dy) * dy;
+        if (bestDistance < 0 || distance < bestDistance) {
+            bestDistance = distance;
+            best = static_cast<MonitorId>(i + 1);
+        }
+    }
+    return best;
+}
+
+MonitorId SimWindowSystem::MonitorOfWindow(WindowId window) {
+    SimLock lock = Enter(window);
+    Record(SimCall::MonitorFromWindow, window);
+    if (!Exists(window)) return NearestMonitor(monitors_, { 0, 0 });
+    const Rect& r = Window(window).rect;
+    return NearestMonitor(monitors_, { r.left + RectWidth(r) / 2, r.top + RectHeight(r) / 2 });
+}
+
+MonitorId SimWindowSystem::MonitorAt(const Point& point) {
+    SimLock lock = Enter();
+    Record(SimCall::MonitorFromPoint);
+    return NearestMonitor(monitors_, point);
+}
+
+bool SimWindowSystem::QueryMonitor(MonitorId monitor, MonitorInfo* info) {
+    SimLock lock = Enter();
+    Record(SimCall::GetMonitorInfoW);
+    if (monitor < 1 || monitor > monitors_.size()) return false;
+    *info = monitors_[monitor - 1];
+    return true;
+}
+
+void SimWindowSystem::EnumerateMonitors(std::vector<MonitorId>* monitors) {
+    SimLock lock = Enter();
+    Record(SimCall::EnumDisplayMonitors);
+    for (size_t i = 0; i < monitors_.size(); ++i) {
+        monitors->push_back(static_cast<MonitorId>(i + 1));
+    }
+}
+
+WindowId SimWindowSystem::CreateBorder(WindowId app, const Rect& rect) {
+    SimLock lock = Enter(app);
+    Record(SimCall::CreateWindowExW, app);
+    Record(SimCall::SetLayeredWindowAttributes, app);
+    Record(SimCall::SetWindowPos, app);
+    Record(SimCall::ShowWindow, app);
+
+    SimWindow border;
+    border.rect = rect;
+    border.border = true;
+    border.style = WINDOW_STYLE_POPUP;
+    border.exStyle = WINDOW_EXSTYLE_TOOLWINDOW;
+    border.className = L"WinTilerBorderClass";
+
+    // Handles of destroyed borders are recycled (as Windows does), so long runs that keep
+    // recreating the border neither grow the desktop nor allocate
+    WindowId id;
+    if (!freeBorders_.empty()) {
+        id = freeBorders_.back();
+        freeBorders_.pop_back();
+        Window(id) = border;
+    } else {
+        windows_.push_back(border);
+        id = static_cast<WindowId>(windows_.size());
+    }
+
+    // Right behind the app window
+    auto it = std::find(zOrder_.begin(), zOrder_.end(), app);
+    zOrder_.insert(it == zOrder_.end() ? zOrder_.end() : it + 1, id);
+    return id;
+}
+
+void SimWindowSystem::MoveBorder(WindowId border, WindowId app, const Rect& rect) {
+    SimLock lock = Enter(border);
+    Record(SimCall::SetWindowPos, border);
+    Record(SimCall::InvalidateRect, border);
+    if (!Exists(border)) return;
+    Window(border).rect = rect;
+    Window(border).visible = true;
+
+    // Restacked right behind the app window, as CreateBorder places it
+    Unlink(border);
+    auto it = std::find(zOrder_.begin(), zOrder_.end(), app);
+    zOrder_.insert(it == zOrder_.end() ? zOrder_.end() : it + 1, border);
+}
+
+void SimWindowSystem::DestroyBorder(WindowId border) {
+    SimLock lock = Enter(border);
+    Record(SimCall::DestroyWindow, border);
+    if (!Exists(border)) return;
+    Window(border).alive = false;
+    Window(border).visible = false;
+    Unlink(border);
+    freeBorders_.push_back(border);
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+// Simulated desktop behind the WindowSystem interface. Windows, monitors, focus and the cursor
+// are plain data; every method records the Win32 call(s) the real backend makes for it, so
+// benchmarks can run the actual tiler commands and count their OS calls.
+
+#include "constraints.h"
+#include "window_system.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class SimCall {
+    GetCursorPos,
+    SetCursorPos,
+    WindowFromPoint,
+    GetAncestor,
+    GetForegroundWindow,
+    SetForegroundWindow,
+    EnumWindows,
+    IsWindow,
+    IsWindowVisible,
+    IsIconic,
+    IsZoomed,
+    GetClassNameW,
+    GetWindowTextW,
+    GetWindowThreadProcessId,
+    OpenProcess,
+    QueryFullProcessImageNameW,
+    RegisterWaitForSingleObject,
+    GetWindowLongW,
+    DwmGetWindowAttribute,
+    GetWindowRect,
+    SetWindowPos,
+    BeginDeferWindowPos,
+    DeferWindowPos,
+    EndDeferWindowPos,
+    MonitorFromWindow,
+    MonitorFromPoint,
+    GetMonitorInfoW,
+    EnumDisplayMonitors,
+    CreateWindowExW,
+    SetLayeredWindowAttributes,
+    ShowWindow,
+    InvalidateRect,
+    DestroyWindow,
+    Count
+};
+
+const char* SimCallName(SimCall call);
+
+struct SimWindow {
+    Rect rect = {};
+    bool alive = true;
+    bool visible = true;
+    bool minimized = false;
+    bool maximized = false;
+    bool cloaked = false;
+    bool border = false;  // One of the tiler's border overlays
+    unsigned long style = WINDOW_STYLE_CAPTION;
+    unsigned long exStyle = 0;
+    const wchar_t* className = L"SimWindow";
+    std::wstring title;
+    unsigned long pid = 0;  // Owning process, see SetProcessPath
+    long long replyNs = 0;  // Every call on the window takes this long first (a busy or hung app)
+    SizeConstraints limits;  // Enforced on placement, like an app answering WM_GETMINMAXINFO
+};
+
+class SimWindowSystem : public WindowSystem {
+public:
+    // Desktop setup; none of these count as OS calls
+    MonitorId AddMonitor(const Rect& bounds, long taskbarHeight = 40);
+    WindowId AddWindow(const Rect& rect);  // Becomes the topmost window
+    SimWindow& Window(WindowId window) { return windows_[window - 1]; }
+    size_t WindowCount() const { return windows_.size(); }
+    void SetCursorPoint(const Point& point) { cursor_ = point; }
+    void SetForeground(WindowId window);  // Raises the window and gives it focus
+    void CloseWindow(WindowId window);
+    // Executable of process `pid`; an empty path ends the process (ProcessImagePath fails)
+    void SetProcessPath(unsigned long pid, const std::wstring& path);
+
+    // Recorded calls since the last ResetCalls
+    void ResetCalls();
+    long long Calls(SimCall call) const { return calls_[static_cast<int>(call)]; }
+    long long TotalCalls() const;
+    long long Transactions() const { return transactions_; }  // Committed PlaceBatch calls
+    void FormatCalls(std::string* out) const;  // "Name=count ..." for every call made
+
+    // Serialize calls with a lock, for tiler code that also calls from worker threads (startup
+    // adoption). The setup methods above are never locked; the single-threaded benchmarks leave
+    // this off and pay nothing for it.
+    bool concurrentCalls = false;
+
+    // Drop the next PlaceBatch transaction, like a window dying mid-batch
+    bool failNextBatch = false;
+
+    // Block the next call of a kind for `durationNs` (a hung target window, a DWM stall)
+    void InjectStall(SimCall call, long long durationNs);
+
+    bool CursorPosition(Point* point) override;
+    bool MoveCursor(const Point& point) override;
+    WindowId WindowAt(const Point& point) override;
+    WindowId RootWindow(WindowId window) override;
+    WindowId ForegroundWindow() override;
+    bool Activate(WindowId window) override;
+    void EnumerateWindows(std::vector<WindowId>* windows) override;
+    bool IsAlive(WindowId window) override;
+    bool IsVisible(WindowId window) override;
+    bool IsMinimized(WindowId window) override;
+    bool IsMaximized(WindowId window) override;
+    bool ClassName(WindowId window, wchar_t* buffer, int size) override;
+    bool WindowTitle(WindowId window, wchar_t* buffer, int size) override;
+    unsigned long ProcessId(WindowId window) override;
+    bool ProcessImagePath(unsigned long pid, wchar_t* buffer, int size) override;
+    unsigned long Style(WindowId window) override;
+    unsigned long ExStyle(WindowId window) override;
+    bool IsCloaked(WindowId window) override;
+    bool WindowRect(WindowId window, Rect* rect) override;
+    bool FrameRect(WindowId window, Rect* rect) override;
+    bool Place(const Placement& placement) override;
+    bool PlaceBatch(const Placement* batch, size_t count) override;
+    MonitorId MonitorOfWindow(WindowId window) override;
+    MonitorId MonitorAt(const Point& point) override;
+    bool QueryMonitor(MonitorId monitor, MonitorInfo* info) override;
+    void EnumerateMonitors(std::vector<MonitorId>* monitors) override;
+    WindowId CreateBorder(WindowId app, const Rect& rect) override;
+    void MoveBorder(WindowId border, WindowId app, const Rect& rect) override;
+    void DestroyBorder(WindowId border) override;
+
+private:
+    typedef std::unique_lock<std::mutex> SimLock;
+
+    // Start of every call: waits out the window's replyNs (unlocked, so other threads' calls
+    // go on meanwhile), then holds the lock for the call if concurrentCalls is set
+    SimLock Enter(WindowId window = 0);
+
+    void Record(SimCall call, WindowId window = 0) {
+        calls_[static_cast<int>(call)] += 1;
+        if (call == stallCall_) Stall(call, window);
+    }
+    void RecordCount(SimCall call, long long count) { calls_[static_cast<int>(call)] += count; }
+    void Stall(SimCall call, WindowId window);
+    bool Exists(WindowId window) const;
+    void Apply(const Placement& placement);
+    void Raise(WindowId window);
+    void Unlink(WindowId window);
+
+    std::vector<SimWindow> windows_;    // WindowId = index + 1
+    std::vector<WindowId> zOrder_;      // Live windows, topmost first
+    std::vector<MonitorInfo> monitors_;  // MonitorId = index + 1
+    std::vector<WindowId> freeBorders_;  // Destroyed border handles, reused by CreateBorder
+    std::unordered_map<unsigned long, std::wstring> processes_;  // Running processes by id
+    Point cursor_ = { 0, 0 };
+    WindowId foreground_ = 0;
+    long long calls_[static_cast<int>(SimCall::Count)] = {};
+    long long transactions_ = 0;
+    SimCall stallCall_ = SimCall::Count;  // Count = no stall armed
+    long long stallNs_ = 0;
+    std::mutex mutex_;
+};
@@ -0,0 +1,255 @@
+// The status-bar state feed under load: a writer thread publishes as fast as it can into a
+// named shared-memory region while a forked reader process and two reader threads, each with
+// its own read-only mapping, poll it without locking. Every published record is derived from
+// its publication number, so a reader can tell a torn copy from a consistent one; none may be
+// torn and `changes` may never go backwards.
+//
+// Then: a writer that died mid-write (odd sequence) makes Read give up instead of hanging the
+// bar, a foreign block is refused, and the tiler on the simulated desktop publishes focus
+// changes, snaps and parked windows, and nothing when the state is unchanged. Exits non-zero
+// on any mismatch.
+
+#include "bench_util.h"
+#include "shared_region.h"
+#include "sim_window_system.h"
+#include "state_feed.h"
+#include "tiler.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const long long DURATION_NS = 1000000000;  // 1 s of publishing
+static const long long READER_TIMEOUT_NS = 10000000000LL;
+static const int READER_THREADS = 2;
+static const int SAMPLE_EVERY = 64;  // Publish latency sample rate
+
+static const char BENCH[] = "state_feed_stress";
+
+// Record `n` (n >= 1); the writer numbers publications from 1, so `changes` equals `n`
+static FeedState MakeRecord(std::uint64_t n) {
+    FeedState state = {};
+    state.window = n;
+    state.pid = static_cast<std::uint32_t>(n * 7);
+    state.state = static_cast<std::int32_t>(n % 10);
+    state.flags = static_cast<std::uint32_t>(n % 4);
+    state.monitor = static_cast<std::int32_t>(n % 3);
+    for (int i = 0; i < 4; ++i) state.monitorBounds[i] = static_cast<std::int32_t>(n + i * 1000);
+    state.workspace = static_cast<std::int32_t>(n % STATE_FEED_WORKSPACES);
+    for (int i = 0; i < STATE_FEED_WORKSPACES; ++i) state.parked[i] = static_cast<std::uint32_t>(n ^ i);
+    return state;
+}
+
+static bool Consistent(const FeedState& state) {
+    FeedState expected = MakeRecord(state.window);
+    expected.changes = state.window;
+    return std::memcmp(&state, &expected, sizeof(FeedState)) == 0;
+}
+
+struct ReaderStats {
+    long long reads = 0;    // Consistent copies
+    long long busy = 0;     // Read gave up (the writer kept the record busy)
+    long long torn = 0;     // Copies that mixed two records
+    long long backwards = 0;
+    long long retries = 0;
+};
+
+// Poll until the writer's stop record (window 0 after the first publication) or the timeout
+static ReaderStats ReadUntilStopped(const char* name) {
+    ReaderStats stats;
+    SharedRegion region;
+    StateFeedReader reader;
+    if (!OpenSharedRegion(name, sizeof(StateFeedBlock), &region) || !reader.Attach(region.base, region.size)) {
+        stats.torn = -1;
+        return stats;
+    }
+    std::uint64_t last = 0;
+    BenchClock::time_point start = BenchClock::now();
+    for (long long poll = 1;; ++poll) {
+        FeedState state;
+        if (!reader.Read(&state)) {
+            stats.busy += 1;
+        } else if (state.window == 0) {
+            if (state.changes != 0) break;  // Stop record
+        } else {
+            stats.reads += 1;
+            if (!Consistent(state)) stats.torn += 1;
+            if (state.changes < last) stats.backwards += 1;
+            last = state.changes;
+        }
+        if ((poll & 1023) == 0 && ElapsedNs(start) > READER_TIMEOUT_NS) break;
+    }
+    stats.retries = reader.Retries();
+    CloseSharedRegion(&region);
+    return stats;
+}
+
+static void Report(const char* who, const ReaderStats& stats) {
+    std::printf("bench=state_feed reader=%s reads=%lld busy=%lld retries=%lld torn=%lld backwards=%lld\n",
+                who, stats.reads, stats.busy, stats.retries, stats.torn, stats.backwards);
+    BenchCheck(BENCH, stats.torn == 0, "a reader saw a torn record (or could not open the region)");
+    BenchCheck(BENCH, stats.backwards == 0, "a reader saw the change count go backwards");
+    BenchCheck(BENCH, stats.reads > 0, "a reader never got a record");
+}
+
+static void StressTest() {
+    char name[64];
+    std::snprintf(name, sizeof(name), "WinVimTilerFeedStress%d", static_cast<int>(getpid()));
+    RemoveSharedRegion(name);
+    SharedRegion region;
+    StateFeedWriter writer;
+    if (!CreateSharedRegion(name, sizeof(StateFeedBlock), &region) || !writer.Attach(region.base, region.size)) {
+        BenchCheck(BENCH, false, "could not create the region");
+        return;
+    }
+
+    // The other process maps the region by name, like a status bar
+    int pipeFds[2];
+    BenchCheck(BENCH, pipe(pipeFds) == 0, "pipe failed");
+    pid_t child = fork();
+    if (child == 0) {
+        close(pipeFds[0]);
+        ReaderStats stats = ReadUntilStopped(name);
+        ssize_t written = write(pipeFds[1], &stats, sizeof(stats));
+        _exit(written == sizeof(stats) ? 0 : 1);
+    }
+    close(pipeFds[1]);
+
+    ReaderStats threadStats[READER_THREADS];
+    std::thread readers[READER_THREADS];
+    for (int i = 0; i < READER_THREADS; ++i) {
+        readers[i] = std::thread([&threadStats, i, &name] { threadStats[i] = ReadUntilStopped(name); });
+    }
+
+    std::vector<long long> publish;
+    std::uint64_t n = 0;
+    BenchClock::time_point start = BenchClock::now();
+    while (ElapsedNs(start) < DURATION_NS) {
+        for (int i = 0; i < SAMPLE_EVERY - 1; ++i) writer.Publish(MakeRecord(++n));
+        BenchClock::time_point publishStart = BenchClock::now();
+        writer.Publish(MakeRecord(++n));
+        publish.push_back(ElapsedNs(publishStart));
+    }
+    BenchCheck(BENCH, writer.Publications() == static_cast<long long>(n), "a distinct record was not published");
+    BenchCheck(BENCH, !writer.Publish(MakeRecord(n)), "an unchanged record was published again");
+    writer.Publish(FeedState());  // Stop record
+
+    for (std::thread& reader : readers) reader.join();
+    ReaderStats childStats;
+    bool got = read(pipeFds[0], &childStats, sizeof(childStats)) == sizeof(childStats);
+    close(pipeFds[0]);
+    int status = 0;
+    waitpid(child, &status, 0);
+    BenchCheck(BENCH, got && WIFEXITED(status) && WEXITSTATUS(status) == 0, "the reader process failed");
+
+    char params[128];
+    std::snprintf(params, sizeof(params), "op=publish readers=%d publications=%lld", READER_THREADS + 1, writer.Publications());
+    ReportSamples("state_feed", params, publish);
+    if (got) Report("process", childStats);
+    for (int i = 0; i < READER_THREADS; ++i) Report("thread", threadStats[i]);
+
+    writer.Detach();
+    CloseSharedRegion(&region);
+    RemoveSharedRegion(name);
+}
+
+// A writer that died between its two sequence stores; the bar gets false, not a hang
+static void StuckWriterTest() {
+    StateFeedBlock block = {};
+    StateFeedWriter writer;
+    StateFeedReader reader;
+    BenchCheck(BENCH, writer.Attach(&block, sizeof(block)), "writer attach failed");
+    BenchCheck(BENCH, reader.Attach(&block, sizeof(block)), "reader attach failed");
+    writer.Publish(MakeRecord(1));
+
+    std::uint32_t sequence = reader.Sequence();
+    BenchCheck(BENCH, !writer.Publish(MakeRecord(1)), "an unchanged record was published");
+    BenchCheck(BENCH, reader.Sequence() == sequence, "the sequence moved without a change");
+
+    block.sequence.fetch_add(1);
+    FeedState state;
+    BenchClock::time_point start = BenchClock::now();
+    BenchCheck(BENCH, !reader.Read(&state), "a read succeeded during a write");
+    long long stuckNs = ElapsedNs(start);
+    BenchCheck(BENCH, reader.Retries() == StateFeedReader::MAX_TRIES, "the stuck read did not retry");
+    std::printf("bench=state_feed op=stuck_writer_read giveup_ns=%lld tries=%lld\n", stuckNs, reader.Retries());
+
+    // A restarted writer carries on with an even sequence above the old one
+    BenchCheck(BENCH, writer.Attach(&block, sizeof(block)), "writer re-attach failed");
+    BenchCheck(BENCH, reader.Sequence() > sequence && (reader.Sequence() & 1) == 0, "re-attach did not continue the sequence");
+    BenchCheck(BENCH, reader.Read(&state) && state.window == 0, "re-attach did not publish an empty record");
+
+    StateFeedBlock foreign = {};
+    foreign.magic = 0x12345678;
+    BenchCheck(BENCH, !reader.Attach(&foreign, sizeof(foreign)), "a foreign block was accepted");
+    BenchCheck(BENCH, !reader.Attach(&block, sizeof(block) - 4), "a short block was accepted");
+}
+
+// The tiler's publications on a simulated desktop
+static void TilerTest() {
+    SimWindowSystem sim;
+    sim.AddMonitor({ 0, 0, 2560, 1440 });
+    sim.AddMonitor({ 2560, 0, 5120, 1440 });
+    WindowId first = sim.AddWindow({ 300, 300, 1100, 900 });
+    sim.AddWindow({ 1500, 300, 2200, 900 });
+    WindowId remote = sim.AddWindow({ 3000, 300, 3800, 900 });
+    sim.Window(first).pid = 41;
+    sim.Window(remote).pid = 42;
+
+    StateFeedBlock block = {};
+    StateFeedWriter writer;
+    StateFeedReader reader;
+    writer.Attach(&block, sizeof(block));
+    reader.Attach(&block, sizeof(block));
+
+    InitTiler(&sim);
+    RefreshMonitorCache();
+    AttachStateFeed(&writer);
+    FeedState state;
+
+    sim.SetForeground(first);
+    UpdateFocusedWindow();
+    BenchCheck(BENCH, reader.Read(&state) && state.window == first && state.pid == 41, "focus change not published");
+    BenchCheck(BENCH, state.monitor == 1 && state.monitorBounds[2] == 2560 && state.flags == 0, "wrong monitor or flags");
+
+    // Snap the focused window; the same focus again publishes nothing
+    sim.SetCursorPoint({ 500, 500 });
+    HandleSnapRequest(SnapDirection::Left);
+    BenchCheck(BENCH, reader.Read(&state) && state.state == static_cast<std::int32_t>(WindowState::LeftHalf) &&
+               (state.flags & FEED_TRACKED), "snap not published");
+    std::uint32_t sequence = reader.Sequence();
+    UpdateFocusedWindow();
+    RefreshMonitorCache();
+    BenchCheck(BENCH, reader.Sequence() == sequence, "an unchanged state was published");
+
+    // Another window of the monitor parked on workspace 2
+    sim.SetCursorPoint({ 1800, 500 });
+    HandleMoveToWorkspace(2);
+    BenchCheck(BENCH, reader.Read(&state) && state.window == first && state.parked[2] == 1 && state.workspace == 0,
+               "parked window not published");
+
+    sim.SetForeground(remote);
+    UpdateFocusedWindow();
+    BenchCheck(BENCH, reader.Read(&state) && state.window == remote && state.pid == 42 && state.monitor == 2 &&
+               state.parked[2] == 0 && !(state.flags & FEED_TRACKED), "focus on the second monitor not published");
+
+    DetachStateFeed();
+    sequence = reader.Sequence();
+    sim.SetForeground(first);
+    UpdateFocusedWindow();
+    BenchCheck(BENCH, reader.Sequence() == sequence, "a detached feed was written");
+    ShutdownTiler();
+
+    std::printf("bench=state_feed op=tiler_publications publications=%lld\n", writer.Publications());
+}
+
+int main() {
+    StressTest();
+    StuckWriterTest();
+    TilerTest();
+    std::printf("bench=state_feed_check failures=%d\n", benchFailures);
+    return benchFailures ? 1 : 0;
+}
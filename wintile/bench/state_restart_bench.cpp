@@ -0,0 +1,247 @@
+// Warm restart from the memory-mapped state store. 500 windows of 60 processes on a simulated
+// two-monitor desktop are snapped into halves and quarters, some maximized, with the store
+// attached to a mapped file; every change must cost one 80-byte slot write, never a rewrite of
+// the file. While the "tiler is down" windows close, and handles turn up in other processes and
+// classes. Each restart maps the file again into a fresh tiler and times restart-to-ready
+// (map, attach, monitor refresh, re-attach to live windows). The restored states and maximize
+// restore points must match what was saved, the stale entries must be dropped, and a torn slot
+// and a file of another version must be rejected. Exits non-zero on any mismatch.
+
+#include "bench_util.h"
+#include "sim_window_system.h"
+#include "state_store.h"
+#include "tiler.h"
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const int WINDOWS = 500;
+static const int PROCESSES = 60;
+static const int RESTARTS = 50;
+static const int TAMPERED = 10;  // Each of: closed, other process, other class
+static const long long READY_BUDGET_NS = 5000000;  // 5 ms
+
+static const WindowState states[] = {
+    WindowState::LeftHalf, WindowState::RightHalf, WindowState::TopLeftQuarter, WindowState::TopRightQuarter,
+    WindowState::BottomLeftQuarter, WindowState::BottomRightQuarter, WindowState::TopHalf, WindowState::BottomHalf,
+};
+static const wchar_t* const classNames[] = {
+    L"Chrome_WidgetWin_1", L"CASCADIA_HOSTING_WINDOW_CLASS", L"Notepad", L"MozillaWindowClass",
+    L"SunAwtFrame", L"XLMAIN", L"OpusApp", L"CabinetWClass",
+};
+
+// The state file, mapped the way WinMain maps it
+struct MappedFile {
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+    void* view = nullptr;
+
+    void* Open(const std::string& path, size_t size) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return nullptr;
+        mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, static_cast<DWORD>(size), NULL);
+        view = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+#else
+        fd = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+        if (fd < 0) return nullptr;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (static_cast<size_t>(info.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+            return nullptr;
+        }
+        void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        view = mapped == MAP_FAILED ? nullptr : mapped;
+#endif
+        return view;
+    }
+
+    void Close(size_t size) {
+#ifdef _WIN32
+        if (view) UnmapViewOfFile(view);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+        mapping = NULL;
+#else
+        if (view) munmap(view, size);
+        if (fd >= 0) close(fd);
+        fd = -1;
+#endif
+        view = nullptr;
+    }
+};
+
+struct Saved {
+    WindowState state = WindowState::Unknown;
+    bool maximized = false;
+    Rect original = {};  // Where the maximize toggle must put it back
+};
+
+static const char BENCH[] = "state_restart_bench";
+
+int main() {
+    std::string path = (std::filesystem::temp_directory_path() / "wintile_state_restart_bench.state").string();
+    std::filesystem::remove(path);
+    const size_t size = StateStore::FileSize();
+    char params[192];
+
+    SimWindowSystem sim;
+    MonitorId monitors[2] = { sim.AddMonitor({ 0, 0, 1920, 1080 }), sim.AddMonitor({ 1920, 0, 3840, 1080 }) };
+    std::vector<WindowId> windows;
+    for (int i = 0; i < WINDOWS; ++i) {
+        long x = 1920L * (i % 2) + 10L * (i % 40);
+        WindowId window = sim.AddWindow({ x, 80, x + 900, 700 });
+        sim.Window(window).pid = 100 + i % PROCESSES;
+        sim.Window(window).className = classNames[i % 8];
+        windows.push_back(window);
+    }
+
+    // Snaps with no store, for the cost of the store on the snap path
+    InitTiler(&sim);
+    RefreshMonitorCache();
+    std::vector<long long> plain;
+    for (int i = 0; i < WINDOWS; ++i) {
+        BenchClock::time_point start = BenchClock::now();
+        SnapWindow(windows[i], states[(i / 2) % 8], monitors[i % 2]);
+        plain.push_back(ElapsedNs(start));
+    }
+    ShutdownTiler();
+
+    // The same snaps with the store attached to a fresh file
+    MappedFile file;
+    StateStore store;
+    InitTiler(&sim);
+    RefreshMonitorCache();
+    void* view = file.Open(path, size);
+    BenchCheck(BENCH, view != nullptr, "cannot map the state file");
+    if (!view) return 1;
+    BenchCheck(BENCH, store.Attach(view, size) == 0 && AttachStateStore(&store) == 0, "fresh file was not empty");
+
+    std::vector<long long> snaps;
+    std::vector<Saved> saved(WINDOWS);
+    long long snapWrites = 0;
+    for (int i = 0; i < WINDOWS; ++i) {
+        long long before = store.Writes();
+        BenchClock::time_point start = BenchClock::now();
+        SnapWindow(windows[i], states[(i / 2) % 8], monitors[i % 2]);
+        snaps.push_back(ElapsedNs(start));
+        snapWrites += store.Writes() - before;
+        saved[i].state = states[(i / 2) % 8];
+    }
+    BenchCheck(BENCH, snapWrites == WINDOWS, "a snap wrote more than its own slot");
+
+    // Every 10th window maximized with the toggle, remembering where it was
+    long long before = store.Writes();
+    for (int i = 0; i < WINDOWS; i += 10) {
+        saved[i].original = sim.Window(windows[i]).rect;
+        MaximizeWindow(windows[i]);
+        saved[i].state = WindowState::Maximized;
+        saved[i].maximized = true;
+    }
+    long long maximizeWrites = store.Writes() - before;
+
+    std::snprintf(params, sizeof(params), "op=snap store=none windows=%d", WINDOWS);
+    ReportSamples("state_restart", params, plain);
+    std::snprintf(params, sizeof(params), "op=snap store=mapped windows=%d slot_writes=%lld bytes_per_write=%zu file_bytes=%zu",
+                  WINDOWS, snapWrites, sizeof(StoredWindow), size);
+    ReportSamples("state_restart", params, snaps);
+    BenchCheck(BENCH, maximizeWrites == 2 * (WINDOWS / 10), "maximize wrote more than two slot updates");
+
+    // While the tiler is down: windows close, handles show up in other processes and classes
+    std::vector<bool> stale(WINDOWS, false);
+    for (int t = 0; t < TAMPERED; ++t) {
+        int closed = 3 + 30 * t, moved = 5 + 30 * t, renamed = 7 + 30 * t;
+        sim.CloseWindow(windows[closed]);
+        sim.Window(windows[moved]).pid = 9999;
+        sim.Window(windows[renamed]).className = L"SomeOtherClass";
+        stale[closed] = stale[moved] = stale[renamed] = true;
+    }
+
+    // Restarts: a fresh tiler maps the file and re-attaches
+    std::vector<long long> restarts;
+    long long restoreCalls = 0;
+    size_t restored = 0;
+    for (int r = 0; r < RESTARTS; ++r) {
+        DetachStateStore();
+        store.Detach();
+        file.Close(size);
+        InitTiler(&sim);
+        sim.ResetCalls();
+
+        BenchClock::time_point start = BenchClock::now();
+        view = file.Open(path, size);
+        if (view) store.Attach(view, size);
+        RefreshMonitorCache();
+        restored = view ? AttachStateStore(&store) : 0;
+        restarts.push_back(ElapsedNs(start));
+        restoreCalls = sim.TotalCalls();
+
+        BenchCheck(BENCH, restored == WINDOWS - 3 * TAMPERED, "wrong number of windows restored");
+        BenchCheck(BENCH, store.Size() == restored, "stale entries left in the store");
+    }
+    for (int i = 0; i < WINDOWS; ++i) {
+        WindowState expected = stale[i] ? WindowState::Unknown : saved[i].state;
+        if (TrackedWindowState(windows[i]) != expected) {
+            BenchCheck(BENCH, false, "restored state differs from the saved one");
+            break;
+        }
+    }
+
+    std::snprintf(params, sizeof(params), "op=restart_to_ready windows=%d restored=%zu os_calls=%lld",
+                  WINDOWS, restored, restoreCalls);
+    ReportSamples("state_restart", params, restarts);  // Sorts the samples
+    long long readyP50 = Percentile(restarts, 0.50);
+    BenchCheck(BENCH, readyP50 < READY_BUDGET_NS, "restart-to-ready over budget");
+
+    // The maximize toggle still knows where to go back to
+    int restoredToggles = 0;
+    for (int i = 0; i < WINDOWS; i += 10) {
+        if (stale[i]) continue;
+        MaximizeWindow(windows[i]);
+        restoredToggles += sim.Window(windows[i]).rect == saved[i].original ? 1 : 0;
+        BenchCheck(BENCH, !store.Find(windows[i]), "window back from maximize kept its slot");
+        if (restoredToggles == 5) break;
+    }
+    BenchCheck(BENCH, restoredToggles == 5, "maximize restore point lost across the restart");
+
+    // A torn slot is dropped; a file of another version is started over
+    size_t expectedAfterTear = store.Size() - 1;
+    for (size_t i = 0; i < STATE_STORE_CAPACITY; ++i) {
+        if (const StoredWindow* slot = store.SlotAt(i)) {
+            const_cast<StoredWindow*>(slot)->original[0] ^= 0x40;  // Half-written record
+            break;
+        }
+    }
+    DetachStateStore();
+    BenchCheck(BENCH, store.Attach(view, size) == expectedAfterTear, "torn slot was accepted");
+    static_cast<StateStoreHeader*>(view)->version = STATE_STORE_VERSION + 1;
+    InitTiler(&sim);
+    RefreshMonitorCache();
+    BenchCheck(BENCH, store.Attach(view, size) == 0 && AttachStateStore(&store) == 0, "file of another version was read");
+    BenchCheck(BENCH, static_cast<StateStoreHeader*>(view)->version == STATE_STORE_VERSION, "file of another version was not reset");
+
+    DetachStateStore();
+    store.Detach();
+    ShutdownTiler();
+    file.Close(size);
+    std::filesystem::remove(path);
+
+    std::printf("bench=state_restart_check windows=%d restored=%zu ready_p50_ns=%lld budget_ns=%lld failures=%d\n",
+                WINDOWS, restored, readyP50, READY_BUDGET_NS, benchFailures);
+    return benchFailures ? 1 : 0;
+}
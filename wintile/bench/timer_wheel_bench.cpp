@@ -0,0 +1,252 @@
+// Timer wheel check and benchmark. First a randomized cross-check against a plain reference
+// model: timers scheduled from a tick to beyond the wheel's 2^32-tick reach, rescheduled,
+// cancelled, made periodic from their callbacks, with the clock advanced in small steps and
+// long idle jumps. Every Advance must fire exactly the timers due by then, in due order, and
+// NextWakeNs must never lie past the earliest due time. Then 100,000 outstanding timers are
+// scheduled, rescheduled (debounce), cancelled and expired, with the per-operation cost
+// compared to a std::multimap and the allocation tracker confirming the wheel never
+// allocates. Exits non-zero on any mismatch.
+
+#include "alloc_tracker.h"
+#include "bench_util.h"
+#include "timer_wheel.h"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+
+static const long long TICK_NS = 1000;  // 1 us ticks, so the test reaches the top level quickly
+
+// Reference model of one timer
+struct Model {
+    Timer timer;
+    bool armed = false;
+    std::uint64_t fireTick = 0;  // Tick it must fire at
+    long long periodNs = 0;      // Reschedules itself from the callback when set
+};
+
+struct CrossCheck {
+    TimerWheel wheel;
+    std::vector<Model> models;
+    std::uint64_t current = 0;  // Reference copy of the wheel's tick
+    std::vector<std::pair<int, std::uint64_t>> fired;  // Timer and fire tick, in callback order
+    int failures = 0;
+
+    explicit CrossCheck(size_t count) : wheel(TICK_NS), models(count) {
+        for (size_t i = 0; i < models.size(); ++i) {
+            models[i].timer.SetCallback(OnFire, this);
+        }
+    }
+
+    static void OnFire(void* context, long long nowNs);
+
+    void Schedule(int id, long long dueNs) {
+        Model& model = models[id];
+        std::uint64_t due = dueNs > 0 ? static_cast<std::uint64_t>((dueNs + TICK_NS - 1) / TICK_NS) : 0;
+        model.fireTick = due > current ? due : current + 1;
+        model.armed = true;
+        wheel.Schedule(&model.timer, dueNs);
+    }
+
+    void Cancel(int id) {
+        models[id].armed = false;
+        wheel.Cancel(&models[id].timer);
+    }
+
+    void Fail(const char* what, int id) {
+        if (failures++ < 10) std::fprintf(stderr, "timer_wheel: %s (timer %d, tick %llu)\n", what, id,
+                                          static_cast<unsigned long long>(current));
+    }
+
+    void Advance(long long nowNs) {
+        std::uint64_t target = static_cast<std::uint64_t>(nowNs / TICK_NS);
+
+        // What must fire, in due order
+        std::multimap<std::uint64_t, int> expected;
+        for (size_t i = 0; i < models.size(); ++i) {
+            if (models[i].armed && models[i].fireTick <= target) expected.emplace(models[i].fireTick, static_cast<int>(i));
+        }
+
+        // Never later than the earliest due time
+        long long wake = wheel.NextWakeNs();
+        if (!expected.empty() && (wake < 0 || wake > static_cast<long long>(expected.begin()->first) * TICK_NS)) {
+            Fail("NextWakeNs after the earliest due time", expected.begin()->second);
+        }
+
+        fired.clear();
+        size_t count = wheel.Advance(nowNs);
+        if (target > current) current = target;
+
+        if (count != expected.size() || fired.size() != expected.size()) Fail("wrong number of timers fired", -1);
+        std::uint64_t last = 0;
+        for (auto& [id, tick] : fired) {
+            if (tick < last) Fail("fired out of due order", id);
+            if (tick > target) Fail("fired early", id);
+            last = tick;
+        }
+        size_t armed = 0;
+        for (const Model& model : models) armed += model.armed ? 1 : 0;
+        if (armed != wheel.Size()) Fail("armed count differs", -1);
+    }
+};
+
+void CrossCheck::OnFire(void* context, long long nowNs) {
+    CrossCheck* check = static_cast<CrossCheck*>(context);
+    // Find which timer fired: the only one the wheel disarmed that the model still has armed
+    for (size_t i = 0; i < check->models.size(); ++i) {
+        Model& model = check->models[i];
+        if (model.armed && !model.timer.Armed() && model.fireTick <= static_cast<std::uint64_t>(nowNs / TICK_NS)) {
+            model.armed = false;
+            check->fired.emplace_back(static_cast<int>(i), model.fireTick);
+            if (model.periodNs) {
+                // The wheel is at the fire tick while the callback runs
+                std::uint64_t saved = check->current;
+                check->current = model.fireTick;
+                check->Schedule(static_cast<int>(i), nowNs + model.periodNs);
+                check->current = saved;
+            }
+            return;
+        }
+    }
+    check->Fail("callback for an unknown timer", -1);
+}
+
+static int RunCrossCheck() {
+    CrossCheck check(2000);
+    std::mt19937_64 rng(7);
+    long long now = 0;
+
+    for (int round = 0; round < 4000; ++round) {
+        int ops = 1 + static_cast<int>(rng() % 20);
+        for (int op = 0; op < ops; ++op) {
+            int id = static_cast<int>(rng() % check.models.size());
+            unsigned roll = static_cast<unsigned>(rng() % 100);
+            long long delay;
+            unsigned range = static_cast<unsigned>(rng() % 100);
+            if (range < 50) {
+                delay = static_cast<long long>(rng() % 300) * TICK_NS;  // Level 0
+            } else if (range < 80) {
+                delay = static_cast<long long>(rng() % 70000) * TICK_NS;  // Level 1
+            } else if (range < 95) {
+                delay = static_cast<long long>(rng() % (1ULL << 25)) * TICK_NS;  // Levels 2/3
+            } else {
+                delay = static_cast<long long>(rng() % (1ULL << 34)) * TICK_NS;  // Beyond the wheel
+            }
+            if (rng() % 10 == 0) delay -= static_cast<long long>(rng() % 5) * TICK_NS;  // Past due
+            delay += static_cast<long long>(rng() % TICK_NS);  // Not on a tick boundary
+
+            if (roll < 60) {
+                check.models[id].periodNs = rng() % 10 == 0 ? (1 + static_cast<long long>(rng() % 500)) * TICK_NS : 0;
+                check.Schedule(id, now + delay);
+            } else {
+                check.Cancel(id);
+            }
+        }
+
+        // Mostly short steps, sometimes a long idle jump
+        unsigned jump = static_cast<unsigned>(rng() % 100);
+        if (jump < 85) {
+            now += static_cast<long long>(rng() % 400) * TICK_NS + static_cast<long long>(rng() % TICK_NS);
+        } else if (jump < 98) {
+            now += static_cast<long long>(rng() % 200000) * TICK_NS;
+        } else {
+            now += static_cast<long long>(rng() % (1ULL << 33)) * TICK_NS;
+        }
+        check.Advance(now);
+        if (check.failures) break;
+    }
+
+    long long wake = check.wheel.NextWakeNs();
+    std::printf("bench=timer_wheel_check timers=%zu rounds=4000 final_tick=%llu armed=%zu next_wake_ticks=%lld failures=%d\n",
+                check.models.size(), static_cast<unsigned long long>(check.current), check.wheel.Size(),
+                wake < 0 ? -1 : wake / TICK_NS - static_cast<long long>(check.current), check.failures);
+    return check.failures;
+}
+
+static long long firedCount = 0;
+
+static void CountFire(void*, long long) {
+    ++firedCount;
+}
+
+static void PrintRate(const char* op, const char* container, size_t count, long long ns) {
+    std::printf("bench=timer_wheel_ops op=%s container=%s timers=%zu ns_per_op=%.1f\n", op, container, count,
+                static_cast<double>(ns) / static_cast<double>(count));
+}
+
+static int RunThroughput() {
+    const size_t count = 100000;
+    const long long tickNs = 1000000;                 // 1 ms, as on the desktop
+    const long long horizonNs = 600LL * 1000000000;  // Dues spread over 10 minutes
+    std::mt19937_64 rng(13);
+
+    std::vector<long long> dues(count), moved(count);
+    for (size_t i = 0; i < count; ++i) {
+        dues[i] = tickNs + static_cast<long long>(rng() % horizonNs);
+        moved[i] = tickNs + static_cast<long long>(rng() % horizonNs);
+    }
+
+    TimerWheel wheel(tickNs);
+    std::vector<Timer> timers(count);
+    for (Timer& timer : timers) timer.SetCallback(CountFire, nullptr);
+
+    StartAllocationTracking();
+    BenchClock::time_point start = BenchClock::now();
+    for (size_t i = 0; i < count; ++i) wheel.Schedule(&timers[i], dues[i]);
+    long long scheduleNs = ElapsedNs(start);
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < count; ++i) wheel.Schedule(&timers[i], moved[i]);
+    long long rescheduleNs = ElapsedNs(start);
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < count; i += 2) wheel.Cancel(&timers[i]);
+    long long cancelNs = ElapsedNs(start);
+
+    // Expire the rest in 1 ms steps for the first second, then in 100 ms steps
+    firedCount = 0;
+    size_t advances = 0;
+    start = BenchClock::now();
+    for (long long now = 0; now <= horizonNs + tickNs; now += now < 1000000000 ? tickNs : 100 * tickNs) {
+        wheel.Advance(now);
+        ++advances;
+    }
+    long long expireNs = ElapsedNs(start);
+    StopAllocationTracking();
+
+    PrintRate("schedule", "wheel", count, scheduleNs);
+    PrintRate("reschedule", "wheel", count, rescheduleNs);
+    PrintRate("cancel", "wheel", count / 2, cancelNs);
+    PrintRate("expire", "wheel", static_cast<size_t>(firedCount > 0 ? firedCount : 1), expireNs);
+
+    // Baseline: the same workload on an ordered multimap (allocates and is O(log n))
+    std::multimap<long long, size_t> map;
+    std::vector<std::multimap<long long, size_t>::iterator> entries(count);
+    start = BenchClock::now();
+    for (size_t i = 0; i < count; ++i) entries[i] = map.emplace(dues[i], i);
+    PrintRate("schedule", "multimap", count, ElapsedNs(start));
+    start = BenchClock::now();
+    for (size_t i = 0; i < count; ++i) {
+        map.erase(entries[i]);
+        entries[i] = map.emplace(moved[i], i);
+    }
+    PrintRate("reschedule", "multimap", count, ElapsedNs(start));
+    start = BenchClock::now();
+    for (size_t i = 0; i < count; i += 2) map.erase(entries[i]);
+    PrintRate("cancel", "multimap", count / 2, ElapsedNs(start));
+
+    long long allocations = TrackedAllocations();
+    bool ok = firedCount == static_cast<long long>(count / 2) && wheel.Size() == 0 && allocations == 0;
+    std::printf("bench=timer_wheel_outstanding timers=%zu fired=%lld advances=%zu allocations=%lld ok=%d\n",
+                count, firedCount, advances, allocations, ok ? 1 : 0);
+    if (!ok) std::fprintf(stderr, "timer_wheel: throughput run fired %lld of %zu, %lld allocation(s)\n",
+                          firedCount, count / 2, allocations);
+    return ok ? 0 : 1;
+}
+
+int main() {
+    int failures = RunCrossCheck();
+    failures += RunThroughput();
+    return failures ? 1 : 0;
+}
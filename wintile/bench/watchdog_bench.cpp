@@ -0,0 +1,186 @@
+// Stall watchdog check: runs real tiler commands on the simulated window system with stalls
+// injected into single OS calls, plus stalls inside a dialog, a command and bare message
+// handling. Every stall must be detected once with the right cause, command, target and OS
+// call, and a long run of normal commands and idle time must report nothing. Prints the
+// detection delay per stall; exits non-zero on any mismatch.
+
+#include "bench_util.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+#include "watchdog.h"
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+static const long long THRESHOLD_NS = 20000000;  // 20 ms
+static const long long STALL_NS = 80000000;      // Four thresholds, so polling cannot miss it
+
+static std::mutex reportsMutex;
+static std::vector<StallReport> reports;
+
+static void CollectStall(const StallReport& report) {
+    std::lock_guard<std::mutex> lock(reportsMutex);
+    reports.push_back(report);
+}
+
+// Reports collected so far, and clears them
+static std::vector<StallReport> TakeReports() {
+    std::lock_guard<std::mutex> lock(reportsMutex);
+    std::vector<StallReport> taken;
+    taken.swap(reports);
+    return taken;
+}
+
+// Let the watchdog poll at least once more after the loop went idle
+static void Settle() {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(THRESHOLD_NS));
+}
+
+static void SleepNs(long long ns) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+}
+
+static bool SameName(const char* a, const char* b) {
+    if (!a || !b) return a == b;
+    return std::strcmp(a, b) == 0;
+}
+
+static int failures = 0;
+
+// One stall case: run `handle` as a single message, then check for exactly one detected and
+// one recovered report matching the expectation
+template <typename Fn>
+static void Expect(const char* name, StallCause cause, const char* command, WindowId target,
+                   const char* osCall, WindowId osCallWindow, Fn handle) {
+    ResetWatchdogCounts();
+    TakeReports();
+
+    BenchClock::time_point start = BenchClock::now();
+    WatchdogBusy();
+    handle();
+    WatchdogIdle();
+    long long handledNs = ElapsedNs(start);
+    Settle();
+
+    std::vector<StallReport> got = TakeReports();
+    const StallReport* detected = nullptr;
+    const StallReport* recovered = nullptr;
+    for (const StallReport& report : got) {
+        if (!report.recovered && !detected) detected = &report;
+        if (report.recovered && !recovered) recovered = &report;
+    }
+
+    bool ok = got.size() == 2 && detected && recovered && detected->cause == cause &&
+              recovered->cause == cause && SameName(detected->command, command) &&
+              detected->target == target && SameName(detected->osCall, osCall) &&
+              detected->osCallWindow == osCallWindow &&
+              WatchdogStallCount(cause) == 1 && recovered->stalledNs >= detected->stalledNs;
+    for (int i = 0; i < static_cast<int>(StallCause::Count); ++i) {
+        if (i != static_cast<int>(cause) && WatchdogStallCount(static_cast<StallCause>(i))) ok = false;
+    }
+
+    char params[300];
+    std::snprintf(params, sizeof(params), "case=%s cause=%s threshold_ms=%.0f handled_ms=%.1f detected_ms=%.1f recovered_ms=%.1f reports=%zu ok=%d",
+                  name, StallCauseName(cause), THRESHOLD_NS / 1e6, handledNs / 1e6,
+                  detected ? detected->stalledNs / 1e6 : 0.0, recovered ? recovered->stalledNs / 1e6 : 0.0,
+                  got.size(), ok ? 1 : 0);
+    std::printf("bench=watchdog_stall %s\n", params);
+
+    if (!ok) {
+        ++failures;
+        for (const StallReport& report : got) {
+            std::string line;
+            FormatStallReport(report, &line);
+            std::fprintf(stderr, "watchdog: %s: %s\n", name, line.c_str());
+        }
+    }
+}
+
+int main() {
+    SimWindowSystem sim;
+    sim.AddMonitor({ 0, 0, 1920, 1080 });
+    sim.AddMonitor({ 1920, 0, 3840, 1080 });
+    std::vector<WindowId> windows;
+    for (int i = 0; i < 8; ++i) {
+        long x = 100 + 60 * i;
+        windows.push_back(sim.AddWindow({ x, 100, x + 800, 700 }));
+    }
+
+    StartWatchdog(THRESHOLD_NS, CollectStall);
+    InitTiler(&sim);
+    RefreshMonitorCache();
+
+    auto focus = [&](WindowId window) {
+        sim.SetForeground(window);
+        const Rect& r = sim.Window(window).rect;
+        sim.SetCursorPoint({ r.left + RectWidth(r) / 2, r.top + RectHeight(r) / 2 });
+    };
+
+    // No false positives: many quick commands, then the loop idles for many thresholds
+    ResetWatchdogCounts();
+    std::vector<long long> samples;
+    for (int i = 0; i < 2000; ++i) {
+        WindowId window = windows[i % windows.size()];
+        focus(window);
+        BenchClock::time_point start = BenchClock::now();
+        WatchdogBusy();
+        UpdateFocusedWindow();
+        HandleSnapRequest(static_cast<SnapDirection>(i % 4));
+        WatchdogIdle();
+        samples.push_back(ElapsedNs(start));
+    }
+    SleepNs(10 * THRESHOLD_NS);
+    std::vector<StallReport> spurious = TakeReports();
+    char params[200];
+    std::snprintf(params, sizeof(params), "commands=%zu idle_ms=%.0f reports=%zu",
+                  samples.size(), 10 * THRESHOLD_NS / 1e6, spurious.size());
+    ReportSamples("watchdog_quiet", params, samples);
+    if (!spurious.empty()) {
+        ++failures;
+        std::fprintf(stderr, "watchdog: %zu report(s) without a stall\n", spurious.size());
+    }
+
+    // A hung target window: SetWindowPos blocks inside a snap
+    WindowId snapped = windows[2];
+    focus(snapped);
+    UpdateFocusedWindow();
+    Expect("snap_set_window_pos", StallCause::OsCall, "HandleSnapRequest", snapped, "SetWindowPos", snapped, [&] {
+        sim.InjectStall(SimCall::SetWindowPos, STALL_NS);
+        HandleSnapRequest(SnapDirection::Left);
+    });
+
+    // DWM stalls while the focus border is placed
+    WindowId focused = windows[5];
+    focus(focused);
+    Expect("focus_dwm", StallCause::OsCall, "UpdateFocusedWindow", focused, "DwmGetWindowAttribute", focused, [&] {
+        sim.InjectStall(SimCall::DwmGetWindowAttribute, STALL_NS);
+        UpdateFocusedWindow();
+    });
+
+    // An error dialog left open
+    Expect("dialog", StallCause::Dialog, nullptr, 0, "MessageBoxW", 0, [&] {
+        WatchdogCall call("MessageBoxW", 0, StallCause::Dialog);
+        SleepNs(STALL_NS);
+    });
+
+    // A command busy in its own code, between OS calls
+    Expect("command", StallCause::Command, "HandleArrangeRequest", windows[1], nullptr, 0, [&] {
+        WatchdogCommand command("HandleArrangeRequest", windows[1]);
+        SleepNs(STALL_NS);
+    });
+
+    // Message handling outside any command
+    Expect("message_loop", StallCause::MessageLoop, nullptr, 0, nullptr, 0, [&] {
+        SleepNs(STALL_NS);
+    });
+
+    std::string counts;
+    FormatStallCounts(&counts);
+    StopWatchdog();
+    ShutdownTiler();
+
+    std::printf("bench=watchdog_summary failures=%d last_%s\n", failures, counts.c_str());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,373 @@
+// Benchmark suite for the scenarios listed in OPTIMISATIONS.md ("Benchmark-Szenarien"): rapid
+// hotkey spam, multi-monitor stress, 1000+ open windows, cold start, plus a replayed window
+// event stream. Every scenario runs the real tiler commands against the simulated window
+// system and reports latency percentiles, throughput and OS calls per operation.
+//
+// Usage: wintile_bench [scenario ...]   (default: all scenarios, in a fixed order)
+
+#include "bench_util.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+#include <cstring>
+#include <random>
+#include <string>
+
+// Latency samples and OS calls of one kind of operation
+struct OpStats {
+    std::vector<long long> samples;
+    long long calls = 0;
+};
+
+template <typename Fn>
+static void Measure(SimWindowSystem& sim, OpStats& stats, Fn fn) {
+    long long before = sim.TotalCalls();
+    BenchClock::time_point start = BenchClock::now();
+    fn();
+    stats.samples.push_back(ElapsedNs(start));
+    stats.calls += sim.TotalCalls() - before;
+}
+
+// One result line: `params` plus throughput and OS calls per operation
+static void Report(const char* name, const char* params, OpStats& stats) {
+    long long total = 0;
+    for (long long s : stats.samples) total += s;
+    size_t count = stats.samples.size();
+    long long opsPerSecond = total > 0 ? static_cast<long long>(count * 1000000000.0 / total) : 0;
+    double callsPerOp = count ? static_cast<double>(stats.calls) / count : 0.0;
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%s ops_per_s=%lld os_calls_per_op=%.2f", params, opsPerSecond, callsPerOp);
+    ReportSamples(name, line, stats.samples);
+}
+
+// Desktop of 1920x1080 monitors in two rows with `count` app windows spread over them and
+// half as many background (hidden or tool) windows. The topmost app window has focus and
+// the cursor.
+struct Desktop {
+    SimWindowSystem sim;
+    std::vector<MonitorId> monitors;
+    std::vector<WindowId> windows;
+    std::mt19937 rng;
+
+    Desktop(int monitorCount, int count, unsigned seed, bool init = true) : rng(seed) {
+        int columns = monitorCount > 1 ? (monitorCount + 1) / 2 : 1;
+        for (int i = 0; i < monitorCount; ++i) {
+            long x = 1920L * (i % columns);
+            long y = 1080L * (i / columns);
+            monitors.push_back(sim.AddMonitor({ x, y, x + 1920, y + 1080 }));
+        }
+        for (int i = 0; i < count / 2; ++i) {
+            WindowId window = sim.AddWindow({ 0, 0, 300, 200 });
+            if (i % 2 == 0) {
+                sim.Window(window).visible = false;
+            } else {
+                sim.Window(window).exStyle = WINDOW_EXSTYLE_TOOLWINDOW;
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            windows.push_back(OpenWindow());
+        }
+        if (init) Start();
+    }
+
+    ~Desktop() { ShutdownTiler(); }
+
+    void Start() {
+        InitTiler(&sim);
+        RefreshMonitorCache();
+        if (!windows.empty()) Focus(windows.back());
+    }
+
+    // New 800x600 window at a random spot on a random monitor
+    WindowId OpenWindow() {
+        MonitorInfo info;
+        sim.QueryMonitor(monitors[rng() % monitors.size()], &info);
+        long x = info.work.left + static_cast<long>(rng() % 1000);
+        long y = info.work.top + static_cast<long>(rng() % 400);
+        return sim.AddWindow({ x, y, x + 800, y + 600 });
+    }
+
+    WindowId RandomWindow() { return windows[rng() % windows.size()]; }
+
+    // Give a window focus the way the shell does and put the cursor on it
+    void Focus(WindowId window) {
+        sim.SetForeground(window);
+        const Rect& r = sim.Window(window).rect;
+        sim.SetCursorPoint({ r.left + RectWidth(r) / 2, r.top + RectHeight(r) / 2 });
+        UpdateFocusedWindow();
+    }
+};
+
+static const SnapDirection directions[] = {
+    SnapDirection::Left, SnapDirection::Up, SnapDirection::Right, SnapDirection::Down
+};
+
+// 100 presses per second on the focused window: snaps, monitor switches and split resizes,
+// with an occasional switch to another window. Presses are paced on a virtual clock, so a
+// press that takes longer than the gap to the next one delays it; deadline_misses counts
+// presses that finished more than one gap after they arrived.
+static void RunHotkeySpam() {
+    const long long intervalNs = 10000000;  // 100 presses/s
+    const int presses = 5000;
+    Desktop d(2, 24, 11);
+
+    OpStats stats;
+    long long finishNs = 0;
+    int misses = 0;
+    for (int i = 0; i < presses; ++i) {
+        if (i % 50 == 49) d.Focus(d.RandomWindow());
+        SnapDirection direction = directions[(i * 7 / 3) % 4];
+        Measure(d.sim, stats, [&] {
+            switch (i % 10) {
+                case 7:
+                    HandleMonitorSwitch(direction == SnapDirection::Left ? SnapDirection::Left : SnapDirection::Right);
+                    break;
+                case 9:
+                    if (QueueSplitResize(SplitAxis::X, (i / 10) % 2 ? 1 : -1)) ApplyPendingSplitResize();
+                    break;
+                default:
+                    HandleSnapRequest(direction);
+                    break;
+            }
+        });
+
+        long long arrivalNs = i * intervalNs;
+        finishNs = std::max(finishNs, arrivalNs) + stats.samples.back();
+        if (finishNs - arrivalNs > intervalNs) ++misses;
+    }
+
+    char params[128];
+    std::snprintf(params, sizeof(params), "rate_hz=100 windows=24 monitors=2 deadline_misses=%d", misses);
+    Report("hotkey_spam", params, stats);
+}
+
+// Monitor switches in every direction across a 2-row monitor grid, with a display change
+// (monitor cache refresh) every 100 switches
+static void RunMultiMonitor() {
+    const int monitorCounts[] = { 4, 8 };
+    for (int monitorCount : monitorCounts) {
+        Desktop d(monitorCount, 8 * monitorCount, 23);
+        HandleSnapRequest(SnapDirection::Left);
+
+        OpStats switches;
+        OpStats refreshes;
+        for (int i = 0; i < 4000; ++i) {
+            SnapDirection direction = directions[(i / 3) % 4];
+            Measure(d.sim, switches, [&] { HandleMonitorSwitch(direction); });
+            if (i % 100 == 99) {
+                Measure(d.sim, refreshes, [&] { RefreshMonitorCache(); });
+            }
+            if (i % 500 == 499) d.Focus(d.RandomWindow());
+        }
+
+        char params[128];
+        std::snprintf(params, sizeof(params), "op=monitor_switch monitors=%d windows=%d", monitorCount, 8 * monitorCount);
+        Report("multi_monitor", params, switches);
+        std::snprintf(params, sizeof(params), "op=display_change monitors=%d windows=%d", monitorCount, 8 * monitorCount);
+        Report("multi_monitor", params, refreshes);
+    }
+}
+
+// Per-command cost on a crowded desktop; commands that walk every top-level window are the
+// ones that should grow with the window count
+static void RunManyWindows() {
+    const int windowCounts[] = { 1000, 2000 };
+    for (int count : windowCounts) {
+        Desktop d(4, count, 37);
+        OpStats snap, focus, fill, arrange, workspace;
+
+        for (int i = 0; i < 500; ++i) {
+            Measure(d.sim, snap, [&] { HandleSnapRequest(directions[i % 4]); });
+        }
+        for (int i = 0; i < 500; ++i) {
+            WindowId window = d.RandomWindow();
+            d.sim.SetForeground(window);
+            Measure(d.sim, focus, [&] { UpdateFocusedWindow(); });
+        }
+        d.Focus(d.windows.back());
+        for (int i = 0; i < 20; ++i) {
+            Measure(d.sim, fill, [&] { HandleFillRequest(); });
+        }
+        for (int i = 0; i < 5; ++i) {
+            Measure(d.sim, arrange, [&] { HandleArrangeRequest(i % 2 ? ArrangeLayout::MasterStack : ArrangeLayout::Grid); });
+        }
+        for (int i = 0; i < 20; ++i) {
+            Measure(d.sim, workspace, [&] { HandleWorkspaceSwitch(1); });
+            Measure(d.sim, workspace, [&] { HandleWorkspaceSwitch(0); });
+        }
+
+        const char* names[] = { "snap", "focus_change", "fill", "arrange", "workspace_switch" };
+        OpStats* stats[] = { &snap, &focus, &fill, &arrange, &workspace };
+        for (int i = 0; i < 5; ++i) {
+            char params[128];
+            std::snprintf(params, sizeof(params), "op=%s windows=%d monitors=4", names[i], count);
+            Report("many_windows", params, *stats[i]);
+        }
+    }
+}
+
+// First hotkey after start: tiler start-up (state reset + monitor cache), the first snap, and
+// a second snap for comparison. first_run_ns is the first snap of the first iteration, the
+// only one that also pays for a cold process (page faults, empty allocator caches).
+static void RunColdStart() {
+    const int iterations = 300;
+    OpStats startup, first, warm;
+    long long firstRunNs = 0;
+    for (int i = 0; i < iterations; ++i) {
+        Desktop d(2, 50, 100 + i, false);
+        Measure(d.sim, startup, [&] {
+            InitTiler(&d.sim);
+            RefreshMonitorCache();
+        });
+        d.Focus(d.windows.back());
+        Measure(d.sim, first, [&] { HandleSnapRequest(SnapDirection::Left); });
+        if (i == 0) firstRunNs = first.samples.back();
+        Measure(d.sim, warm, [&] { HandleSnapRequest(SnapDirection::Up); });
+    }
+
+    char params[128];
+    std::snprintf(params, sizeof(params), "op=startup windows=50 monitors=2");
+    Report("cold_start", params, startup);
+    std::snprintf(params, sizeof(params), "op=first_hotkey windows=50 monitors=2 first_run_ns=%lld", firstRunNs);
+    Report("cold_start", params, first);
+    std::snprintf(params, sizeof(params), "op=second_hotkey windows=50 monitors=2");
+    Report("cold_start", params, warm);
+}
+
+// Replay of a seeded window event stream (focus changes, user moves, windows opening,
+// closing, hiding and reappearing), dispatched the way WinEventProc does
+static void RunEventReplay() {
+    enum EventKind { Focus, MoveSizeEnd, Open, Close, Hide, Show, EventKindCount };
+    const char* kindNames[] = { "foreground", "move_size_end", "show_new", "destroy", "hide", "show" };
+    const int events = 20000;
+
+    Desktop d(2, 100, 59);
+    for (int i = 0; i < 20; ++i) {
+        SnapWindow(d.windows[i], i % 2 ? WindowState::RightHalf : WindowState::LeftHalf, d.monitors[i % 2]);
+    }
+
+    OpStats all;
+    OpStats perKind[EventKindCount];
+    std::vector<WindowId> hidden;
+    for (int i = 0; i < events; ++i) {
+        unsigned roll = d.rng() % 100;
+        EventKind kind = roll < 40 ? Focus : roll < 65 ? MoveSizeEnd : roll < 75 ? Open : roll < 85 ? Close : roll < 93 ? Hide : Show;
+        if (d.windows.size() < 20 && (kind == Close || kind == Hide)) kind = Open;
+        if (kind == Show && hidden.empty()) kind = Focus;
+
+        WindowId window = 0;
+        void (*handler)(WindowId) = nullptr;
+        switch (kind) {
+            case Focus:
+                window = d.RandomWindow();
+                d.sim.SetForeground(window);
+                break;
+            case MoveSizeEnd: {
+                window = d.RandomWindow();
+                Rect& r = d.sim.Window(window).rect;
+                long dx = static_cast<long>(d.rng() % 200) - 100;
+                r = { r.left + dx, r.top, r.right + dx, r.bottom };
+                handler = HandleWindowShown;
+                break;
+            }
+            case Open:
+                window = d.OpenWindow();
+                d.windows.push_back(window);
+                handler = HandleWindowShown;
+                break;
+            case Close: {
+                size_t index = d.rng() % d.windows.size();
+                window = d.windows[index];
+                d.windows.erase(d.windows.begin() + index);
+                d.sim.CloseWindow(window);
+                handler = HandleWindowDestroyed;
+                break;
+            }
+            case Hide: {
+                size_t index = d.rng() % d.windows.size();
+                window = d.windows[index];
+                d.windows.erase(d.windows.begin() + index);
+                d.sim.Window(window).visible = false;
+                hidden.push_back(window);
+                handler = HandleWindowHidden;
+                break;
+            }
+            case Show:
+                window = hidden.back();
+                hidden.pop_back();
+                d.sim.Window(window).visible = true;
+                d.windows.push_back(window);
+                handler = HandleWindowShown;
+                break;
+            default:
+                break;
+        }
+
+        Measure(d.sim, perKind[kind], [&] {
+            if (handler) {
+                handler(window);
+            } else {
+                UpdateFocusedWindow();
+            }
+        });
+        all.samples.push_back(perKind[kind].samples.back());
+    }
+    for (const OpStats& stats : perKind) all.calls += stats.calls;
+
+    char params[128];
+    std::snprintf(params, sizeof(params), "event=all events=%d", events);
+    Report("event_replay", params, all);
+    for (int kind = 0; kind < EventKindCount; ++kind) {
+        std::snprintf(params, sizeof(params), "event=%s events=%d", kindNames[kind], events);
+        Report("event_replay", params, perKind[kind]);
+    }
+}
+
+struct Scenario {
+    const char* name;
+    void (*run)();
+};
+
+static const Scenario scenarios[] = {
+    { "hotkey_spam", RunHotkeySpam },
+    { "multi_monitor", RunMultiMonitor },
+    { "many_windows", RunManyWindows },
+    { "cold_start", RunColdStart },
+    { "event_replay", RunEventReplay },
+};
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        bool known = false;
+        for (const Scenario& scenario : scenarios) {
+            if (std::strcmp(argv[i], scenario.name) == 0) known = true;
+        }
+        if (!known) {
+            std::fprintf(stderr, "wintile_bench: unknown scenario '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+
+#ifdef WINTILE_TRACE
+    const char* trace = "on";
+#else
+    const char* trace = "off";
+#endif
+#ifdef WINTILE_TIMELINE
+    const char* timeline = "on";
+#else
+    const char* timeline = "off";
+#endif
+    // Describes the build; the scenario lines follow in a fixed order
+    std::printf("bench=wintile_bench schema=1 trace=%s timeline=%s\n", trace, timeline);
+
+    for (const Scenario& scenario : scenarios) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], scenario.name) == 0) selected = true;
+        }
+        if (selected) scenario.run();
+    }
+    return 0;
+}
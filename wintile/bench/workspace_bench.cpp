@@ -0,0 +1,70 @@
+// Workspace switching on the simulated window system: 50 windows per workspace on a desktop
+// that also holds hidden/background top-level windows. Runs the real HandleWorkspaceSwitch,
+// measuring its wall time and the OS calls and placement transactions it issues per switch.
+
+#include "bench_util.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+#include "workspace.h"
+
+#include <random>
+#include <string>
+
+int main() {
+    const int windowsPerWorkspace = 50;
+    const int backgroundWindows = 150;
+    const int switches = 2000;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<long> coord(0, 1500);
+
+    SimWindowSystem sim;
+    sim.AddMonitor({ 0, 0, 2560, 1440 });
+    sim.SetCursorPoint({ 1280, 720 });
+
+    // Background windows (tool windows, hidden app windows) that EnumWindows still visits
+    for (int i = 0; i < backgroundWindows; ++i) {
+        WindowId window = sim.AddWindow({ 0, 0, 10, 10 });
+        if (i % 3 == 0) {
+            sim.Window(window).exStyle = WINDOW_EXSTYLE_TOOLWINDOW;
+        } else {
+            sim.Window(window).visible = false;
+        }
+    }
+
+    InitTiler(&sim);
+    RefreshMonitorCache();
+
+    // Populate every workspace: switching to an empty one hides the previous windows, so the
+    // windows opened next belong to it
+    for (int ws = 0; ws < WORKSPACE_COUNT; ++ws) {
+        HandleWorkspaceSwitch(ws);
+        for (int i = 0; i < windowsPerWorkspace; ++i) {
+            long x = coord(rng);
+            long y = coord(rng) / 2;
+            sim.AddWindow({ x, y, x + 800, y + 600 });
+        }
+    }
+    sim.SetForeground(static_cast<WindowId>(sim.WindowCount()));
+    UpdateFocusedWindow();
+
+    std::vector<long long> samples;
+    samples.reserve(switches);
+    sim.ResetCalls();
+    int active = WORKSPACE_COUNT - 1;
+    for (int i = 0; i < switches; ++i) {
+        int target = (active + 1 + i % (WORKSPACE_COUNT - 1)) % WORKSPACE_COUNT;
+        BenchClock::time_point start = BenchClock::now();
+        HandleWorkspaceSwitch(target);
+        samples.push_back(ElapsedNs(start));
+        active = target;
+    }
+
+    char params[200];
+    std::snprintf(params, sizeof(params),
+                  "windows_per_workspace=%d background_windows=%d os_calls_per_switch=%lld transactions_per_switch=%lld",
+                  windowsPerWorkspace, backgroundWindows, sim.TotalCalls() / switches,
+                  sim.Transactions() / switches);
+    ReportSamples("workspace_switch", params, samples);
+    ShutdownTiler();
+    return 0;
+}
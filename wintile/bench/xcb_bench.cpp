@@ -0,0 +1,187 @@
+// The XCB backend against a real X server ($DISPLAY, e.g. `Xvfb :99 &` and DISPLAY=:99): a
+// second connection plays the applications and maps 12 windows, then the tiler runs its
+// commands through XcbWindowSystem. For each command the server round trips it made are
+// counted (at most one: the QueryPointer of a hotkey aimed at the window under the cursor) and
+// the geometry the server reports afterwards is checked against the tiler's view. Exits
+// non-zero on any mismatch; without a display it reports `skipped=no_display` and exits 0.
+
+#include "bench_util.h"
+#include "event_queue.h"
+#include "tiler.h"
+#include "window_system_xcb.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cwchar>
+#include <string>
+
+static const int WINDOWS = 12;
+static const int ROUNDS = 50;
+
+static const char BENCH[] = "xcb_bench";
+
+static XcbWindowSystem windowSystem;
+
+static void OnWindowEvent(WindowEvent event, WindowId window) {
+    QueueWindowEvent(event, window);
+}
+
+// Wait until the server has handled everything sent on `connection`
+static void Sync(xcb_connection_t* connection) {
+    std::free(xcb_get_input_focus_reply(connection, xcb_get_input_focus(connection), nullptr));
+}
+
+// Let the server catch up, then take in its events as the daemon's loop does
+static void Pump(xcb_connection_t* apps) {
+    Sync(apps);
+    Sync(windowSystem.Connection());
+    windowSystem.ProcessEvents(OnWindowEvent, nullptr);
+    if (windowSystem.TakeMonitorsChanged()) RefreshMonitorCache();
+    while (WindowEventsPending()) DrainWindowEvents(EVENT_BATCH_SIZE);
+}
+
+// Geometry as the server has it, outer frame in root coordinates
+static bool ServerRect(xcb_connection_t* apps, xcb_window_t root, xcb_window_t window, Rect* rect) {
+    xcb_get_geometry_reply_t* geometry = xcb_get_geometry_reply(apps, xcb_get_geometry(apps, window), nullptr);
+    xcb_translate_coordinates_reply_t* origin =
+        xcb_translate_coordinates_reply(apps, xcb_translate_coordinates(apps, window, root, 0, 0), nullptr);
+    bool ok = geometry && origin;
+    if (ok) *rect = { origin->dst_x, origin->dst_y, origin->dst_x + geometry->width, origin->dst_y + geometry->height };
+    std::free(geometry);
+    std::free(origin);
+    return ok;
+}
+
+// Run `command` and report its round trips and time; every run must stay within `budget`
+template <typename Command>
+static void Measure(const char* name, xcb_connection_t* apps, long long budget, Command command) {
+    std::vector<long long> samples;
+    long long maxTrips = 0;
+    long long totalTrips = 0;
+    for (int i = 0; i < ROUNDS; ++i) {
+        long long before = windowSystem.RoundTrips();
+        BenchClock::time_point start = BenchClock::now();
+        command(i);
+        samples.push_back(ElapsedNs(start));
+        long long trips = windowSystem.RoundTrips() - before;
+        maxTrips = std::max(maxTrips, trips);
+        totalTrips += trips;
+        Pump(apps);
+    }
+    char params[96];
+    std::snprintf(params, sizeof(params), "round_trips_max=%lld round_trips_per_cmd=%.2f", maxTrips,
+                  static_cast<double>(totalTrips) / ROUNDS);
+    ReportSamples(name, params, samples);
+    if (maxTrips > budget) {
+        std::fprintf(stderr, "xcb_bench: %s made %lld round trips (budget %lld)\n", name, maxTrips, budget);
+        benchFailures++;
+    }
+}
+
+int main() {
+    if (!windowSystem.Connect(nullptr)) {
+        std::printf("bench=xcb skipped=no_display\n");
+        return 0;
+    }
+    xcb_connection_t* apps = xcb_connect(nullptr, nullptr);
+    if (xcb_connection_has_error(apps)) {
+        std::printf("bench=xcb skipped=no_display\n");
+        return 0;
+    }
+    xcb_window_t root = windowSystem.Root();
+    const xcb_screen_t* screen = xcb_setup_roots_iterator(xcb_get_setup(apps)).data;
+
+    // The applications: plain top-level windows with a class and a title
+    std::vector<xcb_window_t> windows;
+    const char wmClass[] = "bench\0XcbBench";
+    for (int i = 0; i < WINDOWS; ++i) {
+        xcb_window_t window = xcb_generate_id(apps);
+        std::uint32_t pixel = screen->white_pixel;
+        xcb_create_window(apps, XCB_COPY_FROM_PARENT, window, root, static_cast<std::int16_t>(20 + 30 * i),
+                          static_cast<std::int16_t>(20 + 20 * i), 400, 300, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                          screen->root_visual, XCB_CW_BACK_PIXEL, &pixel);
+        std::string title = "xcb bench " + std::to_string(i);
+        xcb_change_property(apps, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8,
+                            static_cast<std::uint32_t>(title.size()), title.data());
+        xcb_change_property(apps, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8,
+                            sizeof(wmClass), wmClass);
+        xcb_map_window(apps, window);
+        windows.push_back(window);
+    }
+
+    InitTiler(&windowSystem);
+    RefreshMonitorCache();
+    Pump(apps);
+
+    std::vector<WindowId> listed;
+    windowSystem.EnumerateWindows(&listed);
+    for (xcb_window_t window : windows) {
+        BenchCheck(BENCH, std::find(listed.begin(), listed.end(), window) != listed.end(), "a mapped window is not listed");
+        wchar_t text[64];
+        BenchCheck(BENCH, windowSystem.ClassName(window, text, 64) && std::wcscmp(text, L"XcbBench") == 0, "WM_CLASS not read");
+    }
+    std::printf("bench=xcb_setup windows=%d wm=%d monitors=%zu connect_round_trips=%lld\n", WINDOWS,
+                windowSystem.HasWindowManager() ? 1 : 0, [] {
+                    std::vector<MonitorId> monitors;
+                    windowSystem.EnumerateMonitors(&monitors);
+                    return monitors.size();
+                }(), windowSystem.RoundTrips());
+
+    static const WindowState states[] = { WindowState::LeftHalf, WindowState::RightHalf, WindowState::TopLeftQuarter,
+                                          WindowState::BottomRightQuarter };
+
+    // A snap of a given window: placement requests only
+    Measure("xcb_snap_window", apps, 0, [&](int i) {
+        SnapWindow(windows[i % WINDOWS], states[i % 4], 0);
+    });
+
+    // Hotkeys act on the window under the cursor: one QueryPointer
+    Measure("xcb_snap_request", apps, 1, [&](int i) {
+        Rect rect;
+        windowSystem.WindowRect(windows[i % WINDOWS], &rect);
+        windowSystem.MoveCursor({ rect.left + 5, rect.top + 5 });
+        Sync(windowSystem.Connection());
+        HandleSnapRequest(i % 2 ? SnapDirection::Right : SnapDirection::Left);
+    });
+    Measure("xcb_monitor_switch", apps, 1, [&](int i) {
+        (void)i;
+        HandleMonitorSwitch(SnapDirection::Right);
+    });
+    Measure("xcb_snap_batch", apps, 0, [&](int i) {
+        SnapTarget targets[WINDOWS];
+        for (int w = 0; w < WINDOWS; ++w) targets[w] = { windows[w], states[(w + i) % 4], 0 };
+        SnapWindows(targets, WINDOWS);
+    });
+    Measure("xcb_arrange", apps, 1, [&](int i) {
+        HandleArrangeRequest(i % 2 ? ArrangeLayout::MasterStack : ArrangeLayout::Grid);
+    });
+    Measure("xcb_workspace_switch", apps, 1, [&](int i) {
+        HandleWorkspaceSwitch(i % 2 + 1);
+    });
+    HandleWorkspaceSwitch(1);
+    Pump(apps);
+
+    // What the tiler thinks matches what the server did
+    SnapTarget targets[WINDOWS];
+    for (int w = 0; w < WINDOWS; ++w) targets[w] = { windows[w], states[w % 4], 0 };
+    SnapWindows(targets, WINDOWS);
+    Pump(apps);
+    int checked = 0;
+    for (int w = 0; w < WINDOWS; ++w) {
+        Rect cached, server;
+        if (!windowSystem.WindowRect(windows[w], &cached) || !ServerRect(apps, root, windows[w], &server)) {
+            BenchCheck(BENCH, false, "window lost");
+            continue;
+        }
+        BenchCheck(BENCH, cached == server, "cached geometry differs from the server's");
+        BenchCheck(BENCH, TrackedWindowState(windows[w]) == states[w % 4], "tracked state differs from the snap");
+        checked++;
+    }
+    std::printf("bench=xcb_geometry windows_checked=%d failures=%d\n", checked, benchFailures);
+
+    ShutdownTiler();
+    for (xcb_window_t window : windows) xcb_destroy_window(apps, window);
+    xcb_disconnect(apps);
+    windowSystem.Disconnect();
+    return benchFailures ? 1 : 0;
+}
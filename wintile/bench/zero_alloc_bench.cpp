@@ -0,0 +1,91 @@
+// Zero-allocation check for the hotkey path: after a warm-up pass, a burst of 10,000 snap
+// commands (halves, quarters, maximize toggles, moves across monitors, focus changes between
+// windows) plus monitor switches and split resizes must not touch the heap. Linked with the
+// allocation tracker; exits non-zero if anything allocates during the burst.
+
+#include "alloc_tracker.h"
+#include "bench_util.h"
+#include "sim_window_system.h"
+#include "tiler.h"
+
+static const SnapDirection directions[] = {
+    SnapDirection::Left, SnapDirection::Up, SnapDirection::Right, SnapDirection::Down,
+    SnapDirection::Right, SnapDirection::Down, SnapDirection::Left, SnapDirection::Left
+};
+
+struct Burst {
+    SimWindowSystem sim;
+    std::vector<WindowId> windows;
+
+    Burst() {
+        sim.AddMonitor({ 0, 0, 1920, 1080 });
+        sim.AddMonitor({ 1920, 0, 3840, 1080 });
+        sim.AddMonitor({ 0, 1080, 1920, 2160 });
+        for (int i = 0; i < 12; ++i) {
+            long x = 100 + 40 * i;
+            windows.push_back(sim.AddWindow({ x, 100, x + 800, 700 }));
+        }
+        sim.Window(windows[3]).limits.minWidth = 1100;  // Makes the solver move split lines
+        InitTiler(&sim);
+        RefreshMonitorCache();
+    }
+
+    void Focus(WindowId window) {
+        sim.SetForeground(window);
+        const Rect& r = sim.Window(window).rect;
+        sim.SetCursorPoint({ r.left + RectWidth(r) / 2, r.top + RectHeight(r) / 2 });
+        UpdateFocusedWindow();
+    }
+
+    // One pass of every command on the hotkey path
+    void Step(int i) {
+        if (i % 16 == 0) Focus(windows[(i / 16) % windows.size()]);
+        switch (i % 20) {
+            case 17:
+                HandleMonitorSwitch(directions[(i / 20) % 4]);
+                break;
+            case 19:
+                if (QueueSplitResize((i / 20) % 2 ? SplitAxis::X : SplitAxis::Y, (i / 40) % 2 ? 1 : -1)) {
+                    ApplyPendingSplitResize();
+                }
+                break;
+            default:
+                HandleSnapRequest(directions[i % 8]);
+                break;
+        }
+        if (i % 500 == 250) RefreshMonitorCache();  // Display change
+    }
+};
+
+int main() {
+    const int snaps = 10000;
+    Burst burst;
+
+    // Warm-up: the same sequence once, so every window has its record and every scratch
+    // buffer its final capacity
+    for (int i = 0; i < snaps; ++i) burst.Step(i);
+
+    burst.sim.ResetCalls();
+    std::vector<long long> samples(snaps);
+    StartAllocationTracking();
+    for (int i = 0; i < snaps; ++i) {
+        BenchClock::time_point start = BenchClock::now();
+        burst.Step(i);
+        samples[i] = ElapsedNs(start);
+    }
+    StopAllocationTracking();
+
+    long long allocations = TrackedAllocations();
+    char params[200];
+    std::snprintf(params, sizeof(params), "commands=%d windows=%zu monitors=3 allocations=%lld allocated_bytes=%lld",
+                  snaps, burst.windows.size(), allocations, TrackedAllocationBytes());
+    ReportSamples("zero_alloc_burst", params, samples);
+    ShutdownTiler();
+
+    if (allocations) {
+        std::fprintf(stderr, "zero_alloc: %lld allocation(s) during the burst, first of %zu bytes\n",
+                     allocations, FirstTrackedAllocationSize());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "border_tracker.h"
+
+#include "tiler.h"
+
+#include <cstdio>
+
+static bool dirty = false;
+static BorderTrackStats stats = {};
+
+bool NoteLocationChange(WindowId window) {
+    if (!window || window != FocusedWindow()) {
+        stats.ignored += 1;
+        return false;
+    }
+    stats.events += 1;
+    if (dirty) return false;  // A frame is already on its way
+    dirty = true;
+    return true;
+}
+
+bool BorderTrackDirty() {
+    return dirty;
+}
+
+bool TrackBorderFrame() {
+    stats.frames += 1;
+    if (!dirty) return false;
+    dirty = false;
+    TrackFocusedBorder();
+    stats.repositions += 1;
+    return true;
+}
+
+void ClearBorderTrack() {
+    dirty = false;
+}
+
+const BorderTrackStats& BorderTrackStatistics() {
+    return stats;
+}
+
+void ResetBorderTrackStats() {
+    stats = {};
+}
+
+void FormatBorderTrackStats(std::string* out) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "border_track events=%lld ignored=%lld frames=%lld repositions=%lld",
+                  stats.events, stats.ignored, stats.frames, stats.repositions);
+    out->append(line);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// Live border tracking while the focused window is dragged or resized. Location changes only
+// mark the border dirty; it is moved once per display frame at most, so a drag producing
+// hundreds of EVENT_OBJECT_LOCATIONCHANGE per second costs one SetWindowPos per refresh.
+// The caller paces the frames (DwmFlush on Windows) and asks for one whenever the border
+// turns dirty.
+
+#include "layout.h"
+
+#include <string>
+
+struct BorderTrackStats {
+    long long events;       // Location changes of the focused window
+    long long ignored;      // Location changes of other windows
+    long long frames;       // Frames delivered while tracking
+    long long repositions;  // Border moves issued
+};
+
+// EVENT_OBJECT_LOCATIONCHANGE of `window`. Returns true if the border just turned dirty and
+// the caller should request a frame.
+bool NoteLocationChange(WindowId window);
+
+bool BorderTrackDirty();
+
+// A display frame began: move the border if it is dirty. Returns true if it moved.
+bool TrackBorderFrame();
+
+// Forget a pending move (the tiler was reset)
+void ClearBorderTrack();
+
+const BorderTrackStats& BorderTrackStatistics();
+void ResetBorderTrackStats();
+
+// "border_track events=.. ignored=.. frames=.. repositions=.." line
+void FormatBorderTrackStats(std::string* out);
@@ -0,0 +1,348 @@
+#include "command.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+static bool IsBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Next blank-separated word of [*begin, end); advances *begin past it
+static bool NextWord(const char** begin, const char* end, const char** wordBegin, const char** wordEnd) {
+    const char* p = *begin;
+    while (p < end && IsBlank(*p)) ++p;
+    *wordBegin = p;
+    while (p < end && !IsBlank(*p)) ++p;
+    *wordEnd = p;
+    *begin = p;
+    return *wordBegin != *wordEnd;
+}
+
+static bool Equals(const char* begin, const char* end, const char* literal) {
+    size_t length = std::strlen(literal);
+    return static_cast<size_t>(end - begin) == length && std::memcmp(begin, literal, length) == 0;
+}
+
+// Window handle in hex (0x...) or decimal
+static bool ParseWindow(const char* begin, const char* end, WindowId* window) {
+    char text[32];
+    size_t length = static_cast<size_t>(end - begin);
+    if (length == 0 || length >= sizeof(text) || *begin == '-') return false;
+    std::memcpy(text, begin, length);
+    text[length] = '\0';
+    char* parsed = nullptr;
+    unsigned long long value = std::strtoull(text, &parsed, 0);
+    if (parsed != text + length || value == 0) return false;
+    *window = static_cast<WindowId>(value);
+    return true;
+}
+
+// A mark letter a-z
+static bool ParseMark(const char* begin, const char* end, char* mark) {
+    if (end - begin != 1 || *begin < 'a' || *begin > 'z') return false;
+    *mark = *begin;
+    return true;
+}
+
+// A window handle, or 'a for the window of mark a
+static bool ParseWindowOrMark(const char* begin, const char* end, WindowId* window, char* mark) {
+    if (begin < end && *begin == '\'') return ParseMark(begin + 1, end, mark);
+    return ParseWindow(begin, end, window);
+}
+
+// [monitor,]state, the syntax of a rule's place=
+static bool ParsePlacement(const char* begin, const char* end, SnapTarget* target) {
+    const char* comma = static_cast<const char*>(std::memchr(begin, ',', end - begin));
+    target->monitor = 0;
+    if (comma) {
+        if (comma == begin || comma - begin > 2) return false;
+        for (const char* p = begin; p < comma; ++p) {
+            if (*p < '0' || *p > '9') return false;
+            target->monitor = target->monitor * 10 + (*p - '0');
+        }
+        if (target->monitor < 1 || target->monitor > MAX_MONITORS) return false;
+        begin = comma + 1;
+    }
+    return FindSnapState(begin, end, &target->state);
+}
+
+bool ParseCommandLine(const char* begin, const char* end, TilerCommand* command, std::string* error) {
+    const char* wordBegin;
+    const char* wordEnd;
+    if (!NextWord(&begin, end, &wordBegin, &wordEnd)) {
+        *error = "empty command";
+        return false;
+    }
+    std::string name(wordBegin, wordEnd);
+    *command = TilerCommand();
+
+    if (name == "snap" || name == "focus" || name == "query") {
+        command->kind = name == "snap" ? CommandKind::Snap : name == "focus" ? CommandKind::Focus : CommandKind::Query;
+        if (!NextWord(&begin, end, &wordBegin, &wordEnd) ||
+            !ParseWindowOrMark(wordBegin, wordEnd, &command->target.window, &command->mark)) {
+            *error = name + " needs a window handle or 'mark";
+            return false;
+        }
+        if (command->kind == CommandKind::Snap) {
+            if (!NextWord(&begin, end, &wordBegin, &wordEnd)) {
+                *error = "snap needs a state";
+                return false;
+            }
+            if (!ParsePlacement(wordBegin, wordEnd, &command->target)) {
+                *error = "unknown snap state '" + std::string(wordBegin, wordEnd) + "'";
+                return false;
+            }
+        }
+    } else if (name == "session") {
+        command->kind = CommandKind::Session;
+        if (!NextWord(&begin, end, &wordBegin, &wordEnd)) {
+            *error = "session needs a name";
+            return false;
+        }
+        command->session.assign(wordBegin, wordEnd);
+    } else if (name == "mark" || name == "jump") {
+        // Before the bind commands of the same names, which wait for a letter key instead
+        command->kind = name == "mark" ? CommandKind::Mark : CommandKind::Jump;
+        if (!NextWord(&begin, end, &wordBegin, &wordEnd) || !ParseMark(wordBegin, wordEnd, &command->mark)) {
+            *error = name + " needs a letter a-z";
+            return false;
+        }
+        if (command->kind == CommandKind::Mark && NextWord(&begin, end, &wordBegin, &wordEnd) &&
+            !ParseWindow(wordBegin, wordEnd, &command->target.window)) {
+            *error = "bad window handle '" + std::string(wordBegin, wordEnd) + "'";
+            return false;
+        }
+    } else if (FindHotkeyCommand(wordBegin, wordEnd, &command->hotkey)) {
+        if (command->hotkey == HotkeyCommand::DumpLatency || command->hotkey == HotkeyCommand::DumpTimeline) {
+            *error = "'" + name + "' is a hotkey only";
+            return false;
+        }
+        command->kind = CommandKind::Hotkey;
+    } else {
+        *error = "unknown command '" + name + "'";
+        return false;
+    }
+
+    if (NextWord(&begin, end, &wordBegin, &wordEnd)) {
+        *error = "unexpected '" + std::string(wordBegin, wordEnd) + "' after " + name;
+        return false;
+    }
+    return true;
+}
+
+void CommandParser::Feed(const char* data, size_t size, CommandRequest* request) {
+    const char* end = data + size;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+        const char* lineEnd = newline ? newline : end;
+        if (!overlong_) {
+            if (partial_.size() + (lineEnd - data) > COMMAND_MAX_LINE) {
+                overlong_ = true;
+                partial_.clear();
+            } else {
+                partial_.append(data, lineEnd);
+            }
+        }
+        if (!newline) break;
+        data = newline + 1;
+
+        line_ += 1;
+        if (overlong_) {
+            // Still answered, so the replies keep pairing up with what was sent
+            overlong_ = false;
+            Add(false, TilerCommand(), "line longer than " + std::to_string(COMMAND_MAX_LINE) + " characters", request);
+        } else {
+            ParseLine(partial_.data(), partial_.data() + partial_.size(), request);
+        }
+        partial_.clear();
+    }
+}
+
+void CommandParser::ParseLine(const char* begin, const char* end, CommandRequest* request) {
+    while (begin < end && IsBlank(*begin)) ++begin;
+    while (end > begin && IsBlank(end[-1])) --end;
+    if (begin == end || *begin == '#') return;
+
+    if (Equals(begin, end, "begin")) {
+        if (inBatch_) {
+            Add(false, TilerCommand(), "begin inside a batch", request);
+            return;
+        }
+        inBatch_ = true;
+        batch_ = TilerCommand();
+        batch_.kind = CommandKind::Batch;
+        batchTargets_.clear();
+        batchMarks_.clear();
+        return;
+    }
+    if (Equals(begin, end, "commit")) {
+        if (!inBatch_) {
+            Add(false, TilerCommand(), "commit without begin", request);
+            return;
+        }
+        inBatch_ = false;
+        if (batch_.kind == CommandKind::Batch) {
+            batch_.first = request->targets.size();
+            batch_.count = batchTargets_.size();
+            request->targets.insert(request->targets.end(), batchTargets_.begin(), batchTargets_.end());
+            request->marks.insert(request->marks.end(), batchMarks_.begin(), batchMarks_.end());
+        }
+        request->commands.push_back(std::move(batch_));
+        batchTargets_.clear();
+        batchMarks_.clear();
+        return;
+    }
+
+    TilerCommand command;
+    std::string error;
+    bool parsed = ParseCommandLine(begin, end, &command, &error);
+    Add(parsed, std::move(command), std::move(error), request);
+}
+
+void CommandParser::Add(bool parsed, TilerCommand command, std::string error, CommandRequest* request) {
+    if (!inBatch_) {
+        if (!parsed) {
+            command = TilerCommand();
+            command.error = std::move(error);
+        }
+        request->commands.push_back(std::move(command));
+        return;
+    }
+
+    // In a batch: the first bad line fails the whole batch
+    if (batch_.kind != CommandKind::Batch) return;
+    if (parsed && command.kind != CommandKind::Snap) {
+        parsed = false;
+        error = "only snap lines in a batch";
+    } else if (parsed && batchTargets_.size() >= COMMAND_MAX_BATCH) {
+        parsed = false;
+        error = "more than " + std::to_string(COMMAND_MAX_BATCH) + " snaps in a batch";
+    }
+    if (!parsed) {
+        batch_.kind = CommandKind::Error;
+        batch_.error = "line " + std::to_string(line_) + ": " + error;
+        batchTargets_.clear();
+        batchMarks_.clear();
+        return;
+    }
+    batchTargets_.push_back(command.target);
+    batchMarks_.push_back(command.mark);
+}
+
+// Batch snaps with their marks looked up
+static std::vector<SnapTarget> markedTargets;
+
+// Put the window of `mark` (if not 0) into `target`; false with the error replied if the mark
+// is unset or its window gone
+static bool ResolveMark(char mark, SnapTarget* target, std::string* reply) {
+    if (!mark) return true;
+    target->window = MarkedWindow(mark);
+    if (target->window) return true;
+    *reply += "error mark '";
+    *reply += mark;
+    *reply += "' is not set\n";
+    return false;
+}
+
+void RunCommands(const CommandRequest& request, std::string* reply) {
+    for (const TilerCommand& command : request.commands) {
+        SnapTarget target = command.target;
+        switch (command.kind) {
+            case CommandKind::Hotkey:
+                RunWindowCommand(command.hotkey);
+                *reply += "ok\n";
+                break;
+            case CommandKind::Snap:
+                if (!ResolveMark(command.mark, &target, reply)) break;
+                *reply += SnapWindows(&target, 1) ? "ok\n" : "error window not snapped\n";
+                break;
+            case CommandKind::Focus:
+                if (!ResolveMark(command.mark, &target, reply)) break;
+                *reply += ActivateWindow(target.window) ? "ok\n" : "error window not activated\n";
+                break;
+            case CommandKind::Query:
+                if (!ResolveMark(command.mark, &target, reply)) break;
+                *reply += "ok ";
+                *reply += SnapStateName(TrackedWindowState(target.window));
+                *reply += "\n";
+                break;
+            case CommandKind::Mark:
+                *reply += SetMark(command.mark, command.target.window) ? "ok\n" : "error no window to mark\n";
+                break;
+            case CommandKind::Jump:
+                if (JumpToMark(command.mark)) {
+                    *reply += "ok\n";
+                } else {
+                    *reply += "error cannot jump to mark '";
+                    *reply += command.mark;
+                    *reply += "'\n";
+                }
+                break;
+            case CommandKind::Session: {
+                const char* name = command.session.c_str();
+                const LayoutSession* session = FindLayoutSession(CurrentConfig(), name, name + command.session.size());
+                if (!session) {
+                    *reply += "error unknown session '" + command.session + "'\n";
+                    break;
+                }
+                *reply += "ok " + std::to_string(ApplyLayoutSession(*session)) + "\n";
+                break;
+            }
+            case CommandKind::Batch: {
+                const SnapTarget* targets = request.targets.data() + command.first;
+                const char* marks = request.marks.data() + command.first;
+                if (std::any_of(marks, marks + command.count, [](char mark) { return mark != 0; })) {
+                    markedTargets.assign(targets, targets + command.count);
+                    size_t i = 0;
+                    while (i < command.count && ResolveMark(marks[i], &markedTargets[i], reply)) ++i;
+                    if (i < command.count) break;
+                    targets = markedTargets.data();
+                }
+                size_t snapped = command.count ? SnapWindows(targets, command.count) : 0;
+                *reply += "ok " + std::to_string(snapped) + "\n";
+                break;
+            }
+            case CommandKind::Error:
+                *reply += "error " + command.error + "\n";
+                break;
+        }
+    }
+}
+
+bool RunWindowCommand(HotkeyCommand command) {
+    switch (command) {
+        case HotkeyCommand::SnapLeft: HandleSnapRequest(SnapDirection::Left); break;
+        case HotkeyCommand::SnapRight: HandleSnapRequest(SnapDirection::Right); break;
+        case HotkeyCommand::SnapUp: HandleSnapRequest(SnapDirection::Up); break;
+        case HotkeyCommand::SnapDown: HandleSnapRequest(SnapDirection::Down); break;
+        case HotkeyCommand::MonitorLeft: HandleMonitorSwitch(SnapDirection::Left); break;
+        case HotkeyCommand::MonitorRight: HandleMonitorSwitch(SnapDirection::Right); break;
+        case HotkeyCommand::MonitorUp: HandleMonitorSwitch(SnapDirection::Up); break;
+        case HotkeyCommand::MonitorDown: HandleMonitorSwitch(SnapDirection::Down); break;
+        case HotkeyCommand::GrowWidth:
+        case HotkeyCommand::ShrinkWidth:
+        case HotkeyCommand::GrowHeight:
+        case HotkeyCommand::ShrinkHeight: {
+            SplitAxis axis = command == HotkeyCommand::GrowWidth || command == HotkeyCommand::ShrinkWidth ? SplitAxis::X : SplitAxis::Y;
+            int steps = command == HotkeyCommand::GrowWidth || command == HotkeyCommand::GrowHeight ? 1 : -1;
+            // Joins a burst the hotkeys queued; the message they posted then finds nothing left
+            QueueSplitResize(axis, steps);
+            ApplyPendingSplitResize();
+            break;
+        }
+        case HotkeyCommand::Fill: HandleFillRequest(); break;
+        case HotkeyCommand::ArrangeGrid: HandleArrangeRequest(ArrangeLayout::Grid); break;
+        case HotkeyCommand::ArrangeMaster: HandleArrangeRequest(ArrangeLayout::MasterStack); break;
+        case HotkeyCommand::Workspace1: HandleWorkspaceSwitch(0); break;
+        case HotkeyCommand::Workspace2: HandleWorkspaceSwitch(1); break;
+        case HotkeyCommand::Workspace3: HandleWorkspaceSwitch(2); break;
+        case HotkeyCommand::Workspace4: HandleWorkspaceSwitch(3); break;
+        case HotkeyCommand::MoveToWorkspace1: HandleMoveToWorkspace(0); break;
+        case HotkeyCommand::MoveToWorkspace2: HandleMoveToWorkspace(1); break;
+        case HotkeyCommand::MoveToWorkspace3: HandleMoveToWorkspace(2); break;
+        case HotkeyCommand::MoveToWorkspace4: HandleMoveToWorkspace(3); break;
+        default: return false;
+    }
+    return true;
+}
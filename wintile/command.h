@@ -0,0 +1,106 @@
+#pragma once
+
+// Tiler commands from scripts and other tools, one per line, over the command channel
+// (command_channel.h). Lines are parsed on the channel's thread; the main thread only runs them.
+//
+//     snap 0x1a2b right_half        snap a window (handle in hex or decimal); 2,right_half puts
+//                                   it on monitor 2 (enumeration order, as in rule place=)
+//     focus 0x1a2b                  bring a window to the foreground
+//     query 0x1a2b                  reply with its tracked state ("ok left_half", "ok none")
+//     mark a [0x1a2b]               set mark a to a window, by default the one under the cursor
+//     jump a                        focus and raise the window of mark a, cursor on its center
+//     session coding                apply a layout session from the config ("ok 3": windows
+//                                   snapped), in one placement transaction
+//     snap_left, workspace_2, ...   any bind command but the dumps, on the window or monitor
+//                                   under the cursor like its hotkey
+//     begin                         start a batch of snap lines ...
+//     commit                        ... and apply it as one placement transaction
+//
+// 'a in place of a handle names the window of mark a, looked up when the line runs: `snap 'a
+// right_half` sends it to the right half.
+//
+// Every line outside a batch gets one reply line, a batch one for its commit: `ok`, `ok <detail>`
+// or `error <why>`. A batch with a bad line is not applied; its commit reports the first error.
+// Empty lines and `#` comments are skipped.
+
+#include "config.h"
+#include "tiler.h"
+
+#include <string>
+#include <vector>
+
+#define COMMAND_MAX_LINE 256    // Longer lines are rejected whole
+#define COMMAND_MAX_BATCH MAX_TRACKED_WINDOWS  // Snap lines per batch
+
+enum class CommandKind {
+    Hotkey,
+    Snap,
+    Focus,
+    Query,
+    Session,
+    Mark,
+    Jump,
+    Batch,
+    Error
+};
+
+struct TilerCommand {
+    CommandKind kind = CommandKind::Error;
+    HotkeyCommand hotkey = HotkeyCommand::SnapLeft;  // Hotkey
+    SnapTarget target = {};  // Snap, Focus and Query (only its window)
+    size_t first = 0;        // Batch: its snaps are request.targets[first, first + count)
+    size_t count = 0;
+    std::string session;     // Session: its name, looked up when it runs
+    char mark = 0;           // Mark and Jump: the letter. Snap, Focus, Query: the mark naming
+                             // the window, 0 if target.window does
+    std::string error;       // Error: the reply, without the "error " prefix
+};
+
+// Commands that arrived together; run as one unit on the main thread
+struct CommandRequest {
+    std::vector<TilerCommand> commands;
+    std::vector<SnapTarget> targets;  // Snaps of the batches
+    std::vector<char> marks;          // Per target, as TilerCommand::mark
+
+    bool Empty() const { return commands.empty(); }
+    void Clear() {
+        commands.clear();
+        targets.clear();
+        marks.clear();
+    }
+};
+
+// Splits a connection's byte stream into commands; one per connection, its state carries
+// partial lines and open batches from one read to the next
+class CommandParser {
+public:
+    // Parse the complete lines of `data` into `request`
+    void Feed(const char* data, size_t size, CommandRequest* request);
+
+    bool InBatch() const { return inBatch_; }
+
+private:
+    void ParseLine(const char* begin, const char* end, CommandRequest* request);
+    // A parsed (or failed) line: into the request, or into the open batch
+    void Add(bool parsed, TilerCommand command, std::string error, CommandRequest* request);
+
+    std::string partial_;  // Unterminated tail of the last read
+    bool overlong_ = false;  // Skipping the rest of a line past COMMAND_MAX_LINE
+    int line_ = 0;
+    bool inBatch_ = false;
+    TilerCommand batch_;     // The open batch; turns into an Error at its first bad line
+    std::vector<SnapTarget> batchTargets_;
+    std::vector<char> batchMarks_;
+};
+
+// Parse one command line (without its newline); false with `error` set if it is not one.
+// begin and commit are the parser's business and rejected here.
+bool ParseCommandLine(const char* begin, const char* end, TilerCommand* command, std::string* error);
+
+// Run a request and append one reply line per command to `reply`. Main thread only.
+void RunCommands(const CommandRequest& request, std::string* reply);
+
+// Run a bind command on the window or monitor under the cursor, as its hotkey does; split
+// resizes apply at once. False for the dumps, which only the executable provides, and for mark
+// and jump, which need a letter (the mark and jump commands).
+bool RunWindowCommand(HotkeyCommand command);
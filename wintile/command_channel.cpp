@@ -0,0 +1,348 @@
+#include "command_channel.h"
+
+#include <cstring>
+
+bool CommandServer::Start(const char* endpoint, CommandNotify notify) {
+    Stop();
+    endpoint_ = endpoint;
+    notify_ = notify;
+    stopping_.store(false, std::memory_order_relaxed);
+    requests_.store(0, std::memory_order_relaxed);
+    commands_.store(0, std::memory_order_relaxed);
+    if (!OpenEndpoint()) {
+        CloseEndpoint();
+        return false;
+    }
+    thread_ = std::thread(&CommandServer::Run, this);
+    return true;
+}
+
+void CommandServer::Stop() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_.store(true, std::memory_order_relaxed);
+        }
+        replied_.notify_all();
+        Wake();
+        thread_.join();
+    }
+    CloseEndpoint();
+}
+
+bool CommandServer::Exchange(const CommandRequest& request, std::string* reply) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_.load(std::memory_order_relaxed)) return false;
+        pending_ = &request;
+        reply_ = reply;
+    }
+    if (notify_) notify_();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    replied_.wait(lock, [this] { return !pending_ || stopping_.load(std::memory_order_relaxed); });
+    bool answered = !pending_;
+    pending_ = nullptr;
+    reply_ = nullptr;
+    return answered;
+}
+
+bool CommandServer::Serve() {
+    const CommandRequest* request;
+    std::string* reply;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        request = pending_;
+        reply = reply_;
+    }
+    if (!request) return false;
+
+    // The channel thread waits for the reply, so both stay put; Stop runs on this thread too
+    RunCommands(*request, reply);
+    requests_.fetch_add(1, std::memory_order_relaxed);
+    commands_.fetch_add(static_cast<long long>(request->commands.size()), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = nullptr;
+    }
+    replied_.notify_one();
+    return true;
+}
+
+bool CommandClient::ReadLine(std::string* line) {
+    for (;;) {
+        size_t newline = buffer_.find('\n', consumed_);
+        if (newline != std::string::npos) {
+            line->assign(buffer_, consumed_, newline - consumed_);
+            consumed_ = newline + 1;
+            if (consumed_ == buffer_.size()) {
+                buffer_.clear();
+                consumed_ = 0;
+            }
+            return true;
+        }
+        if (!Receive()) return false;
+    }
+}
+
+#ifdef _WIN32
+#include <windows.h>
+
+static std::wstring PipeName(const std::string& endpoint) {
+    std::wstring wide = L"\\\\.\\pipe\\";
+    for (char c : endpoint) wide += static_cast<wchar_t>(c);
+    return wide;
+}
+
+bool CommandServer::OpenEndpoint() {
+    // One instance, reused for each client; the first-instance flag fails if another tiler has it
+    HANDLE pipe = CreateNamedPipeW(PipeName(endpoint_).c_str(),
+                                   PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                   PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                   1, COMMAND_READ_SIZE, COMMAND_READ_SIZE, 0, NULL);
+    if (pipe == INVALID_HANDLE_VALUE) return false;
+    pipe_ = pipe;
+    stopEvent_ = CreateEventW(NULL, TRUE, FALSE, NULL);
+    return stopEvent_ != NULL;
+}
+
+void CommandServer::CloseEndpoint() {
+    if (pipe_) CloseHandle(static_cast<HANDLE>(pipe_));
+    if (stopEvent_) CloseHandle(static_cast<HANDLE>(stopEvent_));
+    pipe_ = nullptr;
+    stopEvent_ = nullptr;
+}
+
+void CommandServer::Wake() {
+    SetEvent(static_cast<HANDLE>(stopEvent_));
+}
+
+// Finish an overlapped operation, or cancel it when the stop event fires first
+static bool WaitIo(HANDLE pipe, OVERLAPPED* overlapped, HANDLE stop, BOOL started, DWORD* bytes) {
+    if (!started && GetLastError() != ERROR_IO_PENDING) return false;
+    HANDLE handles[2] = { stop, overlapped->hEvent };
+    if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) {
+        CancelIo(pipe);
+        GetOverlappedResult(pipe, overlapped, bytes, TRUE);
+        return false;
+    }
+    return GetOverlappedResult(pipe, overlapped, bytes, FALSE) != 0;
+}
+
+void CommandServer::Run() {
+    HANDLE pipe = static_cast<HANDLE>(pipe_);
+    HANDLE stop = static_cast<HANDLE>(stopEvent_);
+    HANDLE io = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!io) return;
+
+    CommandRequest request;
+    std::string reply;
+    char buffer[COMMAND_READ_SIZE];
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = io;
+        DWORD bytes = 0;
+        BOOL connected = ConnectNamedPipe(pipe, &overlapped);
+        if (!connected && GetLastError() == ERROR_PIPE_CONNECTED) {
+            // Connected between CreateNamedPipe and here
+        } else if (!WaitIo(pipe, &overlapped, stop, connected, &bytes)) {
+            DisconnectNamedPipe(pipe);
+            continue;
+        }
+
+        CommandParser parser;
+        for (;;) {
+            BOOL done = ReadFile(pipe, buffer, sizeof(buffer), NULL, &overlapped);
+            if (!WaitIo(pipe, &overlapped, stop, done, &bytes) || bytes == 0) break;
+            request.Clear();
+            parser.Feed(buffer, bytes, &request);
+            if (request.Empty()) continue;
+            reply.clear();
+            if (!Exchange(request, &reply)) break;
+            done = WriteFile(pipe, reply.data(), static_cast<DWORD>(reply.size()), NULL, &overlapped);
+            if (!WaitIo(pipe, &overlapped, stop, done, &bytes) || bytes != reply.size()) break;
+        }
+        DisconnectNamedPipe(pipe);
+    }
+    CloseHandle(io);
+}
+
+bool CommandClient::Connect(const char* endpoint) {
+    Close();
+    std::wstring name = PipeName(endpoint);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        HANDLE pipe = CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+        if (pipe != INVALID_HANDLE_VALUE) {
+            pipe_ = pipe;
+            return true;
+        }
+        // Another client has the one instance
+        if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeW(name.c_str(), 2000)) return false;
+    }
+    return false;
+}
+
+void CommandClient::Close() {
+    if (pipe_) CloseHandle(static_cast<HANDLE>(pipe_));
+    pipe_ = nullptr;
+    buffer_.clear();
+    consumed_ = 0;
+}
+
+bool CommandClient::Send(const char* data, size_t size) {
+    while (size > 0) {
+        DWORD written = 0;
+        if (!pipe_ || !WriteFile(static_cast<HANDLE>(pipe_), data, static_cast<DWORD>(size), &written, NULL)) return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool CommandClient::Receive() {
+    char buffer[COMMAND_READ_SIZE];
+    DWORD bytes = 0;
+    if (!pipe_ || !ReadFile(static_cast<HANDLE>(pipe_), buffer, sizeof(buffer), &bytes, NULL) || bytes == 0) return false;
+    buffer_.append(buffer, bytes);
+    return true;
+}
+
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL  // A client that hung up is an error, not SIGPIPE
+#else
+#define SEND_FLAGS 0
+#endif
+
+static bool SocketAddress(const std::string& endpoint, sockaddr_un* address) {
+    *address = sockaddr_un();
+    address->sun_family = AF_UNIX;
+    if (endpoint.empty() || endpoint.size() >= sizeof(address->sun_path)) return false;
+    std::memcpy(address->sun_path, endpoint.c_str(), endpoint.size() + 1);
+    return true;
+}
+
+static bool SendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, SEND_FLAGS);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool CommandServer::OpenEndpoint() {
+    sockaddr_un address;
+    if (!SocketAddress(endpoint_, &address)) return false;
+
+    // A live tiler answers on the path; the socket file a crashed one left behind is replaced
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    bool live = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    if (probe >= 0) close(probe);
+    if (live) return false;
+    unlink(endpoint_.c_str());
+
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd_ < 0) return false;
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return false;
+    chmod(endpoint_.c_str(), 0600);
+    return listen(listenFd_, 4) == 0 && pipe(wakeFds_) == 0;
+}
+
+void CommandServer::CloseEndpoint() {
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        unlink(endpoint_.c_str());
+    }
+    for (int& fd : wakeFds_) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+    listenFd_ = -1;
+}
+
+void CommandServer::Wake() {
+    char byte = 1;
+    ssize_t written = write(wakeFds_[1], &byte, 1);
+    (void)written;  // Full means a wake-up is pending already
+}
+
+// Wait until `fd` is readable; false when woken to stop
+static bool WaitReadable(int fd, int wakeFd) {
+    for (;;) {
+        pollfd fds[2] = { { fd, POLLIN, 0 }, { wakeFd, POLLIN, 0 } };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        return !fds[1].revents;
+    }
+}
+
+void CommandServer::Run() {
+    CommandRequest request;
+    std::string reply;
+    char buffer[COMMAND_READ_SIZE];
+    while (WaitReadable(listenFd_, wakeFds_[0])) {
+        int client = accept(listenFd_, nullptr, nullptr);
+        if (client < 0) continue;
+
+        CommandParser parser;
+        while (WaitReadable(client, wakeFds_[0])) {
+            ssize_t bytes = read(client, buffer, sizeof(buffer));
+            if (bytes < 0 && errno == EINTR) continue;
+            if (bytes <= 0) break;
+            request.Clear();
+            parser.Feed(buffer, static_cast<size_t>(bytes), &request);
+            if (request.Empty()) continue;
+            reply.clear();
+            if (!Exchange(request, &reply) || !SendAll(client, reply.data(), reply.size())) break;
+        }
+        close(client);
+    }
+}
+
+bool CommandClient::Connect(const char* endpoint) {
+    Close();
+    sockaddr_un address;
+    if (!SocketAddress(endpoint, &address)) return false;
+    fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_ < 0) return false;
+    if (connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void CommandClient::Close() {
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+    buffer_.clear();
+    consumed_ = 0;
+}
+
+bool CommandClient::Send(const char* data, size_t size) {
+    return fd_ >= 0 && SendAll(fd_, data, size);
+}
+
+bool CommandClient::Receive() {
+    char buffer[COMMAND_READ_SIZE];
+    for (;;) {
+        ssize_t bytes = fd_ >= 0 ? read(fd_, buffer, sizeof(buffer)) : -1;
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes <= 0) return false;
+        buffer_.append(buffer, static_cast<size_t>(bytes));
+        return true;
+    }
+}
+#endif
@@ -0,0 +1,92 @@
+#pragma once
+
+// Local command endpoint: a named pipe on Windows (`\\.\pipe\<name>`, local clients only), a Unix
+// domain socket elsewhere (`name` is its path, created 0600). One thread accepts a client at a
+// time, reads its lines and parses them (command.h); whatever arrived in one read is handed to
+// the main thread as one request, and the replies go back in one write. A script that sends a
+// whole file at once thus costs one main-thread turn, not one per line.
+//
+// The main thread is told through `notify` (e.g. posting itself a message) and then calls
+// Serve; the channel thread never touches the tiler.
+
+#include "command.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define COMMAND_CHANNEL_NAME "WinVimTiler"
+#define COMMAND_READ_SIZE 4096
+
+typedef void (*CommandNotify)();
+
+class CommandServer {
+public:
+    ~CommandServer() { Stop(); }
+
+    // Listen on `endpoint`; false if it cannot be created or another tiler holds it
+    bool Start(const char* endpoint, CommandNotify notify);
+    void Stop();
+    bool Running() const { return thread_.joinable(); }
+
+    // Main thread, after a notification: run the waiting request with RunCommands and hand
+    // back its reply. False if none was waiting.
+    bool Serve();
+
+    long long Requests() const { return requests_.load(std::memory_order_relaxed); }
+    long long Commands() const { return commands_.load(std::memory_order_relaxed); }
+
+private:
+    // Per platform: create and close the endpoint, wake the channel thread to stop
+    bool OpenEndpoint();
+    void CloseEndpoint();
+    void Wake();
+
+    void Run();
+    // Hand `request` to the main thread and wait for its reply; false if stopping
+    bool Exchange(const CommandRequest& request, std::string* reply);
+
+    std::thread thread_;
+    std::string endpoint_;
+    CommandNotify notify_ = nullptr;
+    std::atomic<bool> stopping_{ false };
+
+    std::mutex mutex_;
+    std::condition_variable replied_;
+    const CommandRequest* pending_ = nullptr;
+    std::string* reply_ = nullptr;
+
+    std::atomic<long long> requests_{ 0 };
+    std::atomic<long long> commands_{ 0 };
+
+    // The pipe and stop event on Windows; the listening socket and a wake pipe elsewhere
+    void* pipe_ = nullptr;
+    void* stopEvent_ = nullptr;
+    int listenFd_ = -1;
+    int wakeFds_[2] = { -1, -1 };
+};
+
+// A script's side: connect, send lines, read the replies
+class CommandClient {
+public:
+    ~CommandClient() { Close(); }
+
+    bool Connect(const char* endpoint);
+    void Close();
+
+    bool Send(const char* data, size_t size);
+    bool Send(const std::string& text) { return Send(text.data(), text.size()); }
+
+    // Next reply line without its newline; false once the server is gone
+    bool ReadLine(std::string* line);
+
+private:
+    bool Receive();
+
+    void* pipe_ = nullptr;
+    int fd_ = -1;
+    std::string buffer_;
+    size_t consumed_ = 0;
+};
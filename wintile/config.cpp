@@ -0,0 +1,814 @@
+#include "config.h"
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+static const char* const commandNames[] = {
+    "snap_left", "snap_down", "snap_up", "snap_right",
+    "monitor_left", "monitor_down", "monitor_up", "monitor_right",
+    "grow_width", "shrink_width", "grow_height", "shrink_height",
+    "fill", "arrange_grid", "arrange_master",
+    "workspace_1", "workspace_2", "workspace_3", "workspace_4",
+    "move_to_workspace_1", "move_to_workspace_2", "move_to_workspace_3", "move_to_workspace_4",
+    "mark", "jump",
+    "dump_latency", "dump_timeline",
+};
+static_assert(sizeof(commandNames) / sizeof(commandNames[0]) == static_cast<size_t>(HotkeyCommand::Count),
+              "one name per hotkey command");
+
+// Named keys and their virtual-key codes; letters and digits are their own upper-case ASCII
+struct KeyName {
+    const char* name;
+    unsigned key;
+};
+static const KeyName keyNames[] = {
+    { "left", 0x25 }, { "up", 0x26 }, { "right", 0x27 }, { "down", 0x28 },
+    { "space", 0x20 }, { "tab", 0x09 }, { "enter", 0x0D }, { "backspace", 0x08 },
+    { "home", 0x24 }, { "end", 0x23 }, { "pageup", 0x21 }, { "pagedown", 0x22 },
+    { "insert", 0x2D }, { "delete", 0x2E },
+    { "semicolon", 0xBA }, { "plus", 0xBB }, { "comma", 0xBC }, { "minus", 0xBD },
+    { "period", 0xBE }, { "slash", 0xBF }, { "backtick", 0xC0 }, { "lbracket", 0xDB },
+    { "backslash", 0xDC }, { "rbracket", 0xDD }, { "quote", 0xDE },
+};
+
+// Snap states a rule can place a window in
+struct StateName {
+    const char* name;
+    WindowState state;
+};
+static const StateName stateNames[] = {
+    { "left_half", WindowState::LeftHalf }, { "right_half", WindowState::RightHalf },
+    { "top_half", WindowState::TopHalf }, { "bottom_half", WindowState::BottomHalf },
+    { "top_left", WindowState::TopLeftQuarter }, { "top_right", WindowState::TopRightQuarter },
+    { "bottom_left", WindowState::BottomLeftQuarter }, { "bottom_right", WindowState::BottomRightQuarter },
+    { "maximized", WindowState::Maximized },
+};
+
+#define KEY_F1 0x70
+#define KEY_F24 0x87
+
+const char* HotkeyCommandName(HotkeyCommand command) {
+    int index = static_cast<int>(command);
+    return index >= 0 && index < static_cast<int>(HotkeyCommand::Count) ? commandNames[index] : "unknown";
+}
+
+void DefaultConfig(Config* config) {
+    const unsigned ca = CONFIG_MOD_CONTROL | CONFIG_MOD_ALT;
+    const unsigned cas = ca | CONFIG_MOD_SHIFT;
+    *config = Config();
+    config->excludedClasses = {
+        L"Progman", L"WorkerW", L"Shell_TrayWnd", L"DV2ControlHost", L"MsgrIMEWindowClass",
+        L"SysShadow", L"SnapAssistFlyout", L"SearchUI", L"Shell_Flyout",
+    };
+    config->hotkeys = {
+        { ca, 'H', HotkeyCommand::SnapLeft },
+        { ca, 'J', HotkeyCommand::SnapDown },
+        { ca, 'K', HotkeyCommand::SnapUp },
+        { ca, 'L', HotkeyCommand::SnapRight },
+        { ca, 0x25, HotkeyCommand::SnapLeft },
+        { ca, 0x28, HotkeyCommand::SnapDown },
+        { ca, 0x26, HotkeyCommand::SnapUp },
+        { ca, 0x27, HotkeyCommand::SnapRight },
+        { cas, 'H', HotkeyCommand::MonitorLeft },
+        { cas, 'J', HotkeyCommand::MonitorDown },
+        { cas, 'K', HotkeyCommand::MonitorUp },
+        { cas, 'L', HotkeyCommand::MonitorRight },
+        { cas, 0x25, HotkeyCommand::MonitorLeft },
+        { cas, 0x28, HotkeyCommand::MonitorDown },
+        { cas, 0x26, HotkeyCommand::MonitorUp },
+        { cas, 0x27, HotkeyCommand::MonitorRight },
+        { ca, 0xBE, HotkeyCommand::GrowWidth },
+        { ca, 0xBC, HotkeyCommand::ShrinkWidth },
+        { ca, 0xBB, HotkeyCommand::GrowHeight },
+        { ca, 0xBD, HotkeyCommand::ShrinkHeight },
+        { ca, 'F', HotkeyCommand::Fill },
+        { ca, 'A', HotkeyCommand::ArrangeGrid },
+        { cas, 'A', HotkeyCommand::ArrangeMaster },
+        { ca, '1', HotkeyCommand::Workspace1 },
+        { ca, '2', HotkeyCommand::Workspace2 },
+        { ca, '3', HotkeyCommand::Workspace3 },
+        { ca, '4', HotkeyCommand::Workspace4 },
+        { cas, '1', HotkeyCommand::MoveToWorkspace1 },
+        { cas, '2', HotkeyCommand::MoveToWorkspace2 },
+        { cas, '3', HotkeyCommand::MoveToWorkspace3 },
+        { cas, '4', HotkeyCommand::MoveToWorkspace4 },
+        { ca, 'M', HotkeyCommand::Mark },
+        { ca, 0xDE, HotkeyCommand::Jump },
+        { cas, 'P', HotkeyCommand::DumpLatency },
+        { cas, 'T', HotkeyCommand::DumpTimeline },
+    };
+}
+
+// Parsing
+
+static bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static void Trim(const char** begin, const char** end) {
+    while (*begin < *end && IsSpace(**begin)) ++*begin;
+    while (*end > *begin && IsSpace((*end)[-1])) --*end;
+}
+
+static bool Equals(const char* begin, const char* end, const char* literal) {
+    size_t length = std::strlen(literal);
+    return static_cast<size_t>(end - begin) == length && std::memcmp(begin, literal, length) == 0;
+}
+
+bool FindHotkeyCommand(const char* begin, const char* end, HotkeyCommand* command) {
+    for (int i = 0; i < static_cast<int>(HotkeyCommand::Count); ++i) {
+        if (Equals(begin, end, commandNames[i])) {
+            *command = static_cast<HotkeyCommand>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FindSnapState(const char* begin, const char* end, WindowState* state) {
+    for (const StateName& name : stateNames) {
+        if (Equals(begin, end, name.name)) {
+            *state = name.state;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* SnapStateName(WindowState state) {
+    for (const StateName& name : stateNames) {
+        if (name.state == state) return name.name;
+    }
+    return "none";
+}
+
+static bool EqualsIgnoreCase(const char* begin, const char* end, const char* lowerLiteral) {
+    size_t length = std::strlen(lowerLiteral);
+    if (static_cast<size_t>(end - begin) != length) return false;
+    for (size_t i = 0; i < length; ++i) {
+        char c = begin[i];
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        if (c != lowerLiteral[i]) return false;
+    }
+    return true;
+}
+
+// Decimal in 0..max
+static bool ParseInt(const char* begin, const char* end, int max, int* out) {
+    if (begin == end || end - begin > 4) return false;
+    int value = 0;
+    for (const char* p = begin; p < end; ++p) {
+        if (*p < '0' || *p > '9') return false;
+        value = value * 10 + (*p - '0');
+    }
+    if (value > max) return false;
+    *out = value;
+    return true;
+}
+
+static int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// #RRGGBB
+static bool ParseColor(const char* begin, const char* end, unsigned* out) {
+    if (end - begin != 7 || *begin != '#') return false;
+    unsigned value = 0;
+    for (const char* p = begin + 1; p < end; ++p) {
+        int digit = HexDigit(*p);
+        if (digit < 0) return false;
+        value = value * 16 + static_cast<unsigned>(digit);
+    }
+    *out = value;
+    return true;
+}
+
+// Strict UTF-8 to wchar_t (UTF-16 where wchar_t is 16 bits)
+static bool DecodeUtf8(const char* begin, const char* end, std::wstring* out) {
+    out->clear();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(begin);
+    const unsigned char* stop = reinterpret_cast<const unsigned char*>(end);
+    while (p < stop) {
+        unsigned c = *p++;
+        int extra;
+        unsigned min;
+        if (c < 0x80) {
+            extra = 0;
+            min = 0;
+        } else if ((c & 0xE0) == 0xC0) {
+            extra = 1;
+            min = 0x80;
+            c &= 0x1F;
+        } else if ((c & 0xF0) == 0xE0) {
+            extra = 2;
+            min = 0x800;
+            c &= 0x0F;
+        } else if ((c & 0xF8) == 0xF0) {
+            extra = 3;
+            min = 0x10000;
+            c &= 0x07;
+        } else {
+            return false;
+        }
+        if (stop - p < extra) return false;
+        for (int i = 0; i < extra; ++i) {
+            if ((p[i] & 0xC0) != 0x80) return false;
+            c = (c << 6) | (p[i] & 0x3F);
+        }
+        p += extra;
+        if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF) || c < 0x20) return false;
+
+        if (sizeof(wchar_t) == 2 && c >= 0x10000) {
+            c -= 0x10000;
+            out->push_back(static_cast<wchar_t>(0xD800 + (c >> 10)));
+            out->push_back(static_cast<wchar_t>(0xDC00 + (c & 0x3FF)));
+        } else {
+            out->push_back(static_cast<wchar_t>(c));
+        }
+    }
+    return true;
+}
+
+static void EncodeUtf8(const std::wstring& text, std::string* out) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned c = static_cast<unsigned>(text[i]);
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDBFF && i + 1 < text.size()) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (static_cast<unsigned>(text[++i]) - 0xDC00);
+        }
+        if (c < 0x80) {
+            out->push_back(static_cast<char>(c));
+        } else if (c < 0x800) {
+            out->push_back(static_cast<char>(0xC0 | (c >> 6)));
+            out->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        } else if (c < 0x10000) {
+            out->push_back(static_cast<char>(0xE0 | (c >> 12)));
+            out->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            out->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        } else {
+            out->push_back(static_cast<char>(0xF0 | (c >> 18)));
+            out->push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+            out->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            out->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+    }
+}
+
+static bool ParseKey(const char* begin, const char* end, unsigned* key) {
+    if (end - begin == 1) {
+        char c = *begin;
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+            *key = static_cast<unsigned>(c);
+            return true;
+        }
+        return false;
+    }
+    for (const KeyName& name : keyNames) {
+        if (EqualsIgnoreCase(begin, end, name.name)) {
+            *key = name.key;
+            return true;
+        }
+    }
+    int number;
+    if ((*begin == 'f' || *begin == 'F') && ParseInt(begin + 1, end, 24, &number) && number >= 1) {
+        *key = KEY_F1 + static_cast<unsigned>(number - 1);
+        return true;
+    }
+    return false;
+}
+
+// "ctrl+alt+h snap_left"
+static bool ParseBinding(const char* begin, const char* end, HotkeyBinding* binding, std::string* why) {
+    const char* chordEnd = begin;
+    while (chordEnd < end && !IsSpace(*chordEnd)) ++chordEnd;
+    const char* commandBegin = chordEnd;
+    const char* commandEnd = end;
+    Trim(&commandBegin, &commandEnd);
+
+    binding->modifiers = 0;
+    const char* part = begin;
+    for (;;) {
+        const char* partEnd = part;
+        while (partEnd < chordEnd && *partEnd != '+') ++partEnd;
+        if (partEnd == chordEnd) {
+            if (!ParseKey(part, partEnd, &binding->key)) {
+                *why = "unknown key '" + std::string(part, partEnd) + "'";
+                return false;
+            }
+            break;
+        }
+
+        unsigned modifier;
+        if (EqualsIgnoreCase(part, partEnd, "ctrl")) {
+            modifier = CONFIG_MOD_CONTROL;
+        } else if (EqualsIgnoreCase(part, partEnd, "alt")) {
+            modifier = CONFIG_MOD_ALT;
+        } else if (EqualsIgnoreCase(part, partEnd, "shift")) {
+            modifier = CONFIG_MOD_SHIFT;
+        } else if (EqualsIgnoreCase(part, partEnd, "win")) {
+            modifier = CONFIG_MOD_WIN;
+        } else {
+            *why = "unknown modifier '" + std::string(part, partEnd) + "'";
+            return false;
+        }
+        if (binding->modifiers & modifier) {
+            *why = "modifier repeated";
+            return false;
+        }
+        binding->modifiers |= modifier;
+        part = partEnd + 1;
+    }
+
+    // A chord without Ctrl, Alt or Win would swallow ordinary typing
+    if (!(binding->modifiers & (CONFIG_MOD_CONTROL | CONFIG_MOD_ALT | CONFIG_MOD_WIN))) {
+        *why = "hotkey needs ctrl, alt or win";
+        return false;
+    }
+
+    if (FindHotkeyCommand(commandBegin, commandEnd, &binding->command)) return true;
+    *why = commandBegin == commandEnd ? "bind needs a command" :
+        "unknown command '" + std::string(commandBegin, commandEnd) + "'";
+    return false;
+}
+
+// process=, class= or title= value: a non-empty glob, quoted if it holds spaces
+static bool ParsePattern(const char* begin, const char* end, const char* name, std::wstring* pattern,
+                         std::string* why) {
+    if (!pattern->empty()) {
+        *why = std::string(name) + " set twice";
+        return false;
+    }
+    if (begin == end) {
+        *why = std::string(name) + " needs a pattern";
+        return false;
+    }
+    if (!DecodeUtf8(begin, end, pattern)) {
+        *why = std::string(name) + " is not valid UTF-8 text";
+        return false;
+    }
+    if (pattern->size() > CONFIG_MAX_PATTERN) {
+        *why = std::string(name) + " longer than 255 characters";
+        return false;
+    }
+    return true;
+}
+
+// place=[monitor,]state
+static bool ParsePlace(const char* begin, const char* end, WindowRule* rule, std::string* why) {
+    if (rule->actions & RULE_PLACE) {
+        *why = "place set twice";
+        return false;
+    }
+    const char* comma = static_cast<const char*>(std::memchr(begin, ',', end - begin));
+    if (comma) {
+        if (!ParseInt(begin, comma, CONFIG_MAX_RULE_MONITOR, &rule->monitor) || rule->monitor < 1) {
+            *why = "place monitor must be 1..32";
+            return false;
+        }
+        begin = comma + 1;
+    }
+    if (FindSnapState(begin, end, &rule->state)) {
+        rule->actions |= RULE_PLACE;
+        return true;
+    }
+    *why = "unknown place state '" + std::string(begin, end) + "'";
+    return false;
+}
+
+// process=steam.exe title="Friends List" no_tile place=2,right_half
+static bool ParseRule(const char* begin, const char* end, WindowRule* rule, std::string* why) {
+    const char* p = begin;
+    while (p < end) {
+        while (p < end && IsSpace(*p)) ++p;
+        if (p == end) break;
+        const char* nameBegin = p;
+        while (p < end && !IsSpace(*p) && *p != '=') ++p;
+        const char* nameEnd = p;
+
+        if (p == end || *p != '=') {
+            unsigned flag;
+            if (Equals(nameBegin, nameEnd, "no_tile")) {
+                flag = RULE_NO_TILE;
+            } else if (Equals(nameBegin, nameEnd, "no_border")) {
+                flag = RULE_NO_BORDER;
+            } else {
+                *why = "unknown rule option '" + std::string(nameBegin, nameEnd) + "'";
+                return false;
+            }
+            if (rule->actions & flag) {
+                *why = std::string(nameBegin, nameEnd) + " repeated";
+                return false;
+            }
+            rule->actions |= flag;
+            continue;
+        }
+
+        // The value runs to the next space, or to the closing quote
+        const char* valueBegin = ++p;
+        const char* valueEnd;
+        if (p < end && *p == '"') {
+            valueBegin = ++p;
+            while (p < end && *p != '"') ++p;
+            if (p == end) {
+                *why = "unterminated quote";
+                return false;
+            }
+            valueEnd = p++;
+            if (p < end && !IsSpace(*p)) {
+                *why = "expected a space after the closing quote";
+                return false;
+            }
+        } else {
+            while (p < end && !IsSpace(*p)) ++p;
+            valueEnd = p;
+            if (std::memchr(valueBegin, '"', valueEnd - valueBegin)) {
+                *why = "unexpected quote";
+                return false;
+            }
+        }
+
+        bool ok;
+        if (Equals(nameBegin, nameEnd, "process")) {
+            ok = ParsePattern(valueBegin, valueEnd, "process", &rule->process, why);
+        } else if (Equals(nameBegin, nameEnd, "class")) {
+            ok = ParsePattern(valueBegin, valueEnd, "class", &rule->className, why);
+        } else if (Equals(nameBegin, nameEnd, "title")) {
+            ok = ParsePattern(valueBegin, valueEnd, "title", &rule->title, why);
+        } else if (Equals(nameBegin, nameEnd, "place")) {
+            ok = ParsePlace(valueBegin, valueEnd, rule, why);
+        } else {
+            *why = "unknown rule option '" + std::string(nameBegin, nameEnd) + "'";
+            ok = false;
+        }
+        if (!ok) return false;
+    }
+
+    if (rule->process.empty() && rule->className.empty() && rule->title.empty()) {
+        *why = "rule needs process=, class= or title=";
+        return false;
+    }
+    if (!rule->actions) {
+        *why = "rule needs no_tile, no_border or place=";
+        return false;
+    }
+    return true;
+}
+
+static bool IsSessionNameChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+// coding process=code.exe place=1,left_half: one entry of the named session
+static bool ParseSessionEntry(const char* begin, const char* end, Config* config, std::string* why) {
+    const char* nameEnd = begin;
+    while (nameEnd < end && !IsSpace(*nameEnd)) ++nameEnd;
+    for (const char* p = begin; p < nameEnd; ++p) {
+        if (!IsSessionNameChar(*p)) {
+            *why = "session name may only hold letters, digits, '_' and '-'";
+            return false;
+        }
+    }
+    if (nameEnd - begin > CONFIG_MAX_SESSION_NAME) {
+        *why = "session name longer than 32 characters";
+        return false;
+    }
+
+    WindowRule entry;
+    if (!ParseRule(nameEnd, end, &entry, why)) return false;
+    if (entry.actions != RULE_PLACE) {
+        *why = "session entry needs place= and nothing else";
+        return false;
+    }
+
+    LayoutSession* session = nullptr;
+    for (LayoutSession& existing : config->sessions) {
+        if (Equals(begin, nameEnd, existing.name.c_str())) session = &existing;
+    }
+    if (!session) {
+        if (config->sessions.size() >= CONFIG_MAX_SESSIONS) {
+            *why = "more than 64 sessions";
+            return false;
+        }
+        config->sessions.emplace_back();
+        session = &config->sessions.back();
+        session->name.assign(begin, nameEnd);
+    }
+    if (session->entries.size() >= CONFIG_MAX_SESSION_ENTRIES) {
+        *why = "more than 256 entries in session " + session->name;
+        return false;
+    }
+    session->entries.push_back(std::move(entry));
+    return true;
+}
+
+// Which settings a file has set so far
+struct SeenSettings {
+    bool borderWidth = false;
+    bool padding = false;
+    bool borderColor = false;
+    bool animationMs = false;
+    bool excludedClasses = false;  // The built-in list was replaced
+    bool hotkeys = false;
+    bool rules = false;
+    bool sessions = false;
+};
+
+static bool SetOnce(bool* seen, const char* name, std::string* why) {
+    if (*seen) {
+        *why = std::string(name) + " set twice";
+        return false;
+    }
+    *seen = true;
+    return true;
+}
+
+// One trimmed, non-empty, non-comment line
+static bool ParseLine(const char* begin, const char* end, Config* config, SeenSettings* seen, std::string* why) {
+    if (std::memchr(begin, '\0', end - begin)) {
+        *why = "unexpected NUL byte";
+        return false;
+    }
+    const char* equals = static_cast<const char*>(std::memchr(begin, '=', end - begin));
+    if (!equals) {
+        *why = "expected 'name = value'";
+        return false;
+    }
+    const char* keyBegin = begin;
+    const char* keyEnd = equals;
+    const char* valueBegin = equals + 1;
+    const char* valueEnd = end;
+    Trim(&keyBegin, &keyEnd);
+    Trim(&valueBegin, &valueEnd);
+
+    if (Equals(keyBegin, keyEnd, "border_width")) {
+        if (!ParseInt(valueBegin, valueEnd, CONFIG_MAX_BORDER_WIDTH, &config->borderWidth)) {
+            *why = "border_width must be 0..32";
+            return false;
+        }
+        return SetOnce(&seen->borderWidth, "border_width", why);
+    }
+    if (Equals(keyBegin, keyEnd, "padding")) {
+        if (!ParseInt(valueBegin, valueEnd, CONFIG_MAX_PADDING, &config->padding)) {
+            *why = "padding must be 0..128";
+            return false;
+        }
+        return SetOnce(&seen->padding, "padding", why);
+    }
+    if (Equals(keyBegin, keyEnd, "animation_ms")) {
+        if (!ParseInt(valueBegin, valueEnd, CONFIG_MAX_ANIMATION_MS, &config->animationMs)) {
+            *why = "animation_ms must be 0..1000";
+            return false;
+        }
+        return SetOnce(&seen->animationMs, "animation_ms", why);
+    }
+    if (Equals(keyBegin, keyEnd, "border_color")) {
+        if (!ParseColor(valueBegin, valueEnd, &config->borderColor)) {
+            *why = "border_color must be #RRGGBB";
+            return false;
+        }
+        return SetOnce(&seen->borderColor, "border_color", why);
+    }
+
+    if (Equals(keyBegin, keyEnd, "exclude_class")) {
+        if (!seen->excludedClasses) config->excludedClasses.clear();
+        seen->excludedClasses = true;
+        if (valueBegin == valueEnd) return true;
+
+        std::wstring name;
+        if (!DecodeUtf8(valueBegin, valueEnd, &name)) {
+            *why = "exclude_class is not valid UTF-8 text";
+            return false;
+        }
+        if (name.size() > CONFIG_MAX_CLASS_NAME) {
+            *why = "exclude_class longer than 255 characters";
+            return false;
+        }
+        config->excludedClasses.push_back(name);
+        return true;
+    }
+
+    if (Equals(keyBegin, keyEnd, "bind")) {
+        if (!seen->hotkeys) config->hotkeys.clear();
+        seen->hotkeys = true;
+        if (valueBegin == valueEnd) return true;
+
+        HotkeyBinding binding;
+        if (!ParseBinding(valueBegin, valueEnd, &binding, why)) return false;
+        for (const HotkeyBinding& other : config->hotkeys) {
+            if (other.modifiers == binding.modifiers && other.key == binding.key) {
+                *why = "hotkey bound twice";
+                return false;
+            }
+        }
+        if (config->hotkeys.size() >= CONFIG_MAX_BINDINGS) {
+            *why = "more than 128 bindings";
+            return false;
+        }
+        config->hotkeys.push_back(binding);
+        return true;
+    }
+
+    if (Equals(keyBegin, keyEnd, "rule")) {
+        if (!seen->rules) config->rules.clear();
+        seen->rules = true;
+        if (valueBegin == valueEnd) return true;
+
+        WindowRule rule;
+        if (!ParseRule(valueBegin, valueEnd, &rule, why)) return false;
+        if (config->rules.size() >= CONFIG_MAX_RULES) {
+            *why = "more than 1024 rules";
+            return false;
+        }
+        config->rules.push_back(std::move(rule));
+        return true;
+    }
+
+    if (Equals(keyBegin, keyEnd, "session")) {
+        if (!seen->sessions) config->sessions.clear();
+        seen->sessions = true;
+        if (valueBegin == valueEnd) return true;
+        return ParseSessionEntry(valueBegin, valueEnd, config, why);
+    }
+
+    *why = "unknown setting '" + std::string(keyBegin, keyEnd) + "'";
+    return false;
+}
+
+bool ParseConfig(const char* text, size_t length, Config* config, std::string* error) {
+    Config parsed;
+    DefaultConfig(&parsed);
+    SeenSettings seen;
+
+    const char* end = text + length;
+    int lineNumber = 0;
+    for (const char* line = text; line < end;) {
+        ++lineNumber;
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!lineEnd) lineEnd = end;
+        const char* begin = line;
+        line = lineEnd < end ? lineEnd + 1 : end;
+
+        Trim(&begin, &lineEnd);
+        if (begin == lineEnd || *begin == '#') continue;
+
+        std::string why;
+        if (!ParseLine(begin, lineEnd, &parsed, &seen, &why)) {
+            if (error) *error = "line " + std::to_string(lineNumber) + ": " + why;
+            return false;
+        }
+    }
+
+    parsed.ruleMatcher.Compile(parsed.rules);
+    for (LayoutSession& session : parsed.sessions) session.matcher.Compile(session.entries);
+    *config = std::move(parsed);
+    return true;
+}
+
+// Formatting
+
+void FormatHotkey(const HotkeyBinding& binding, std::string* out) {
+    if (binding.modifiers & CONFIG_MOD_CONTROL) *out += "ctrl+";
+    if (binding.modifiers & CONFIG_MOD_ALT) *out += "alt+";
+    if (binding.modifiers & CONFIG_MOD_SHIFT) *out += "shift+";
+    if (binding.modifiers & CONFIG_MOD_WIN) *out += "win+";
+
+    unsigned key = binding.key;
+    if ((key >= 'A' && key <= 'Z') || (key >= '0' && key <= '9')) {
+        out->push_back(static_cast<char>(key >= 'A' ? key - 'A' + 'a' : key));
+        return;
+    }
+    if (key >= KEY_F1 && key <= KEY_F24) {
+        *out += 'f';
+        *out += std::to_string(key - KEY_F1 + 1);
+        return;
+    }
+    for (const KeyName& name : keyNames) {
+        if (name.key == key) {
+            *out += name.name;
+            return;
+        }
+    }
+    *out += "?";
+}
+
+static void FormatPattern(const char* name, const std::wstring& pattern, std::string* out) {
+    if (pattern.empty()) return;
+    if (!out->empty() && out->back() != ' ') *out += " ";
+    *out += name;
+    *out += "=";
+    bool quote = pattern.find(L' ') != std::wstring::npos;
+    if (quote) *out += "\"";
+    EncodeUtf8(pattern, out);
+    if (quote) *out += "\"";
+}
+
+void FormatRule(const WindowRule& rule, std::string* out) {
+    std::string text;
+    FormatPattern("process", rule.process, &text);
+    FormatPattern("class", rule.className, &text);
+    FormatPattern("title", rule.title, &text);
+    if (rule.actions & RULE_NO_TILE) text += " no_tile";
+    if (rule.actions & RULE_NO_BORDER) text += " no_border";
+    if (rule.actions & RULE_PLACE) {
+        text += " place=";
+        if (rule.monitor) text += std::to_string(rule.monitor) + ",";
+        text += SnapStateName(rule.state);
+    }
+    *out += text;
+}
+
+void FormatConfig(const Config& config, std::string* out) {
+    char color[16];
+    std::snprintf(color, sizeof(color), "#%06X", config.borderColor & 0xFFFFFF);
+
+    *out += "# WinVimTiler settings; saved changes apply at once\n";
+    *out += "border_width = " + std::to_string(config.borderWidth) + "\n";
+    *out += "padding = " + std::to_string(config.padding) + "\n";
+    *out += "border_color = ";
+    *out += color;
+    *out += "\n";
+    *out += "animation_ms = " + std::to_string(config.animationMs) + "\n\n";
+
+    if (config.excludedClasses.empty()) *out += "exclude_class =\n";
+    for (const std::wstring& name : config.excludedClasses) {
+        *out += "exclude_class = ";
+        EncodeUtf8(name, out);
+        *out += "\n";
+    }
+    *out += "\n";
+
+    if (config.hotkeys.empty()) *out += "bind =\n";
+    for (const HotkeyBinding& binding : config.hotkeys) {
+        *out += "bind = ";
+        FormatHotkey(binding, out);
+        *out += " ";
+        *out += HotkeyCommandName(binding.command);
+        *out += "\n";
+    }
+
+    if (!config.rules.empty()) {
+        *out += "\n";
+        for (const WindowRule& rule : config.rules) {
+            *out += "rule = ";
+            FormatRule(rule, out);
+            *out += "\n";
+        }
+    }
+
+    if (!config.sessions.empty()) {
+        *out += "\n";
+        for (const LayoutSession& session : config.sessions) {
+            for (const WindowRule& entry : session.entries) {
+                *out += "session = " + session.name + " ";
+                FormatRule(entry, out);
+                *out += "\n";
+            }
+        }
+    }
+}
+
+const LayoutSession* FindLayoutSession(const Config& config, const char* begin, const char* end) {
+    for (const LayoutSession& session : config.sessions) {
+        if (Equals(begin, end, session.name.c_str())) return &session;
+    }
+    return nullptr;
+}
+
+// Publishing
+
+static Config MakeDefaultConfig() {
+    Config config;
+    DefaultConfig(&config);
+    return config;
+}
+
+static const Config builtinConfig = MakeDefaultConfig();
+std::atomic<const Config*> activeConfig(&builtinConfig);
+
+// Owned snapshots: the active one (none while the built-in defaults are active) and the ones
+// replaced since the main thread last released them
+static std::mutex publishMutex;
+static std::unique_ptr<Config> ownedConfig;
+static std::vector<std::unique_ptr<Config>> retiredConfigs;
+static unsigned lastGeneration = 0;
+
+unsigned PublishConfig(std::unique_ptr<Config> config) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    unsigned generation = ++lastGeneration;
+    config->generation = generation;
+    activeConfig.store(config.get(), std::memory_order_release);
+    if (ownedConfig) retiredConfigs.push_back(std::move(ownedConfig));
+    ownedConfig = std::move(config);
+    return generation;
+}
+
+size_t ReleaseRetiredConfigs() {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    size_t count = retiredConfigs.size();
+    retiredConfigs.clear();
+    return count;
+}
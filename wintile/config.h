@@ -0,0 +1,163 @@
+#pragma once
+
+// Runtime configuration. WinVimTiler.conf next to the executable is parsed and validated into
+// an immutable Config snapshot. A reload builds the new snapshot off the main thread and
+// publishes it with one atomic store, so the snap and border paths pay a pointer load to read
+// the settings, never a lock or a parse.
+//
+// File format, one setting per line, `#` starts a comment line:
+//
+//     border_width = 2
+//     padding = 6
+//     border_color = #6495ED
+//     animation_ms = 150                 (snap and move animations; 0, the default, is off)
+//     exclude_class = Shell_TrayWnd      (repeatable)
+//     bind = ctrl+alt+h snap_left        (repeatable)
+//     rule = process=steam.exe title="Friends List" no_tile no_border    (repeatable)
+//     session = coding process=code.exe place=1,left_half                (repeatable)
+//
+// Settings not in the file keep their defaults. The first exclude_class, bind, rule or session
+// line replaces the built-in list; an empty value (`bind =`) leaves it empty.
+//
+// A rule names what it matches (process=, class=, title=; globs with `*` and `?`, quoted if
+// they hold spaces) and what it does: no_tile, no_border, place=right_half or
+// place=2,right_half (monitor 2 in enumeration order). See rules.h.
+//
+// The mark and jump bind commands wait for a letter key a-z, as m and ' do in vim: mark names
+// the window under the cursor, jump goes back to it (tiler.h).
+//
+// A session line adds an entry to the named layout session: a rule with only a place=. Applying
+// the session (ApplyLayoutSession) moves one matching window per entry. Entries are served
+// greedily in file order, each with the topmost window it matches that no earlier entry took, so
+// a catch-all listed before a specific entry can take that entry's only window: list specific
+// entries first.
+
+#include "rules.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Hotkey modifiers, with the values of the Win32 MOD_* flags
+#define CONFIG_MOD_ALT 0x0001
+#define CONFIG_MOD_CONTROL 0x0002
+#define CONFIG_MOD_SHIFT 0x0004
+#define CONFIG_MOD_WIN 0x0008
+
+// Validation limits
+#define CONFIG_MAX_BORDER_WIDTH 32
+#define CONFIG_MAX_PADDING 128
+#define CONFIG_MAX_ANIMATION_MS 1000
+#define CONFIG_MAX_CLASS_NAME 255  // ClassName buffers hold 256 characters
+#define CONFIG_MAX_BINDINGS 128
+#define CONFIG_MAX_RULES 1024
+#define CONFIG_MAX_PATTERN 255
+#define CONFIG_MAX_RULE_MONITOR 32
+#define CONFIG_MAX_SESSIONS 64
+#define CONFIG_MAX_SESSION_ENTRIES 256  // Per session
+#define CONFIG_MAX_SESSION_NAME 32
+
+enum class HotkeyCommand {
+    SnapLeft,
+    SnapDown,
+    SnapUp,
+    SnapRight,
+    MonitorLeft,
+    MonitorDown,
+    MonitorUp,
+    MonitorRight,
+    GrowWidth,
+    ShrinkWidth,
+    GrowHeight,
+    ShrinkHeight,
+    Fill,
+    ArrangeGrid,
+    ArrangeMaster,
+    Workspace1,
+    Workspace2,
+    Workspace3,
+    Workspace4,
+    MoveToWorkspace1,
+    MoveToWorkspace2,
+    MoveToWorkspace3,
+    MoveToWorkspace4,
+    Mark,  // Followed by a letter key
+    Jump,
+    DumpLatency,
+    DumpTimeline,
+    Count
+};
+
+struct HotkeyBinding {
+    unsigned modifiers = 0;  // CONFIG_MOD_*
+    unsigned key = 0;        // Virtual-key code
+    HotkeyCommand command = HotkeyCommand::SnapLeft;
+
+    bool operator==(const HotkeyBinding&) const = default;
+};
+
+// A named arrangement ("coding": editor left, terminal top right, ...)
+struct LayoutSession {
+    std::string name;                 // Letters, digits, `_` and `-`
+    std::vector<WindowRule> entries;  // Place actions only, in file order
+    RuleMatcher matcher;              // `entries` compiled by ParseConfig
+
+    bool operator==(const LayoutSession& other) const { return name == other.name && entries == other.entries; }
+};
+
+struct Config {
+    int borderWidth = 2;
+    int padding = 6;
+    unsigned borderColor = 0x6495ED;  // 0xRRGGBB
+    int animationMs = 0;  // Length of a snap animation, 0 = windows jump to their slots
+    std::vector<std::wstring> excludedClasses;  // No border and no tiling for these
+    std::vector<HotkeyBinding> hotkeys;
+    std::vector<WindowRule> rules;
+    RuleMatcher ruleMatcher;  // `rules` compiled by ParseConfig
+    std::vector<LayoutSession> sessions;
+    unsigned generation = 0;  // Set when published, 0 for the built-in defaults
+};
+
+// The built-in settings: what a missing or empty file gives
+void DefaultConfig(Config* config);
+
+// Parse and validate a config file on top of the defaults. On failure `config` is untouched
+// and `error` says why ("line 3: padding must be 0..128").
+bool ParseConfig(const char* text, size_t length, Config* config, std::string* error);
+
+// Write `config` in the file format; ParseConfig reads it back unchanged
+void FormatConfig(const Config& config, std::string* out);
+
+// "ctrl+alt+h", the chord syntax of a bind line
+void FormatHotkey(const HotkeyBinding& binding, std::string* out);
+const char* HotkeyCommandName(HotkeyCommand command);
+
+// Names of the bind commands and of the place states ("right_half"), also used by the command
+// channel; the lookups return false for an unknown name, SnapStateName "none" for Unknown
+bool FindHotkeyCommand(const char* begin, const char* end, HotkeyCommand* command);
+bool FindSnapState(const char* begin, const char* end, WindowState* state);
+const char* SnapStateName(WindowState state);
+
+// "process=steam.exe no_tile", the syntax of a rule line
+void FormatRule(const WindowRule& rule, std::string* out);
+
+// The session named [begin, end), null if there is none
+const LayoutSession* FindLayoutSession(const Config& config, const char* begin, const char* end);
+
+// The active snapshot. Only the main thread reads it; a reference stays valid until that
+// thread calls ReleaseRetiredConfigs.
+extern std::atomic<const Config*> activeConfig;
+
+inline const Config& CurrentConfig() {
+    return *activeConfig.load(std::memory_order_acquire);
+}
+
+// Make `config` the active snapshot (from any thread). The one it replaces is retired. Returns
+// the generation it was given, so a publishing thread need not read the snapshot back.
+unsigned PublishConfig(std::unique_ptr<Config> config);
+
+// Free the retired snapshots. Call on the main thread while it holds no Config reference
+// (between messages). Returns how many were freed.
+size_t ReleaseRetiredConfigs();
@@ -0,0 +1,96 @@
+#include "constraints.h"
+
+#include <algorithm>
+
+// Combined limits of all windows on one side of a split
+struct SideLimits {
+    long min = 0;
+    long max = 0;  // 0 = unbounded
+};
+
+static void AddLimits(SideLimits& side, long min, long max) {
+    side.min = std::max(side.min, min);
+    if (max > 0) {
+        side.max = (side.max > 0) ? std::min(side.max, max) : max;
+    }
+}
+
+// Resolve one split line. The first side spans [outerStart, line - padding / 2], the second
+// side [line + padding / 2, outerEnd].
+static long SolveLine(long outerStart, long outerEnd, long desired, long padding,
+                      const SideLimits& first, const SideLimits& second) {
+    long half = padding / 2;
+    long minLine = outerStart + first.min + half;
+    long maxLine = outerEnd - second.min - half;
+
+    if (minLine > maxLine) {
+        // Both minimums cannot fit; share the space in proportion to them
+        long available = outerEnd - outerStart - 2 * half;
+        long total = first.min + second.min;
+        if (total <= 0) return desired;
+        return outerStart + half + available * first.min / total;
+    }
+
+    // Maximum sizes are soft: honor them only as long as both minimums still fit
+    if (first.max > 0) {
+        maxLine = std::min(maxLine, std::max(minLine, outerStart + first.max + half));
+    }
+    if (second.max > 0) {
+        minLine = std::max(minLine, std::min(maxLine, outerEnd - second.max - half));
+    }
+    return std::clamp(desired, minLine, maxLine);
+}
+
+SplitLines SolveSplitLines(const Rect& work, const SplitLines& desired, long padding,
+                           const LayoutMember* members, size_t count) {
+    SideLimits left, right, top, bottom;
+
+    for (size_t i = 0; i < count; ++i) {
+        const LayoutMember& m = members[i];
+        switch (StateSplitSide(m.state, SplitAxis::X)) {
+            case SplitSide::First: AddLimits(left, m.limits.minWidth, m.limits.maxWidth); break;
+            case SplitSide::Second: AddLimits(right, m.limits.minWidth, m.limits.maxWidth); break;
+            default: break;
+        }
+        switch (StateSplitSide(m.state, SplitAxis::Y)) {
+            case SplitSide::First: AddLimits(top, m.limits.minHeight, m.limits.maxHeight); break;
+            case SplitSide::Second: AddLimits(bottom, m.limits.minHeight, m.limits.maxHeight); break;
+            default: break;
+        }
+    }
+
+    SplitLines solved;
+    solved.x = SolveLine(work.left + padding, work.right - padding, desired.x, padding, left, right);
+    solved.y = SolveLine(work.top + padding, work.bottom - padding, desired.y, padding, top, bottom);
+    return solved;
+}
+
+bool LearnSizeConstraints(SizeConstraints& limits, const Rect& requested, const Rect& actual) {
+    bool learned = false;
+    long requestedWidth = RectWidth(requested);
+    long requestedHeight = RectHeight(requested);
+    long actualWidth = RectWidth(actual);
+    long actualHeight = RectHeight(actual);
+
+    // Any overshoot overlaps a neighbor, so it always counts as a minimum
+    if (actualWidth > requestedWidth && actualWidth > limits.minWidth) {
+        limits.minWidth = actualWidth;
+        learned = true;
+    }
+    if (actualHeight > requestedHeight && actualHeight > limits.minHeight) {
+        limits.minHeight = actualHeight;
+        learned = true;
+    }
+
+    if (requestedWidth - actualWidth > MAX_SIZE_LEARN_TOLERANCE &&
+        (limits.maxWidth == 0 || actualWidth < limits.maxWidth)) {
+        limits.maxWidth = actualWidth;
+        learned = true;
+    }
+    if (requestedHeight - actualHeight > MAX_SIZE_LEARN_TOLERANCE &&
+        (limits.maxHeight == 0 || actualHeight < limits.maxHeight)) {
+        limits.maxHeight = actualHeight;
+        learned = true;
+    }
+    return learned;
+}
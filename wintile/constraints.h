@@ -0,0 +1,34 @@
+#pragma once
+
+#include "layout.h"
+
+#include <cstddef>
+
+// Shortfalls up to this size are treated as size increments (e.g. terminals snapping to
+// character cells) rather than as a maximum size
+#define MAX_SIZE_LEARN_TOLERANCE 32
+
+// Size limits a window enforces on itself (0 = no limit known)
+struct SizeConstraints {
+    long minWidth = 0;
+    long minHeight = 0;
+    long maxWidth = 0;
+    long maxHeight = 0;
+};
+
+// A tracked window taking part in a monitor layout
+struct LayoutMember {
+    WindowId window;
+    WindowState state;
+    SizeConstraints limits;
+};
+
+// Move the split lines away from their desired position just far enough that every member
+// fits its limits. Runs in one linear pass: aggregate the limits of each column/row, then
+// clamp each line. Minimum sizes win over maximum sizes when both cannot be met.
+SplitLines SolveSplitLines(const Rect& work, const SplitLines& desired, long padding,
+                           const LayoutMember* members, size_t count);
+
+// Update `limits` from the rect a window actually took when asked for `requested`.
+// Returns true if anything new was learned.
+bool LearnSizeConstraints(SizeConstraints& limits, const Rect& requested, const Rect& actual);
@@ -0,0 +1,98 @@
+#include "event_queue.h"
+
+#include "tiler.h"
+#include "timeline.h"
+
+struct QueuedEvent {
+    WindowEvent event;
+    WindowId window;
+};
+
+// Ring buffer; head is the oldest entry
+static QueuedEvent queue[EVENT_QUEUE_CAPACITY];
+static size_t head = 0;
+static size_t count = 0;
+static bool foregroundQueued = false;
+static EventQueueStats stats = {};
+
+void ApplyWindowEvent(WindowEvent event, WindowId window) {
+    switch (event) {
+        case WindowEvent::Destroyed: HandleWindowDestroyed(window); break;
+        case WindowEvent::Hidden: HandleWindowHidden(window); break;
+        case WindowEvent::Shown: HandleWindowShown(window); break;
+        case WindowEvent::Foreground: UpdateFocusedWindow(); break;
+        case WindowEvent::Renamed: HandleWindowRenamed(window); break;
+        default: break;
+    }
+}
+
+bool QueueWindowEvent(WindowEvent event, WindowId window) {
+    // Repeats of pending work: one foreground update covers every focus change before it
+    // runs, and an event right behind the same one for the same window adds nothing
+    if (event == WindowEvent::Foreground && foregroundQueued) {
+        stats.coalesced += 1;
+        return true;
+    }
+    if (count) {
+        const QueuedEvent& last = queue[(head + count - 1) % EVENT_QUEUE_CAPACITY];
+        if (last.event == event && last.window == window) {
+            stats.coalesced += 1;
+            return true;
+        }
+    }
+
+    // Full: the oldest entry runs now to make room, so events still run in arrival order (a
+    // show overtaking the hide before it would lose its border)
+    bool overflowed = false;
+    while (count == EVENT_QUEUE_CAPACITY) {
+        stats.overflowed += 1;
+        overflowed = true;
+        DrainWindowEvents(1);
+    }
+
+    queue[(head + count) % EVENT_QUEUE_CAPACITY] = { event, window };
+    count += 1;
+    if (event == WindowEvent::Foreground) foregroundQueued = true;
+    stats.queued += 1;
+    if (count > stats.maxDepth) stats.maxDepth = count;
+    return !overflowed;
+}
+
+bool WindowEventsPending() {
+    return count != 0;
+}
+
+size_t PendingWindowEvents() {
+    return count;
+}
+
+size_t DrainWindowEvents(size_t maxEvents) {
+    TIMELINE_SPAN("event", "DrainWindowEvents");
+    size_t ran = 0;
+    while (count && ran < maxEvents) {
+        // Pop before running: a handler may pump messages and queue more events
+        QueuedEvent next = queue[head];
+        head = (head + 1) % EVENT_QUEUE_CAPACITY;
+        count -= 1;
+        if (next.event == WindowEvent::Foreground) foregroundQueued = false;
+
+        ApplyWindowEvent(next.event, next.window);
+        stats.applied += 1;
+        ++ran;
+    }
+    return ran;
+}
+
+void ClearWindowEvents() {
+    head = 0;
+    count = 0;
+    foregroundQueued = false;
+}
+
+const EventQueueStats& WindowEventStats() {
+    return stats;
+}
+
+void ResetWindowEventStats() {
+    stats = {};
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+// Deferred window-event work. WinEvent callbacks only queue what happened; the message loop
+// handles hotkeys first and drains the queue in bounded batches between them, so a burst of
+// show/hide/foreground events cannot delay a keypress behind border churn.
+
+#include "layout.h"
+
+#include <cstddef>
+
+// Fixed capacities; a full queue runs its oldest event to take a new one
+#define EVENT_QUEUE_CAPACITY 256
+#define EVENT_BATCH_SIZE 8
+
+enum class WindowEvent {
+    Destroyed,   // HandleWindowDestroyed
+    Hidden,      // HandleWindowHidden
+    Shown,       // HandleWindowShown (shown, restored, moved/resized by the user)
+    Foreground,  // UpdateFocusedWindow; reads the foreground when drained, so one is enough
+    Renamed,     // HandleWindowRenamed
+    Count
+};
+
+struct EventQueueStats {
+    long long queued;      // Events accepted into the queue
+    long long coalesced;   // Dropped as a repeat of pending work
+    long long overflowed;  // Oldest events run early because the queue was full
+    long long applied;     // Handled by a drain
+    size_t maxDepth;       // Deepest the queue has been
+};
+
+// Queue an event. Returns false if the queue was full and its oldest event ran to make room.
+bool QueueWindowEvent(WindowEvent event, WindowId window);
+
+// Run the tiler handler of one event now
+void ApplyWindowEvent(WindowEvent event, WindowId window);
+
+bool WindowEventsPending();
+size_t PendingWindowEvents();
+
+// Handle up to `maxEvents` queued events in arrival order; returns how many ran
+size_t DrainWindowEvents(size_t maxEvents);
+
+// Drop everything queued (the tiler was reset)
+void ClearWindowEvents();
+
+const EventQueueStats& WindowEventStats();
+void ResetWindowEventStats();
@@ -0,0 +1,77 @@
+#include "focus_settle.h"
+
+#include <cstdio>
+
+// Set by CMake
+#ifndef WINTILE_FOCUS_SETTLE_MS
+#define WINTILE_FOCUS_SETTLE_MS 40
+#endif
+
+static long long settleNs = WINTILE_FOCUS_SETTLE_MS * 1000000LL;
+static bool pending = false;
+static long long deadline = 0;
+static long long burstTransitions = 0;  // Changes since the last settle
+static WindowId latestWindow = 0;
+static WindowId settledWindow = 0;      // Foreground at the last settle
+static FocusSettleStats stats = {};
+
+void SetFocusSettleTime(long long ns) {
+    settleNs = ns > 0 ? ns : 0;
+}
+
+long long FocusSettleTime() {
+    return settleNs;
+}
+
+long long NoteForegroundChange(WindowId window, long long nowNs) {
+    stats.transitions += 1;
+    burstTransitions += 1;
+    latestWindow = window;
+    pending = true;
+    deadline = nowNs + settleNs;
+    return deadline;
+}
+
+bool FocusSettlePending() {
+    return pending;
+}
+
+long long FocusSettleDeadline() {
+    return deadline;
+}
+
+bool SettleFocus(long long nowNs) {
+    if (!pending) return false;
+    if (nowNs < deadline) return false;
+
+    // Every change of the burst but the last one never reached the border
+    stats.settled += 1;
+    stats.suppressed += burstTransitions - 1;
+    if (latestWindow == settledWindow) stats.reverted += 1;
+    settledWindow = latestWindow;
+    burstTransitions = 0;
+    pending = false;
+    return true;
+}
+
+void ClearFocusSettle() {
+    pending = false;
+    burstTransitions = 0;
+    latestWindow = 0;
+    settledWindow = 0;
+}
+
+void FormatFocusSettleStats(std::string* out) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "focus settle_ms=%.0f transitions=%lld settled=%lld suppressed=%lld reverted=%lld",
+                  settleNs / 1e6, stats.transitions, stats.settled, stats.suppressed, stats.reverted);
+    out->append(line);
+}
+
+const FocusSettleStats& FocusSettleStatistics() {
+    return stats;
+}
+
+void ResetFocusSettleStats() {
+    stats = {};
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+// Focus-flap hysteresis. Alt+Tab, UWP activation and notification toasts move the foreground
+// several times within a few milliseconds; the border only follows focus once it has stayed
+// put for the settle time. The caller owns the timer: every foreground change returns the
+// deadline to (re)arm it for, and when it fires SettleFocus says whether to update the border.
+// Times are caller-supplied nanoseconds, so replays can run on a virtual clock.
+
+#include "layout.h"
+
+#include <string>
+
+struct FocusSettleStats {
+    long long transitions;  // Foreground changes seen
+    long long settled;      // Border updates they led to
+    long long suppressed;   // Changes superseded within the settle time, no border update
+    long long reverted;     // Settled back on the window that had focus before the burst
+};
+
+// Starts at WINTILE_FOCUS_SETTLE_MS (CMake, default 40); 0 lets the border follow at once
+void SetFocusSettleTime(long long ns);
+long long FocusSettleTime();
+
+// The foreground moved to `window` at `nowNs`. Returns when the border should follow.
+long long NoteForegroundChange(WindowId window, long long nowNs);
+
+// A change is waiting for its settle time to pass
+bool FocusSettlePending();
+long long FocusSettleDeadline();
+
+// Settle timer fired: true if focus has now been stable for the settle time, in which case
+// the caller updates the border (UpdateFocusedWindow); false if it must wait until
+// FocusSettleDeadline()
+bool SettleFocus(long long nowNs);
+
+// Forget a pending change (the tiler was reset)
+void ClearFocusSettle();
+
+const FocusSettleStats& FocusSettleStatistics();
+void ResetFocusSettleStats();
+
+// "focus settle_ms=.. transitions=.. settled=.. suppressed=.. reverted=.." line
+void FormatFocusSettleStats(std::string* out);
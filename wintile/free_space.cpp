@@ -0,0 +1,97 @@
+#include "free_space.h"
+
+#include <algorithm>
+#include <vector>
+
+// Index of `value` in a sorted, de-duplicated coordinate list
+static size_t CoordIndex(const std::vector<long>& coords, long value) {
+    return static_cast<size_t>(std::lower_bound(coords.begin(), coords.end(), value) - coords.begin());
+}
+
+static void SortUnique(std::vector<long>& coords) {
+    std::sort(coords.begin(), coords.end());
+    coords.erase(std::unique(coords.begin(), coords.end()), coords.end());
+}
+
+bool FindLargestEmptyRect(const Rect& bounds, const Rect* obstacles, size_t count, Rect* out) {
+    if (RectIsEmpty(bounds)) return false;
+
+    // Clip obstacles to the bounds; whatever lies outside doesn't constrain the result
+    std::vector<Rect> clipped;
+    clipped.reserve(count);
+    std::vector<long> xs = { bounds.left, bounds.right };
+    std::vector<long> ys = { bounds.top, bounds.bottom };
+    for (size_t i = 0; i < count; ++i) {
+        Rect r = {
+            std::max(obstacles[i].left, bounds.left),
+            std::max(obstacles[i].top, bounds.top),
+            std::min(obstacles[i].right, bounds.right),
+            std::min(obstacles[i].bottom, bounds.bottom)
+        };
+        if (RectIsEmpty(r)) continue;
+        clipped.push_back(r);
+        xs.push_back(r.left);
+        xs.push_back(r.right);
+        ys.push_back(r.top);
+        ys.push_back(r.bottom);
+    }
+    SortUnique(xs);
+    SortUnique(ys);
+
+    size_t columns = xs.size() - 1;
+    size_t rows = ys.size() - 1;
+    size_t stride = columns + 1;
+
+    // 2D difference array over the compressed grid; running sums during the sweep give the
+    // number of obstacles covering each cell
+    std::vector<int> diff((rows + 1) * stride, 0);
+    for (const Rect& r : clipped) {
+        size_t x0 = CoordIndex(xs, r.left);
+        size_t x1 = CoordIndex(xs, r.right);
+        size_t y0 = CoordIndex(ys, r.top);
+        size_t y1 = CoordIndex(ys, r.bottom);
+        diff[y0 * stride + x0] += 1;
+        diff[y0 * stride + x1] -= 1;
+        diff[y1 * stride + x0] -= 1;
+        diff[y1 * stride + x1] += 1;
+    }
+
+    std::vector<int> columnCover(columns, 0);
+    std::vector<long> heights(columns, 0);  // Free height ending at the current row, in pixels
+    std::vector<size_t> stack;
+    stack.reserve(columns + 1);
+
+    long long bestArea = 0;
+    Rect best = {};
+
+    for (size_t y = 0; y < rows; ++y) {
+        long rowHeight = ys[y + 1] - ys[y];
+        int cover = 0;
+        for (size_t c = 0; c < columns; ++c) {
+            columnCover[c] += diff[y * stride + c];
+            cover += columnCover[c];
+            heights[c] = (cover > 0) ? 0 : heights[c] + rowHeight;
+        }
+
+        // Largest rectangle under the histogram; column widths come from the compressed xs
+        stack.clear();
+        for (size_t c = 0; c <= columns; ++c) {
+            long height = (c < columns) ? heights[c] : -1;  // Sentinel flushes the stack
+            while (!stack.empty() && heights[stack.back()] >= height) {
+                long barHeight = heights[stack.back()];
+                stack.pop_back();
+                size_t left = stack.empty() ? 0 : stack.back() + 1;
+                long long area = static_cast<long long>(xs[c] - xs[left]) * barHeight;
+                if (area > bestArea) {
+                    bestArea = area;
+                    best = { xs[left], ys[y + 1] - barHeight, xs[c], ys[y + 1] };
+                }
+            }
+            stack.push_back(c);
+        }
+    }
+
+    if (bestArea == 0) return false;
+    *out = best;
+    return true;
+}
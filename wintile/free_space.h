@@ -0,0 +1,11 @@
+#pragma once
+
+#include "geometry.h"
+
+#include <cstddef>
+
+// Find the largest-area rect inside `bounds` that overlaps none of the `obstacles`.
+// The obstacle edges are coordinate-compressed and a weighted maximal-rectangle histogram
+// sweep runs over the resulting grid, so the cost is O(n^2) in the number of obstacles and
+// independent of the pixel size of `bounds`. Returns false if no free area is left.
+bool FindLargestEmptyRect(const Rect& bounds, const Rect* obstacles, size_t count, Rect* out);
@@ -0,0 +1,43 @@
+#pragma once
+
+// Portable rectangle type used by the layout core (same layout as the Win32 RECT)
+struct Rect {
+    long left;
+    long top;
+    long right;
+    long bottom;
+};
+
+inline long RectWidth(const Rect& r) {
+    return r.right - r.left;
+}
+
+inline long RectHeight(const Rect& r) {
+    return r.bottom - r.top;
+}
+
+inline bool RectIsEmpty(const Rect& r) {
+    return r.right <= r.left || r.bottom <= r.top;
+}
+
+inline bool RectsIntersect(const Rect& a, const Rect& b) {
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+inline bool operator==(const Rect& a, const Rect& b) {
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+inline bool operator!=(const Rect& a, const Rect& b) {
+    return !(a == b);
+}
+
+// Portable point type (same layout as the Win32 POINT)
+struct Point {
+    long x;
+    long y;
+};
+
+inline bool RectContains(const Rect& r, const Point& p) {
+    return p.x >= r.left && p.x < r.right && p.y >= r.top && p.y < r.bottom;
+}
@@ -0,0 +1,106 @@
+#include "latency.h"
+
+#include <atomic>
+#include <cstdio>
+
+struct LatencyHistogram {
+    std::atomic<std::uint64_t> buckets[LATENCY_BUCKETS];
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> max;
+};
+
+// Zero-initialized as a static
+static LatencyHistogram histograms[static_cast<int>(LatencyStage::Count)];
+
+static int BucketIndex(std::uint64_t value) {
+    if (value < LATENCY_SUB_BUCKETS) return static_cast<int>(value);
+
+    int msb = 63;
+    while (!(value >> msb)) --msb;
+    int shift = msb - LATENCY_SUB_BUCKET_BITS;
+    int sub = static_cast<int>(value >> shift) - LATENCY_SUB_BUCKETS;
+    return (shift + 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Highest value that falls into a bucket
+static std::uint64_t BucketUpperBound(int index) {
+    if (index < LATENCY_SUB_BUCKETS) return static_cast<std::uint64_t>(index);
+
+    int shift = index / LATENCY_SUB_BUCKETS - 1;
+    std::uint64_t sub = static_cast<std::uint64_t>(index % LATENCY_SUB_BUCKETS);
+    return ((LATENCY_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+const char* LatencyStageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Hotkey: return "hotkey";
+        case LatencyStage::SnapRequest: return "snap_request";
+        case LatencyStage::MonitorSwitch: return "monitor_switch";
+        case LatencyStage::Placement: return "placement";
+        case LatencyStage::Border: return "border";
+        case LatencyStage::Cursor: return "cursor";
+        default: return "unknown";
+    }
+}
+
+void RecordLatency(LatencyStage stage, std::uint64_t ns) {
+    LatencyHistogram& h = histograms[static_cast<int>(stage)];
+    h.buckets[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    h.count.fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t previous = h.max.load(std::memory_order_relaxed);
+    while (ns > previous && !h.max.compare_exchange_weak(previous, ns, std::memory_order_relaxed)) {
+    }
+}
+
+std::uint64_t LatencyCount(LatencyStage stage) {
+    return histograms[static_cast<int>(stage)].count.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyMax(LatencyStage stage) {
+    return histograms[static_cast<int>(stage)].max.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyPercentile(LatencyStage stage, double p) {
+    const LatencyHistogram& h = histograms[static_cast<int>(stage)];
+    std::uint64_t total = h.count.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+
+    std::uint64_t rank = static_cast<std::uint64_t>(p * static_cast<double>(total) + 0.5);
+    if (rank == 0) rank = 1;
+
+    std::uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+        seen += h.buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // Never report more than the largest value actually seen
+            std::uint64_t bound = BucketUpperBound(i);
+            std::uint64_t max = h.max.load(std::memory_order_relaxed);
+            return bound < max ? bound : max;
+        }
+    }
+    return h.max.load(std::memory_order_relaxed);
+}
+
+void FormatLatencyReport(std::string* out) {
+    for (int i = 0; i < static_cast<int>(LatencyStage::Count); ++i) {
+        LatencyStage stage = static_cast<LatencyStage>(i);
+        std::uint64_t count = LatencyCount(stage);
+        if (count == 0) continue;
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "stage=%s count=%llu p50_us=%.1f p99_us=%.1f p999_us=%.1f max_us=%.1f\n",
+                      LatencyStageName(stage), static_cast<unsigned long long>(count),
+                      LatencyPercentile(stage, 0.50) / 1000.0, LatencyPercentile(stage, 0.99) / 1000.0,
+                      LatencyPercentile(stage, 0.999) / 1000.0, LatencyMax(stage) / 1000.0);
+        out->append(line);
+    }
+}
+
+void ResetLatency() {
+    for (auto& h : histograms) {
+        for (auto& bucket : h.buckets) bucket.store(0, std::memory_order_relaxed);
+        h.count.store(0, std::memory_order_relaxed);
+        h.max.store(0, std::memory_order_relaxed);
+    }
+}
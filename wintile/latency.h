@@ -0,0 +1,66 @@
+#pragma once
+
+// Per-stage hotkey latency histograms. Tracepoints are placed with TRACE_LATENCY(stage),
+// which times the rest of the enclosing scope and compiles to nothing unless WINTILE_TRACE
+// is defined (CMake option WINTILE_ENABLE_TRACE).
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+enum class LatencyStage {
+    Hotkey,         // WM_HOTKEY handling in WndProc, end to end
+    SnapRequest,    // HandleSnapRequest
+    MonitorSwitch,  // HandleMonitorSwitch
+    Placement,      // SetWindowPos / DeferWindowPos batch
+    Border,         // CreateOrUpdateBorder
+    Cursor,         // Final SetCursorPos
+    Count
+};
+
+// Histogram buckets are log-linear: 16 linear sub-buckets per power of two, so a recorded
+// value is reported within ~6% of its true value across the whole ns..minutes range
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKETS (64 * LATENCY_SUB_BUCKETS)
+
+const char* LatencyStageName(LatencyStage stage);
+
+// Record one sample. Lock-free (relaxed atomic increments), safe from any thread.
+void RecordLatency(LatencyStage stage, std::uint64_t ns);
+
+// Samples recorded for a stage, and the value at percentile `p` (0..1) in nanoseconds
+std::uint64_t LatencyCount(LatencyStage stage);
+std::uint64_t LatencyPercentile(LatencyStage stage, double p);
+std::uint64_t LatencyMax(LatencyStage stage);
+
+// One "stage=<name> count=.. p50_us=.. p99_us=.. p999_us=.. max_us=.." line per stage
+// that has samples
+void FormatLatencyReport(std::string* out);
+
+void ResetLatency();
+
+// Records the lifetime of the scope into a stage
+class LatencyScope {
+public:
+    explicit LatencyScope(LatencyStage stage) : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+    ~LatencyScope() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        RecordLatency(stage_, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+    LatencyScope(const LatencyScope&) = delete;
+    LatencyScope& operator=(const LatencyScope&) = delete;
+
+private:
+    LatencyStage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#define LATENCY_CONCAT_INNER(a, b) a##b
+#define LATENCY_CONCAT(a, b) LATENCY_CONCAT_INNER(a, b)
+
+#ifdef WINTILE_TRACE
+#define TRACE_LATENCY(stage) LatencyScope LATENCY_CONCAT(latencyScope, __LINE__)(stage)
+#else
+#define TRACE_LATENCY(stage) ((void)0)
+#endif
@@ -0,0 +1,137 @@
+#include "layout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+static bool IsLeftColumn(WindowState state) {
+    return state == WindowState::LeftHalf || state == WindowState::TopLeftQuarter || state == WindowState::BottomLeftQuarter;
+}
+
+static bool IsRightColumn(WindowState state) {
+    return state == WindowState::RightHalf || state == WindowState::TopRightQuarter || state == WindowState::BottomRightQuarter;
+}
+
+static bool IsTopRow(WindowState state) {
+    return state == WindowState::TopHalf || state == WindowState::TopLeftQuarter || state == WindowState::TopRightQuarter;
+}
+
+static bool IsBottomRow(WindowState state) {
+    return state == WindowState::BottomHalf || state == WindowState::BottomLeftQuarter || state == WindowState::BottomRightQuarter;
+}
+
+SplitLines SplitLinesFromRatio(const Rect& work, const SplitRatio& split) {
+    // A ratio of 0.5 reproduces the classic w / 2 and h / 2 layout
+    SplitLines lines;
+    lines.x = work.left + static_cast<long>(RectWidth(work) * split.x);
+    lines.y = work.top + static_cast<long>(RectHeight(work) * split.y);
+    return lines;
+}
+
+bool ComputeSnapRect(const Rect& work, WindowState state, const SplitRatio& split, long padding, Rect* out) {
+    return ComputeSnapRectAt(work, state, SplitLinesFromRatio(work, split), padding, out);
+}
+
+bool ComputeSnapRectAt(const Rect& work, WindowState state, const SplitLines& lines, long padding, Rect* out) {
+    long splitX = lines.x;
+    long splitY = lines.y;
+
+    long outerLeft = work.left + padding;
+    long outerTop = work.top + padding;
+    long outerRight = work.right - padding;
+    long outerBottom = work.bottom - padding;
+
+    // Windows on either side of a split share the padding between them
+    long leftColumnRight = splitX - padding / 2;
+    long rightColumnLeft = splitX + padding / 2;
+    long topRowBottom = splitY - padding / 2;
+    long bottomRowTop = splitY + padding / 2;
+
+    switch (state) {
+        case WindowState::LeftHalf:
+            *out = { outerLeft, outerTop, leftColumnRight, outerBottom };
+            break;
+        case WindowState::RightHalf:
+            *out = { rightColumnLeft, outerTop, outerRight, outerBottom };
+            break;
+        case WindowState::TopHalf:
+            *out = { outerLeft, outerTop, outerRight, topRowBottom };
+            break;
+        case WindowState::BottomHalf:
+            *out = { outerLeft, bottomRowTop, outerRight, outerBottom };
+            break;
+        case WindowState::TopLeftQuarter:
+            *out = { outerLeft, outerTop, leftColumnRight, topRowBottom };
+            break;
+        case WindowState::TopRightQuarter:
+            *out = { rightColumnLeft, outerTop, outerRight, topRowBottom };
+            break;
+        case WindowState::BottomLeftQuarter:
+            *out = { outerLeft, bottomRowTop, leftColumnRight, outerBottom };
+            break;
+        case WindowState::BottomRightQuarter:
+            *out = { rightColumnLeft, bottomRowTop, outerRight, outerBottom };
+            break;
+        case WindowState::Maximized:
+            *out = { outerLeft, outerTop, outerRight, outerBottom };
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+WindowState InferSnapState(const Rect& rect, const Rect& work, const SplitLines& lines, long padding, long tolerance) {
+    WindowState best = WindowState::Unknown;
+    long bestDistance = tolerance + 1;
+    for (int i = static_cast<int>(WindowState::LeftHalf); i <= static_cast<int>(WindowState::Maximized); ++i) {
+        WindowState state = static_cast<WindowState>(i);
+        Rect target;
+        if (!ComputeSnapRectAt(work, state, lines, padding, &target)) continue;
+
+        // Largest edge offset; every edge must be close, not just the sum
+        long distance = std::max({ std::labs(rect.left - target.left), std::labs(rect.top - target.top),
+                                   std::labs(rect.right - target.right), std::labs(rect.bottom - target.bottom) });
+        if (distance < bestDistance) {
+            best = state;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+SplitSide StateSplitSide(WindowState state, SplitAxis axis) {
+    if (axis == SplitAxis::X) {
+        if (IsLeftColumn(state)) return SplitSide::First;
+        if (IsRightColumn(state)) return SplitSide::Second;
+    } else {
+        if (IsTopRow(state)) return SplitSide::First;
+        if (IsBottomRow(state)) return SplitSide::Second;
+    }
+    return SplitSide::None;
+}
+
+bool StateUsesSplit(WindowState state, SplitAxis axis) {
+    return StateSplitSide(state, axis) != SplitSide::None;
+}
+
+bool AdjustSplitRatio(SplitRatio& split, WindowState state, SplitAxis axis, int steps) {
+    float* ratio = (axis == SplitAxis::X) ? &split.x : &split.y;
+
+    // Growing a window in the first column/row moves the split away from it
+    float direction;
+    switch (StateSplitSide(state, axis)) {
+        case SplitSide::First: direction = 1.0f; break;
+        case SplitSide::Second: direction = -1.0f; break;
+        default: return false;
+    }
+
+    float next = *ratio + direction * static_cast<float>(steps) * SPLIT_RATIO_STEP;
+    // Snap to the step grid so repeated presses don't accumulate float drift
+    next = std::round(next / SPLIT_RATIO_STEP) * SPLIT_RATIO_STEP;
+    next = std::clamp(next, SPLIT_RATIO_MIN, SPLIT_RATIO_MAX);
+    if (next == *ratio) return false;
+
+    *ratio = next;
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "geometry.h"
+
+#include <cstdint>
+
+// Opaque window handle used by the portable core (an HWND on Windows)
+typedef std::uintptr_t WindowId;
+
+enum class SnapDirection {
+    Left,
+    Right,
+    Up,
+    Down
+};
+
+enum class WindowState {
+    Unknown,
+    LeftHalf,
+    RightHalf,
+    TopHalf,
+    BottomHalf,
+    TopLeftQuarter,
+    TopRightQuarter,
+    BottomLeftQuarter,
+    BottomRightQuarter,
+    Maximized
+};
+
+// Which split line of a monitor a resize command moves
+enum class SplitAxis {
+    X,  // Vertical line between the left and right column
+    Y   // Horizontal line between the top and bottom row
+};
+
+// Split ratio limits and the step applied per grow/shrink key press
+#define SPLIT_RATIO_MIN 0.15f
+#define SPLIT_RATIO_MAX 0.85f
+#define SPLIT_RATIO_STEP 0.05f
+
+// Per-monitor split position as a fraction of the work area
+struct SplitRatio {
+    float x = 0.5f;
+    float y = 0.5f;
+};
+
+// Split line positions in screen coordinates
+struct SplitLines {
+    long x;
+    long y;
+};
+
+// Side of a split line a state's rect lies on
+enum class SplitSide {
+    None,    // The state spans the split (or is not tiled)
+    First,   // Left column / top row
+    Second   // Right column / bottom row
+};
+
+// Placement flags beyond the move/size itself
+#define PLACEMENT_SHOW 0x1  // Show the window at `rect`
+#define PLACEMENT_HIDE 0x2  // Hide the window in place; `rect` is ignored
+
+// One window move of a batched placement pass
+struct Placement {
+    WindowId window;
+    Rect rect;
+    unsigned flags = 0;
+};
+
+// Convert a monitor's split ratio into split line positions
+SplitLines SplitLinesFromRatio(const Rect& work, const SplitRatio& split);
+
+// Compute the target rect of a snap state inside a work area
+bool ComputeSnapRect(const Rect& work, WindowState state, const SplitRatio& split, long padding, Rect* out);
+
+// Same as ComputeSnapRect, for split lines that have already been resolved
+bool ComputeSnapRectAt(const Rect& work, WindowState state, const SplitLines& lines, long padding, Rect* out);
+
+// The snap state whose rect (as ComputeSnapRectAt gives it) `rect` matches to within
+// `tolerance` pixels on every edge; the closest one if several do, Unknown if none
+WindowState InferSnapState(const Rect& rect, const Rect& work, const SplitLines& lines, long padding, long tolerance);
+
+// Which side of the given split line a state's rect lies on
+SplitSide StateSplitSide(WindowState state, SplitAxis axis);
+
+// True if the state's rect depends on the given split line
+bool StateUsesSplit(WindowState state, SplitAxis axis);
+
+// Move the split line so the window in `state` grows (steps > 0) or shrinks (steps < 0).
+// Returns false if the state does not touch that split or the ratio is already at its limit.
+bool AdjustSplitRatio(SplitRatio& split, WindowState state, SplitAxis axis, int steps);
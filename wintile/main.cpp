@@ -1,241 +1,199 @@
 #include <windows.h>
+#include <dwmapi.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
-#include <dwmapi.h>  // Add DWM API support
-
-// Add includes for unordered_map and hooks
-#include <unordered_map>
-#include <windowsx.h> // For GET_X_LPARAM etc if needed
-
-// Hotkey IDs
-#define HOTKEY_ID_H 1
-#define HOTKEY_ID_J 2
-#define HOTKEY_ID_K 3
-#define HOTKEY_ID_L 4
-
-#define HOTKEY_ID_SHIFT_H 5
-#define HOTKEY_ID_SHIFT_J 6
-#define HOTKEY_ID_SHIFT_K 7
-#define HOTKEY_ID_SHIFT_L 8
-
-#define HOTKEY_ID_LEFT_ARROW 9
-#define HOTKEY_ID_DOWN_ARROW 10
-#define HOTKEY_ID_UP_ARROW 11
-#define HOTKEY_ID_RIGHT_ARROW 12
-
-#define HOTKEY_ID_SHIFT_LEFT_ARROW 13
-#define HOTKEY_ID_SHIFT_DOWN_ARROW 14
-#define HOTKEY_ID_SHIFT_UP_ARROW 15
-#define HOTKEY_ID_SHIFT_RIGHT_ARROW 16
-
-// Border and padding configuration
-#define BORDER_WIDTH 2
-#define PADDING 6
-#define FOCUSED_BORDER_COLOR RGB(100, 149, 237)  // Blue-gray for focused window
-#define TRANSPARENT_COLOR RGB(255, 0, 255)  // Magenta for color-key transparency
-
-enum class SnapDirection {
-    Left,
-    Right,
-    Up,
-    Down
-};
-
-enum class WindowState {
-    Unknown,
-    LeftHalf,
-    RightHalf,
-    TopHalf,
-    BottomHalf,
-    TopLeftQuarter,
-    TopRightQuarter,
-    BottomLeftQuarter,
-    BottomRightQuarter,
-    Maximized
-};
-
-// Change to unordered_map
-std::unordered_map<HWND, WindowState> windowStates;
-
-// Maximized state for full-screen toggle
-std::unordered_map<HWND, RECT> originalPositions;
-
-// Border windows management
-std::unordered_map<HWND, HWND> windowBorders;  // Maps application window to its border window
-
-// Focus and visibility tracking
-HWND currentFocusedWindow = NULL;
+
+#include "animation.h"
+#include "border_tracker.h"
+#include "command_channel.h"
+#include "config.h"
+#include "event_queue.h"
+#include "focus_settle.h"
+#include "latency.h"
+#include "shared_region.h"
+#include "tiler.h"
+#include "timeline.h"
+#include "timer_wheel.h"
+#include "watchdog.h"
+#include "window_system_win32.h"
+
+// A message handled for longer than this is reported as a stall (set by CMake)
+#ifndef WINTILE_STALL_THRESHOLD_MS
+#define WINTILE_STALL_THRESHOLD_MS 250
+#endif
+
+// Posted to ourselves to apply coalesced split resizes
+#define WM_APP_APPLY_SPLIT (WM_APP + 1)
+
+// Posted by the frame pacer at the start of a display frame
+#define WM_APP_BORDER_FRAME (WM_APP + 2)
+
+// Posted by the config watcher after it published new settings
+#define WM_APP_CONFIG_CHANGED (WM_APP + 3)
+
+// Posted by the thread pool when a process whose executable name the rules cached has exited
+#define WM_APP_PROCESS_EXITED (WM_APP + 4)
+
+// Posted by the startup adoption workers when classified windows are waiting, and by the
+// handler to itself while more are
+#define WM_APP_ADOPT_WINDOWS (WM_APP + 5)
+
+// Posted by the command channel when a script's commands are waiting
+#define WM_APP_RUN_COMMANDS (WM_APP + 6)
+
+// The config watcher reads the file this long after a change; editors save in several writes
+#define CONFIG_RELOAD_DELAY_MS 50
+#define CONFIG_MAX_FILE_SIZE (1 << 20)
+
+// After a mark or jump hotkey the letters a-z are hotkeys of their own until one is pressed,
+// Escape cancels, or this much time passes
+#define MARK_LETTER_TIMEOUT_MS 2000
+#define MARK_LETTER_HOTKEY_ID 0xB000  // Ids of the letters, then Escape; above the config's
+#define MARK_HELD_LETTER_HOTKEY_ID (MARK_LETTER_HOTKEY_ID + MARK_COUNT + 1)  // Letters with the chord's modifiers
+
+// Resolution of the message loop's timers
+#define LOOP_TIMER_TICK_NS 1000000  // 1 ms
+
+// Owns the hotkeys
+static HWND mainWindow = NULL;
+
+// The tiler's OS backend; also reports process exits for the rules' name cache
+static Win32WindowSystem* windowSystem = NULL;
+
+// Message loop clock (QueryPerformanceCounter underneath)
+static long long TickNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Deferred work of the main thread; the message loop sleeps until the next one is due
+static TimerWheel loopTimers(LOOP_TIMER_TICK_NS, TickNs());
+
+// Fires once the foreground has held for the focus settle time
+static void OnFocusSettleTimer(void*, long long nowNs);
+static Timer focusSettleTimer(OnFocusSettleTimer, NULL);
+
+// (Re)arm the focus settle timer for the pending deadline
+static void ArmFocusSettleTimer() {
+    loopTimers.Schedule(&focusSettleTimer, FocusSettleDeadline());
+}
+
+static void OnFocusSettleTimer(void*, long long nowNs) {
+    if (SettleFocus(nowNs)) {
+        QueueWindowEvent(WindowEvent::Foreground, 0);
+    } else if (FocusSettlePending()) {
+        ArmFocusSettleTimer();  // Re-armed by a later change
+    }
+}
+
+// Milliseconds the loop may sleep before the next timer is due, INFINITE if none is armed
+static DWORD LoopTimeoutMs() {
+    long long wake = loopTimers.NextWakeNs();
+    if (wake < 0) return INFINITE;
+    long long remaining = wake - TickNs();
+    return remaining > 0 ? static_cast<DWORD>((remaining + 999999) / 1000000) : 0;
+}
 
 // Add global hook variables
 static HWINEVENTHOOK hEventHook = NULL;
 
-// Add cache for monitors
-std::unordered_map<HMONITOR, MONITORINFO> monitorCache;
-
 // Forward declarations
-void SnapWindow(HWND hwnd, WindowState newState, HMONITOR monitor);
-void CreateOrUpdateBorder(HWND appWindow);
-void RemoveBorder(HWND appWindow);
 LRESULT CALLBACK BorderWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
-bool IsWindowFullscreen(HWND hwnd);
-void UpdateBorderVisibility(HWND appWindow);
-bool ShouldWindowHaveBorder(HWND hwnd);
-void UpdateFocusedWindow();
-BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam);
-BOOL CALLBACK MonitorEnumProc(HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData);
+
+// Frame pacer: set frameRequest when the border turns dirty and the pacer thread posts
+// WM_APP_BORDER_FRAME at the next composition, so a drag moves the border once per refresh
+static HANDLE frameRequest = NULL;  // Auto-reset
+static std::thread framePacer;
+static std::atomic<bool> framePacerStopping(false);
+
+// Frame interval of the primary display, used if DWM cannot pace us
+static DWORD RefreshIntervalMs() {
+    DEVMODEW mode = { };
+    mode.dmSize = sizeof(mode);
+    if (EnumDisplaySettingsW(NULL, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1) {
+        return 1000 / mode.dmDisplayFrequency;
+    }
+    return 16;
+}
+
+// Snap animations step on the same frames; the first one of a run asks for a frame
+static Animator animator;
+
+static void RequestAnimationFrame() {
+    SetEvent(frameRequest);
+}
+
+static void FramePacerLoop() {
+    DWORD fallbackMs = RefreshIntervalMs();
+    while (WaitForSingleObject(frameRequest, INFINITE) == WAIT_OBJECT_0 && !framePacerStopping) {
+        if (FAILED(DwmFlush())) Sleep(fallbackMs);
+        PostMessage(mainWindow, WM_APP_BORDER_FRAME, 0, 0);
+    }
+}
 
 // Add hook procedure
 void CALLBACK WinEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject, LONG idChild, DWORD dwEventThread, DWORD dwmsEventTime) {
+    // Out-of-context hooks run inside the loop's message calls, where it counts as idle
+    WatchdogMessage busy;
+    TIMELINE_SPAN_ARG("event", "WinEventProc", event);
     if (!hwnd)
         return;
 
+    // Only queue the work; the message loop runs it between hotkeys
     switch (event) {
         case EVENT_OBJECT_DESTROY:
+            // Only the window itself going away ends tracking (ignore carets, menus etc.)
+            if (idObject == OBJID_WINDOW && idChild == CHILDID_SELF) {
+                QueueWindowEvent(WindowEvent::Destroyed, ToWindowId(hwnd));
+            } else {
+                QueueWindowEvent(WindowEvent::Hidden, ToWindowId(hwnd));
+            }
+            break;
+
         case EVENT_OBJECT_HIDE:
-            // Always remove the border when a window is hidden or destroyed
-            RemoveBorder(hwnd);
+            QueueWindowEvent(WindowEvent::Hidden, ToWindowId(hwnd));
             break;
 
         case EVENT_SYSTEM_MOVESIZEEND:
         case EVENT_SYSTEM_MINIMIZEEND:
         case EVENT_OBJECT_SHOW:
-            if (hwnd == currentFocusedWindow && ShouldWindowHaveBorder(hwnd)) {
-                CreateOrUpdateBorder(hwnd);
-            }
+            QueueWindowEvent(WindowEvent::Shown, ToWindowId(hwnd));
             break;
 
-        case EVENT_SYSTEM_FOREGROUND:
-            UpdateFocusedWindow();
+        case EVENT_OBJECT_LOCATIONCHANGE:
+            // Fires for every step of a drag; the border follows once per display frame
+            if (idObject == OBJID_WINDOW && idChild == CHILDID_SELF &&
+                NoteLocationChange(ToWindowId(hwnd))) {
+                SetEvent(frameRequest);
+            }
             break;
-    }
-}
-
-// Modify GetActualWindowRect to use DWM first and cache if possible
-bool GetActualWindowRect(HWND hwnd, RECT* rect) {
-    HRESULT hr = DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, rect, sizeof(RECT));
-    if (SUCCEEDED(hr)) {
-        return true;
-    }
-    return GetWindowRect(hwnd, rect) != 0;
-}
-
-// Check if window is in fullscreen mode
-bool IsWindowFullscreen(HWND hwnd) {
-    if (!hwnd || !IsWindow(hwnd)) return false;
-    
-    // Get window rect
-    RECT windowRect;
-    if (!GetWindowRect(hwnd, &windowRect)) return false;
-    
-    // Get monitor info for the window
-    HMONITOR monitor = MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST);
-    MONITORINFO mi = { sizeof(mi) };
-    if (!GetMonitorInfo(monitor, &mi)) return false;
-    
-    // Check if window covers the entire monitor (including taskbar area)
-    return (windowRect.left <= mi.rcMonitor.left &&
-            windowRect.top <= mi.rcMonitor.top &&
-            windowRect.right >= mi.rcMonitor.right &&
-            windowRect.bottom >= mi.rcMonitor.bottom);
-}
-
-// Check if window should have a border
-bool ShouldWindowHaveBorder(HWND hwnd) {
-    if (!hwnd || !IsWindow(hwnd) || !IsWindowVisible(hwnd)) {
-        return false;
-    }
-    
-    // Don't show borders for fullscreen windows
-    if (IsWindowFullscreen(hwnd)) {
-        return false;
-    }
-    
-    // Don't show borders for minimized windows
-    if (IsIconic(hwnd)) {
-        return false;
-    }
-    
-    // Don't show borders for desktop, taskbar, etc.
-    wchar_t className[256];
-    if (GetClassNameW(hwnd, className, sizeof(className) / sizeof(wchar_t))) {
-        if (lstrcmpW(className, L"Progman") == 0 || 
-            lstrcmpW(className, L"WorkerW") == 0 || 
-            lstrcmpW(className, L"Shell_TrayWnd") == 0 ||
-            lstrcmpW(className, L"DV2ControlHost") == 0 ||
-            lstrcmpW(className, L"MsgrIMEWindowClass") == 0 ||
-            lstrcmpW(className, L"SysShadow") == 0 ||
-            lstrcmpW(className, L"SnapAssistFlyout") == 0 ||
-            lstrcmpW(className, L"SearchUI") == 0 ||
-            lstrcmpW(className, L"Shell_Flyout") == 0) {
-            return false;
-        }
-    }
-    
-    // Don't show borders for very small windows (likely system windows)
-    RECT rect;
-    if (GetWindowRect(hwnd, &rect)) {
-        int width = rect.right - rect.left;
-        int height = rect.bottom - rect.top;
-        if (width < 100 || height < 50) {
-            return false;
-        }
-    }
-    
-    // Check window style - only show for normal application windows
-    LONG style = GetWindowLong(hwnd, GWL_STYLE);
-    LONG exStyle = GetWindowLong(hwnd, GWL_EXSTYLE);
-    
-    // Must have a caption or be a popup with visible border
-    if (!(style & WS_CAPTION) && !(style & WS_POPUP)) {
-        return false;
-    }
-    
-    // Skip tool windows and other special windows
-    if (exStyle & WS_EX_TOOLWINDOW) {
-        return false;
-    }
-    
-    return true;
-}
-
-// Update border visibility based on window state
-void UpdateBorderVisibility(HWND appWindow) {
-    if (appWindow == currentFocusedWindow && ShouldWindowHaveBorder(appWindow)) {
-        CreateOrUpdateBorder(appWindow);
-    } else {
-        RemoveBorder(appWindow);
-    }
-}
 
-// Update focused window
-void UpdateFocusedWindow() {
-    HWND newFocusedWindow = GetForegroundWindow();
-    if (newFocusedWindow != currentFocusedWindow) {
-        HWND oldFocusedWindow = currentFocusedWindow;
-        currentFocusedWindow = newFocusedWindow;
+        case EVENT_OBJECT_NAMECHANGE:
+            // Only title rules care, and only about the window's own title
+            if (idObject == OBJID_WINDOW && idChild == CHILDID_SELF && CurrentConfig().ruleMatcher.UsesTitles()) {
+                QueueWindowEvent(WindowEvent::Renamed, ToWindowId(hwnd));
+            }
+            break;
 
-        // Remove border from the old focused window
-        if (oldFocusedWindow) {
-            RemoveBorder(oldFocusedWindow);
-        }
-        // Create or update border for the new focused window
-        if (currentFocusedWindow && ShouldWindowHaveBorder(currentFocusedWindow)) {
-            CreateOrUpdateBorder(currentFocusedWindow);
-        }
+        case EVENT_SYSTEM_FOREGROUND:
+            // The border follows once the foreground stops flapping (Alt+Tab, toasts)
+            if (FocusSettleTime() == 0) {
+                QueueWindowEvent(WindowEvent::Foreground, ToWindowId(hwnd));
+                break;
+            }
+            NoteForegroundChange(ToWindowId(hwnd), TickNs());
+            ArmFocusSettleTimer();
+            break;
     }
 }
 
-// Enumerate windows callback
-BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
-    // This function is no longer strictly necessary with the new border logic,
-    // but can be kept for future debugging or functionality.
-    // For now, it does nothing.
-    return TRUE;
-}
-
 // Border window class registration
 bool RegisterBorderWindowClass(HINSTANCE hInstance) {
-    const WCHAR BORDER_CLASS_NAME[] = L"WinTilerBorderClass";
-    
     WNDCLASSW wc = { };
     wc.lpfnWndProc = BorderWndProc;
     wc.hInstance = hInstance;
@@ -251,6 +209,7 @@ bool RegisterBorderWindowClass(HINSTANCE hInstance) {
 LRESULT CALLBACK BorderWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     switch (msg) {
         case WM_PAINT: {
+            TIMELINE_SPAN("border", "BorderPaint");
             PAINTSTRUCT ps;
             HDC hdc = BeginPaint(hwnd, &ps);
             
@@ -263,22 +222,25 @@ LRESULT CALLBACK BorderWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam
             DeleteObject(transparentBrush);
             
             // Border is always for the focused window
-            COLORREF borderColor = FOCUSED_BORDER_COLOR;
+            const Config& config = CurrentConfig();
+            COLORREF borderColor = RGB((config.borderColor >> 16) & 0xFF, (config.borderColor >> 8) & 0xFF,
+                                       config.borderColor & 0xFF);
+            int width = config.borderWidth;
             
             // Create brush for border color
             HBRUSH borderBrush = CreateSolidBrush(borderColor);
             
-            // Draw border (2px thick)
-            RECT topBorder = {0, 0, rect.right, BORDER_WIDTH};
+            // Draw border (border_width px thick)
+            RECT topBorder = {0, 0, rect.right, width};
             FillRect(hdc, &topBorder, borderBrush);
             
-            RECT bottomBorder = {0, rect.bottom - BORDER_WIDTH, rect.right, rect.bottom};
+            RECT bottomBorder = {0, rect.bottom - width, rect.right, rect.bottom};
             FillRect(hdc, &bottomBorder, borderBrush);
             
-            RECT leftBorder = {0, 0, BORDER_WIDTH, rect.bottom};
+            RECT leftBorder = {0, 0, width, rect.bottom};
             FillRect(hdc, &leftBorder, borderBrush);
             
-            RECT rightBorder = {rect.right - BORDER_WIDTH, 0, rect.right, rect.bottom};
+            RECT rightBorder = {rect.right - width, 0, rect.right, rect.bottom};
             FillRect(hdc, &rightBorder, borderBrush);
             
             DeleteObject(borderBrush);
@@ -295,484 +257,497 @@ LRESULT CALLBACK BorderWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam
     }
 }
 
-void CreateOrUpdateBorder(HWND appWindow) {
-    if (!appWindow || appWindow != currentFocusedWindow) return;
-    
-    RECT appRect;
-    if (!GetActualWindowRect(appWindow, &appRect)) return;
-    
-    // Calculate border window position (extending around the app window)
-    RECT borderRect;
-    borderRect.left = appRect.left - BORDER_WIDTH;
-    borderRect.top = appRect.top - BORDER_WIDTH;
-    borderRect.right = appRect.right + BORDER_WIDTH;
-    borderRect.bottom = appRect.bottom + BORDER_WIDTH;
-    
-    HWND borderWindow = NULL;
-    if (windowBorders.count(appWindow)) {
-        // Update existing border window - position it right behind the app window
-        borderWindow = windowBorders[appWindow];
-        SetWindowPos(borderWindow, appWindow, 
-                    borderRect.left, borderRect.top,
-                    borderRect.right - borderRect.left,
-                    borderRect.bottom - borderRect.top,
-                    SWP_NOACTIVATE | SWP_SHOWWINDOW);
-        
-        // Trigger repaint to update border color
-        InvalidateRect(borderWindow, NULL, TRUE);
-    } else {
-        // Create new border window without TOPMOST flag
-        borderWindow = CreateWindowExW(
-            WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_NOACTIVATE | WS_EX_TOOLWINDOW,
-            L"WinTilerBorderClass",
-            L"",
-            WS_POPUP,
-            borderRect.left, borderRect.top,
-            borderRect.right - borderRect.left,
-            borderRect.bottom - borderRect.top,
-            NULL, NULL, GetModuleHandle(NULL), NULL
-        );
-        
-        if (borderWindow) {
-            // Use pure color-key transparency to ensure no darkening occurs
-            SetLayeredWindowAttributes(borderWindow, TRANSPARENT_COLOR, 255, LWA_COLORKEY);
-            
-            // Position border window right behind the app window in Z-order
-            SetWindowPos(borderWindow, appWindow, 0, 0, 0, 0, 
-                        SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
-            
-            windowBorders[appWindow] = borderWindow;
-            ShowWindow(borderWindow, SW_SHOWNOACTIVATE);
-        }
-    }
-}
+// Queue a split resize; presses that arrive before WM_APP_APPLY_SPLIT is processed are coalesced
+void HandleSplitResize(HWND messageWindow, SplitAxis axis, int steps) {
+    if (!QueueSplitResize(axis, steps)) return;
 
-void RemoveBorder(HWND appWindow) {
-    if (windowBorders.count(appWindow)) {
-        HWND borderWindow = windowBorders[appWindow];
-        DestroyWindow(borderWindow);
-        windowBorders.erase(appWindow);
+    // Could not defer (message queue full), apply right away
+    if (!PostMessage(messageWindow, WM_APP_APPLY_SPLIT, 0, 0)) {
+        ApplyPendingSplitResize();
     }
 }
 
-// Modify UpdateAllBorders to be called less frequently or on demand
-void UpdateAllBorders() {
-    UpdateFocusedWindow();
+// Path of a file next to the executable
+bool GetExecutableSiblingPath(const wchar_t* fileName, std::wstring* out) {
+    wchar_t path[MAX_PATH];
+    DWORD length = GetModuleFileNameW(NULL, path, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH) return false;
+    out->assign(path, length);
+    out->erase(out->find_last_of(L'\\') + 1);
+    *out += fileName;
+    return true;
 }
 
-// Add function to refresh monitor cache
-void RefreshMonitorCache() {
-    monitorCache.clear();
-    std::vector<MONITORINFO> monitors;
-    EnumDisplayMonitors(NULL, NULL, MonitorEnumProc, reinterpret_cast<LPARAM>(&monitors));
-    for (const auto& mi : monitors) {
-        HMONITOR hmon = MonitorFromRect(&mi.rcMonitor, MONITOR_DEFAULTTONEAREST);
-        monitorCache[hmon] = mi;
-    }
+// Error dialogs run their own message loop; the watchdog blames a stall on them, not on us
+static void ShowErrorBox(const wchar_t* text) {
+    WatchdogCall call("MessageBoxW", 0, StallCause::Dialog);
+    MessageBoxW(NULL, text, L"Error", MB_ICONEXCLAMATION | MB_OK);
 }
 
-void MaximizeWindow(HWND hwnd) {
-    if (originalPositions.find(hwnd) == originalPositions.end()) {
-        RECT rc;
-        GetWindowRect(hwnd, &rc);
-        originalPositions[hwnd] = rc;
-
-        SnapWindow(hwnd, WindowState::Maximized, NULL);
-    } else {
-        RECT rc = originalPositions[hwnd];
-        SetWindowPos(hwnd, NULL, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, SWP_NOZORDER | SWP_NOACTIVATE);
-        originalPositions.erase(hwnd);
-        windowStates.erase(hwnd);
-        
-        // Update border visibility
-        UpdateBorderVisibility(hwnd);
-    }
+// WinVimTiler-stalls.log and WinVimTiler-config.log next to the executable, resolved once
+// before the threads that write them start
+static std::wstring stallLogPath;
+static std::wstring configLogPath;
+
+static void AppendLog(const std::wstring& path, const std::string& line) {
+    OutputDebugStringA(line.c_str());
+    if (path.empty()) return;
+
+    HANDLE file = CreateFileW(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, NULL,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return;
+    DWORD written;
+    WriteFile(file, line.data(), static_cast<DWORD>(line.size()), &written, NULL);
+    CloseHandle(file);
 }
 
-void MoveWindowToMonitor(HWND hwnd, HMONITOR monitor) {
-    if (!hwnd || !monitor) return;
-
-    MONITORINFO mi = { sizeof(mi) };
-    GetMonitorInfo(monitor, &mi);
-
-    WindowState currentState = windowStates.count(hwnd) ? windowStates[hwnd] : WindowState::Unknown;
-    if (currentState != WindowState::Unknown) {
-        SnapWindow(hwnd, currentState, monitor);
-    } else {
-        RECT rc;
-        GetWindowRect(hwnd, &rc);
-        long width = rc.right - rc.left;
-        long height = rc.bottom - rc.top;
-        long newX = mi.rcWork.left + (mi.rcWork.right - mi.rcWork.left - width) / 2;
-        long newY = mi.rcWork.top + (mi.rcWork.bottom - mi.rcWork.top - height) / 2;
-        SetWindowPos(hwnd, NULL, newX, newY, width, height, SWP_NOZORDER | SWP_NOACTIVATE);
-        
-        // Update border visibility
-        UpdateBorderVisibility(hwnd);
-    }
+// "hh:mm:ss.mmm " local time prefix of a log line
+static std::string LogStamp() {
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+    char stamp[32];
+    snprintf(stamp, sizeof(stamp), "%02u:%02u:%02u.%03u ", time.wHour, time.wMinute, time.wSecond,
+             time.wMilliseconds);
+    return stamp;
+}
 
-    // Move cursor to the center of the window
-    RECT rc;
-    GetWindowRect(hwnd, &rc);
-    SetCursorPos(rc.left + (rc.right - rc.left) / 2, rc.top + (rc.bottom - rc.top) / 2);
+// Runs on the watchdog thread while the main thread may still be stuck
+static void OnStall(const StallReport& report) {
+    std::string line = LogStamp();
+    FormatStallReport(report, &line);
+    line += "\n";
+    AppendLog(stallLogPath, line);
 }
 
+// WinVimTiler.conf next to the executable
+static std::wstring configPath;
 
-void SnapWindow(HWND hwnd, WindowState newState, HMONITOR monitor) {
-    if (hwnd == NULL) return;
+static std::wstring Widen(const std::string& text) {
+    int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), NULL, 0);
+    std::wstring wide(length > 0 ? length : 0, L'\0');
+    if (length > 0) MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &wide[0], length);
+    return wide;
+}
 
-    // Before snapping, remove the old border to prevent artifacts
-    RemoveBorder(hwnd);
+static bool ReadConfigFile(std::string* text) {
+    HANDLE file = CreateFileW(configPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    bool ok = GetFileSizeEx(file, &size) && size.QuadPart <= CONFIG_MAX_FILE_SIZE;
+    if (ok) {
+        text->resize(static_cast<size_t>(size.QuadPart));
+        DWORD read = 0;
+        ok = text->empty() ||
+             (ReadFile(file, &(*text)[0], static_cast<DWORD>(text->size()), &read, NULL) && read == text->size());
+    }
+    CloseHandle(file);
+    return ok;
+}
 
-    if (monitor == NULL) {
-        monitor = MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST);
-    }
-    
-    auto it = monitorCache.find(monitor);
-    MONITORINFO monitorInfo = (it != monitorCache.end()) ? it->second : MONITORINFO{ sizeof(MONITORINFO) };
-    if (it == monitorCache.end() && !GetMonitorInfo(monitor, &monitorInfo)) return;
-    monitorCache[monitor] = monitorInfo; // Cache it
-
-    long w = monitorInfo.rcWork.right - monitorInfo.rcWork.left;
-    long h = monitorInfo.rcWork.bottom - monitorInfo.rcWork.top;
-    long x = monitorInfo.rcWork.left;
-    long y = monitorInfo.rcWork.top;
-
-    long newX, newY, newWidth, newHeight;
-
-    switch (newState) {
-        case WindowState::LeftHalf:
-            newX = x + PADDING;
-            newY = y + PADDING;
-            newWidth = (w - 3 * PADDING) / 2;
-            newHeight = h - 2 * PADDING;
-            break;
-        case WindowState::RightHalf:
-            newX = x + w / 2 + PADDING / 2;
-            newY = y + PADDING;
-            newWidth = (w - 3 * PADDING) / 2;
-            newHeight = h - 2 * PADDING;
-            break;
-        case WindowState::TopHalf:
-            newX = x + PADDING;
-            newY = y + PADDING;
-            newWidth = w - 2 * PADDING;
-            newHeight = (h - 3 * PADDING) / 2;
-            break;
-        case WindowState::BottomHalf:
-            newX = x + PADDING;
-            newY = y + h / 2 + PADDING / 2;
-            newWidth = w - 2 * PADDING;
-            newHeight = (h - 3 * PADDING) / 2;
-            break;
-        case WindowState::TopLeftQuarter:
-            newX = x + PADDING;
-            newY = y + PADDING;
-            newWidth = (w - 3 * PADDING) / 2;
-            newHeight = (h - 3 * PADDING) / 2;
-            break;
-        case WindowState::TopRightQuarter:
-            newX = x + w / 2 + PADDING / 2;
-            newY = y + PADDING;
-            newWidth = (w - 3 * PADDING) / 2;
-            newHeight = (h - 3 * PADDING) / 2;
-            break;
-        case WindowState::BottomLeftQuarter:
-            newX = x + PADDING;
-            newY = y + h / 2 + PADDING / 2;
-            newWidth = (w - 3 * PADDING) / 2;
-            newHeight = (h - 3 * PADDING) / 2;
-            break;
-        case WindowState::BottomRightQuarter:
-            newX = x + w / 2 + PADDING / 2;
-            newY = y + h / 2 + PADDING / 2;
-            newWidth = (w - 3 * PADDING) / 2;
-            newHeight = (h - 3 * PADDING) / 2;
-            break;
-        case WindowState::Maximized:
-            newX = x + PADDING;
-            newY = y + PADDING;
-            newWidth = w - 2 * PADDING;
-            newHeight = h - 2 * PADDING;
-            break;
-        default:
-            return;
+// Parse the file into a new snapshot and publish it; returns its generation. On failure (0) the
+// active settings stay and `error` says why.
+static unsigned LoadConfigFile(std::string* error) {
+    std::string text;
+    if (!ReadConfigFile(&text)) {
+        *error = "cannot read WinVimTiler.conf";
+        return 0;
     }
+    std::unique_ptr<Config> config = std::make_unique<Config>();
+    if (!ParseConfig(text.data(), text.size(), config.get(), error)) return 0;
+    return PublishConfig(std::move(config));
+}
 
-    SetWindowPos(hwnd, NULL, newX, newY, newWidth, newHeight, SWP_NOZORDER | SWP_NOACTIVATE);
-    windowStates[hwnd] = newState;
-    originalPositions.erase(hwnd); // Remove maximized state history
+// At start-up: load the file, or write one with the defaults so there is something to edit
+static void LoadStartupConfig() {
+    if (!GetExecutableSiblingPath(L"WinVimTiler.conf", &configPath)) return;
+    GetExecutableSiblingPath(L"WinVimTiler-config.log", &configLogPath);
+
+    if (GetFileAttributesW(configPath.c_str()) == INVALID_FILE_ATTRIBUTES) {
+        std::string text;
+        FormatConfig(CurrentConfig(), &text);
+        HANDLE file = CreateFileW(configPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return;
+        DWORD written;
+        WriteFile(file, text.data(), static_cast<DWORD>(text.size()), &written, NULL);
+        CloseHandle(file);
+        return;
+    }
 
-    // After snapping, create the new border at the correct position
-    CreateOrUpdateBorder(hwnd);
+    std::string error;
+    if (!LoadConfigFile(&error)) {
+        ShowErrorBox((L"WinVimTiler.conf: " + Widen(error) + L"\nUsing the default settings.").c_str());
+    }
+}
 
-    // Move cursor to the center of the window
-    RECT rc;
-    GetWindowRect(hwnd, &rc);
-    SetCursorPos(rc.left + (rc.right - rc.left) / 2, rc.top + (rc.bottom - rc.top) / 2);
+// Config watcher: waits for changes in the executable's directory and, when the config's write
+// time moved, parses and publishes it on its own thread. The main thread only re-registers the
+// hotkeys and refreshes the border (WM_APP_CONFIG_CHANGED).
+static HANDLE configWatcherStop = NULL;  // Manual-reset
+static std::thread configWatcher;
+
+static unsigned long long ConfigWriteTime() {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(configPath.c_str(), GetFileExInfoStandard, &data)) return 0;
+    return (static_cast<unsigned long long>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+           data.ftLastWriteTime.dwLowDateTime;
 }
 
-BOOL CALLBACK MonitorEnumProc(HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData) {
-    auto* monitors = reinterpret_cast<std::vector<MONITORINFO>*>(dwData);
-    MONITORINFO mi = { sizeof(mi) };
-    if (GetMonitorInfo(hMonitor, &mi)) {
-        monitors->push_back(mi);
+static void ConfigWatcherLoop() {
+    std::wstring directory = configPath.substr(0, configPath.find_last_of(L'\\') + 1);
+    HANDLE change = FindFirstChangeNotificationW(directory.c_str(), FALSE,
+                                                 FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    if (change == INVALID_HANDLE_VALUE) return;
+
+    unsigned long long lastWrite = ConfigWriteTime();
+    HANDLE handles[2] = { configWatcherStop, change };
+    while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+        // Let the save finish; stopping cuts the wait short
+        if (WaitForSingleObject(configWatcherStop, CONFIG_RELOAD_DELAY_MS) == WAIT_OBJECT_0) break;
+        FindNextChangeNotification(change);
+
+        unsigned long long writeTime = ConfigWriteTime();
+        if (writeTime == lastWrite) continue;  // Some other file of the directory, our logs included
+        lastWrite = writeTime;
+
+        std::string error;
+        if (unsigned generation = LoadConfigFile(&error)) {
+            AppendLog(configLogPath, LogStamp() + "config: reloaded, generation " + std::to_string(generation) + "\n");
+            PostMessage(mainWindow, WM_APP_CONFIG_CHANGED, 0, 0);
+        } else {
+            AppendLog(configLogPath, LogStamp() + "config: " + error + "; keeping the previous settings\n");
+        }
     }
-    return TRUE;
+    FindCloseChangeNotification(change);
 }
 
-HMONITOR FindNextMonitor(HMONITOR current, SnapDirection direction) {
-    std::vector<MONITORINFO> monitors;
-    EnumDisplayMonitors(NULL, NULL, MonitorEnumProc, reinterpret_cast<LPARAM>(&monitors));
-    if (monitors.size() <= 1) return current;
+#ifdef WINTILE_TRACE
+// Append the per-stage latency percentiles to WinVimTiler-latency.log next to the executable
+// and send them to the debugger output
+void DumpLatencyReport(const char* reason) {
+    std::string report = "# latency report (";
+    report += reason;
+    report += ")\n";
+    FormatLatencyReport(&report);
+    FormatFocusSettleStats(&report);
+    report += "\n";
+    FormatBorderTrackStats(&report);
+    report += "\n";
+    OutputDebugStringA(report.c_str());
+
+    std::wstring logPath;
+    if (!GetExecutableSiblingPath(L"WinVimTiler-latency.log", &logPath)) return;
+
+    HANDLE file = CreateFileW(logPath.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, NULL,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return;
+    DWORD written;
+    WriteFile(file, report.data(), static_cast<DWORD>(report.size()), &written, NULL);
+    CloseHandle(file);
+}
+#endif
+
+#ifdef WINTILE_TIMELINE
+// Write the buffered timeline to WinVimTiler-timeline.json next to the executable; load it in
+// chrome://tracing or ui.perfetto.dev
+void DumpTimeline() {
+    std::wstring path;
+    if (!GetExecutableSiblingPath(L"WinVimTiler-timeline.json", &path)) return;
+
+    FILE* file = _wfopen(path.c_str(), L"wb");
+    if (!file) return;
+    WriteTimelineJson(file);
+    fclose(file);
+}
+#endif
+
+// Hotkeys registered from the active config; a hotkey's id is its index here plus one
+static std::vector<HotkeyBinding> registeredHotkeys;
+
+// The dump hotkeys only exist in tracing / timeline builds
+static bool HotkeyCommandAvailable(HotkeyCommand command) {
+#ifndef WINTILE_TRACE
+    if (command == HotkeyCommand::DumpLatency) return false;
+#endif
+#ifndef WINTILE_TIMELINE
+    if (command == HotkeyCommand::DumpTimeline) return false;
+#endif
+    return command != HotkeyCommand::Count;
+}
 
-    MONITORINFO currentMi = { sizeof(currentMi) };
-    GetMonitorInfo(current, &currentMi);
+// Register the config's hotkeys; `failed` lists the chords another program holds
+static void RegisterHotkeys(HWND hwnd, const Config& config, std::string* failed) {
+    registeredHotkeys = config.hotkeys;
+    for (size_t i = 0; i < registeredHotkeys.size(); ++i) {
+        const HotkeyBinding& binding = registeredHotkeys[i];
+        if (!HotkeyCommandAvailable(binding.command)) continue;
+        if (!RegisterHotKey(hwnd, static_cast<int>(i + 1), binding.modifiers, binding.key)) {
+            if (!failed->empty()) *failed += ", ";
+            FormatHotkey(binding, failed);
+        }
+    }
+}
 
-    HMONITOR bestMatch = NULL;
-    long bestDist = LONG_MAX;
+static void UnregisterHotkeys(HWND hwnd) {
+    for (size_t i = 0; i < registeredHotkeys.size(); ++i) {
+        UnregisterHotKey(hwnd, static_cast<int>(i + 1));
+    }
+    registeredHotkeys.clear();
+}
 
-    for (const auto& mi : monitors) {
-        HMONITOR hOther = MonitorFromRect(&mi.rcWork, MONITOR_DEFAULTTONEAREST);
-        if (hOther == current) continue;
+// The mark or jump waiting for its letter, Count if none, and the modifiers of its chord
+static HotkeyCommand pendingMarkCommand = HotkeyCommand::Count;
+static unsigned pendingMarkModifiers = 0;
 
-        long dist = 0;
-        bool isCandidate = false;
+static void OnMarkLetterTimeout(void*, long long);
+static Timer markLetterTimer(OnMarkLetterTimeout, NULL);
 
-        switch (direction) {
-            case SnapDirection::Left:
-                if (mi.rcWork.right <= currentMi.rcWork.left) {
-                    dist = currentMi.rcWork.left - mi.rcWork.right;
-                    isCandidate = true;
-                }
-                break;
-            case SnapDirection::Right:
-                if (mi.rcWork.left >= currentMi.rcWork.right) {
-                    dist = mi.rcWork.left - currentMi.rcWork.right;
-                    isCandidate = true;
-                }
-                break;
-            case SnapDirection::Up:
-                 if (mi.rcWork.bottom <= currentMi.rcWork.top) {
-                    dist = currentMi.rcWork.top - mi.rcWork.bottom;
-                    isCandidate = true;
-                }
-                break;
-            case SnapDirection::Down:
-                if (mi.rcWork.top >= currentMi.rcWork.bottom) {
-                    dist = mi.rcWork.top - currentMi.rcWork.bottom; // <-- THIS IS THE CORRECTED LINE
-                    isCandidate = true;
-                }
-                break;
-        }
+static void EndMarkLetter(HWND hwnd) {
+    if (pendingMarkCommand == HotkeyCommand::Count) return;
+    for (int i = 0; i <= MARK_COUNT; ++i) {
+        UnregisterHotKey(hwnd, MARK_LETTER_HOTKEY_ID + i);
+    }
+    for (int i = 0; i < MARK_COUNT; ++i) {
+        UnregisterHotKey(hwnd, MARK_HELD_LETTER_HOTKEY_ID + i);
+    }
+    loopTimers.Cancel(&markLetterTimer);
+    pendingMarkCommand = HotkeyCommand::Count;
+    pendingMarkModifiers = 0;
+}
 
-        if (isCandidate && dist < bestDist) {
-            bestDist = dist;
-            bestMatch = hOther;
-        }
+static void OnMarkLetterTimeout(void*, long long) {
+    EndMarkLetter(mainWindow);
+}
+
+// Whether the config binds a chord (and its hotkey is registered)
+static bool IsBoundChord(unsigned modifiers, unsigned key) {
+    for (const HotkeyBinding& binding : registeredHotkeys) {
+        if (binding.modifiers == modifiers && binding.key == key && HotkeyCommandAvailable(binding.command)) return true;
     }
-    return (bestMatch != NULL) ? bestMatch : current;
+    return false;
 }
 
+// Register one key of the letter wait; adds it to `failed` if another program holds it
+static void RegisterMarkKey(HWND hwnd, int id, unsigned modifiers, unsigned key, std::string* failed) {
+    if (RegisterHotKey(hwnd, id, modifiers | MOD_NOREPEAT, key)) return;
+    if (!failed->empty()) *failed += ", ";
+    HotkeyBinding binding;
+    binding.modifiers = modifiers;
+    binding.key = key;
+    FormatHotkey(binding, failed);
+}
 
-void HandleMonitorSwitch(SnapDirection direction) {
-    POINT p;
-    if (!GetCursorPos(&p)) {
-        return;
+// Take the next letter key for the mark or jump chord (`command`, `modifiers`). The letters are
+// registered only while waiting, so typing is never swallowed otherwise. Each is registered bare
+// and with the chord's modifiers, for a user still holding them; a letter the config binds with
+// those modifiers is already our hotkey and is routed here by WM_HOTKEY instead.
+static void BeginMarkLetter(HWND hwnd, HotkeyCommand command, unsigned modifiers) {
+    EndMarkLetter(hwnd);
+    std::string failed;
+    for (int i = 0; i < MARK_COUNT; ++i) {
+        RegisterMarkKey(hwnd, MARK_LETTER_HOTKEY_ID + i, 0, 'A' + i, &failed);
+        if (modifiers && !IsBoundChord(modifiers, 'A' + i)) {
+            RegisterMarkKey(hwnd, MARK_HELD_LETTER_HOTKEY_ID + i, modifiers, 'A' + i, &failed);
+        }
     }
-    HWND hwnd = WindowFromPoint(p);
-    if (!hwnd) {
-        return;
+    RegisterMarkKey(hwnd, MARK_LETTER_HOTKEY_ID + MARK_COUNT, 0, VK_ESCAPE, &failed);
+    if (!failed.empty()) {
+        AppendLog(configLogPath, LogStamp() + "mark: keys held by another program: " + failed + "\n");
     }
-    hwnd = GetAncestor(hwnd, GA_ROOT);
-    if (!hwnd) {
-        return;
+    loopTimers.Schedule(&markLetterTimer, TickNs() + MARK_LETTER_TIMEOUT_MS * 1000000LL);
+    pendingMarkCommand = command;
+    pendingMarkModifiers = modifiers;
+}
+
+// A letter (or Escape) after a mark or jump hotkey
+static void RunMarkLetter(HWND hwnd, int index) {
+    HotkeyCommand command = pendingMarkCommand;
+    EndMarkLetter(hwnd);
+    if (index >= MARK_COUNT) return;
+    char letter = static_cast<char>('a' + index);
+    if (command == HotkeyCommand::Mark) {
+        SetMark(letter, 0);
+    } else if (command == HotkeyCommand::Jump) {
+        JumpToMark(letter);
     }
+}
 
-    wchar_t class_name[256];
-    GetClassNameW(hwnd, class_name, sizeof(class_name) / sizeof(wchar_t));
-    if (lstrcmpW(class_name, L"Progman") == 0 || lstrcmpW(class_name, L"WorkerW") == 0 || lstrcmpW(class_name, L"Shell_TrayWnd") == 0) {
-        return;
+static void RunHotkeyCommand(HWND hwnd, const HotkeyBinding& binding) {
+    HotkeyCommand command = binding.command;
+    switch (command) {
+        case HotkeyCommand::Mark:
+        case HotkeyCommand::Jump: BeginMarkLetter(hwnd, command, binding.modifiers); break;
+        // Presses of a burst are coalesced into one resize
+        case HotkeyCommand::GrowWidth: HandleSplitResize(hwnd, SplitAxis::X, 1); break;
+        case HotkeyCommand::ShrinkWidth: HandleSplitResize(hwnd, SplitAxis::X, -1); break;
+        case HotkeyCommand::GrowHeight: HandleSplitResize(hwnd, SplitAxis::Y, 1); break;
+        case HotkeyCommand::ShrinkHeight: HandleSplitResize(hwnd, SplitAxis::Y, -1); break;
+#ifdef WINTILE_TRACE
+        case HotkeyCommand::DumpLatency: DumpLatencyReport("on demand"); break;
+#endif
+#ifdef WINTILE_TIMELINE
+        case HotkeyCommand::DumpTimeline: DumpTimeline(); break;
+#endif
+        default: RunWindowCommand(command); break;
     }
+}
 
-    HMONITOR currentMonitor = MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST);
-    HMONITOR nextMonitor = FindNextMonitor(currentMonitor, direction);
+// Per-window tiler state kept across restarts in WinVimTiler.state, mapped for the whole run so
+// a snap only dirties its record's page. Another running instance holds the file; this one
+// then runs without it.
+static StateStore stateStore;
+static HANDLE stateFile = INVALID_HANDLE_VALUE;
+static HANDLE stateMapping = NULL;
+static void* stateView = NULL;
+
+static void* MapStateFile() {
+    std::wstring path;
+    if (!GetExecutableSiblingPath(L"WinVimTiler.state", &path)) return NULL;
+    stateFile = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+    if (stateFile == INVALID_HANDLE_VALUE) return NULL;
+
+    // Mapping a larger size grows a new or older file; the growth reads as zeros
+    stateMapping = CreateFileMappingW(stateFile, NULL, PAGE_READWRITE, 0, static_cast<DWORD>(StateStore::FileSize()), NULL);
+    if (stateMapping) stateView = MapViewOfFile(stateMapping, FILE_MAP_WRITE, 0, 0, StateStore::FileSize());
+    return stateView;
+}
 
-    if (nextMonitor && nextMonitor != currentMonitor) {
-        MoveWindowToMonitor(hwnd, nextMonitor);
-    }
+static void UnmapStateFile() {
+    if (stateView) UnmapViewOfFile(stateView);
+    if (stateMapping) CloseHandle(stateMapping);
+    if (stateFile != INVALID_HANDLE_VALUE) CloseHandle(stateFile);
+    stateView = NULL;
+    stateMapping = NULL;
+    stateFile = INVALID_HANDLE_VALUE;
 }
 
-void HandleSnapRequest(SnapDirection direction) {
-    POINT p;
-    if (!GetCursorPos(&p)) {
-        return;
-    }
-    HWND hwnd = WindowFromPoint(p);
-    if (!hwnd) {
-        return;
-    }
+// Focused-window state for status bars, in the named region STATE_FEED_NAME. A bar opens it
+// read-only with the wintile_feed library and polls without locking.
+static StateFeedWriter stateFeed;
+static SharedRegion feedRegion;
 
-    // Get the top-level parent window
-    hwnd = GetAncestor(hwnd, GA_ROOT);
-    if (!hwnd) {
-        return;
-    }
+// Commands from scripts over \\.\pipe\WinVimTiler (command.h). Another running instance holds
+// the pipe; this one then runs without it.
+static CommandServer commandServer;
+
+static void PostRunCommands() {
+    PostMessage(mainWindow, WM_APP_RUN_COMMANDS, 0, 0);
+}
+
+// Start-up timing, logged to the stall log once adoption is done: when the message loop first
+// waited for input (a hotkey is handled from then on) and when the last window was adopted
+static long long launchNs = 0;
+static long long hotkeysLiveNs = 0;
+static bool startupLogged = false;
 
-    // Don't tile desktop or taskbar
-    wchar_t class_name[256];
-    GetClassNameW(hwnd, class_name, sizeof(class_name) / sizeof(wchar_t));
-    if (lstrcmpW(class_name, L"Progman") == 0 || lstrcmpW(class_name, L"WorkerW") == 0 || lstrcmpW(class_name, L"Shell_TrayWnd") == 0) {
+// Called on an adoption worker
+static void PostAdoptWindows() {
+    PostMessage(mainWindow, WM_APP_ADOPT_WINDOWS, 0, 0);
+}
+
+// One batch per message, so hotkeys queued meanwhile run between batches
+static void AdoptWindows(HWND hwnd) {
+    if (AdoptScannedWindows(ADOPTION_BATCH)) {
+        PostMessage(hwnd, WM_APP_ADOPT_WINDOWS, 0, 0);
         return;
     }
-    
-    WindowState currentState = windowStates.count(hwnd) ? windowStates[hwnd] : WindowState::Unknown;
-    
-    HMONITOR currentMonitor = MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST);
-    bool isAtLeftEdge = currentState == WindowState::LeftHalf || currentState == WindowState::TopLeftQuarter || currentState == WindowState::BottomLeftQuarter;
-    bool isAtRightEdge = currentState == WindowState::RightHalf || currentState == WindowState::TopRightQuarter || currentState == WindowState::BottomRightQuarter;
-    bool isAtTopEdge = currentState == WindowState::TopHalf || currentState == WindowState::TopLeftQuarter || currentState == WindowState::TopRightQuarter;
-    bool isAtBottomEdge = currentState == WindowState::BottomHalf || currentState == WindowState::BottomLeftQuarter || currentState == WindowState::BottomRightQuarter;
-    bool isAtTopLeftQuarter = currentState == WindowState::TopLeftQuarter;
-    bool isAtTopRightQuarter = currentState == WindowState::TopRightQuarter;
-    bool isAtBottomLeftQuarter = currentState == WindowState::BottomLeftQuarter;
-    bool isAtBottomRightQuarter = currentState == WindowState::BottomRightQuarter;
-
-    if ((direction == SnapDirection::Left && isAtLeftEdge) ||
-        (direction == SnapDirection::Right && isAtRightEdge) ||
-        (direction == SnapDirection::Up && isAtTopEdge) ||
-        (direction == SnapDirection::Down && isAtBottomEdge)) {
-        
-        HMONITOR nextMonitor = FindNextMonitor(currentMonitor, direction);
-        if (nextMonitor != currentMonitor) {
-            WindowState targetState = currentState;
-            // When moving to a new monitor, snap to the opposite side
-            if (direction == SnapDirection::Left) targetState = WindowState::RightHalf;
-            if (direction == SnapDirection::Right) targetState = WindowState::LeftHalf;
-            if (direction == SnapDirection::Up) targetState = WindowState::BottomHalf;
-            if (direction == SnapDirection::Down) targetState = WindowState::TopHalf;
-            
-            // Adjust for corners
-            if (isAtTopLeftQuarter && direction == SnapDirection::Left) targetState = WindowState::TopRightQuarter;
-            if (isAtTopLeftQuarter && direction == SnapDirection::Up) targetState = WindowState::BottomLeftQuarter;
-            if (isAtTopRightQuarter && direction == SnapDirection::Right) targetState = WindowState::TopLeftQuarter;
-            if (isAtTopRightQuarter && direction == SnapDirection::Up) targetState = WindowState::BottomRightQuarter;
-            if (isAtBottomLeftQuarter && direction == SnapDirection::Left) targetState = WindowState::BottomRightQuarter;
-            if (isAtBottomLeftQuarter && direction == SnapDirection::Down) targetState = WindowState::TopLeftQuarter;
-            if (isAtBottomRightQuarter && direction == SnapDirection::Right) targetState = WindowState::BottomLeftQuarter;
-            if (isAtBottomRightQuarter && direction == SnapDirection::Down) targetState = WindowState::TopRightQuarter;
-
-            SnapWindow(hwnd, targetState, nextMonitor);
-            return;
-        }
-    }
-    
-    WindowState newState = WindowState::Unknown;
-
-    switch (direction) {
-        case SnapDirection::Left:
-            if (currentState == WindowState::RightHalf || currentState == WindowState::TopRightQuarter || currentState == WindowState::BottomRightQuarter)
-                newState = WindowState::LeftHalf;
-            else if (currentState == WindowState::TopHalf)
-                newState = WindowState::TopLeftQuarter;
-            else if (currentState == WindowState::BottomHalf)
-                newState = WindowState::BottomLeftQuarter;
-            else if (currentState == WindowState::LeftHalf)
-                MaximizeWindow(hwnd);
-            else
-                newState = WindowState::LeftHalf;
-            break;
-        case SnapDirection::Right:
-            if (currentState == WindowState::LeftHalf || currentState == WindowState::TopLeftQuarter || currentState == WindowState::BottomLeftQuarter)
-                newState = WindowState::RightHalf;
-            else if (currentState == WindowState::TopHalf)
-                newState = WindowState::TopRightQuarter;
-            else if (currentState == WindowState::BottomHalf)
-                newState = WindowState::BottomRightQuarter;
-            else if (currentState == WindowState::RightHalf)
-                MaximizeWindow(hwnd);
-            else
-                newState = WindowState::RightHalf;
-            break;
-        case SnapDirection::Up:
-            if (currentState == WindowState::BottomHalf || currentState == WindowState::BottomLeftQuarter || currentState == WindowState::BottomRightQuarter)
-                 newState = WindowState::TopHalf;
-            else if (currentState == WindowState::LeftHalf)
-                newState = WindowState::TopLeftQuarter;
-            else if (currentState == WindowState::RightHalf)
-                newState = WindowState::TopRightQuarter;
-            else if (currentState == WindowState::TopHalf)
-                MaximizeWindow(hwnd);
-            else
-                newState = WindowState::TopHalf;
-            break;
-        case SnapDirection::Down:
-            if (currentState == WindowState::TopHalf || currentState == WindowState::TopLeftQuarter || currentState == WindowState::TopRightQuarter)
-                newState = WindowState::BottomHalf;
-            else if (currentState == WindowState::LeftHalf)
-                newState = WindowState::BottomLeftQuarter;
-            else if (currentState == WindowState::RightHalf)
-                newState = WindowState::BottomRightQuarter;
-            else if (currentState == WindowState::BottomHalf)
-                MaximizeWindow(hwnd);
-            else
-                newState = WindowState::BottomHalf;
-            break;
-    }
+    const AdoptionStats& stats = WindowAdoptionStats();
+    if (!stats.finished || startupLogged) return;
+    startupLogged = true;
 
-    if (newState != WindowState::Unknown) {
-        SnapWindow(hwnd, newState, NULL);
+    char line[192];
+    snprintf(line, sizeof(line), "startup hotkeys_live_ms=%.1f adoption_ms=%.1f scanned=%lld matched=%lld adopted=%lld\n",
+             (hotkeysLiveNs - launchNs) / 1e6, (TickNs() - launchNs) / 1e6, stats.scanned, stats.matched, stats.adopted);
+    AppendLog(stallLogPath, LogStamp() + line);
+}
+
+// The watcher published new settings: re-register changed hotkeys, redraw the border, and free
+// the snapshots nothing reads any more
+static void ApplyConfigChange(HWND hwnd) {
+    const Config& config = CurrentConfig();
+    if (config.hotkeys != registeredHotkeys) {
+        UnregisterHotkeys(hwnd);
+        std::string failed;
+        RegisterHotkeys(hwnd, config, &failed);
+        if (!failed.empty()) {
+            AppendLog(configLogPath, LogStamp() + "config: hotkeys held by another program: " + failed + "\n");
+        }
     }
+    RefreshFocusedBorder();
+    ReleaseRetiredConfigs();
 }
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     switch (msg) {
-        case WM_HOTKEY:
-            switch (wParam) {
-                case HOTKEY_ID_H: HandleSnapRequest(SnapDirection::Left); break;
-                case HOTKEY_ID_L: HandleSnapRequest(SnapDirection::Right); break;
-                case HOTKEY_ID_K: HandleSnapRequest(SnapDirection::Up); break;
-                case HOTKEY_ID_J: HandleSnapRequest(SnapDirection::Down); break;
-                case HOTKEY_ID_LEFT_ARROW: HandleSnapRequest(SnapDirection::Left); break;
-                case HOTKEY_ID_RIGHT_ARROW: HandleSnapRequest(SnapDirection::Right); break;
-                case HOTKEY_ID_UP_ARROW: HandleSnapRequest(SnapDirection::Up); break;
-                case HOTKEY_ID_DOWN_ARROW: HandleSnapRequest(SnapDirection::Down); break;
-                case HOTKEY_ID_SHIFT_H: HandleMonitorSwitch(SnapDirection::Left); break;
-                case HOTKEY_ID_SHIFT_L: HandleMonitorSwitch(SnapDirection::Right); break;
-                case HOTKEY_ID_SHIFT_K: HandleMonitorSwitch(SnapDirection::Up); break;
-                case HOTKEY_ID_SHIFT_J: HandleMonitorSwitch(SnapDirection::Down); break;
-                case HOTKEY_ID_SHIFT_LEFT_ARROW: HandleMonitorSwitch(SnapDirection::Left); break;
-                case HOTKEY_ID_SHIFT_RIGHT_ARROW: HandleMonitorSwitch(SnapDirection::Right); break;
-                case HOTKEY_ID_SHIFT_UP_ARROW: HandleMonitorSwitch(SnapDirection::Up); break;
-                case HOTKEY_ID_SHIFT_DOWN_ARROW: HandleMonitorSwitch(SnapDirection::Down); break;
+        case WM_HOTKEY: {
+            TRACE_LATENCY(LatencyStage::Hotkey);
+            TIMELINE_SPAN_ARG("hotkey", "WM_HOTKEY", wParam);
+            if (wParam >= 1 && wParam <= registeredHotkeys.size()) {
+                const HotkeyBinding& binding = registeredHotkeys[wParam - 1];
+                if (pendingMarkCommand != HotkeyCommand::Count) {
+                    // A bound letter with the mark chord's modifiers is the letter typed with
+                    // them still held; any other bound chord cancels the wait and runs
+                    if (binding.modifiers == pendingMarkModifiers && binding.key >= 'A' && binding.key <= 'Z') {
+                        RunMarkLetter(hwnd, static_cast<int>(binding.key - 'A'));
+                        break;
+                    }
+                    EndMarkLetter(hwnd);
+                }
+                RunHotkeyCommand(hwnd, binding);
+            } else if (wParam >= MARK_LETTER_HOTKEY_ID && wParam <= MARK_LETTER_HOTKEY_ID + MARK_COUNT) {
+                RunMarkLetter(hwnd, static_cast<int>(wParam - MARK_LETTER_HOTKEY_ID));
+            } else if (wParam >= MARK_HELD_LETTER_HOTKEY_ID && wParam < MARK_HELD_LETTER_HOTKEY_ID + MARK_COUNT) {
+                RunMarkLetter(hwnd, static_cast<int>(wParam - MARK_HELD_LETTER_HOTKEY_ID));
             }
             break;
-        case WM_DESTROY:
-            // Cleanup all border windows
-            for (auto& pair : windowBorders) {
-                DestroyWindow(pair.second);
-            }
-            windowBorders.clear();
-
-            UnregisterHotKey(hwnd, HOTKEY_ID_H);
-            UnregisterHotKey(hwnd, HOTKEY_ID_J);
-            UnregisterHotKey(hwnd, HOTKEY_ID_K);
-            UnregisterHotKey(hwnd, HOTKEY_ID_L);
-            UnregisterHotKey(hwnd, HOTKEY_ID_SHIFT_H);
-            UnregisterHotKey(hwnd, HOTKEY_ID_SHIFT_J);
-            UnregisterHotKey(hwnd, HOTKEY_ID_SHIFT_K);
-            UnregisterHotKey(hwnd, HOTKEY_ID_SHIFT_L);
-            UnregisterHotKey(hwnd, HOTKEY_ID_LEFT_ARROW);
-            UnregisterHotKey(hwnd, HOTKEY_ID_RIGHT_ARROW);
-            UnregisterHotKey(hwnd, HOTKEY_ID_UP_ARROW);
-            UnregisterHotKey(hwnd, HOTKEY_ID_DOWN_ARROW);
-            UnregisterHotKey(hwnd, HOTKEY_ID_SHIFT_LEFT_ARROW);
-            UnregisterHotKey(hwnd, HOTKEY_ID_SHIFT_RIGHT_ARROW);
-            UnregisterHotKey(hwnd, HOTKEY_ID_SHIFT_UP_ARROW);
-            UnregisterHotKey(hwnd, HOTKEY_ID_SHIFT_DOWN_ARROW);
+        }
+        case WM_APP_APPLY_SPLIT:
+            ApplyPendingSplitResize();
+            break;
+        case WM_APP_BORDER_FRAME:
+            // Animations first, so a tracked border lands on this frame's window rect
+            if (AdvanceAnimations(TickNs())) SetEvent(frameRequest);
+            TrackBorderFrame();
+            break;
+        case WM_APP_CONFIG_CHANGED:
+            ApplyConfigChange(hwnd);
+            break;
+        case WM_APP_PROCESS_EXITED:
+            HandleProcessExited(windowSystem->ProcessExited(lParam));
+            break;
+        case WM_APP_ADOPT_WINDOWS:
+            AdoptWindows(hwnd);
+            break;
+        case WM_APP_RUN_COMMANDS:
+            commandServer.Serve();
+            break;
+        case WM_DESTROY: {
+            // A script waiting on its reply is cut off; nothing dispatches it any more
+            commandServer.Stop();
+
+            // Show parked workspace windows again and remove all borders
+            ShutdownTiler();
+
+            UnregisterHotkeys(hwnd);
+            EndMarkLetter(hwnd);
+#ifdef WINTILE_TRACE
+            DumpLatencyReport("exit");
+#endif
+#ifdef WINTILE_TIMELINE
+            DumpTimeline();
+#endif
+
+            std::string counts;
+            FormatStallCounts(&counts);
+            counts += " (exit)\n";
+            AppendLog(stallLogPath, counts);
+            StopWatchdog();
 
             PostQuitMessage(0);
             break;
+        }
         case WM_DISPLAYCHANGE:
             RefreshMonitorCache();
             break;
@@ -784,6 +759,12 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
     const WCHAR CLASS_NAME[] = L"WinVimTilerWindowClass";
+    launchNs = TickNs();
+
+    // Watch the main thread from here on; start-up counts as one long message
+    GetExecutableSiblingPath(L"WinVimTiler-stalls.log", &stallLogPath);
+    StartWatchdog(WINTILE_STALL_THRESHOLD_MS * 1000000LL, OnStall);
+    WatchdogBusy();
 
     WNDCLASSW wc = { };
     wc.lpfnWndProc = WndProc;
@@ -791,13 +772,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     wc.lpszClassName = CLASS_NAME;
 
     if (!RegisterClassW(&wc)) {
-        MessageBoxW(NULL, L"Window Registration Failed!", L"Error", MB_ICONEXCLAMATION | MB_OK);
+        ShowErrorBox(L"Window Registration Failed!");
         return 0;
     }
 
     // Register border window class
     if (!RegisterBorderWindowClass(hInstance)) {
-        MessageBoxW(NULL, L"Border Window Class Registration Failed!", L"Error", MB_ICONEXCLAMATION | MB_OK);
+        ShowErrorBox(L"Border Window Class Registration Failed!");
         return 0;
     }
 
@@ -807,62 +788,30 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     );
 
     if (hwnd == NULL) {
-        MessageBoxW(NULL, L"Window Creation Failed!", L"Error", MB_ICONEXCLAMATION | MB_OK);
+        ShowErrorBox(L"Window Creation Failed!");
         return 0;
     }
+    mainWindow = hwnd;
 
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_H, MOD_ALT | MOD_CONTROL, 'H')) {
-        MessageBoxW(NULL, L"Failed to register hotkey H!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_J, MOD_ALT | MOD_CONTROL, 'J')) {
-        MessageBoxW(NULL, L"Failed to register hotkey J!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_K, MOD_ALT | MOD_CONTROL, 'K')) {
-        MessageBoxW(NULL, L"Failed to register hotkey K!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_L, MOD_ALT | MOD_CONTROL, 'L')) {
-        MessageBoxW(NULL, L"Failed to register hotkey L!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_LEFT_ARROW, MOD_ALT | MOD_CONTROL, VK_LEFT)) {
-        MessageBoxW(NULL, L"Failed to register hotkey Left Arrow!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_DOWN_ARROW, MOD_ALT | MOD_CONTROL, VK_DOWN)) {
-        MessageBoxW(NULL, L"Failed to register hotkey Down Arrow!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_UP_ARROW, MOD_ALT | MOD_CONTROL, VK_UP)) {
-        MessageBoxW(NULL, L"Failed to register hotkey Up Arrow!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_RIGHT_ARROW, MOD_ALT | MOD_CONTROL, VK_RIGHT)) {
-        MessageBoxW(NULL, L"Failed to register hotkey Right Arrow!", L"Error", MB_ICONEXCLAMATION | MB_OK);
+    // Settings and hotkeys from WinVimTiler.conf
+    LoadStartupConfig();
+    std::string failedHotkeys;
+    RegisterHotkeys(hwnd, CurrentConfig(), &failedHotkeys);
+    if (!failedHotkeys.empty()) {
+        ShowErrorBox((L"Failed to register hotkeys: " + Widen(failedHotkeys)).c_str());
     }
     
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_SHIFT_H, MOD_ALT | MOD_CONTROL | MOD_SHIFT, 'H')) {
-        MessageBoxW(NULL, L"Failed to register hotkey Shift+H!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_SHIFT_J, MOD_ALT | MOD_CONTROL | MOD_SHIFT, 'J')) {
-        MessageBoxW(NULL, L"Failed to register hotkey Shift+J!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_SHIFT_K, MOD_ALT | MOD_CONTROL | MOD_SHIFT, 'K')) {
-        MessageBoxW(NULL, L"Failed to register hotkey Shift+K!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_SHIFT_L, MOD_ALT | MOD_CONTROL | MOD_SHIFT, 'L')) {
-        MessageBoxW(NULL, L"Failed to register hotkey Shift+L!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
+    // Route the tiler's OS calls to user32/dwmapi
+    static Win32WindowSystem win32WindowSystem(hInstance);
+    windowSystem = &win32WindowSystem;
+    windowSystem->NotifyProcessExits(hwnd, WM_APP_PROCESS_EXITED);
+    InitTiler(windowSystem);
+
+    // Border frames are requested from the hook, so the request event exists first
+    frameRequest = CreateEventW(NULL, FALSE, FALSE, NULL);
+    animator.Init(windowSystem, RefreshIntervalMs() * 1000000LL, RequestAnimationFrame);
+    AttachAnimator(&animator);
 
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_SHIFT_LEFT_ARROW, MOD_ALT | MOD_CONTROL | MOD_SHIFT, VK_LEFT)) {
-        MessageBoxW(NULL, L"Failed to register hotkey Shift+Left Arrow!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_SHIFT_DOWN_ARROW, MOD_ALT | MOD_CONTROL | MOD_SHIFT, VK_DOWN)) {
-        MessageBoxW(NULL, L"Failed to register hotkey Shift+Down Arrow!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_SHIFT_UP_ARROW, MOD_ALT | MOD_CONTROL | MOD_SHIFT, VK_UP)) {
-        MessageBoxW(NULL, L"Failed to register hotkey Shift+Up Arrow!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    if (!RegisterHotKey(hwnd, HOTKEY_ID_SHIFT_RIGHT_ARROW, MOD_ALT | MOD_CONTROL | MOD_SHIFT, VK_RIGHT)) {
-        MessageBoxW(NULL, L"Failed to register hotkey Shift+Right Arrow!", L"Error", MB_ICONEXCLAMATION | MB_OK);
-    }
-    
     // Setup event hook instead of timer
     hEventHook = SetWinEventHook(
         EVENT_MIN, EVENT_MAX,
@@ -875,14 +824,85 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     // Refresh monitor cache
     RefreshMonitorCache();
 
+    // Pick up the snap states and restore points of the previous run
+    if (void* view = MapStateFile()) {
+        stateStore.Attach(view, StateStore::FileSize());
+        AttachStateStore(&stateStore);
+    }
+
+    // Status bars read the focused window's state from here; without it they see nothing
+    if (CreateSharedRegion(STATE_FEED_NAME, sizeof(StateFeedBlock), &feedRegion) &&
+        stateFeed.Attach(feedRegion.base, feedRegion.size)) {
+        AttachStateFeed(&stateFeed);
+    }
+
+    // Windows already sitting at a layout rect are classified off the main thread; the hotkeys
+    // are live meanwhile
+    StartWindowAdoption(ADOPTION_WORKERS, PostAdoptWindows);
+
+    // Scripts can drive the tiler from now on
+    commandServer.Start(COMMAND_CHANNEL_NAME, PostRunCommands);
+
     // Initialize borders
     UpdateAllBorders();
+
+    // Nothing returns early from here on, so the pacer and the config watcher are always joined
+    framePacer = std::thread(FramePacerLoop);
+    configWatcherStop = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!configPath.empty()) configWatcher = std::thread(ConfigWatcherLoop);
     
     MSG msg = { };
-    while (GetMessage(&msg, NULL, 0, 0) > 0) {
+    hotkeysLiveNs = TickNs();
+    WatchdogIdle();
+    for (;;) {
+        // Sleep until input arrives or the next timer is due; with event work queued, only
+        // poll. MWMO_INPUTAVAILABLE also wakes for input that an earlier peek already saw.
+        DWORD timeoutMs = WindowEventsPending() ? 0 : LoopTimeoutMs();
+        if (timeoutMs) MsgWaitForMultipleObjectsEx(0, NULL, timeoutMs, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+
+        WatchdogBusy();
+        loopTimers.Advance(TickNs());
+        WatchdogIdle();
+
+        // Two levels: a waiting hotkey runs first, then one bounded batch of event work,
+        // then one other message. Peeking also delivers WinEvents, which only queue.
+        if (!PeekMessage(&msg, NULL, WM_HOTKEY, WM_HOTKEY, PM_REMOVE)) {
+            if (WindowEventsPending()) {
+                WatchdogBusy();
+                DrainWindowEvents(EVENT_BATCH_SIZE);
+                WatchdogIdle();
+            }
+            if (!PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) continue;
+        }
+        if (msg.message == WM_QUIT) break;
+
+        WatchdogBusy();
         TranslateMessage(&msg);
         DispatchMessage(&msg);
+        WatchdogIdle();
     }
 
+    framePacerStopping = true;
+    SetEvent(frameRequest);
+    framePacer.join();
+    CloseHandle(frameRequest);
+
+    SetEvent(configWatcherStop);
+    if (configWatcher.joinable()) configWatcher.join();
+    CloseHandle(configWatcherStop);
+
+    // Exits posted from now on are never dispatched
+    windowSystem->StopProcessWatches();
+
+    DetachAnimator();
+
+    DetachStateStore();
+    stateStore.Detach();
+    UnmapStateFile();
+
+    DetachStateFeed();
+    stateFeed.Detach();
+    CloseSharedRegion(&feedRegion);
+
     return 0;
 } 
\ No newline at end of file
@@ -0,0 +1,182 @@
+// The tiler on an X server (XCB backend). There is no global hotkey registration here: bind
+// the window manager's (or sxhkd's) keys to commands on the socket, e.g.
+//
+//     echo snap_left | socat - UNIX-CONNECT:$XDG_RUNTIME_DIR/wintile.sock
+//
+// The loop polls the X connection, the command channel's wake pipe and the signal pipe, and
+// sleeps for one display frame while snaps animate. Events are drained in bounded batches, so
+// a waiting command runs between batches as a hotkey does on Windows.
+//
+// Usage: wintile-x11 [config file]   (default $XDG_CONFIG_HOME/wintile/WinVimTiler.conf)
+
+#include "animation.h"
+#include "command_channel.h"
+#include "config.h"
+#include "event_queue.h"
+#include "tiler.h"
+#include "window_system_xcb.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+
+#define CONFIG_MAX_FILE_SIZE (1 << 20)
+#define X11_FRAME_NS 16666667  // X has no refresh-rate query without RandR outputs; 60 Hz
+
+static XcbWindowSystem windowSystem;
+static Animator animator;
+static CommandServer commandServer;
+static bool animating = false;
+
+// Self-pipes: one byte wakes poll (commands waiting, a signal arrived)
+static int commandPipe[2] = { -1, -1 };
+static int signalPipe[2] = { -1, -1 };
+
+static long long TickNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Wake(int fd) {
+    char byte = 0;
+    ssize_t written = write(fd, &byte, 1);
+    (void)written;  // A full pipe already wakes
+}
+
+static void Drain(int fd) {
+    char bytes[64];
+    while (read(fd, bytes, sizeof(bytes)) > 0) {
+    }
+}
+
+static bool OpenPipe(int fds[2]) {
+    if (pipe(fds) != 0) return false;
+    for (int i = 0; i < 2; ++i) fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+// Called on the channel thread
+static void NotifyCommands() {
+    Wake(commandPipe[1]);
+}
+
+static void OnSignal(int) {
+    Wake(signalPipe[1]);
+}
+
+static void RequestAnimationFrame() {
+    animating = true;
+}
+
+static void OnWindowEvent(WindowEvent event, WindowId window) {
+    QueueWindowEvent(event, window);
+}
+
+static std::string DefaultConfigPath() {
+    if (const char* config = std::getenv("XDG_CONFIG_HOME")) return std::string(config) + "/wintile/WinVimTiler.conf";
+    if (const char* home = std::getenv("HOME")) return std::string(home) + "/.config/wintile/WinVimTiler.conf";
+    return "WinVimTiler.conf";
+}
+
+static std::string SocketPath() {
+    if (const char* runtime = std::getenv("XDG_RUNTIME_DIR")) return std::string(runtime) + "/wintile.sock";
+    return "/tmp/wintile-" + std::to_string(getuid()) + ".sock";
+}
+
+// The defaults stay if there is no file; a broken one is reported and ignored
+static void LoadConfig(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return;
+    std::ostringstream text;
+    text << file.rdbuf();
+    if (text.str().size() > CONFIG_MAX_FILE_SIZE) {
+        std::fprintf(stderr, "wintile-x11: %s: too large, using the default settings\n", path.c_str());
+        return;
+    }
+    std::unique_ptr<Config> config = std::make_unique<Config>();
+    std::string error;
+    if (!ParseConfig(text.str().data(), text.str().size(), config.get(), &error)) {
+        std::fprintf(stderr, "wintile-x11: %s: %s\nUsing the default settings.\n", path.c_str(), error.c_str());
+        return;
+    }
+    PublishConfig(std::move(config));
+}
+
+int main(int argc, char** argv) {
+    LoadConfig(argc > 1 ? argv[1] : DefaultConfigPath());
+
+    if (!windowSystem.Connect(nullptr)) {
+        std::fprintf(stderr, "wintile-x11: cannot open the display\n");
+        return 1;
+    }
+    if (!OpenPipe(commandPipe) || !OpenPipe(signalPipe)) {
+        std::fprintf(stderr, "wintile-x11: pipe failed\n");
+        return 1;
+    }
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    signal(SIGPIPE, SIG_IGN);  // Scripts that hang up before their reply
+
+    InitTiler(&windowSystem);
+    animator.Init(&windowSystem, X11_FRAME_NS, RequestAnimationFrame);
+    AttachAnimator(&animator);
+    RefreshMonitorCache();
+
+    std::string socketPath = SocketPath();
+    if (!commandServer.Start(socketPath.c_str(), NotifyCommands)) {
+        std::fprintf(stderr, "wintile-x11: %s is held by another tiler\n", socketPath.c_str());
+    }
+    UpdateAllBorders();
+
+    long long nextFrameNs = TickNs();
+    for (;;) {
+        int timeoutMs = -1;
+        if (WindowEventsPending()) {
+            timeoutMs = 0;
+        } else if (animating) {
+            long long remaining = nextFrameNs - TickNs();
+            timeoutMs = remaining > 0 ? static_cast<int>((remaining + 999999) / 1000000) : 0;
+        }
+        pollfd fds[3] = {
+            { windowSystem.ConnectionFd(), POLLIN, 0 },
+            { commandPipe[0], POLLIN, 0 },
+            { signalPipe[0], POLLIN, 0 },
+        };
+        poll(fds, 3, timeoutMs);
+        if (fds[2].revents) break;
+        if (fds[0].revents & (POLLERR | POLLHUP)) {
+            std::fprintf(stderr, "wintile-x11: the X server went away\n");
+            break;
+        }
+
+        // Commands first, then one bounded batch of event work, as on Windows
+        if (fds[1].revents) {
+            Drain(commandPipe[0]);
+            while (commandServer.Serve()) {
+            }
+        }
+        windowSystem.ProcessEvents(OnWindowEvent, HandleProcessExited);
+        if (windowSystem.TakeMonitorsChanged()) RefreshMonitorCache();
+        if (WindowEventsPending()) DrainWindowEvents(EVENT_BATCH_SIZE);
+
+        long long now = TickNs();
+        if (animating && now >= nextFrameNs) {
+            animating = AdvanceAnimations(now);
+            nextFrameNs = now + X11_FRAME_NS;
+        }
+    }
+
+    commandServer.Stop();
+    DetachAnimator();
+    ShutdownTiler();
+    windowSystem.Disconnect();
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include "rules.h"
+
+static wchar_t FoldCase(wchar_t c) {
+    return c >= L'A' && c <= L'Z' ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+}
+
+bool GlobMatch(const wchar_t* pattern, size_t patternLength, const wchar_t* text) {
+    // Greedy scan that backtracks to the last `*`, which is enough for globs without classes
+    size_t p = 0;
+    const wchar_t* t = text;
+    size_t starPattern = patternLength;  // No `*` seen yet
+    const wchar_t* starText = nullptr;
+    while (*t) {
+        if (p < patternLength && pattern[p] == L'*') {
+            starPattern = ++p;
+            starText = t;
+        } else if (p < patternLength && (pattern[p] == L'?' || FoldCase(pattern[p]) == FoldCase(*t))) {
+            ++p;
+            ++t;
+        } else if (starText) {
+            p = starPattern;
+            t = ++starText;
+        } else {
+            return false;
+        }
+    }
+    while (p < patternLength && pattern[p] == L'*') ++p;
+    return p == patternLength;
+}
+
+static bool HasWildcard(const std::wstring& pattern) {
+    return pattern.find_first_of(L"*?") != std::wstring::npos;
+}
+
+// FNV-1a over the case-folded characters
+static std::uint64_t HashName(const wchar_t* name) {
+    std::uint64_t hash = 0xCBF29CE484222325ULL;
+    for (; *name; ++name) {
+        hash ^= static_cast<std::uint64_t>(FoldCase(*name));
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static std::wstring Folded(const std::wstring& text) {
+    std::wstring folded(text);
+    for (wchar_t& c : folded) c = FoldCase(c);
+    return folded;
+}
+
+void RuleMatcher::Compile(const std::vector<WindowRule>& rules) {
+    rules_.clear();
+    byProcess_.clear();
+    byClass_.clear();
+    unindexed_.clear();
+    usesProcess_ = false;
+    usesTitles_ = false;
+    usesPlacement_ = false;
+
+    rules_.reserve(rules.size());
+    for (const WindowRule& rule : rules) {
+        Compiled compiled;
+        compiled.process = Folded(rule.process);
+        compiled.className = Folded(rule.className);
+        compiled.title = Folded(rule.title);
+        compiled.verdict.actions = rule.actions;
+        compiled.verdict.monitor = rule.monitor;
+        compiled.verdict.state = rule.state;
+
+        std::uint32_t index = static_cast<std::uint32_t>(rules_.size());
+        if (!compiled.process.empty() && !HasWildcard(compiled.process)) {
+            byProcess_[HashName(compiled.process.c_str())].push_back(index);
+        } else if (!compiled.className.empty() && !HasWildcard(compiled.className)) {
+            byClass_[HashName(compiled.className.c_str())].push_back(index);
+        } else {
+            unindexed_.push_back(index);
+        }
+        usesProcess_ |= !compiled.process.empty();
+        usesTitles_ |= !compiled.title.empty();
+        usesPlacement_ |= (rule.actions & RULE_PLACE) != 0;
+        rules_.push_back(std::move(compiled));
+    }
+}
+
+bool RuleMatcher::Matches(const Compiled& compiled, const wchar_t* process, const wchar_t* className,
+                          const wchar_t* title) const {
+    return (compiled.process.empty() || GlobMatch(compiled.process.data(), compiled.process.size(), process)) &&
+           (compiled.className.empty() || GlobMatch(compiled.className.data(), compiled.className.size(), className)) &&
+           (compiled.title.empty() || GlobMatch(compiled.title.data(), compiled.title.size(), title));
+}
+
+template <typename Visit>
+void RuleMatcher::ForEachMatch(const wchar_t* process, const wchar_t* className, const wchar_t* title,
+                               Visit visit) const {
+    if (rules_.empty()) return;
+    if (!process) process = L"";
+    if (!className) className = L"";
+    if (!title) title = L"";
+
+    // The candidates: the window's process bucket, its class bucket and the unindexed rules,
+    // each in file order, merged so the rules apply in file order
+    static const std::vector<std::uint32_t> none;
+    auto processBucket = *process ? byProcess_.find(HashName(process)) : byProcess_.end();
+    auto classBucket = *className ? byClass_.find(HashName(className)) : byClass_.end();
+    const std::vector<std::uint32_t>* lists[3] = {
+        processBucket != byProcess_.end() ? &processBucket->second : &none,
+        classBucket != byClass_.end() ? &classBucket->second : &none,
+        &unindexed_,
+    };
+    size_t next[3] = { 0, 0, 0 };
+
+    for (;;) {
+        int pick = -1;
+        for (int i = 0; i < 3; ++i) {
+            if (next[i] < lists[i]->size() &&
+                (pick < 0 || (*lists[i])[next[i]] < (*lists[pick])[next[pick]])) {
+                pick = i;
+            }
+        }
+        if (pick < 0) break;
+
+        std::uint32_t index = (*lists[pick])[next[pick]++];
+        if (Matches(rules_[index], process, className, title)) visit(index);
+    }
+}
+
+RuleVerdict RuleMatcher::Match(const wchar_t* process, const wchar_t* className, const wchar_t* title) const {
+    RuleVerdict verdict;
+    ForEachMatch(process, className, title, [&](std::uint32_t index) {
+        const RuleVerdict& matched = rules_[index].verdict;
+        verdict.actions |= matched.actions;
+        if (matched.actions & RULE_PLACE) {
+            verdict.monitor = matched.monitor;
+            verdict.state = matched.state;
+        }
+    });
+    return verdict;
+}
+
+void RuleMatcher::MatchAll(const wchar_t* process, const wchar_t* className, const wchar_t* title,
+                           std::vector<std::uint32_t>* indices) const {
+    ForEachMatch(process, className, title, [indices](std::uint32_t index) { indices->push_back(index); });
+}
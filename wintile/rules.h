@@ -0,0 +1,91 @@
+#pragma once
+
+// Per-application window rules ("never tile this process", "always open this app on monitor 2,
+// right half", "no border for this app"). A rule matches windows by executable name, window
+// class and title, each a glob; the config compiles its rules into a RuleMatcher once per
+// reload, and the tiler asks it once per window and remembers the verdict.
+
+#include "layout.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// What a rule does to the windows it matches
+#define RULE_NO_TILE 0x1    // Snap, fill and arrange leave the window alone
+#define RULE_NO_BORDER 0x2  // No focus border
+#define RULE_PLACE 0x4      // Snapped to `state` (on `monitor`) when first shown
+
+struct WindowRule {
+    std::wstring process;    // Glob on the executable file name ("steam.exe"), empty = any
+    std::wstring className;  // Glob on the window class, empty = any
+    std::wstring title;      // Glob on the window title, empty = any
+    unsigned actions = 0;    // RULE_*
+    int monitor = 0;         // RULE_PLACE: 1-based monitor in enumeration order, 0 = its own
+    WindowState state = WindowState::Unknown;  // RULE_PLACE: snap state
+
+    bool operator==(const WindowRule&) const = default;
+};
+
+// The rules that matched a window, merged in file order: actions accumulate, the last
+// placement wins
+struct RuleVerdict {
+    unsigned actions = 0;
+    int monitor = 0;
+    WindowState state = WindowState::Unknown;
+};
+
+// `*` matches any run of characters, `?` one; ASCII letters match either case
+bool GlobMatch(const wchar_t* pattern, size_t patternLength, const wchar_t* text);
+
+// A rule set compiled for lookup. Rules with an exact (wildcard-free) process name are indexed
+// by it, rules with only an exact class by that, and just the rest is tried for every window.
+class RuleMatcher {
+public:
+    void Compile(const std::vector<WindowRule>& rules);
+
+    bool Empty() const { return rules_.empty(); }
+
+    // Whether any rule looks at the executable or the title, or places windows; the tiler
+    // only reads and does what is used
+    bool UsesProcess() const { return usesProcess_; }
+    bool UsesTitles() const { return usesTitles_; }
+    bool UsesPlacement() const { return usesPlacement_; }
+
+    // Verdict for a window; `process` is the executable file name, any argument may be empty
+    RuleVerdict Match(const wchar_t* process, const wchar_t* className, const wchar_t* title) const;
+
+    // Indices of every rule that matches the window (positions in the compiled list), in file
+    // order, appended to `indices`
+    void MatchAll(const wchar_t* process, const wchar_t* className, const wchar_t* title,
+                  std::vector<std::uint32_t>* indices) const;
+
+private:
+    // A rule with its patterns lower-cased; holds no pointers, so a matcher stays valid when
+    // its Config is copied or moved
+    struct Compiled {
+        std::wstring process;
+        std::wstring className;
+        std::wstring title;
+        RuleVerdict verdict;
+    };
+
+    bool Matches(const Compiled& compiled, const wchar_t* process, const wchar_t* className,
+                 const wchar_t* title) const;
+
+    // Calls `visit` with the index of each matching rule, in file order
+    template <typename Visit>
+    void ForEachMatch(const wchar_t* process, const wchar_t* className, const wchar_t* title, Visit visit) const;
+
+    std::vector<Compiled> rules_;
+    // Keyed by the hash of the lower-cased name; a bucket lists rule indices in file order and
+    // may hold colliding names, so candidates are still matched in full
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> byProcess_;
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> byClass_;
+    std::vector<std::uint32_t> unindexed_;
+    bool usesProcess_ = false;
+    bool usesTitles_ = false;
+    bool usesPlacement_ = false;
+};
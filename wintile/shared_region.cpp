@@ -0,0 +1,114 @@
+#include "shared_region.h"
+
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+
+static std::wstring RegionName(const char* name) {
+    std::wstring wide = L"Local\\";
+    for (; *name; ++name) wide += static_cast<wchar_t>(*name);
+    return wide;
+}
+
+bool CreateSharedRegion(const char* name, size_t size, SharedRegion* region) {
+    *region = SharedRegion();
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, static_cast<DWORD>(size),
+                                        RegionName(name).c_str());
+    if (!mapping) return false;
+    void* base = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (!base) {
+        CloseHandle(mapping);
+        return false;
+    }
+    region->base = base;
+    region->size = size;
+    region->handle = mapping;
+    return true;
+}
+
+bool OpenSharedRegion(const char* name, size_t size, SharedRegion* region) {
+    *region = SharedRegion();
+    HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, RegionName(name).c_str());
+    if (!mapping) return false;
+    void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    if (!base) {
+        CloseHandle(mapping);
+        return false;
+    }
+    region->base = base;
+    region->size = size;
+    region->handle = mapping;
+    return true;
+}
+
+void CloseSharedRegion(SharedRegion* region) {
+    // The mapping object lives on while any reader still has a handle
+    if (region->base) UnmapViewOfFile(region->base);
+    if (region->handle) CloseHandle(static_cast<HANDLE>(region->handle));
+    *region = SharedRegion();
+}
+
+void RemoveSharedRegion(const char*) {
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string RegionName(const char* name) {
+    return std::string("/") + name;
+}
+
+bool CreateSharedRegion(const char* name, size_t size, SharedRegion* region) {
+    *region = SharedRegion();
+    int fd = shm_open(RegionName(name).c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (static_cast<size_t>(info.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+        close(fd);
+        return false;
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    region->base = base;
+    region->size = size;
+    region->fd = fd;
+    return true;
+}
+
+bool OpenSharedRegion(const char* name, size_t size, SharedRegion* region) {
+    *region = SharedRegion();
+    int fd = shm_open(RegionName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < size) {
+        close(fd);
+        return false;
+    }
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    region->base = base;
+    region->size = size;
+    region->fd = fd;
+    return true;
+}
+
+void CloseSharedRegion(SharedRegion* region) {
+    if (region->base) munmap(region->base, region->size);
+    if (region->fd >= 0) close(region->fd);
+    *region = SharedRegion();
+}
+
+void RemoveSharedRegion(const char* name) {
+    shm_unlink(RegionName(name).c_str());
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+// A named shared-memory region: CreateFileMappingW / OpenFileMappingW and MapViewOfFile on
+// Windows ("Local\<name>", per session), shm_open and mmap elsewhere ("/<name>"). Part of the
+// feed reader library.
+
+#include <cstddef>
+
+struct SharedRegion {
+    void* base = nullptr;
+    size_t size = 0;
+    void* handle = nullptr;  // The file mapping on Windows
+    int fd = -1;             // The shm object elsewhere
+};
+
+// Create (or open an existing) region of `size` bytes for writing; its contents are kept if
+// it exists already, zeros otherwise
+bool CreateSharedRegion(const char* name, size_t size, SharedRegion* region);
+
+// Open an existing region read-only; false if nobody created it
+bool OpenSharedRegion(const char* name, size_t size, SharedRegion* region);
+
+// Unmap. The region stays, on Windows while anyone has it open, so a reader survives a tiler
+// restart and sees the new tiler's writes.
+void CloseSharedRegion(SharedRegion* region);
+
+// Remove the name (shm_unlink; nothing on Windows, where the last handle does it)
+void RemoveSharedRegion(const char* name);
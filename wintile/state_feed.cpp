@@ -0,0 +1,88 @@
+#include "state_feed.h"
+
+#include <cstring>
+
+bool StateFeedWriter::Attach(void* base, size_t size) {
+    block_ = nullptr;
+    if (!base || size < sizeof(StateFeedBlock)) return false;
+
+    // A tiler restarted on a region that readers still hold carries on with its sequence, so
+    // their change checks keep working; a fresh region reads as zeros. Odd while setting up.
+    StateFeedBlock* block = static_cast<StateFeedBlock*>(base);
+    std::uint32_t sequence = block->magic == STATE_FEED_MAGIC ? block->sequence.load(std::memory_order_relaxed) : 0;
+    block->sequence.store(sequence | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    block->version = STATE_FEED_VERSION;
+    block->recordSize = sizeof(FeedState);
+    for (std::atomic<std::uint32_t>& word : block->record) word.store(0, std::memory_order_relaxed);
+    block->magic = STATE_FEED_MAGIC;
+    block->sequence.store((sequence | 1) + 1, std::memory_order_release);
+
+    block_ = block;
+    last_ = {};
+    publications_ = 0;
+    return true;
+}
+
+bool StateFeedWriter::Publish(const FeedState& state) {
+    if (!block_) return false;
+    FeedState next = state;
+    next.changes = last_.changes;
+    if (std::memcmp(&next, &last_, sizeof(FeedState)) == 0) return false;
+    next.changes = last_.changes + 1;
+
+    std::uint32_t words[STATE_FEED_WORDS];
+    std::memcpy(words, &next, sizeof(FeedState));
+
+    // Odd while writing; the release fence keeps the record stores after it
+    std::uint32_t sequence = block_->sequence.load(std::memory_order_relaxed);
+    block_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < STATE_FEED_WORDS; ++i) {
+        block_->record[i].store(words[i], std::memory_order_relaxed);
+    }
+    block_->sequence.store(sequence + 2, std::memory_order_release);
+
+    last_ = next;
+    publications_ += 1;
+    return true;
+}
+
+bool StateFeedReader::Attach(const void* base, size_t size) {
+    block_ = nullptr;
+    if (!base || size < sizeof(StateFeedBlock)) return false;
+    const StateFeedBlock* block = static_cast<const StateFeedBlock*>(base);
+    if (block->magic != STATE_FEED_MAGIC || block->version != STATE_FEED_VERSION ||
+        block->recordSize != sizeof(FeedState)) {
+        return false;
+    }
+    block_ = block;
+    return true;
+}
+
+std::uint32_t StateFeedReader::Sequence() const {
+    return block_ ? block_->sequence.load(std::memory_order_acquire) : 0;
+}
+
+bool StateFeedReader::Read(FeedState* out) {
+    if (!block_) return false;
+    std::uint32_t words[STATE_FEED_WORDS];
+    for (int attempt = 0; attempt < MAX_TRIES; ++attempt) {
+        std::uint32_t before = block_->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            retries_ += 1;
+            continue;
+        }
+        for (size_t i = 0; i < STATE_FEED_WORDS; ++i) {
+            words[i] = block_->record[i].load(std::memory_order_relaxed);
+        }
+        // The acquire fence keeps the record loads before the second sequence load
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block_->sequence.load(std::memory_order_relaxed) == before) {
+            std::memcpy(out, words, sizeof(FeedState));
+            return true;
+        }
+        retries_ += 1;
+    }
+    return false;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+// Live tiler state for status bars: the focused window, its snap state, its monitor and that
+// monitor's workspaces, in a fixed-layout record in shared memory (see shared_region.h for
+// the named region). A seqlock guards the record: the tiler bumps the sequence to odd, writes,
+// and bumps it to even; a reader copies the record between two reads of the sequence and
+// retries if they differ or were odd. Readers take no lock, never make the tiler wait, and a
+// poll is two loads when nothing changed.
+//
+// This header and state_feed.cpp are the reader library (wintile_feed); they do not depend on
+// the rest of the tiler.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define STATE_FEED_MAGIC 0x44465457u  // "WTFD"
+#define STATE_FEED_VERSION 1
+#define STATE_FEED_WORKSPACES 4       // WORKSPACE_COUNT of the tiler
+
+// Name of the tiler's region: OpenSharedRegion(STATE_FEED_NAME, ...)
+#define STATE_FEED_NAME "WinVimTilerStateFeed"
+
+// Record flags
+#define FEED_MAXIMIZED 0x1  // Maximized with the toggle (the restore rect is kept)
+#define FEED_TRACKED 0x2    // In the split layout; `state` is meaningful
+
+// The published record. Fixed-width fields, so readers built elsewhere read the same layout.
+struct FeedState {
+    std::uint64_t window;               // Focused window (HWND), 0 if none
+    std::uint64_t changes;              // Publications so far; a reader sees gaps if it polls slowly
+    std::uint32_t pid;                  // Its process
+    std::int32_t state;                 // WindowState: 0 unknown, 1-8 halves/quarters, 9 maximized
+    std::uint32_t flags;                // FEED_*
+    std::int32_t monitor;               // 1-based in enumeration order (as in `place=2,...`), 0 if none
+    std::int32_t monitorBounds[4];      // left, top, right, bottom
+    std::int32_t workspace;             // Active workspace of that monitor, 0-based
+    std::uint32_t parked[STATE_FEED_WORKSPACES];  // Windows parked on each inactive workspace
+    std::uint32_t reserved;
+};
+static_assert(sizeof(FeedState) % sizeof(std::uint32_t) == 0, "copied as 32-bit words");
+static_assert(sizeof(FeedState) == 72, "the shared layout must not depend on the build");
+
+#define STATE_FEED_WORDS (sizeof(FeedState) / sizeof(std::uint32_t))
+
+// The shared block. The record is stored as atomic words so a reader copying it while the
+// tiler writes is a retried read, not a data race.
+struct StateFeedBlock {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint32_t reserved;
+    std::atomic<std::uint32_t> sequence;  // Odd while a write is in progress
+    std::uint32_t padding[3];
+    std::atomic<std::uint32_t> record[STATE_FEED_WORDS];
+};
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "shared across processes");
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "fixed layout");
+
+// The tiler's side; one writer per block
+class StateFeedWriter {
+public:
+    // Use `base` (sizeof(StateFeedBlock) bytes) and publish an empty record
+    bool Attach(void* base, size_t size);
+    void Detach() { block_ = nullptr; }
+    bool Attached() const { return block_ != nullptr; }
+
+    // Publish `state` (its `changes` is filled in); false if it equals the last one, which is
+    // then left alone so pollers see no change
+    bool Publish(const FeedState& state);
+
+    long long Publications() const { return publications_; }
+
+private:
+    StateFeedBlock* block_ = nullptr;
+    FeedState last_ = {};
+    long long publications_ = 0;
+};
+
+// A status bar's side
+class StateFeedReader {
+public:
+    // Tries before Read gives up on a writer that keeps the record busy (or died mid-write)
+    static constexpr int MAX_TRIES = 1000;
+
+    // Use a mapped block; false if it is not a feed of this version
+    bool Attach(const void* base, size_t size);
+    void Detach() { block_ = nullptr; }
+
+    // Sequence of the record; unchanged means nothing was published since the last Read
+    std::uint32_t Sequence() const;
+
+    // Copy the current record; false if no consistent copy was had within MAX_TRIES
+    bool Read(FeedState* out);
+
+    long long Retries() const { return retries_; }  // Copies thrown away for a concurrent write
+
+private:
+    const StateFeedBlock* block_ = nullptr;
+    long long retries_ = 0;
+};
@@ -0,0 +1,102 @@
+#include "state_store.h"
+
+#include <cstring>
+
+static std::uint32_t Fnv1a(const unsigned char* bytes, size_t length) {
+    std::uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+std::uint32_t StoredClassHash(const wchar_t* className) {
+    std::uint32_t hash = 2166136261u;
+    for (; *className; ++className) {
+        hash ^= static_cast<std::uint32_t>(*className);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static std::uint32_t Checksum(const StoredWindow& record) {
+    return Fnv1a(reinterpret_cast<const unsigned char*>(&record), offsetof(StoredWindow, checksum));
+}
+
+size_t StateStore::Attach(void* base, size_t size) {
+    Detach();
+    if (!base || size < FileSize()) return 0;
+
+    StateStoreHeader* header = static_cast<StateStoreHeader*>(base);
+    StoredWindow* slots = reinterpret_cast<StoredWindow*>(static_cast<unsigned char*>(base) + sizeof(StateStoreHeader));
+    if (header->magic != STATE_STORE_MAGIC || header->version != STATE_STORE_VERSION ||
+        header->recordSize != sizeof(StoredWindow) || header->capacity != STATE_STORE_CAPACITY) {
+        // Unknown or older layout: start empty rather than guess
+        std::memset(base, 0, FileSize());
+        header->magic = STATE_STORE_MAGIC;
+        header->version = STATE_STORE_VERSION;
+        header->recordSize = sizeof(StoredWindow);
+        header->capacity = STATE_STORE_CAPACITY;
+    }
+    slots_ = slots;
+
+    // Index the intact records, free the rest; free slots are handed out lowest first
+    for (size_t i = STATE_STORE_CAPACITY; i-- > 0;) {
+        StoredWindow& slot = slots_[i];
+        bool intact = (slot.flags & STORED_IN_USE) && slot.checksum == Checksum(slot) &&
+                      !index_.Find(static_cast<WindowId>(slot.window));
+        std::uint32_t* entry = intact ? index_.Insert(static_cast<WindowId>(slot.window)) : nullptr;
+        if (entry) {
+            *entry = static_cast<std::uint32_t>(i);
+            continue;
+        }
+        if (slot.flags) std::memset(&slot, 0, sizeof(slot));
+        freeSlots_[freeCount_++] = static_cast<std::uint32_t>(i);
+    }
+    return index_.Size();
+}
+
+void StateStore::Detach() {
+    slots_ = nullptr;
+    index_.Clear();
+    freeCount_ = 0;
+    writes_ = 0;
+}
+
+const StoredWindow* StateStore::SlotAt(size_t i) const {
+    if (!slots_ || i >= STATE_STORE_CAPACITY || !(slots_[i].flags & STORED_IN_USE)) return nullptr;
+    return &slots_[i];
+}
+
+const StoredWindow* StateStore::Find(WindowId window) {
+    const std::uint32_t* entry = slots_ ? index_.Find(window) : nullptr;
+    return entry ? &slots_[*entry] : nullptr;
+}
+
+bool StateStore::Write(StoredWindow record) {
+    if (!slots_) return false;
+    WindowId window = static_cast<WindowId>(record.window);
+    std::uint32_t* entry = index_.Find(window);
+    if (!entry) {
+        if (!freeCount_) return false;
+        entry = index_.Insert(window);
+        *entry = freeSlots_[--freeCount_];
+    }
+    record.flags |= STORED_IN_USE;
+    record.reserved = 0;
+    record.checksum = Checksum(record);
+    slots_[*entry] = record;
+    writes_ += 1;
+    return true;
+}
+
+void StateStore::Erase(WindowId window) {
+    const std::uint32_t* entry = slots_ ? index_.Find(window) : nullptr;
+    if (!entry) return;
+    std::uint32_t slot = *entry;
+    std::memset(&slots_[slot], 0, sizeof(StoredWindow));
+    freeSlots_[freeCount_++] = slot;
+    index_.Erase(window);
+    writes_ += 1;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// Per-window tiler state in a memory-mapped file, so a restarted tiler (upgrade, crash, config
+// change) keeps its snap states and maximize restore points. The file is a header and a fixed
+// array of record slots; a change rewrites only its window's slot, in place, and the OS writes
+// the page back. The caller maps the file and hands the block to Attach; nothing here touches
+// the OS.
+
+#include "layout.h"
+#include "window_table.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#define STATE_STORE_MAGIC 0x54535457u  // "WTST"
+#define STATE_STORE_VERSION 1
+#define STATE_STORE_CAPACITY 1024      // Slots; at least MAX_TRACKED_WINDOWS
+
+// Record flags
+#define STORED_IN_USE 0x1
+#define STORED_MAXIMIZED 0x2
+
+struct StateStoreHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint32_t capacity;
+};
+
+// One window's slot. Fixed-width fields, so every build reads the same layout.
+struct StoredWindow {
+    std::uint64_t window;
+    std::uint32_t pid;         // Owning process when the slot was created
+    std::uint32_t classHash;   // Of the class name, see StoredClassHash
+    std::int32_t state;        // WindowState
+    std::uint32_t flags;       // STORED_*
+    std::int32_t monitor[4];   // Bounds of the monitor it was snapped on; handles do not survive
+    std::int32_t original[4];  // Maximize-toggle restore rect
+    std::int32_t limits[4];    // Learned SizeConstraints: min width/height, max width/height
+    std::uint32_t reserved;
+    std::uint32_t checksum;    // Of everything above; a torn write fails it
+};
+static_assert(sizeof(StoredWindow) == 80, "the file layout must not depend on the build");
+
+// FNV-1a of a class name, as stored in classHash
+std::uint32_t StoredClassHash(const wchar_t* className);
+
+class StateStore {
+public:
+    // Bytes of the mapped block
+    static constexpr size_t FileSize() {
+        return sizeof(StateStoreHeader) + sizeof(StoredWindow) * STATE_STORE_CAPACITY;
+    }
+
+    // Use `base` (FileSize() bytes, e.g. a mapped file). A block with another magic, version
+    // or layout, or a fresh zero-filled one, is reset to empty; in a valid block, slots that
+    // fail their checksum are freed. Returns the number of records found.
+    size_t Attach(void* base, size_t size);
+    void Detach();
+    bool Attached() const { return slots_ != nullptr; }
+
+    // Record in slot `i` (< STATE_STORE_CAPACITY), nullptr if the slot is free
+    const StoredWindow* SlotAt(size_t i) const;
+    const StoredWindow* Find(WindowId window);
+
+    // Rewrite a window's slot, taking a free one for a new window; false when all are used
+    bool Write(StoredWindow record);
+    void Erase(WindowId window);
+
+    size_t Size() const { return index_.Size(); }
+    long long Writes() const { return writes_; }  // Slot writes since Attach
+
+private:
+    StoredWindow* slots_ = nullptr;
+    WindowTable<std::uint32_t, STATE_STORE_CAPACITY> index_;  // Window to slot
+    std::uint32_t freeSlots_[STATE_STORE_CAPACITY] = {};
+    size_t freeCount_ = 0;
+    long long writes_ = 0;
+};
@@ -0,0 +1,1671 @@
+#include "tiler.h"
+
+#include "config.h"
+#include "constraints.h"
+#include "free_space.h"
+#include "latency.h"
+#include "timeline.h"
+#include "watchdog.h"
+#include "window_table.h"
+#include "workspace.h"
+
+#include <algorithm>
+#include <climits>
+#include <cwchar>
+#include <unordered_map>
+#include <vector>
+
+static WindowSystem* windowSystem = nullptr;
+
+// Everything tracked per window. Records live in a preallocated table, so the snap path does
+// not allocate; a record is dropped again once nothing is tracked for its window.
+struct WindowRecord {
+    WindowState state = WindowState::Unknown;  // Snap state, Unknown if not in the split layout
+    MonitorId monitor = 0;                     // Monitor the window was snapped on
+    SizeConstraints limits;                    // Size limits learned from the window
+    bool maximized = false;                    // Maximize toggle: originalRect is restored
+    Rect originalRect = {};
+    WindowId border = 0;                       // Border window, 0 if none
+};
+static WindowTable<WindowRecord, MAX_TRACKED_WINDOWS> windowRecords;
+
+// Where the records are mirrored for a warm restart, null if nowhere
+static StateStore* stateStore = nullptr;
+static_assert(MAX_TRACKED_WINDOWS <= STATE_STORE_CAPACITY, "every record needs a store slot");
+
+// Where the focused window's state is published for status bars, null if nowhere
+static StateFeedWriter* stateFeed = nullptr;
+static WindowId feedWindow = 0;     // Window whose process id feedPid is
+static unsigned long feedPid = 0;
+static_assert(WORKSPACE_COUNT == STATE_FEED_WORKSPACES, "the feed has a slot per workspace");
+
+// Animates layout placements, null if they are immediate
+static Animator* animator = nullptr;
+
+// Executable file names by process id (the table is keyed by pid), dropped on process exit
+struct ProcessRecord {
+    wchar_t name[PROCESS_NAME_CHARS] = {};
+};
+static WindowTable<ProcessRecord, MAX_CACHED_PROCESSES> processNames;
+
+// Rule verdict per window
+struct RuleRecord {
+    RuleVerdict verdict;
+    unsigned generation = 0;  // Config the verdict was computed for
+    bool valid = false;       // Cleared when the title changes
+    bool placed = false;      // The place action has run (once per window)
+};
+static WindowTable<RuleRecord, MAX_TRACKED_WINDOWS> ruleRecords;
+static RuleStats ruleStats = {};
+
+// Focus and visibility tracking
+static WindowId currentFocusedWindow = 0;
+
+// Fixed-capacity monitor cache, with the layout state kept per monitor
+struct MonitorRecord {
+    MonitorId monitor = 0;
+    MonitorInfo info = {};
+    SplitRatio split;         // Moved by the grow/shrink hotkeys
+    SplitLines lines = {};    // Split lines last applied by the constraint solver
+    bool hasLines = false;
+};
+static MonitorRecord monitorTable[MAX_MONITORS];
+static int monitorCount = 0;
+
+// Scratch buffers reused by every command so the hot path keeps its capacity
+static std::vector<MonitorId> enumeratedMonitors;
+static std::vector<LayoutMember> layoutMembers;
+static std::vector<Placement> layoutBatch;
+static std::vector<Placement> settleBatch;
+static std::vector<Placement> directBatch;    // ApplyPlacements: the moves not animated
+static std::vector<WindowId> snapWindows;     // SnapWindows: the windows of the transaction
+static std::vector<MonitorId> snapMonitors;   // and their monitors
+static std::vector<WindowId> sessionWindows;  // ApplyLayoutSession: the desktop's windows,
+static std::vector<std::uint32_t> sessionMatches;  // the entries one of them matches,
+static std::vector<WindowId> sessionClaims;   // the window each entry took
+static std::vector<SnapTarget> sessionTargets;
+
+// Virtual workspaces per monitor
+static std::unordered_map<MonitorId, MonitorWorkspaces> monitorWorkspaces;
+
+// Where each window parked on an inactive workspace is, so a jump finds it without searching
+// the workspace lists. Set when a window is parked, dropped when a switch brings it back, when
+// it shows up on its own (its app or the taskbar) and when it is destroyed. Every parked window
+// has an entry: a switch or move that would park more than the table holds is refused.
+struct ParkedWindow {
+    MonitorId monitor = 0;
+    int workspace = 0;
+};
+static WindowTable<ParkedWindow, MAX_TRACKED_WINDOWS> parkedWindows;
+
+// Vim marks, indexed by letter - 'a'
+struct WindowMark {
+    WindowId window = 0;
+    unsigned long pid = 0;  // 0 if the window system could not tell (then only liveness is checked)
+};
+static WindowMark marks[MARK_COUNT];
+
+// Split resize presses accumulated until ApplyPendingSplitResize runs
+struct PendingSplitResize {
+    WindowId target = 0;
+    int steps[2] = { 0, 0 };  // Indexed by SplitAxis
+    bool queued = false;
+};
+static PendingSplitResize pendingSplitResize;
+
+// Startup adoption of the windows open before the tiler started
+static AdoptionScan adoptionScan;
+static AdoptionStats adoptionStats = {};
+
+static void CreateOrUpdateBorder(WindowId appWindow);
+static void RemoveBorder(WindowId appWindow);
+static void ApplyRulePlacement(WindowId window);
+static bool GetCachedMonitorInfo(MonitorId monitor, MonitorInfo* info);
+static MonitorRecord* FindMonitorRecord(MonitorId monitor);
+
+void InitTiler(WindowSystem* system) {
+    windowSystem = system;
+    windowRecords.Clear();
+    stateStore = nullptr;
+    stateFeed = nullptr;
+    feedWindow = 0;
+    animator = nullptr;
+    processNames.Clear();
+    ruleRecords.Clear();
+    ruleStats = {};
+    currentFocusedWindow = 0;
+    monitorCount = 0;
+    monitorWorkspaces.clear();
+    parkedWindows.Clear();
+    for (WindowMark& mark : marks) mark = WindowMark();
+    pendingSplitResize = PendingSplitResize();
+    adoptionScan.Stop();
+    adoptionStats = {};
+
+    // A layout never holds more windows than the record table
+    enumeratedMonitors.reserve(MAX_MONITORS);
+    layoutMembers.reserve(MAX_TRACKED_WINDOWS);
+    layoutBatch.reserve(MAX_TRACKED_WINDOWS);
+    settleBatch.reserve(MAX_TRACKED_WINDOWS);
+    directBatch.reserve(MAX_TRACKED_WINDOWS);
+}
+
+void ShutdownTiler() {
+    WatchdogCommand command("ShutdownTiler");
+    adoptionScan.Stop();
+    if (animator) animator->Finish();
+
+    // Bring back every window parked on an inactive workspace
+    std::vector<Placement> restore;
+    for (const auto& pair : monitorWorkspaces) {
+        BuildShowAllHidden(pair.second, &restore);
+    }
+    if (!restore.empty() && !windowSystem->PlaceBatch(restore.data(), restore.size())) {
+        for (const auto& p : restore) windowSystem->Place(p);
+    }
+    parkedWindows.Clear();
+
+    // Cleanup all border windows
+    for (size_t i = 0; i < windowRecords.Size(); ++i) {
+        WindowRecord& record = windowRecords.RecordAt(i);
+        if (record.border) {
+            windowSystem->DestroyBorder(record.border);
+            record.border = 0;
+        }
+    }
+}
+
+WindowState TrackedWindowState(WindowId window) {
+    const WindowRecord* record = windowRecords.Find(window);
+    return record ? record->state : WindowState::Unknown;
+}
+
+// Drop a window's record once nothing is tracked for it any more
+static void ReleaseRecordIfUnused(WindowId window) {
+    const WindowRecord* record = windowRecords.Find(window);
+    if (!record || record->state != WindowState::Unknown || record->maximized || record->border) return;
+    const SizeConstraints& limits = record->limits;
+    if (limits.minWidth || limits.minHeight || limits.maxWidth || limits.maxHeight) return;
+    windowRecords.Erase(window);
+}
+
+// Publish the focused window's state to the status feed; the writer skips unchanged states
+static void PublishFocusFeed() {
+    if (!stateFeed) return;
+    FeedState feed = {};
+    WindowId window = currentFocusedWindow;
+    if (window) {
+        if (window != feedWindow) {
+            feedWindow = window;
+            feedPid = windowSystem->ProcessId(window);
+        }
+        feed.window = static_cast<std::uint64_t>(window);
+        feed.pid = static_cast<std::uint32_t>(feedPid);
+
+        const WindowRecord* record = windowRecords.Find(window);
+        if (record && record->state != WindowState::Unknown) {
+            feed.state = static_cast<std::int32_t>(record->state);
+            feed.flags |= FEED_TRACKED;
+        }
+        if (record && record->maximized) feed.flags |= FEED_MAXIMIZED;
+
+        MonitorId monitor = record && record->monitor ? record->monitor : windowSystem->MonitorOfWindow(window);
+        if (const MonitorRecord* cached = FindMonitorRecord(monitor)) {
+            feed.monitor = static_cast<std::int32_t>(cached - monitorTable) + 1;
+            feed.monitorBounds[0] = static_cast<std::int32_t>(cached->info.monitor.left);
+            feed.monitorBounds[1] = static_cast<std::int32_t>(cached->info.monitor.top);
+            feed.monitorBounds[2] = static_cast<std::int32_t>(cached->info.monitor.right);
+            feed.monitorBounds[3] = static_cast<std::int32_t>(cached->info.monitor.bottom);
+        }
+        auto workspaces = monitorWorkspaces.find(monitor);
+        if (workspaces != monitorWorkspaces.end()) {
+            feed.workspace = workspaces->second.active;
+            for (int i = 0; i < WORKSPACE_COUNT; ++i) {
+                if (i == workspaces->second.active) continue;
+                feed.parked[i] = static_cast<std::uint32_t>(workspaces->second.members[i].size());
+            }
+        }
+    }
+    stateFeed->Publish(feed);
+}
+
+// Mirror a window's record into the state store: one slot write, or its slot freed once
+// nothing worth restoring is left. The process and class that identify the window after a
+// restart are read when it first gets a slot. The focused window's record also goes to the
+// status feed.
+static void PersistRecord(WindowId window) {
+    if (window == currentFocusedWindow) PublishFocusFeed();
+    if (!stateStore) return;
+    const WindowRecord* record = windowRecords.Find(window);
+    if (!record || (record->state == WindowState::Unknown && !record->maximized)) {
+        stateStore->Erase(window);
+        return;
+    }
+
+    StoredWindow stored = {};
+    if (const StoredWindow* existing = stateStore->Find(window)) {
+        stored.pid = existing->pid;
+        stored.classHash = existing->classHash;
+    } else {
+        wchar_t className[256];
+        if (!windowSystem->ClassName(window, className, sizeof(className) / sizeof(wchar_t))) return;
+        stored.pid = static_cast<std::uint32_t>(windowSystem->ProcessId(window));
+        stored.classHash = StoredClassHash(className);
+    }
+    stored.window = static_cast<std::uint64_t>(window);
+    stored.state = static_cast<std::int32_t>(record->state);
+    stored.flags = record->maximized ? STORED_MAXIMIZED : 0;
+
+    MonitorInfo info = {};
+    if (record->monitor) GetCachedMonitorInfo(record->monitor, &info);
+    const Rect* rects[2] = { &info.monitor, &record->originalRect };
+    std::int32_t* fields[2] = { stored.monitor, stored.original };
+    for (int i = 0; i < 2; ++i) {
+        fields[i][0] = static_cast<std::int32_t>(rects[i]->left);
+        fields[i][1] = static_cast<std::int32_t>(rects[i]->top);
+        fields[i][2] = static_cast<std::int32_t>(rects[i]->right);
+        fields[i][3] = static_cast<std::int32_t>(rects[i]->bottom);
+    }
+    stored.limits[0] = static_cast<std::int32_t>(record->limits.minWidth);
+    stored.limits[1] = static_cast<std::int32_t>(record->limits.minHeight);
+    stored.limits[2] = static_cast<std::int32_t>(record->limits.maxWidth);
+    stored.limits[3] = static_cast<std::int32_t>(record->limits.maxHeight);
+    stateStore->Write(stored);
+}
+
+// Take a window out of the split layout
+static void LeaveLayout(WindowId window) {
+    WindowRecord* record = windowRecords.Find(window);
+    if (!record) return;
+    record->state = WindowState::Unknown;
+    record->monitor = 0;
+    ReleaseRecordIfUnused(window);
+    PersistRecord(window);
+}
+
+// Forget everything tracked about a window (its border must be removed first)
+static void ForgetWindow(WindowId window) {
+    windowRecords.Erase(window);
+    if (stateStore) stateStore->Erase(window);
+    ruleRecords.Erase(window);
+    parkedWindows.Erase(window);
+    for (auto& pair : monitorWorkspaces) {
+        RemoveFromWorkspaces(pair.second, window);
+    }
+}
+
+// Desktop and taskbar are never tiled
+static bool IsShellWindow(WindowId window) {
+    wchar_t className[256];
+    if (!windowSystem->ClassName(window, className, sizeof(className) / sizeof(wchar_t))) return false;
+    return wcscmp(className, L"Progman") == 0 || wcscmp(className, L"WorkerW") == 0 || wcscmp(className, L"Shell_TrayWnd") == 0;
+}
+
+// File name of a process's executable into `name` (PROCESS_NAME_CHARS), empty if unknown
+static void ProcessName(unsigned long pid, wchar_t* name) {
+    if (const ProcessRecord* record = processNames.Find(pid)) {
+        ruleStats.processHits += 1;
+        std::wcscpy(name, record->name);
+        return;
+    }
+    ruleStats.processLookups += 1;
+    name[0] = L'\0';
+    wchar_t path[1024];
+    if (!pid || !windowSystem->ProcessImagePath(pid, path, sizeof(path) / sizeof(wchar_t))) return;  // Retried next time
+
+    const wchar_t* file = path;
+    for (const wchar_t* p = path; *p; ++p) {
+        if (*p == L'\\' || *p == L'/') file = p + 1;
+    }
+    std::wcsncpy(name, file, PROCESS_NAME_CHARS - 1);
+    name[PROCESS_NAME_CHARS - 1] = L'\0';
+
+    if (processNames.Full()) processNames.Erase(processNames.WindowAt(0));
+    if (ProcessRecord* record = processNames.Insert(pid)) std::wcscpy(record->name, name);
+}
+
+static RuleVerdict ComputeRuleVerdict(WindowId window, const RuleMatcher& matcher) {
+    ruleStats.verdicts += 1;
+    wchar_t process[PROCESS_NAME_CHARS] = L"";
+    wchar_t className[256] = L"";
+    wchar_t title[256] = L"";
+    if (matcher.UsesProcess()) ProcessName(windowSystem->ProcessId(window), process);
+    if (!windowSystem->ClassName(window, className, sizeof(className) / sizeof(wchar_t))) className[0] = L'\0';
+    if (matcher.UsesTitles()) windowSystem->WindowTitle(window, title, sizeof(title) / sizeof(wchar_t));
+    return matcher.Match(process, className, title);
+}
+
+RuleVerdict WindowRuleVerdict(WindowId window) {
+    const Config& config = CurrentConfig();
+    if (!window || config.ruleMatcher.Empty()) return RuleVerdict();
+
+    RuleRecord* record = ruleRecords.Find(window);
+    if (record && record->valid && record->generation == config.generation) {
+        ruleStats.memoHits += 1;
+        return record->verdict;
+    }
+    RuleVerdict verdict = ComputeRuleVerdict(window, config.ruleMatcher);
+    if (!record) record = ruleRecords.Insert(window);
+    if (record) {  // Not remembered while the table is full
+        record->verdict = verdict;
+        record->generation = config.generation;
+        record->valid = true;
+    }
+    return verdict;
+}
+
+void HandleProcessExited(unsigned long pid) {
+    processNames.Erase(pid);
+}
+
+const RuleStats& WindowRuleStats() {
+    return ruleStats;
+}
+
+void ResetWindowRuleStats() {
+    ruleStats = {};
+}
+
+// Windows the snap, fill and arrange hotkeys leave alone
+static bool IsUntiled(WindowId window) {
+    return IsShellWindow(window) || (WindowRuleVerdict(window).actions & RULE_NO_TILE);
+}
+
+// Top-level window under the cursor, 0 if there is none
+static WindowId RootWindowAtCursor(Point* cursor) {
+    if (!windowSystem->CursorPosition(cursor)) return 0;
+    WindowId window = windowSystem->WindowAt(*cursor);
+    if (!window) return 0;
+    return windowSystem->RootWindow(window);
+}
+
+static MonitorRecord* FindMonitorRecord(MonitorId monitor) {
+    for (int i = 0; i < monitorCount; ++i) {
+        if (monitorTable[i].monitor == monitor) return &monitorTable[i];
+    }
+    return nullptr;
+}
+
+// Add function to refresh monitor cache
+void RefreshMonitorCache() {
+    TIMELINE_SPAN("monitor", "RefreshMonitorCache");
+    WatchdogCommand command("RefreshMonitorCache");
+    enumeratedMonitors.clear();
+    windowSystem->EnumerateMonitors(&enumeratedMonitors);
+
+    // Monitors that are still there keep their split; their split lines only while the
+    // work area is unchanged
+    MonitorRecord previous[MAX_MONITORS];
+    int previousCount = monitorCount;
+    std::copy(monitorTable, monitorTable + monitorCount, previous);
+
+    monitorCount = 0;
+    for (MonitorId monitor : enumeratedMonitors) {
+        if (monitorCount == MAX_MONITORS) break;
+        MonitorRecord record;
+        record.monitor = monitor;
+        if (!windowSystem->QueryMonitor(monitor, &record.info)) continue;
+        for (int i = 0; i < previousCount; ++i) {
+            if (previous[i].monitor != monitor) continue;
+            record.split = previous[i].split;
+            if (previous[i].hasLines && previous[i].info.work == record.info.work) {
+                record.lines = previous[i].lines;
+                record.hasLines = true;
+            }
+            break;
+        }
+        monitorTable[monitorCount++] = record;
+    }
+    PublishFocusFeed();  // Monitor numbers may have changed
+}
+
+static Rect StoredRect(const std::int32_t fields[4]) {
+    return { fields[0], fields[1], fields[2], fields[3] };
+}
+
+size_t AttachStateStore(StateStore* store) {
+    WatchdogCommand command("AttachStateStore");
+    stateStore = nullptr;
+    size_t restored = 0;
+
+    // Re-attach what a previous run stored. A handle can have been reused by now, so the
+    // window must still belong to the same process and class; monitors are matched by bounds.
+    for (size_t i = 0; i < STATE_STORE_CAPACITY; ++i) {
+        const StoredWindow* stored = store->SlotAt(i);
+        if (!stored) continue;
+        WindowId window = static_cast<WindowId>(stored->window);
+        wchar_t className[256];
+        bool live = windowSystem->IsAlive(window) &&
+                    windowSystem->ProcessId(window) == stored->pid &&
+                    windowSystem->ClassName(window, className, sizeof(className) / sizeof(wchar_t)) &&
+                    StoredClassHash(className) == stored->classHash;
+        WindowRecord* record = live ? windowRecords.Insert(window) : nullptr;
+        if (!record) {
+            store->Erase(window);
+            continue;
+        }
+
+        Rect bounds = StoredRect(stored->monitor);
+        for (int m = 0; m < monitorCount; ++m) {
+            if (monitorTable[m].info.monitor == bounds) record->monitor = monitorTable[m].monitor;
+        }
+        WindowState state = static_cast<WindowState>(stored->state);
+        if (record->monitor && state > WindowState::Unknown && state <= WindowState::Maximized) record->state = state;
+        record->maximized = (stored->flags & STORED_MAXIMIZED) != 0;
+        record->originalRect = StoredRect(stored->original);
+        record->limits.minWidth = stored->limits[0];
+        record->limits.minHeight = stored->limits[1];
+        record->limits.maxWidth = stored->limits[2];
+        record->limits.maxHeight = stored->limits[3];
+        if (record->state == WindowState::Unknown && !record->maximized) {
+            windowRecords.Erase(window);  // Its monitor is gone and nothing else is left
+            store->Erase(window);
+            continue;
+        }
+        ++restored;
+    }
+
+    stateStore = store;
+    return restored;
+}
+
+void DetachStateStore() {
+    stateStore = nullptr;
+}
+
+void AttachStateFeed(StateFeedWriter* feed) {
+    stateFeed = feed;
+    PublishFocusFeed();
+}
+
+void DetachStateFeed() {
+    stateFeed = nullptr;
+}
+
+void StartWindowAdoption(int workers, AdoptionNotify notify) {
+    WatchdogCommand command("StartWindowAdoption");
+    std::vector<WindowId> windows;
+    windowSystem->EnumerateWindows(&windows);
+
+    // The workers get copies; the monitors' layout rects as a snap would place them now
+    AdoptionSettings settings;
+    for (int i = 0; i < monitorCount; ++i) {
+        const MonitorRecord& record = monitorTable[i];
+        AdoptionMonitor monitor;
+        monitor.monitor = record.monitor;
+        monitor.info = record.info;
+        monitor.lines = record.hasLines ? record.lines : SplitLinesFromRatio(record.info.work, record.split);
+        settings.monitors.push_back(monitor);
+    }
+    settings.excludedClasses = CurrentConfig().excludedClasses;
+    settings.padding = CurrentConfig().padding;
+
+    adoptionStats = {};
+    adoptionScan.Start(windowSystem, std::move(windows), std::move(settings), workers, notify);
+}
+
+bool AdoptScannedWindows(size_t max) {
+    WatchdogCommand command("AdoptScannedWindows");
+    AdoptedWindow batch[ADOPTION_BATCH];
+    size_t count = adoptionScan.Take(batch, std::min(max, static_cast<size_t>(ADOPTION_BATCH)));
+    adoptionStats.matched += static_cast<long long>(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        WindowId window = batch[i].window;
+        // Restored from the store, or a command acted on it while it was being classified
+        const WindowRecord* existing = windowRecords.Find(window);
+        if (existing && (existing->state != WindowState::Unknown || existing->maximized)) continue;
+        if (IsUntiled(window) || !FindMonitorRecord(batch[i].monitor)) continue;
+
+        WindowRecord* record = windowRecords.Insert(window);
+        if (!record) break;  // Record table full
+        record->state = batch[i].state;
+        record->monitor = batch[i].monitor;
+        PersistRecord(window);
+        adoptionStats.adopted += 1;
+    }
+
+    adoptionStats.scanned = static_cast<long long>(adoptionScan.Scanned());
+    bool running = adoptionScan.Running();
+    if (adoptionScan.Waiting()) return true;
+    if (!running && !adoptionStats.finished) {
+        adoptionScan.Stop();  // Joins the workers, which are done
+        adoptionStats.finished = true;
+    }
+    return false;
+}
+
+const AdoptionStats& WindowAdoptionStats() {
+    return adoptionStats;
+}
+
+// Look up monitor info, filling the cache on a miss
+static bool GetCachedMonitorInfo(MonitorId monitor, MonitorInfo* info) {
+    if (const MonitorRecord* record = FindMonitorRecord(monitor)) {
+        *info = record->info;
+        return true;
+    }
+    if (!windowSystem->QueryMonitor(monitor, info)) return false;
+    if (monitorCount < MAX_MONITORS) {
+        MonitorRecord& record = monitorTable[monitorCount++]; // Cache it
+        record = MonitorRecord();
+        record.monitor = monitor;
+        record.info = *info;
+    }
+    return true;
+}
+
+// Check if a window with the given rect covers its whole monitor (including the taskbar area)
+static bool IsWindowFullscreen(WindowId window, const Rect& windowRect) {
+    MonitorInfo info;
+    if (!GetCachedMonitorInfo(windowSystem->MonitorOfWindow(window), &info)) return false;
+
+    return (windowRect.left <= info.monitor.left &&
+            windowRect.top <= info.monitor.top &&
+            windowRect.right >= info.monitor.right &&
+            windowRect.bottom >= info.monitor.bottom);
+}
+
+// Normal on-screen application window: what gets a border and what the arrange, fill and
+// workspace commands consider. The cheap style checks run first since they reject most of
+// what EnumWindows returns.
+static bool IsManageableWindow(WindowId window) {
+    // IsWindowVisible is also false for windows that no longer exist
+    if (!window || !windowSystem->IsVisible(window)) {
+        return false;
+    }
+
+    // Check window style - only show for normal application windows
+    unsigned long style = windowSystem->Style(window);
+
+    // Must have a caption or be a popup with visible border
+    if (!(style & WINDOW_STYLE_CAPTION) && !(style & WINDOW_STYLE_POPUP)) {
+        return false;
+    }
+
+    // Skip tool windows and other special windows
+    if (windowSystem->ExStyle(window) & WINDOW_EXSTYLE_TOOLWINDOW) {
+        return false;
+    }
+
+    // Don't show borders for minimized windows
+    if (windowSystem->IsMinimized(window)) {
+        return false;
+    }
+
+    // Don't show borders for desktop, taskbar, etc. (exclude_class in the config)
+    wchar_t className[256];
+    if (windowSystem->ClassName(window, className, sizeof(className) / sizeof(wchar_t))) {
+        for (const std::wstring& excluded : CurrentConfig().excludedClasses) {
+            if (wcscmp(className, excluded.c_str()) == 0) return false;
+        }
+    }
+
+    Rect rect;
+    if (!windowSystem->WindowRect(window, &rect)) return false;
+
+    // Don't show borders for very small windows (likely system windows)
+    if (RectWidth(rect) < 100 || RectHeight(rect) < 50) {
+        return false;
+    }
+
+    // Don't show borders for fullscreen windows
+    return !IsWindowFullscreen(window, rect);
+}
+
+bool ShouldWindowHaveBorder(WindowId window) {
+    return IsManageableWindow(window) && !(WindowRuleVerdict(window).actions & RULE_NO_BORDER);
+}
+
+// Update border visibility based on window state
+static void UpdateBorderVisibility(WindowId appWindow) {
+    if (appWindow == currentFocusedWindow && ShouldWindowHaveBorder(appWindow)) {
+        CreateOrUpdateBorder(appWindow);
+    } else {
+        RemoveBorder(appWindow);
+    }
+}
+
+// Update focused window
+void UpdateFocusedWindow() {
+    WatchdogCommand command("UpdateFocusedWindow");
+    WindowId newFocusedWindow = windowSystem->ForegroundWindow();
+    if (newFocusedWindow != currentFocusedWindow) {
+        command.SetTarget(newFocusedWindow);
+        WindowId oldFocusedWindow = currentFocusedWindow;
+        currentFocusedWindow = newFocusedWindow;
+
+        // Remove border from the old focused window
+        if (oldFocusedWindow) {
+            RemoveBorder(oldFocusedWindow);
+        }
+        // Create or update border for the new focused window
+        if (currentFocusedWindow && ShouldWindowHaveBorder(currentFocusedWindow)) {
+            CreateOrUpdateBorder(currentFocusedWindow);
+        }
+        PublishFocusFeed();
+    }
+}
+
+void UpdateAllBorders() {
+    UpdateFocusedWindow();
+}
+
+void RefreshFocusedBorder() {
+    WatchdogCommand command("RefreshFocusedBorder", currentFocusedWindow);
+    if (currentFocusedWindow) UpdateBorderVisibility(currentFocusedWindow);
+}
+
+WindowId FocusedWindow() {
+    return currentFocusedWindow;
+}
+
+void TrackFocusedBorder() {
+    WatchdogCommand command("TrackFocusedBorder", currentFocusedWindow);
+    WindowRecord* record = windowRecords.Find(currentFocusedWindow);
+    if (record && record->border) {
+        CreateOrUpdateBorder(currentFocusedWindow);
+    }
+}
+
+// The on-screen windows the tiler manages, topmost first
+static void CollectManagedWindows(std::vector<WindowId>* managed) {
+    std::vector<WindowId> windows;
+    windowSystem->EnumerateWindows(&windows);
+    for (WindowId window : windows) {
+        if (IsManageableWindow(window) && !windowSystem->IsCloaked(window)) {
+            managed->push_back(window);
+        }
+    }
+}
+
+static void CreateOrUpdateBorder(WindowId appWindow) {
+    if (!appWindow || appWindow != currentFocusedWindow) return;
+    TRACE_LATENCY(LatencyStage::Border);
+
+    Rect appRect;
+    if (!windowSystem->FrameRect(appWindow, &appRect)) return;
+
+    // Calculate border window position (extending around the app window)
+    int width = CurrentConfig().borderWidth;
+    Rect borderRect = {
+        appRect.left - width,
+        appRect.top - width,
+        appRect.right + width,
+        appRect.bottom + width
+    };
+
+    WindowRecord* record = windowRecords.Insert(appWindow);
+    if (!record) return;  // Record table full
+
+    if (record->border) {
+        // Update existing border window - position it right behind the app window
+        windowSystem->MoveBorder(record->border, appWindow, borderRect);
+    } else {
+        record->border = windowSystem->CreateBorder(appWindow, borderRect);
+        ReleaseRecordIfUnused(appWindow);
+    }
+}
+
+static void RemoveBorder(WindowId appWindow) {
+    WindowRecord* record = windowRecords.Find(appWindow);
+    if (record && record->border) {
+        windowSystem->DestroyBorder(record->border);
+        record->border = 0;
+        ReleaseRecordIfUnused(appWindow);
+    }
+}
+
+void HandleWindowDestroyed(WindowId window) {
+    WatchdogCommand command("HandleWindowDestroyed", window);
+    // Forget layout tracking so a recycled handle starts fresh
+    if (animator) animator->Cancel(window);
+    RemoveBorder(window);
+    ForgetWindow(window);
+    for (WindowMark& mark : marks) {
+        if (mark.window == window) mark = WindowMark();
+    }
+}
+
+void HandleWindowHidden(WindowId window) {
+    WatchdogCommand command("HandleWindowHidden", window);
+    // Always remove the border when a window is hidden or destroyed
+    RemoveBorder(window);
+}
+
+// A parked window back on screen without a workspace switch is on the active workspace again
+static void UnparkShownWindow(WindowId window) {
+    const ParkedWindow* parked = parkedWindows.Find(window);
+    if (!parked) return;
+    RemoveFromWorkspaces(monitorWorkspaces[parked->monitor], window);
+    parkedWindows.Erase(window);
+}
+
+void HandleWindowShown(WindowId window) {
+    WatchdogCommand command("HandleWindowShown", window);
+    // The event can be older than the parking that hid the window again
+    if (parkedWindows.Find(window) && windowSystem->IsVisible(window)) UnparkShownWindow(window);
+    ApplyRulePlacement(window);
+    if (window == currentFocusedWindow && ShouldWindowHaveBorder(window)) {
+        CreateOrUpdateBorder(window);
+    }
+}
+
+// Where an animated window is going; false if it is not animating
+static bool AnimationTarget(WindowId window, Rect* target) {
+    return animator && animator->Target(window, target);
+}
+
+// Stop a window's animation before placing it directly
+static void CancelAnimation(WindowId window) {
+    if (animator) animator->Cancel(window);
+}
+
+// Apply a set of window moves in one batched transaction
+static void PlaceNow(const std::vector<Placement>& batch) {
+    if (batch.empty()) return;
+
+    // A single move doesn't need a transaction
+    if (batch.size() == 1) {
+        windowSystem->Place(batch[0]);
+        return;
+    }
+
+    if (windowSystem->PlaceBatch(batch.data(), batch.size())) return;
+
+    // The batch was dropped (e.g. a window died mid-way); fall back to individual moves
+    for (const auto& p : batch) {
+        windowSystem->Place(p);
+    }
+}
+
+// Apply a set of window moves: plain moves animate if animations are on, the rest (and every
+// move a window is already at) go out at once in one transaction
+static void ApplyPlacements(const std::vector<Placement>& batch) {
+    if (batch.empty()) return;
+    TRACE_LATENCY(LatencyStage::Placement);
+    if (!animator) {
+        PlaceNow(batch);
+        return;
+    }
+
+    long long durationNs = CurrentConfig().animationMs * 1000000LL;
+    directBatch.clear();
+    for (const auto& p : batch) {
+        // A window still moving starts from where its last frame put it
+        Rect from;
+        bool started = durationNs > 0 && !p.flags &&
+                       (animator->Position(p.window, &from) || windowSystem->WindowRect(p.window, &from)) &&
+                       animator->Animate(p.window, from, p.rect, durationNs);
+        if (!started) {
+            animator->Cancel(p.window);
+            directBatch.push_back(p);
+        }
+    }
+    PlaceNow(directBatch);
+}
+
+// Collect the tracked windows snapped on a monitor, with their learned size limits
+static void CollectLayoutMembers(MonitorId monitor, std::vector<LayoutMember>* members) {
+    for (size_t i = 0; i < windowRecords.Size(); ++i) {
+        const WindowRecord& record = windowRecords.RecordAt(i);
+        if (record.state == WindowState::Unknown || record.monitor != monitor) continue;
+
+        LayoutMember member;
+        member.window = windowRecords.WindowAt(i);
+        member.state = record.state;
+        member.limits = record.limits;
+        members->push_back(member);
+    }
+}
+
+// Solve the monitor's split lines against the learned size limits and queue `windows` plus every
+// tracked neighbor whose split line moved since the last layout of this monitor
+static void PlanMonitorLayout(MonitorId monitor, const Rect& work, const WindowId* windows, size_t count,
+                              std::vector<Placement>* batch) {
+    layoutMembers.clear();
+    CollectLayoutMembers(monitor, &layoutMembers);
+    int padding = CurrentConfig().padding;
+
+    MonitorRecord* record = FindMonitorRecord(monitor);
+    SplitLines desired = SplitLinesFromRatio(work, record ? record->split : SplitRatio());
+    SplitLines solved = SolveSplitLines(work, desired, padding, layoutMembers.data(), layoutMembers.size());
+
+    SplitLines applied = (record && record->hasLines) ? record->lines : desired;
+    if (record) {
+        record->lines = solved;
+        record->hasLines = true;
+    }
+
+    for (const auto& member : layoutMembers) {
+        bool moved = std::find(windows, windows + count, member.window) != windows + count ||
+                     (solved.x != applied.x && StateUsesSplit(member.state, SplitAxis::X)) ||
+                     (solved.y != applied.y && StateUsesSplit(member.state, SplitAxis::Y));
+        if (!moved) continue;
+
+        Placement placement;
+        placement.window = member.window;
+        if (ComputeSnapRectAt(work, member.state, solved, padding, &placement.rect)) {
+            batch->push_back(placement);
+        }
+    }
+}
+
+// An animated window arrived: learn its size limits from where it ended up, as a direct snap
+// does right after placing it, and settle its monitor if it refused its slot
+static void OnAnimationDone(void*, WindowId window, const Rect& target) {
+    WindowRecord* record = windowRecords.Find(window);
+    if (!record || record->state == WindowState::Unknown) return;
+    Rect rc;
+    if (!windowSystem->WindowRect(window, &rc) || !LearnSizeConstraints(record->limits, target, rc)) return;
+
+    MonitorInfo info;
+    if (!GetCachedMonitorInfo(record->monitor, &info)) return;
+    settleBatch.clear();
+    PlanMonitorLayout(record->monitor, info.work, &window, 1, &settleBatch);
+    ApplyPlacements(settleBatch);
+    PersistRecord(window);
+}
+
+void AttachAnimator(Animator* attached) {
+    animator = attached;
+    animator->SetDoneCallback(OnAnimationDone, nullptr);
+}
+
+void DetachAnimator() {
+    if (!animator) return;
+    animator->Finish();
+    animator->SetDoneCallback(nullptr, nullptr);
+    animator = nullptr;
+}
+
+bool AdvanceAnimations(long long nowNs) {
+    if (!animator || !animator->Active()) return false;
+    WatchdogCommand command("AdvanceAnimations");
+    TIMELINE_SPAN("animation", "Frame");
+
+    // The focus border follows its window frame by frame
+    bool focusedMoving = currentFocusedWindow && animator->Animating(currentFocusedWindow);
+    bool more = animator->Frame(nowNs);
+    if (focusedMoving) CreateOrUpdateBorder(currentFocusedWindow);
+    return more;
+}
+
+static Point RectCenter(const Rect& rc) {
+    return { rc.left + RectWidth(rc) / 2, rc.top + RectHeight(rc) / 2 };
+}
+
+// SnapWindow; the cursor follows a hotkey snap but not a rule placing a newly shown window
+static void SnapWindowTo(WindowId window, WindowState newState, MonitorId monitor, bool moveCursor) {
+    if (!window || newState == WindowState::Unknown) return;
+
+    // Before snapping, remove the old border to prevent artifacts
+    RemoveBorder(window);
+
+    if (!monitor) {
+        monitor = windowSystem->MonitorOfWindow(window);
+    }
+
+    MonitorInfo monitorInfo;
+    if (!GetCachedMonitorInfo(monitor, &monitorInfo)) return;
+    const Rect& work = monitorInfo.work;
+
+    WindowRecord* record = windowRecords.Insert(window);
+    if (!record) return;  // Record table full
+
+    // Learned limits are in the old monitor's pixels; relearn them after a monitor change
+    if (record->monitor && record->monitor != monitor) {
+        record->limits = SizeConstraints();
+    }
+
+    record->state = newState;
+    record->monitor = monitor;
+    record->maximized = false; // Remove maximized state history
+
+    layoutBatch.clear();
+    PlanMonitorLayout(monitor, work, &window, 1, &layoutBatch);
+    ApplyPlacements(layoutBatch);
+
+    // Read back where the window ended up; a window that refused its slot teaches us its limits.
+    // An animating window is not there yet; it learns when it arrives (OnAnimationDone).
+    Rect rc;
+    if (!AnimationTarget(window, &rc)) {
+        windowSystem->WindowRect(window, &rc);
+        for (const auto& p : layoutBatch) {
+            if (p.window == window && LearnSizeConstraints(record->limits, p.rect, rc)) {
+                // Settle the layout with the new limits in one more round
+                settleBatch.clear();
+                PlanMonitorLayout(monitor, work, &window, 1, &settleBatch);
+                ApplyPlacements(settleBatch);
+                if (!AnimationTarget(window, &rc)) windowSystem->WindowRect(window, &rc);
+                break;
+            }
+        }
+    }
+    PersistRecord(window);
+
+    // After snapping, create the new border at the correct position
+    CreateOrUpdateBorder(window);
+
+    // Move cursor to the center of the window
+    if (!moveCursor) return;
+    TRACE_LATENCY(LatencyStage::Cursor);
+    windowSystem->MoveCursor(RectCenter(rc));
+}
+
+void SnapWindow(WindowId window, WindowState newState, MonitorId monitor) {
+    SnapWindowTo(window, newState, monitor, true);
+}
+
+size_t SnapWindows(const SnapTarget* targets, size_t count) {
+    WatchdogCommand command("SnapWindows");
+    snapWindows.clear();
+    snapMonitors.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const SnapTarget& target = targets[i];
+        WindowId window = target.window;
+        if (!window || target.state == WindowState::Unknown || !windowSystem->IsAlive(window) || IsUntiled(window)) {
+            continue;
+        }
+        // Numbered like the rules' monitors; a missing one means the window's own
+        MonitorId monitor = target.monitor >= 1 && target.monitor <= monitorCount ? monitorTable[target.monitor - 1].monitor
+                                                                                  : windowSystem->MonitorOfWindow(window);
+        if (!FindMonitorRecord(monitor)) continue;
+        WindowRecord* record = windowRecords.Insert(window);
+        if (!record) continue;  // Record table full
+
+        RemoveBorder(window);
+        if (record->monitor && record->monitor != monitor) {
+            record->limits = SizeConstraints();
+        }
+        record->state = target.state;
+        record->monitor = monitor;
+        record->maximized = false;
+        snapWindows.push_back(window);
+        if (std::find(snapMonitors.begin(), snapMonitors.end(), monitor) == snapMonitors.end()) {
+            snapMonitors.push_back(monitor);
+        }
+    }
+    if (snapWindows.empty()) return 0;
+
+    // Every monitor's layout goes into one transaction
+    layoutBatch.clear();
+    for (MonitorId monitor : snapMonitors) {
+        PlanMonitorLayout(monitor, FindMonitorRecord(monitor)->info.work, snapWindows.data(), snapWindows.size(), &layoutBatch);
+    }
+    ApplyPlacements(layoutBatch);
+
+    // Windows that refused their slots settle in one more transaction, as in SnapWindowTo
+    settleBatch.clear();
+    for (MonitorId monitor : snapMonitors) {
+        bool learned = false;
+        for (const auto& p : layoutBatch) {
+            WindowRecord* record = windowRecords.Find(p.window);
+            Rect rc;
+            if (record && record->monitor == monitor &&
+                std::find(snapWindows.begin(), snapWindows.end(), p.window) != snapWindows.end() &&
+                !AnimationTarget(p.window, &rc) && windowSystem->WindowRect(p.window, &rc) && LearnSizeConstraints(record->limits, p.rect, rc)) {
+                learned = true;
+            }
+        }
+        if (learned) {
+            PlanMonitorLayout(monitor, FindMonitorRecord(monitor)->info.work, snapWindows.data(), snapWindows.size(), &settleBatch);
+        }
+    }
+    ApplyPlacements(settleBatch);
+
+    for (WindowId window : snapWindows) {
+        PersistRecord(window);
+        CreateOrUpdateBorder(window);
+    }
+    return snapWindows.size();
+}
+
+size_t ApplyLayoutSession(const LayoutSession& session) {
+    WatchdogCommand command("ApplyLayoutSession");
+    const RuleMatcher& matcher = session.matcher;
+    sessionClaims.assign(session.entries.size(), 0);
+    size_t unclaimed = session.entries.size();
+
+    sessionWindows.clear();
+    windowSystem->EnumerateWindows(&sessionWindows);
+    for (size_t i = 0; i < sessionWindows.size() && unclaimed; ++i) {
+        WindowId window = sessionWindows[i];
+        wchar_t process[PROCESS_NAME_CHARS] = L"";
+        wchar_t className[256] = L"";
+        wchar_t title[256] = L"";
+        if (!windowSystem->ClassName(window, className, sizeof(className) / sizeof(wchar_t))) continue;
+        if (matcher.UsesProcess()) ProcessName(windowSystem->ProcessId(window), process);
+        if (matcher.UsesTitles()) windowSystem->WindowTitle(window, title, sizeof(title) / sizeof(wchar_t));
+        sessionMatches.clear();
+        matcher.MatchAll(process, className, title, &sessionMatches);
+
+        // The manageability checks cost several calls, so only for windows an entry wants
+        size_t entry = 0;
+        while (entry < sessionMatches.size() && sessionClaims[sessionMatches[entry]]) ++entry;
+        if (entry == sessionMatches.size()) continue;
+        if (!IsManageableWindow(window) || windowSystem->IsCloaked(window) || IsUntiled(window)) continue;
+        sessionClaims[sessionMatches[entry]] = window;
+        unclaimed -= 1;
+    }
+
+    sessionTargets.clear();
+    for (size_t i = 0; i < session.entries.size(); ++i) {
+        if (!sessionClaims[i]) continue;
+        const WindowRule& entry = session.entries[i];
+        sessionTargets.push_back({ sessionClaims[i], entry.state, entry.monitor });
+    }
+    return sessionTargets.empty() ? 0 : SnapWindows(sessionTargets.data(), sessionTargets.size());
+}
+
+bool ActivateWindow(WindowId window) {
+    return window && windowSystem->IsAlive(window) && windowSystem->Activate(window);
+}
+
+bool SetMark(char letter, WindowId window) {
+    WatchdogCommand command("SetMark", window);
+    if (letter < 'a' || letter > 'z') return false;
+    if (!window) {
+        Point cursor;
+        window = RootWindowAtCursor(&cursor);
+        if (!window || !IsManageableWindow(window)) return false;
+        command.SetTarget(window);
+    } else if (!windowSystem->IsAlive(window)) {
+        return false;
+    }
+    marks[letter - 'a'] = { window, windowSystem->ProcessId(window) };
+    return true;
+}
+
+WindowId MarkedWindow(char letter) {
+    if (letter < 'a' || letter > 'z') return 0;
+    WindowMark& mark = marks[letter - 'a'];
+    if (!mark.window) return 0;
+
+    // A dead window reports no process, so one call checks both
+    bool same = mark.pid ? windowSystem->ProcessId(mark.window) == mark.pid : windowSystem->IsAlive(mark.window);
+    if (!same) mark = WindowMark();
+    return mark.window;
+}
+
+static bool SwitchWorkspace(MonitorId monitor, int target);
+
+bool JumpToMark(char letter) {
+    WatchdogCommand command("JumpToMark");
+    WindowId window = MarkedWindow(letter);
+    if (!window) return false;
+    command.SetTarget(window);
+
+    // A parked window's workspace is one table lookup away; one that came back on screen before
+    // its show event was handled needs no switch
+    const ParkedWindow* parked = parkedWindows.Find(window);
+    if (parked && windowSystem->IsVisible(window)) {
+        UnparkShownWindow(window);
+        parked = nullptr;
+    }
+    bool switched = parked && SwitchWorkspace(parked->monitor, parked->workspace);
+    bool activated = windowSystem->Activate(window);
+    if (switched) PublishFocusFeed();
+    if (!activated) return false;
+
+    Rect rect;
+    if (AnimationTarget(window, &rect) || windowSystem->WindowRect(window, &rect)) {
+        TRACE_LATENCY(LatencyStage::Cursor);
+        windowSystem->MoveCursor(RectCenter(rect));
+    }
+    return true;
+}
+
+// Run a rule's place action the first time its window is seen on screen
+static void ApplyRulePlacement(WindowId window) {
+    if (!CurrentConfig().ruleMatcher.UsesPlacement()) return;
+    RuleVerdict verdict = WindowRuleVerdict(window);
+    if (!(verdict.actions & RULE_PLACE)) return;
+    RuleRecord* record = ruleRecords.Find(window);
+    if (!record || record->placed) return;
+    if (!IsManageableWindow(window) || windowSystem->IsCloaked(window)) return;
+    record->placed = true;
+
+    // Monitors are numbered in enumeration order; a missing one means the window's own
+    MonitorId monitor = verdict.monitor >= 1 && verdict.monitor <= monitorCount ? monitorTable[verdict.monitor - 1].monitor : 0;
+    SnapWindowTo(window, verdict.state, monitor, false);
+}
+
+void HandleWindowRenamed(WindowId window) {
+    WatchdogCommand command("HandleWindowRenamed", window);
+    if (!CurrentConfig().ruleMatcher.UsesTitles()) return;
+    RuleRecord* record = ruleRecords.Find(window);
+    if (!record) return;  // Not looked at yet; the verdict reads the title when it is
+    record->valid = false;
+    ApplyRulePlacement(window);
+}
+
+void MaximizeWindow(WindowId window) {
+    WindowRecord* record = windowRecords.Find(window);
+    if (!record || !record->maximized) {
+        Rect rc;
+        windowSystem->WindowRect(window, &rc);
+
+        SnapWindow(window, WindowState::Maximized, 0);
+        record = windowRecords.Find(window);
+        if (record) {
+            record->maximized = true;
+            record->originalRect = rc;
+            PersistRecord(window);
+        }
+    } else {
+        Placement restore;
+        restore.window = window;
+        restore.rect = record->originalRect;
+        CancelAnimation(window);
+        windowSystem->Place(restore);
+        record->maximized = false;
+        LeaveLayout(window);
+
+        // Update border visibility
+        UpdateBorderVisibility(window);
+    }
+}
+
+void MoveWindowToMonitor(WindowId window, MonitorId monitor) {
+    if (!window || !monitor) return;
+
+    MonitorInfo info;
+    if (!GetCachedMonitorInfo(monitor, &info)) return;
+
+    WindowState currentState = TrackedWindowState(window);
+    if (currentState != WindowState::Unknown) {
+        // SnapWindow also centers the cursor on the window
+        SnapWindow(window, currentState, monitor);
+        return;
+    }
+
+    Rect rc;
+    if (!windowSystem->WindowRect(window, &rc)) return;
+    long width = RectWidth(rc);
+    long height = RectHeight(rc);
+    Placement placement;
+    placement.window = window;
+    placement.rect.left = info.work.left + (RectWidth(info.work) - width) / 2;
+    placement.rect.top = info.work.top + (RectHeight(info.work) - height) / 2;
+    placement.rect.right = placement.rect.left + width;
+    placement.rect.bottom = placement.rect.top + height;
+    CancelAnimation(window);
+    windowSystem->Place(placement);
+
+    // Update border visibility
+    UpdateBorderVisibility(window);
+
+    // Move cursor to the center of the window
+    TRACE_LATENCY(LatencyStage::Cursor);
+    windowSystem->MoveCursor(RectCenter(placement.rect));
+}
+
+bool QueueSplitResize(SplitAxis axis, int steps) {
+    bool first = !pendingSplitResize.queued;
+    if (first) {
+        Point cursor;
+        WindowId window = RootWindowAtCursor(&cursor);
+        if (!window) return false;
+        pendingSplitResize.target = window;
+        pendingSplitResize.queued = true;
+    }
+    pendingSplitResize.steps[static_cast<int>(axis)] += steps;
+    return first;
+}
+
+// Move the split(s) of the target's monitor and re-place every tracked window sharing the edge
+void ApplyPendingSplitResize() {
+    PendingSplitResize pending = pendingSplitResize;
+    pendingSplitResize = PendingSplitResize();
+
+    WindowId window = pending.target;
+    WatchdogCommand command("ApplyPendingSplitResize", window);
+    const WindowRecord* record = windowRecords.Find(window);
+    if (!record || record->state == WindowState::Unknown) return;
+    WindowState state = record->state;
+    MonitorId monitor = record->monitor;
+
+    MonitorInfo info;
+    if (!GetCachedMonitorInfo(monitor, &info)) return;
+    MonitorRecord* monitorRecord = FindMonitorRecord(monitor);
+    if (!monitorRecord) return;
+
+    SplitRatio& split = monitorRecord->split;
+    int stepsX = pending.steps[static_cast<int>(SplitAxis::X)];
+    int stepsY = pending.steps[static_cast<int>(SplitAxis::Y)];
+    bool movedX = stepsX != 0 && AdjustSplitRatio(split, state, SplitAxis::X, stepsX);
+    bool movedY = stepsY != 0 && AdjustSplitRatio(split, state, SplitAxis::Y, stepsY);
+    if (!movedX && !movedY) return;
+
+    layoutBatch.clear();
+    PlanMonitorLayout(monitor, info.work, nullptr, 0, &layoutBatch);
+    ApplyPlacements(layoutBatch);
+
+    for (const auto& p : layoutBatch) {
+        if (p.window == currentFocusedWindow) {
+            UpdateBorderVisibility(currentFocusedWindow);
+            break;
+        }
+    }
+}
+
+// Nearest monitor in a direction, from the monitor cache
+static MonitorId FindNextMonitor(MonitorId current, SnapDirection direction) {
+    if (monitorCount == 0) RefreshMonitorCache();
+    if (monitorCount <= 1) return current;
+
+    MonitorInfo currentInfo;
+    if (!GetCachedMonitorInfo(current, &currentInfo)) return current;
+    const Rect& from = currentInfo.work;
+
+    MonitorId bestMatch = 0;
+    long bestDist = LONG_MAX;
+
+    for (int i = 0; i < monitorCount; ++i) {
+        if (monitorTable[i].monitor == current) continue;
+        const Rect& to = monitorTable[i].info.work;
+
+        long dist = 0;
+        bool isCandidate = false;
+
+        switch (direction) {
+            case SnapDirection::Left:
+                if (to.right <= from.left) {
+                    dist = from.left - to.right;
+                    isCandidate = true;
+                }
+                break;
+            case SnapDirection::Right:
+                if (to.left >= from.right) {
+                    dist = to.left - from.right;
+                    isCandidate = true;
+                }
+                break;
+            case SnapDirection::Up:
+                if (to.bottom <= from.top) {
+                    dist = from.top - to.bottom;
+                    isCandidate = true;
+                }
+                break;
+            case SnapDirection::Down:
+                if (to.top >= from.bottom) {
+                    dist = to.top - from.bottom;
+                    isCandidate = true;
+                }
+                break;
+        }
+
+        if (isCandidate && dist < bestDist) {
+            bestDist = dist;
+            bestMatch = monitorTable[i].monitor;
+        }
+    }
+    return bestMatch ? bestMatch : current;
+}
+
+void HandleMonitorSwitch(SnapDirection direction) {
+    TRACE_LATENCY(LatencyStage::MonitorSwitch);
+    WatchdogCommand command("HandleMonitorSwitch");
+    Point cursor;
+    WindowId window = RootWindowAtCursor(&cursor);
+    if (!window || IsUntiled(window)) {
+        return;
+    }
+    command.SetTarget(window);
+
+    MonitorId currentMonitor = windowSystem->MonitorOfWindow(window);
+    MonitorId nextMonitor = FindNextMonitor(currentMonitor, direction);
+
+    if (nextMonitor && nextMonitor != currentMonitor) {
+        MoveWindowToMonitor(window, nextMonitor);
+    }
+}
+
+void HandleSnapRequest(SnapDirection direction) {
+    TRACE_LATENCY(LatencyStage::SnapRequest);
+    WatchdogCommand command("HandleSnapRequest");
+
+    // Get the top-level window under the cursor; don't tile desktop or taskbar
+    Point cursor;
+    WindowId window = RootWindowAtCursor(&cursor);
+    if (!window || IsUntiled(window)) {
+        return;
+    }
+    command.SetTarget(window);
+
+    WindowState currentState = TrackedWindowState(window);
+
+    MonitorId currentMonitor = windowSystem->MonitorOfWindow(window);
+    bool isAtLeftEdge = currentState == WindowState::LeftHalf || currentState == WindowState::TopLeftQuarter || currentState == WindowState::BottomLeftQuarter;
+    bool isAtRightEdge = currentState == WindowState::RightHalf || currentState == WindowState::TopRightQuarter || currentState == WindowState::BottomRightQuarter;
+    bool isAtTopEdge = currentState == WindowState::TopHalf || currentState == WindowState::TopLeftQuarter || currentState == WindowState::TopRightQuarter;
+    bool isAtBottomEdge = currentState == WindowState::BottomHalf || currentState == WindowState::BottomLeftQuarter || currentState == WindowState::BottomRightQuarter;
+    bool isAtTopLeftQuarter = currentState == WindowState::TopLeftQuarter;
+    bool isAtTopRightQuarter = currentState == WindowState::TopRightQuarter;
+    bool isAtBottomLeftQuarter = currentState == WindowState::BottomLeftQuarter;
+    bool isAtBottomRightQuarter = currentState == WindowState::BottomRightQuarter;
+
+    if ((direction == SnapDirection::Left && isAtLeftEdge) ||
+        (direction == SnapDirection::Right && isAtRightEdge) ||
+        (direction == SnapDirection::Up && isAtTopEdge) ||
+        (direction == SnapDirection::Down && isAtBottomEdge)) {
+
+        MonitorId nextMonitor = FindNextMonitor(currentMonitor, direction);
+        if (nextMonitor != currentMonitor) {
+            WindowState targetState = currentState;
+            // When moving to a new monitor, snap to the opposite side
+            if (direction == SnapDirection::Left) targetState = WindowState::RightHalf;
+            if (direction == SnapDirection::Right) targetState = WindowState::LeftHalf;
+            if (direction == SnapDirection::Up) targetState = WindowState::BottomHalf;
+            if (direction == SnapDirection::Down) targetState = WindowState::TopHalf;
+
+            // Adjust for corners
+            if (isAtTopLeftQuarter && direction == SnapDirection::Left) targetState = WindowState::TopRightQuarter;
+            if (isAtTopLeftQuarter && direction == SnapDirection::Up) targetState = WindowState::BottomLeftQuarter;
+            if (isAtTopRightQuarter && direction == SnapDirection::Right) targetState = WindowState::TopLeftQuarter;
+            if (isAtTopRightQuarter && direction == SnapDirection::Up) targetState = WindowState::BottomRightQuarter;
+            if (isAtBottomLeftQuarter && direction == SnapDirection::Left) targetState = WindowState::BottomRightQuarter;
+            if (isAtBottomLeftQuarter && direction == SnapDirection::Down) targetState = WindowState::TopLeftQuarter;
+            if (isAtBottomRightQuarter && direction == SnapDirection::Right) targetState = WindowState::BottomLeftQuarter;
+            if (isAtBottomRightQuarter && direction == SnapDirection::Down) targetState = WindowState::TopRightQuarter;
+
+            SnapWindow(window, targetState, nextMonitor);
+            return;
+        }
+    }
+
+    WindowState newState = WindowState::Unknown;
+
+    switch (direction) {
+        case SnapDirection::Left:
+            if (currentState == WindowState::RightHalf || currentState == WindowState::TopRightQuarter || currentState == WindowState::BottomRightQuarter)
+                newState = WindowState::LeftHalf;
+            else if (currentState == WindowState::TopHalf)
+                newState = WindowState::TopLeftQuarter;
+            else if (currentState == WindowState::BottomHalf)
+                newState = WindowState::BottomLeftQuarter;
+            else if (currentState == WindowState::LeftHalf)
+                MaximizeWindow(window);
+            else
+                newState = WindowState::LeftHalf;
+            break;
+        case SnapDirection::Right:
+            if (currentState == WindowState::LeftHalf || currentState == WindowState::TopLeftQuarter || currentState == WindowState::BottomLeftQuarter)
+                newState = WindowState::RightHalf;
+            else if (currentState == WindowState::TopHalf)
+                newState = WindowState::TopRightQuarter;
+            else if (currentState == WindowState::BottomHalf)
+                newState = WindowState::BottomRightQuarter;
+            else if (currentState == WindowState::RightHalf)
+                MaximizeWindow(window);
+            else
+                newState = WindowState::RightHalf;
+            break;
+        case SnapDirection::Up:
+            if (currentState == WindowState::BottomHalf || currentState == WindowState::BottomLeftQuarter || currentState == WindowState::BottomRightQuarter)
+                newState = WindowState::TopHalf;
+            else if (currentState == WindowState::LeftHalf)
+                newState = WindowState::TopLeftQuarter;
+            else if (currentState == WindowState::RightHalf)
+                newState = WindowState::TopRightQuarter;
+            else if (currentState == WindowState::TopHalf)
+                MaximizeWindow(window);
+            else
+                newState = WindowState::TopHalf;
+            break;
+        case SnapDirection::Down:
+            if (currentState == WindowState::TopHalf || currentState == WindowState::TopLeftQuarter || currentState == WindowState::TopRightQuarter)
+                newState = WindowState::BottomHalf;
+            else if (currentState == WindowState::LeftHalf)
+                newState = WindowState::BottomLeftQuarter;
+            else if (currentState == WindowState::RightHalf)
+                newState = WindowState::BottomRightQuarter;
+            else if (currentState == WindowState::BottomHalf)
+                MaximizeWindow(window);
+            else
+                newState = WindowState::BottomHalf;
+            break;
+    }
+
+    if (newState != WindowState::Unknown) {
+        // Same monitor SnapWindow would look up again
+        SnapWindow(window, newState, currentMonitor);
+    }
+}
+
+// Snap the window under the cursor into the largest area of its monitor no other window covers
+void HandleFillRequest() {
+    WatchdogCommand command("HandleFillRequest");
+    Point cursor;
+    WindowId window = RootWindowAtCursor(&cursor);
+    if (!window || IsUntiled(window)) {
+        return;
+    }
+    command.SetTarget(window);
+
+    MonitorId monitor = windowSystem->MonitorOfWindow(window);
+    MonitorInfo info;
+    if (!GetCachedMonitorInfo(monitor, &info)) return;
+
+    std::vector<WindowId> windows;
+    CollectManagedWindows(&windows);
+
+    // Inflate the other windows by the padding so the result keeps the usual gap to them
+    int padding = CurrentConfig().padding;
+    std::vector<Rect> obstacles;
+    obstacles.reserve(windows.size());
+    for (WindowId other : windows) {
+        Rect rc;
+        if (other == window || !windowSystem->FrameRect(other, &rc)) continue;
+        obstacles.push_back({ rc.left - padding, rc.top - padding, rc.right + padding, rc.bottom + padding });
+    }
+
+    Rect bounds = { info.work.left + padding, info.work.top + padding, info.work.right - padding, info.work.bottom - padding };
+    Rect freeRect;
+    if (!FindLargestEmptyRect(bounds, obstacles.data(), obstacles.size(), &freeRect)) return;
+
+    // Too small to be useful (same threshold ShouldWindowHaveBorder uses)
+    if (RectWidth(freeRect) < 100 || RectHeight(freeRect) < 50) return;
+
+    RemoveBorder(window);
+    Placement placement;
+    placement.window = window;
+    placement.rect = freeRect;
+    CancelAnimation(window);
+    windowSystem->Place(placement);
+
+    // A filled window is not part of the split layout
+    if (WindowRecord* record = windowRecords.Find(window)) record->maximized = false;
+    LeaveLayout(window);
+
+    CreateOrUpdateBorder(window);
+
+    // Move cursor to the center of the window
+    windowSystem->MoveCursor(RectCenter(freeRect));
+}
+
+// Put every managed window of the cursor's monitor into a grid or master-stack layout.
+// Windows are matched to slots with minimal total movement and placed in one batch.
+void HandleArrangeRequest(ArrangeLayout layout) {
+    WatchdogCommand command("HandleArrangeRequest");
+    Point cursor;
+    if (!windowSystem->CursorPosition(&cursor)) {
+        return;
+    }
+    MonitorId monitor = windowSystem->MonitorAt(cursor);
+    MonitorInfo info;
+    if (!GetCachedMonitorInfo(monitor, &info)) return;
+
+    // For master-stack the window under the cursor becomes the master
+    WindowId master = 0;
+    if (layout == ArrangeLayout::MasterStack) {
+        WindowId window = windowSystem->WindowAt(cursor);
+        master = window ? windowSystem->RootWindow(window) : 0;
+    }
+
+    std::vector<WindowId> candidates;
+    CollectManagedWindows(&candidates);
+
+    // Maximized and no_tile windows are left alone; the master goes first so it lines up
+    // with slot 0
+    std::vector<WindowId> windows;
+    std::vector<Rect> rects;
+    bool hasMaster = false;
+    for (WindowId window : candidates) {
+        Rect rc;
+        if ((WindowRuleVerdict(window).actions & RULE_NO_TILE) || windowSystem->IsMaximized(window) || windowSystem->MonitorOfWindow(window) != monitor || !windowSystem->WindowRect(window, &rc)) continue;
+        if (window == master) {
+            windows.insert(windows.begin(), window);
+            rects.insert(rects.begin(), rc);
+            hasMaster = true;
+        } else {
+            windows.push_back(window);
+            rects.push_back(rc);
+        }
+    }
+    if (windows.empty()) return;
+
+    const MonitorRecord* monitorRecord = FindMonitorRecord(monitor);
+    float splitX = monitorRecord ? monitorRecord->split.x : SplitRatio().x;
+    std::vector<Rect> slots;
+    ComputeArrangeSlots(info.work, layout, windows.size(), CurrentConfig().padding, splitX, &slots);
+
+    // A pinned master takes slot 0; everything else is assigned by minimal movement
+    size_t pinned = hasMaster ? 1 : 0;
+    std::vector<size_t> assignment;
+    AssignSlots(rects.data() + pinned, slots.data() + pinned, windows.size() - pinned, &assignment);
+
+    std::vector<Placement> batch;
+    batch.reserve(windows.size());
+    for (size_t i = 0; i < windows.size(); ++i) {
+        Placement placement;
+        placement.window = windows[i];
+        placement.rect = (i < pinned) ? slots[i] : slots[assignment[i - pinned] + pinned];
+        batch.push_back(placement);
+
+        // Arranged windows are not part of the split layout
+        if (WindowRecord* record = windowRecords.Find(windows[i])) record->maximized = false;
+        LeaveLayout(windows[i]);
+    }
+
+    ApplyPlacements(batch);
+    UpdateBorderVisibility(currentFocusedWindow);
+}
+
+// Collect the managed windows currently shown on a monitor as workspace members (topmost first)
+static void CollectShownMembers(MonitorId monitor, std::vector<WorkspaceMember>* members) {
+    std::vector<WindowId> windows;
+    CollectManagedWindows(&windows);
+
+    for (WindowId window : windows) {
+        Rect rc;
+        if (windowSystem->MonitorOfWindow(window) != monitor || !windowSystem->WindowRect(window, &rc)) continue;
+        WorkspaceMember member;
+        member.window = window;
+        member.state = TrackedWindowState(window);
+        member.rect = rc;
+        members->push_back(member);
+    }
+}
+
+// Switch a monitor to another workspace: the outgoing windows, the border and the incoming
+// windows change visibility in a single batch. False if `target` is already active or the
+// parked table has no room for the outgoing windows.
+static bool SwitchWorkspace(MonitorId monitor, int target) {
+    MonitorWorkspaces& workspaces = monitorWorkspaces[monitor];
+    if (target < 0 || target >= WORKSPACE_COUNT || target == workspaces.active) return false;
+    int outgoing = workspaces.active;
+
+    std::vector<WorkspaceMember> shown;
+    CollectShownMembers(monitor, &shown);
+    CaptureActiveWorkspace(workspaces, shown.data(), shown.size());
+
+    // Every outgoing window needs a parked entry; the incoming ones free theirs
+    if (parkedWindows.Size() + shown.size() > MAX_TRACKED_WINDOWS + workspaces.members[target].size()) return false;
+
+    // The border leaves with the focused window if that is on the outgoing workspace
+    WindowId border = 0;
+    const WindowRecord* focused = windowRecords.Find(currentFocusedWindow);
+    for (const auto& m : shown) {
+        if (m.window == currentFocusedWindow && focused) {
+            border = focused->border;
+            break;
+        }
+    }
+
+    std::vector<Placement> batch;
+    if (!BuildWorkspaceSwitch(workspaces, target, border, &batch)) return false;
+    ApplyPlacements(batch);
+    if (border) {
+        RemoveBorder(currentFocusedWindow);
+    }
+
+    // Hidden windows drop out of the split layout; incoming ones rejoin it. Entries are freed
+    // before they are taken, so the check above leaves room for every insert.
+    for (const auto& m : workspaces.members[target]) {
+        parkedWindows.Erase(m.window);
+    }
+    for (const auto& m : shown) {
+        *parkedWindows.Insert(m.window) = { monitor, outgoing };
+        LeaveLayout(m.window);
+    }
+    for (const auto& m : workspaces.members[target]) {
+        if (m.state == WindowState::Unknown) continue;
+        WindowRecord* record = windowRecords.Insert(m.window);
+        if (!record) continue;
+        record->state = m.state;
+        record->monitor = monitor;
+        PersistRecord(m.window);
+    }
+    return true;
+}
+
+// Switch the cursor's monitor to another workspace
+void HandleWorkspaceSwitch(int target) {
+    WatchdogCommand command("HandleWorkspaceSwitch");
+    Point cursor;
+    if (!windowSystem->CursorPosition(&cursor)) {
+        return;
+    }
+    MonitorId monitor = windowSystem->MonitorAt(cursor);
+    if (!SwitchWorkspace(monitor, target)) return;
+
+    // Focusing the topmost incoming window brings the border back through the focus event
+    const std::vector<WorkspaceMember>& incoming = monitorWorkspaces[monitor].members[target];
+    if (!incoming.empty()) {
+        windowSystem->Activate(incoming.front().window);
+    }
+    PublishFocusFeed();
+}
+
+// Send the window under the cursor to another workspace of its monitor
+void HandleMoveToWorkspace(int target) {
+    WatchdogCommand command("HandleMoveToWorkspace");
+    Point cursor;
+    WindowId window = RootWindowAtCursor(&cursor);
+    if (!window || !IsManageableWindow(window)) {
+        return;
+    }
+    command.SetTarget(window);
+
+    Rect rc;
+    if (!windowSystem->WindowRect(window, &rc)) return;
+
+    MonitorId monitor = windowSystem->MonitorOfWindow(window);
+    WorkspaceMember member;
+    member.window = window;
+    member.state = TrackedWindowState(window);
+    member.rect = rc;
+
+    // A window the parked table has no room for stays where it is
+    if (parkedWindows.Full() && !parkedWindows.Find(window)) return;
+    Placement hide;
+    if (!MoveToWorkspace(monitorWorkspaces[monitor], member, target, &hide)) return;
+    *parkedWindows.Insert(window) = { monitor, target };
+
+    RemoveBorder(window);
+    ApplyPlacements({ hide });
+    LeaveLayout(window);
+    PublishFocusFeed();  // Parked counts changed
+}
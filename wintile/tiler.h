@@ -0,0 +1,162 @@
+#pragma once
+
+// Tiler commands and window tracking. All OS access goes through the WindowSystem passed to
+// InitTiler, so the same code runs on the desktop and against a simulated backend.
+
+#include "adoption.h"
+#include "animation.h"
+#include "arrange.h"
+#include "layout.h"
+#include "rules.h"
+#include "state_feed.h"
+#include "state_store.h"
+#include "window_system.h"
+
+// Fixed capacities of the tracking tables; nothing on the snap path allocates once they exist.
+// Windows beyond MAX_TRACKED_WINDOWS are left alone, monitors beyond MAX_MONITORS uncached.
+#define MAX_TRACKED_WINDOWS 1024
+#define MAX_MONITORS 32
+
+// Executable names cached for the window rules; longer names are cut (and match no exact rule)
+#define MAX_CACHED_PROCESSES 256
+#define PROCESS_NAME_CHARS 128
+
+// Reset all tracking state and route OS calls to `system`
+void InitTiler(WindowSystem* system);
+
+// Show every window parked on an inactive workspace and destroy all borders
+void ShutdownTiler();
+
+// Re-read the monitor layout (at startup and on display changes)
+void RefreshMonitorCache();
+
+// Keep the per-window state (snap state, monitor, maximize restore rect, learned size limits)
+// in `store` from now on, each change as one slot write. The records already in the store are
+// first re-attached to the live windows they still match by handle, process and class; call
+// after RefreshMonitorCache. Returns the number of windows restored.
+size_t AttachStateStore(StateStore* store);
+void DetachStateStore();
+
+// Publish the focused window's state (window, snap state, monitor, workspaces) to `feed` from
+// now on, once per change; see state_feed.h
+void AttachStateFeed(StateFeedWriter* feed);
+void DetachStateFeed();
+
+// Animate layout placements (snaps, moves across monitors, split resizes, arranges) through
+// `animator` from now on, while the config's animation_ms is not 0. Workspace shows and hides,
+// maximize restores and fills stay immediate and stop the window's animation.
+// AdvanceAnimations runs one frame of them; call it once per display frame, starting after the
+// animator's wake callback, for as long as it returns true.
+void AttachAnimator(Animator* animator);
+void DetachAnimator();  // Windows jump to their targets
+bool AdvanceAnimations(long long nowNs);
+
+// Startup adoption (adoption.h): classify the open windows on `workers` threads. Call after
+// RefreshMonitorCache and AttachStateStore; restored windows keep their stored state. `notify`
+// runs on a worker when classified windows are waiting and when the scan is done; the main
+// thread then calls AdoptScannedWindows, which adopts up to `max` of them and returns true if
+// more are waiting already (call it again after other messages).
+struct AdoptionStats {
+    long long scanned;  // Windows classified
+    long long matched;  // Found at a layout rect
+    long long adopted;  // Tracked in that state (not restored, acted on or excluded by a rule)
+    bool finished;      // Every window classified and taken
+};
+
+void StartWindowAdoption(int workers, AdoptionNotify notify);
+bool AdoptScannedWindows(size_t max);
+const AdoptionStats& WindowAdoptionStats();
+
+// Window commands
+void SnapWindow(WindowId window, WindowState newState, MonitorId monitor);
+void MaximizeWindow(WindowId window);
+void MoveWindowToMonitor(WindowId window, MonitorId monitor);
+
+// Snap several windows in one placement transaction: every affected monitor's layout is planned
+// first and applied as a single batch. Untiled, dead and unknown-state targets are skipped.
+// Returns the number of windows snapped.
+struct SnapTarget {
+    WindowId window;
+    WindowState state;
+    int monitor;  // 1-based in enumeration order, 0 = the window's own
+};
+
+size_t SnapWindows(const SnapTarget* targets, size_t count);
+
+// Apply a layout session (config.h) in one SnapWindows transaction. Each entry takes the
+// topmost manageable window it matches that no earlier-matched entry took; entries without a
+// window are skipped. One EnumWindows, then per window its class (and its process and title if
+// an entry looks at them) until every entry has a window. Returns the number of windows snapped.
+struct LayoutSession;
+size_t ApplyLayoutSession(const LayoutSession& session);
+
+// Bring a window to the foreground; the focus border follows through the focus event
+bool ActivateWindow(WindowId window);
+
+// Vim-style marks: a letter a-z names a window. A mark keeps the window's process id, and the
+// window's destroy event clears it, so a recycled handle never answers for the marked window.
+// A lookup is an array index and one OS call on the window; nothing enumerates the desktop.
+#define MARK_COUNT 26
+
+// Mark `window`, or the window under the cursor if 0 (m{letter}); false if there is none or
+// `letter` is not a-z
+bool SetMark(char letter, WindowId window);
+
+// The marked window, 0 if the mark is unset or its window is gone (the mark is then cleared)
+WindowId MarkedWindow(char letter);
+
+// Focus and raise the marked window and put the cursor on its center ('{letter}). A window
+// parked on an inactive workspace brings its workspace back first. False if the mark is unset,
+// its window is gone or it could not be activated.
+bool JumpToMark(char letter);
+
+// Focus border
+void UpdateFocusedWindow();
+void UpdateAllBorders();
+bool ShouldWindowHaveBorder(WindowId window);
+
+// Re-evaluate the focus border after the configuration changed (width, excluded classes)
+void RefreshFocusedBorder();
+
+// Window the focus border follows, 0 if none
+WindowId FocusedWindow();
+
+// Move an existing focus border to where its window is now (live tracking during a drag)
+void TrackFocusedBorder();
+
+// Hotkey commands; they act on the window (or monitor) under the cursor
+void HandleSnapRequest(SnapDirection direction);
+void HandleMonitorSwitch(SnapDirection direction);
+void HandleFillRequest();
+void HandleArrangeRequest(ArrangeLayout layout);
+void HandleWorkspaceSwitch(int target);
+void HandleMoveToWorkspace(int target);
+
+// Split resizes are coalesced: QueueSplitResize returns true for the first press of a burst,
+// and the caller then schedules ApplyPendingSplitResize (e.g. by posting itself a message)
+bool QueueSplitResize(SplitAxis axis, int steps);
+void ApplyPendingSplitResize();
+
+// Window events
+void HandleWindowDestroyed(WindowId window);
+void HandleWindowHidden(WindowId window);
+void HandleWindowShown(WindowId window);  // Shown, restored or moved/resized by the user
+
+// Tracked state of a window, Unknown if it is not part of the split layout
+WindowState TrackedWindowState(WindowId window);
+
+// Per-application rules (`rule` lines in the config). A window's verdict is computed on first
+// use and remembered until the window is destroyed, its title changes (if rules match titles)
+// or the config is reloaded. Executable names are cached by process id until the process exits.
+struct RuleStats {
+    long long verdicts;        // Verdicts computed by the matcher
+    long long memoHits;        // Verdicts answered from the memo
+    long long processLookups;  // Executable names resolved through the window system
+    long long processHits;     // Executable names answered from the cache
+};
+
+RuleVerdict WindowRuleVerdict(WindowId window);
+void HandleProcessExited(unsigned long pid);
+void HandleWindowRenamed(WindowId window);  // Title changed; may run a title rule's placement
+const RuleStats& WindowRuleStats();
+void ResetWindowRuleStats();
@@ -0,0 +1,68 @@
+#include "timeline.h"
+
+#include <atomic>
+
+struct TimelineEvent {
+    const char* category;
+    const char* name;
+    std::uint64_t startNs;
+    std::uint64_t durationNs;
+    std::uint64_t arg;
+    std::uint32_t thread;
+};
+
+static TimelineEvent events[TIMELINE_CAPACITY];
+static std::atomic<std::uint64_t> nextEvent{ 0 };
+static std::atomic<std::uint32_t> nextThread{ 1 };
+
+static std::uint32_t CurrentThread() {
+    thread_local std::uint32_t thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+    return thread;
+}
+
+std::uint64_t TimelineNow() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::now() - epoch;
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void RecordTimelineSpan(const char* category, const char* name, std::uint64_t startNs,
+                        std::uint64_t endNs, std::uint64_t arg) {
+    std::uint64_t index = nextEvent.fetch_add(1, std::memory_order_relaxed);
+    TimelineEvent& e = events[index & (TIMELINE_CAPACITY - 1)];
+    e.category = category;
+    e.name = name;
+    e.startNs = startNs;
+    e.durationNs = endNs - startNs;
+    e.arg = arg;
+    e.thread = CurrentThread();
+}
+
+std::uint64_t TimelineRecorded() {
+    return nextEvent.load(std::memory_order_relaxed);
+}
+
+bool WriteTimelineJson(std::FILE* out) {
+    std::uint64_t end = nextEvent.load(std::memory_order_acquire);
+    std::uint64_t begin = end > TIMELINE_CAPACITY ? end - TIMELINE_CAPACITY : 0;
+
+    std::fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    std::fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"WinVimTiler\"}}");
+    for (std::uint64_t i = begin; i < end; ++i) {
+        const TimelineEvent& e = events[i & (TIMELINE_CAPACITY - 1)];
+        // Timestamps are microseconds; keep ns precision in the fraction
+        std::fprintf(out, ",\n{\"cat\":\"%s\",\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                          "\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"args\":{\"arg\":%llu}}",
+                     e.category, e.name, e.thread,
+                     static_cast<unsigned long long>(e.startNs / 1000), static_cast<unsigned>(e.startNs % 1000),
+                     static_cast<unsigned long long>(e.durationNs / 1000), static_cast<unsigned>(e.durationNs % 1000),
+                     static_cast<unsigned long long>(e.arg));
+    }
+    std::fprintf(out, "\n],\"otherData\":{\"recorded_spans\":%llu,\"dropped_spans\":%llu}}\n",
+                 static_cast<unsigned long long>(end), static_cast<unsigned long long>(begin));
+    return std::ferror(out) == 0;
+}
+
+void ResetTimeline() {
+    nextEvent.store(0, std::memory_order_relaxed);
+}
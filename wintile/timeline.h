@@ -0,0 +1,90 @@
+#pragma once
+
+// Timeline tracer: spans recorded into a fixed ring buffer and exported as Chrome trace-event
+// JSON (loads in chrome://tracing, Perfetto and Speedscope). The newest TIMELINE_CAPACITY spans
+// are kept. Spans are placed with TIMELINE_SPAN / TIMELINE_SPAN_ARG / TIMELINE_CALL, which
+// compile to nothing unless WINTILE_TIMELINE is defined (CMake option WINTILE_ENABLE_TIMELINE).
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// ~24 MB of spans; minutes of event storms plus hotkey handling
+#define TIMELINE_CAPACITY (1 << 19)
+
+// Nanoseconds on the steady clock; span timestamps are relative to the first call
+std::uint64_t TimelineNow();
+
+// Record a completed span. `category` and `name` must outlive the tracer (string literals).
+// Lock-free; the thread is recorded so spans from other threads get their own track.
+void RecordTimelineSpan(const char* category, const char* name, std::uint64_t startNs,
+                        std::uint64_t endNs, std::uint64_t arg);
+
+// Spans recorded since the last reset, including ones the ring has since overwritten
+std::uint64_t TimelineRecorded();
+
+// Write the buffered spans as a trace-event JSON object. Call from the recording thread,
+// or while no spans are being recorded.
+bool WriteTimelineJson(std::FILE* out);
+
+void ResetTimeline();
+
+class TimelineScope {
+public:
+    TimelineScope(const char* category, const char* name, std::uint64_t arg = 0)
+        : category_(category), name_(name), arg_(arg), start_(TimelineNow()) {}
+    ~TimelineScope() { RecordTimelineSpan(category_, name_, start_, TimelineNow(), arg_); }
+    TimelineScope(const TimelineScope&) = delete;
+    TimelineScope& operator=(const TimelineScope&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    std::uint64_t arg_;
+    std::uint64_t start_;
+};
+
+// Calls a function inside an "os" span named after it; see TIMELINE_CALL. Arguments convert to
+// the function's own parameter types, so NULL and literal flags pass through as usual.
+template <typename Fn>
+struct TimelineCall;
+
+template <typename R, typename... Params>
+struct TimelineCall<R(Params...)> {
+    const char* name;
+    R (*fn)(Params...);
+
+    R operator()(Params... args) const {
+        TimelineScope scope("os", name);
+        return fn(args...);
+    }
+};
+
+#if defined(_WIN32) && !defined(_WIN64)
+// 32-bit Windows APIs are __stdcall, a distinct function type there
+template <typename R, typename... Params>
+struct TimelineCall<R __stdcall(Params...)> {
+    const char* name;
+    R (__stdcall* fn)(Params...);
+
+    R operator()(Params... args) const {
+        TimelineScope scope("os", name);
+        return fn(args...);
+    }
+};
+#endif
+
+#define TIMELINE_CONCAT_INNER(a, b) a##b
+#define TIMELINE_CONCAT(a, b) TIMELINE_CONCAT_INNER(a, b)
+
+#ifdef WINTILE_TIMELINE
+#define TIMELINE_SPAN(category, name) TimelineScope TIMELINE_CONCAT(timelineScope, __LINE__)(category, name)
+#define TIMELINE_SPAN_ARG(category, name, arg) \
+    TimelineScope TIMELINE_CONCAT(timelineScope, __LINE__)(category, name, static_cast<std::uint64_t>(arg))
+// TIMELINE_CALL(SetWindowPos)(hwnd, ...) traces one OS call
+#define TIMELINE_CALL(fn) (TimelineCall<decltype(fn)>{ #fn, fn })
+#else
+#define TIMELINE_SPAN(category, name) ((void)0)
+#define TIMELINE_SPAN_ARG(category, name, arg) ((void)0)
+#define TIMELINE_CALL(fn) fn
+#endif
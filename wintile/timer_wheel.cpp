@@ -0,0 +1,194 @@
+#include "timer_wheel.h"
+
+#include <bit>
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+// Bits of the tick that select the slot of a level
+static int LevelShift(int level) {
+    return TIMER_WHEEL_SLOT_BITS * level;
+}
+
+TimerWheel::TimerWheel(long long tickNs, long long nowNs)
+    : tickNs_(tickNs > 0 ? tickNs : 1), current_(static_cast<std::uint64_t>(nowNs / tickNs_)) {
+    for (auto& level : slots_) {
+        for (Timer& head : level) InitList(&head);
+    }
+    InitList(&expiring_);
+}
+
+// Empty circular list: the sentinel links to itself
+void TimerWheel::InitList(Timer* head) {
+    head->next_ = head;
+    head->prev_ = head;
+}
+
+void TimerWheel::Append(Timer* head, Timer* timer) {
+    timer->prev_ = head->prev_;
+    timer->next_ = head;
+    head->prev_->next_ = timer;
+    head->prev_ = timer;
+}
+
+// Link an unlinked timer into the slot for its due tick
+void TimerWheel::Place(Timer* timer) {
+    std::uint64_t due = timer->dueTick_;
+    std::uint64_t delta = due - current_;
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (std::uint64_t(1) << LevelShift(level + 1))) {
+        ++level;
+    }
+    // Beyond the top level's reach: park it in the last slot that comes around, it is placed
+    // again from there
+    std::uint64_t span = std::uint64_t(1) << LevelShift(TIMER_WHEEL_LEVELS);
+    if (delta >= span) due = current_ + span - 1;
+
+    int index = static_cast<int>((due >> LevelShift(level)) & SLOT_MASK);
+    Append(&slots_[level][index], timer);
+    timer->slot_ = level * TIMER_WHEEL_SLOTS + index;
+    occupied_[level][index / 64] |= std::uint64_t(1) << (index % 64);
+}
+
+void TimerWheel::Unlink(Timer* timer) {
+    timer->prev_->next_ = timer->next_;
+    timer->next_->prev_ = timer->prev_;
+
+    if (timer->slot_ != EXPIRING_SLOT) {
+        int level = timer->slot_ / TIMER_WHEEL_SLOTS;
+        int index = timer->slot_ % TIMER_WHEEL_SLOTS;
+        Timer* head = &slots_[level][index];
+        if (head->next_ == head) occupied_[level][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+    }
+    timer->next_ = nullptr;
+    timer->prev_ = nullptr;
+    timer->slot_ = -1;
+}
+
+void TimerWheel::Schedule(Timer* timer, long long dueNs) {
+    if (timer->Armed()) {
+        Unlink(timer);
+    } else {
+        ++count_;
+    }
+
+    // Round up so a timer never fires before its due time
+    std::uint64_t due = dueNs > 0 ? static_cast<std::uint64_t>((dueNs + tickNs_ - 1) / tickNs_) : 0;
+    timer->dueTick_ = due > current_ ? due : current_ + 1;
+    Place(timer);
+}
+
+void TimerWheel::Cancel(Timer* timer) {
+    if (!timer->Armed()) return;
+    Unlink(timer);
+    --count_;
+}
+
+// Move every timer of the level's current slot one level down (or further)
+void TimerWheel::Cascade(int level) {
+    int index = static_cast<int>((current_ >> LevelShift(level)) & SLOT_MASK);
+    Timer* head = &slots_[level][index];
+    if (head->next_ == head) return;
+
+    // Detach the whole list first; placing may append to lower levels only
+    Timer* timer = head->next_;
+    head->prev_->next_ = nullptr;
+    InitList(head);
+    occupied_[level][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+    while (timer) {
+        Timer* next = timer->next_;
+        Place(timer);
+        timer = next;
+    }
+}
+
+// Process the tick after current_; returns how many timers fired
+size_t TimerWheel::Step(long long nowNs) {
+    ++current_;
+
+    // When the lower levels wrap, bring the next slot of each wrapping level down, top first
+    // so its timers reach level 0 in this same step
+    if ((current_ & SLOT_MASK) == 0) {
+        int top = 1;
+        while (top < TIMER_WHEEL_LEVELS - 1 && (current_ & ((std::uint64_t(1) << LevelShift(top + 1)) - 1)) == 0) {
+            ++top;
+        }
+        for (int level = top; level >= 1; --level) Cascade(level);
+    }
+
+    int index = static_cast<int>(current_ & SLOT_MASK);
+    Timer* head = &slots_[0][index];
+    if (head->next_ == head) return 0;
+
+    // Move the slot onto the expiring list, so callbacks can cancel or reschedule any timer
+    // of it (or add new ones to the wheel) while it is being run
+    expiring_.next_ = head->next_;
+    expiring_.prev_ = head->prev_;
+    expiring_.next_->prev_ = &expiring_;
+    expiring_.prev_->next_ = &expiring_;
+    InitList(head);
+    occupied_[0][index / 64] &= ~(std::uint64_t(1) << (index % 64));
+    for (Timer* timer = expiring_.next_; timer != &expiring_; timer = timer->next_) {
+        timer->slot_ = EXPIRING_SLOT;
+    }
+
+    size_t fired = 0;
+    while (expiring_.next_ != &expiring_) {
+        Timer* timer = expiring_.next_;
+        Unlink(timer);
+        --count_;
+        ++fired;
+        if (timer->callback_) timer->callback_(timer->context_, nowNs);
+    }
+    return fired;
+}
+
+int TimerWheel::NextOccupied(int level, int from) const {
+    for (int word = from / 64; word < TIMER_WHEEL_SLOTS / 64; ++word) {
+        std::uint64_t bits = occupied_[level][word];
+        if (word == from / 64) bits &= ~std::uint64_t(0) << (from % 64);
+        if (bits) return word * 64 + std::countr_zero(bits);
+    }
+    return -1;
+}
+
+// First tick after current_ at which a timer expires or a slot cascades down
+std::uint64_t TimerWheel::NextWakeTick() const {
+    // The first occupied slot after the current one on each level, in tick order; for
+    // level 0 that is the exact due tick, above it the tick its slot cascades down
+    std::uint64_t wake = ~std::uint64_t(0);
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+        int shift = LevelShift(level);
+        int index = static_cast<int>((current_ >> shift) & SLOT_MASK);
+        int slot = index < SLOT_MASK ? NextOccupied(level, index + 1) : -1;
+        if (slot < 0) slot = NextOccupied(level, 0);
+        if (slot < 0) continue;
+
+        std::uint64_t rotation = std::uint64_t(1) << LevelShift(level + 1);
+        std::uint64_t tick = (current_ & ~(rotation - 1)) | (std::uint64_t(slot) << shift);
+        if (tick <= current_) tick += rotation;
+        if (tick < wake) wake = tick;
+    }
+    return wake;
+}
+
+size_t TimerWheel::Advance(long long nowNs) {
+    std::uint64_t target = nowNs > 0 ? static_cast<std::uint64_t>(nowNs / tickNs_) : 0;
+    size_t fired = 0;
+    while (current_ < target) {
+        // Jump over the ticks in which nothing expires or cascades
+        std::uint64_t next = count_ ? NextWakeTick() : ~std::uint64_t(0);
+        if (next > target) {
+            current_ = target;
+            break;
+        }
+        current_ = next - 1;
+        fired += Step(nowNs);
+    }
+    return fired;
+}
+
+long long TimerWheel::NextWakeNs() const {
+    if (!count_) return -1;
+    return static_cast<long long>(NextWakeTick()) * tickNs_;
+}
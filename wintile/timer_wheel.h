@@ -0,0 +1,90 @@
+#pragma once
+
+// Hierarchical timer wheel for deferred and periodic work on the main thread. Four levels of
+// 256 slots cover 2^32 ticks; a timer sits in the level matching how far away it is and moves
+// down a level each time its slot comes around, so scheduling, cancelling and expiring are
+// O(1). Timers are intrusive: the caller owns the Timer and the wheel only links it into a
+// slot, so nothing allocates. Times are caller-supplied nanoseconds; timers never fire early
+// and at most one tick late (from the last Advance).
+
+#include <cstddef>
+#include <cstdint>
+
+class TimerWheel;
+
+// Called when the timer expires, with the time Advance was given. The timer is already
+// disarmed; scheduling it again from here makes it periodic.
+typedef void (*TimerCallback)(void* context, long long nowNs);
+
+class Timer {
+public:
+    Timer() = default;
+    Timer(TimerCallback callback, void* context) : callback_(callback), context_(context) {}
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    void SetCallback(TimerCallback callback, void* context) {
+        callback_ = callback;
+        context_ = context;
+    }
+
+    bool Armed() const { return next_ != nullptr; }
+
+private:
+    friend class TimerWheel;
+
+    Timer* next_ = nullptr;  // Slot list links, nullptr when not armed
+    Timer* prev_ = nullptr;
+    std::uint64_t dueTick_ = 0;
+    int slot_ = -1;  // level * TIMER_WHEEL_SLOTS + index, or EXPIRING_SLOT
+    TimerCallback callback_ = nullptr;
+    void* context_ = nullptr;
+};
+
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 8
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+class TimerWheel {
+public:
+    // `tickNs` is the resolution; the wheel starts at `nowNs`
+    explicit TimerWheel(long long tickNs, long long nowNs = 0);
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Arm `timer` to fire at `dueNs`, moving it if it is armed already. A due time in the
+    // past fires on the next tick.
+    void Schedule(Timer* timer, long long dueNs);
+
+    // Disarm `timer`; nothing happens if it is not armed. Cancel before destroying a Timer.
+    void Cancel(Timer* timer);
+
+    // Run every timer due at or before `nowNs`, in due order. Returns how many fired.
+    size_t Advance(long long nowNs);
+
+    // Earliest time the wheel needs an Advance: the next due time, or earlier when timers
+    // have to move down a level first. -1 when no timer is armed.
+    long long NextWakeNs() const;
+
+    size_t Size() const { return count_; }
+    long long TickNs() const { return tickNs_; }
+
+private:
+    static const int EXPIRING_SLOT = TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS;
+
+    static void InitList(Timer* head);
+    static void Append(Timer* head, Timer* timer);
+    void Place(Timer* timer);
+    void Unlink(Timer* timer);
+    void Cascade(int level);
+    size_t Step(long long nowNs);
+    int NextOccupied(int level, int from) const;  // First occupied slot index >= from, or -1
+    std::uint64_t NextWakeTick() const;
+
+    long long tickNs_;
+    std::uint64_t current_;  // Last tick processed
+    size_t count_ = 0;
+    Timer slots_[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];  // Sentinels of circular lists
+    std::uint64_t occupied_[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS / 64] = {};
+    Timer expiring_;  // Sentinel for the slot being expired
+};
@@ -0,0 +1,197 @@
+#include "watchdog.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+// What the main thread is doing, written by it and read by the watchdog thread. A snapshot of
+// several fields may mix two moments; good enough for a diagnostic.
+static std::atomic<long long> busySince(0);  // Start of the message in progress, 0 when idle
+static std::atomic<const char*> currentCommand(nullptr);
+static std::atomic<WindowId> currentTarget(0);
+static std::atomic<const char*> currentCall(nullptr);
+static std::atomic<WindowId> currentCallWindow(0);
+static std::atomic<int> currentCallCause(static_cast<int>(StallCause::OsCall));
+
+// Set on threads whose OS calls are not the main thread's
+static thread_local bool ignoredThread = false;
+
+static std::atomic<long long> stallCounts[static_cast<int>(StallCause::Count)];
+
+static std::mutex watchdogMutex;
+static std::condition_variable watchdogWake;
+static std::thread watchdogThread;
+static bool watchdogStopping = false;
+
+static long long WatchdogNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* StallCauseName(StallCause cause) {
+    switch (cause) {
+        case StallCause::OsCall: return "os_call";
+        case StallCause::Dialog: return "dialog";
+        case StallCause::Command: return "command";
+        case StallCause::MessageLoop: return "message_loop";
+        default: return "unknown";
+    }
+}
+
+void WatchdogBusy() {
+    busySince.store(WatchdogNow(), std::memory_order_release);
+}
+
+void WatchdogIdle() {
+    busySince.store(0, std::memory_order_release);
+}
+
+WatchdogMessage::WatchdogMessage() : marked_(busySince.load(std::memory_order_relaxed) == 0) {
+    if (marked_) WatchdogBusy();
+}
+
+WatchdogMessage::~WatchdogMessage() {
+    if (marked_) WatchdogIdle();
+}
+
+static StallReport SnapshotStall(long long stalledNs) {
+    StallReport report;
+    report.recovered = false;
+    report.stalledNs = stalledNs;
+    report.command = currentCommand.load(std::memory_order_relaxed);
+    report.target = currentTarget.load(std::memory_order_relaxed);
+    report.osCall = currentCall.load(std::memory_order_relaxed);
+    report.osCallWindow = report.osCall ? currentCallWindow.load(std::memory_order_relaxed) : 0;
+    if (report.osCall) {
+        report.cause = static_cast<StallCause>(currentCallCause.load(std::memory_order_relaxed));
+    } else {
+        report.cause = report.command ? StallCause::Command : StallCause::MessageLoop;
+    }
+    return report;
+}
+
+static void WatchdogLoop(long long thresholdNs, StallCallback callback) {
+    const std::chrono::nanoseconds poll(thresholdNs / 4 > 1000000 ? thresholdNs / 4 : 1000000);
+    long long reportedSince = 0;  // busySince of the stall reported last, 0 if none is open
+    StallReport open = {};
+
+    std::unique_lock<std::mutex> lock(watchdogMutex);
+    while (!watchdogStopping) {
+        watchdogWake.wait_for(lock, poll);
+        if (watchdogStopping) break;
+
+        long long since = busySince.load(std::memory_order_acquire);
+        long long now = WatchdogNow();
+
+        // The stalled message finished: report how long it took in total
+        if (reportedSince && since != reportedSince) {
+            open.recovered = true;
+            open.stalledNs = now - reportedSince;
+            reportedSince = 0;
+            lock.unlock();
+            if (callback) callback(open);
+            lock.lock();
+        }
+
+        if (since && since != reportedSince && now - since >= thresholdNs) {
+            open = SnapshotStall(now - since);
+            reportedSince = since;
+            stallCounts[static_cast<int>(open.cause)].fetch_add(1, std::memory_order_relaxed);
+            lock.unlock();
+            if (callback) callback(open);
+            lock.lock();
+        }
+    }
+}
+
+bool StartWatchdog(long long thresholdNs, StallCallback callback) {
+    std::lock_guard<std::mutex> lock(watchdogMutex);
+    if (watchdogThread.joinable()) return false;
+    watchdogStopping = false;
+    watchdogThread = std::thread(WatchdogLoop, thresholdNs, callback);
+    return true;
+}
+
+void StopWatchdog() {
+    {
+        std::lock_guard<std::mutex> lock(watchdogMutex);
+        if (!watchdogThread.joinable()) return;
+        watchdogStopping = true;
+    }
+    watchdogWake.notify_all();
+    watchdogThread.join();
+}
+
+// Early exits (failed start-up) must not leave a joinable thread behind
+static struct WatchdogShutdown {
+    ~WatchdogShutdown() { StopWatchdog(); }
+} watchdogShutdown;
+
+long long WatchdogStallCount(StallCause cause) {
+    return stallCounts[static_cast<int>(cause)].load(std::memory_order_relaxed);
+}
+
+void ResetWatchdogCounts() {
+    for (auto& count : stallCounts) count.store(0, std::memory_order_relaxed);
+}
+
+void FormatStallReport(const StallReport& report, std::string* out) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "stall %s cause=%s stalled_ms=%.1f command=%s target=0x%llx os_call=%s os_call_window=0x%llx",
+                  report.recovered ? "recovered" : "detected", StallCauseName(report.cause),
+                  report.stalledNs / 1e6, report.command ? report.command : "none",
+                  static_cast<unsigned long long>(report.target), report.osCall ? report.osCall : "none",
+                  static_cast<unsigned long long>(report.osCallWindow));
+    out->append(line);
+}
+
+void FormatStallCounts(std::string* out) {
+    out->append("stalls");
+    for (int i = 0; i < static_cast<int>(StallCause::Count); ++i) {
+        char item[64];
+        std::snprintf(item, sizeof(item), " %s=%lld", StallCauseName(static_cast<StallCause>(i)),
+                      stallCounts[i].load(std::memory_order_relaxed));
+        out->append(item);
+    }
+}
+
+WatchdogCommand::WatchdogCommand(const char* command, WindowId target)
+    : previousCommand_(currentCommand.load(std::memory_order_relaxed)),
+      previousTarget_(currentTarget.load(std::memory_order_relaxed)) {
+    currentCommand.store(command, std::memory_order_relaxed);
+    currentTarget.store(target, std::memory_order_relaxed);
+}
+
+WatchdogCommand::~WatchdogCommand() {
+    currentCommand.store(previousCommand_, std::memory_order_relaxed);
+    currentTarget.store(previousTarget_, std::memory_order_relaxed);
+}
+
+void WatchdogCommand::SetTarget(WindowId target) {
+    currentTarget.store(target, std::memory_order_relaxed);
+}
+
+void WatchdogIgnoreThread() {
+    ignoredThread = true;
+}
+
+WatchdogCall::WatchdogCall(const char* call, WindowId window, StallCause cause)
+    : marked_(!ignoredThread),
+      previousCall_(currentCall.load(std::memory_order_relaxed)),
+      previousWindow_(currentCallWindow.load(std::memory_order_relaxed)),
+      previousCause_(static_cast<StallCause>(currentCallCause.load(std::memory_order_relaxed))) {
+    if (!marked_) return;
+    currentCallWindow.store(window, std::memory_order_relaxed);
+    currentCallCause.store(static_cast<int>(cause), std::memory_order_relaxed);
+    currentCall.store(call, std::memory_order_relaxed);
+}
+
+WatchdogCall::~WatchdogCall() {
+    if (!marked_) return;
+    currentCall.store(previousCall_, std::memory_order_relaxed);
+    currentCallWindow.store(previousWindow_, std::memory_order_relaxed);
+    currentCallCause.store(static_cast<int>(previousCause_), std::memory_order_relaxed);
+}
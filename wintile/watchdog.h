@@ -0,0 +1,93 @@
+#pragma once
+
+// Message-loop stall watchdog. The main thread marks when it starts and stops handling a
+// message, which tiler command runs and which OS call is in progress; a watchdog thread polls
+// that state and reports a stall once a single message has been in progress for longer than
+// the threshold. Marking costs a few relaxed atomic stores, so it stays on in every build.
+
+#include "layout.h"
+
+#include <string>
+
+enum class StallCause {
+    OsCall,       // Blocked in a window system call (slow SetWindowPos target, DWM)
+    Dialog,       // A modal dialog such as MessageBoxW running its own loop
+    Command,      // Inside a tiler command, no OS call in progress
+    MessageLoop,  // Handling a message outside any tiler command
+    Count
+};
+
+const char* StallCauseName(StallCause cause);
+
+struct StallReport {
+    StallCause cause;
+    bool recovered;         // false when first detected, true once the loop moved on
+    long long stalledNs;    // Time the message has been in progress (to within one poll)
+    const char* command;    // Tiler command running, nullptr if none
+    WindowId target;        // Window the command acts on, 0 if not known yet
+    const char* osCall;     // OS call in progress, nullptr if none
+    WindowId osCallWindow;  // Window that call acts on, 0 if none
+};
+
+// Called on the watchdog thread for every detected stall and again when it ends
+typedef void (*StallCallback)(const StallReport& report);
+
+// Start the watchdog thread. It polls four times per threshold. Returns false if it runs already.
+bool StartWatchdog(long long thresholdNs, StallCallback callback);
+void StopWatchdog();
+
+// Message loop side: a message (or start-up) is being handled / the loop waits for the next one
+void WatchdogBusy();
+void WatchdogIdle();
+
+// Marks a callback that the OS runs from inside the wait (WinEvent hooks) as busy; nested in a
+// busy period it leaves that period alone
+class WatchdogMessage {
+public:
+    WatchdogMessage();
+    ~WatchdogMessage();
+
+private:
+    bool marked_;
+};
+
+// Detected stalls since start or the last reset
+long long WatchdogStallCount(StallCause cause);
+void ResetWatchdogCounts();
+
+// "stall cause=.. ..." line for a report, without a trailing newline
+void FormatStallReport(const StallReport& report, std::string* out);
+
+// "stalls os_call=.. dialog=.. command=.. message_loop=.." line
+void FormatStallCounts(std::string* out);
+
+// Marks the running tiler command for the scope's lifetime; the outer command comes back after
+class WatchdogCommand {
+public:
+    explicit WatchdogCommand(const char* command, WindowId target = 0);
+    ~WatchdogCommand();
+
+    // The command resolved the window it acts on
+    void SetTarget(WindowId target);
+
+private:
+    const char* previousCommand_;
+    WindowId previousTarget_;
+};
+
+// Helper threads that make window system calls of their own (startup adoption) call this
+// first, so their calls are not taken for the main thread's
+void WatchdogIgnoreThread();
+
+// Marks an OS call in progress for the scope's lifetime
+class WatchdogCall {
+public:
+    explicit WatchdogCall(const char* call, WindowId window = 0, StallCause cause = StallCause::OsCall);
+    ~WatchdogCall();
+
+private:
+    bool marked_;
+    const char* previousCall_;
+    WindowId previousWindow_;
+    StallCause previousCause_;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+// Everything the tiler asks of the windowing system. Each method is documented with the
+// user32/dwmapi call(s) the Win32 backend makes for it, so a backend that counts calls
+// measures what a command costs on a real desktop.
+//
+// The tiler calls from the main thread, except for startup adoption: its workers make the
+// read-only window queries (visibility, styles, minimized/maximized, class, cloaked, rects,
+// MonitorFromWindow) concurrently with the main thread's calls. user32 and DWM allow that; a
+// simulated backend has to lock.
+
+#include "geometry.h"
+#include "layout.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Opaque monitor handle (an HMONITOR on Windows)
+typedef std::uintptr_t MonitorId;
+
+// Monitor bounds and work area (the bounds minus taskbars and docked bars)
+struct MonitorInfo {
+    Rect monitor;
+    Rect work;
+};
+
+// Window style bits the tiler looks at (Win32 values; other backends translate)
+#define WINDOW_STYLE_POPUP 0x80000000UL
+#define WINDOW_STYLE_CAPTION 0x00C00000UL
+#define WINDOW_EXSTYLE_TOOLWINDOW 0x00000080UL
+
+class WindowSystem {
+public:
+    virtual ~WindowSystem() {}
+
+    // GetCursorPos / SetCursorPos
+    virtual bool CursorPosition(Point* point) = 0;
+    virtual bool MoveCursor(const Point& point) = 0;
+
+    // WindowFromPoint / GetAncestor(GA_ROOT)
+    virtual WindowId WindowAt(const Point& point) = 0;
+    virtual WindowId RootWindow(WindowId window) = 0;
+
+    // GetForegroundWindow / SetForegroundWindow
+    virtual WindowId ForegroundWindow() = 0;
+    virtual bool Activate(WindowId window) = 0;
+
+    // EnumWindows: top-level windows, topmost first
+    virtual void EnumerateWindows(std::vector<WindowId>* windows) = 0;
+
+    // IsWindow / IsWindowVisible / IsIconic / IsZoomed
+    virtual bool IsAlive(WindowId window) = 0;
+    virtual bool IsVisible(WindowId window) = 0;
+    virtual bool IsMinimized(WindowId window) = 0;
+    virtual bool IsMaximized(WindowId window) = 0;
+
+    // GetClassNameW
+    virtual bool ClassName(WindowId window, wchar_t* buffer, int size) = 0;
+
+    // GetWindowTextW
+    virtual bool WindowTitle(WindowId window, wchar_t* buffer, int size) = 0;
+
+    // GetWindowThreadProcessId
+    virtual unsigned long ProcessId(WindowId window) = 0;
+
+    // Full path of a process's executable: OpenProcess, QueryFullProcessImageNameW and
+    // RegisterWaitForSingleObject. The backend keeps the process handle until the process has
+    // exited, so its id is not reused before the exit is reported (HandleProcessExited).
+    virtual bool ProcessImagePath(unsigned long pid, wchar_t* buffer, int size) = 0;
+
+    // GetWindowLong(GWL_STYLE) / GetWindowLong(GWL_EXSTYLE)
+    virtual unsigned long Style(WindowId window) = 0;
+    virtual unsigned long ExStyle(WindowId window) = 0;
+
+    // DwmGetWindowAttribute(DWMWA_CLOAKED): on another virtual desktop or suspended
+    virtual bool IsCloaked(WindowId window) = 0;
+
+    // GetWindowRect
+    virtual bool WindowRect(WindowId window, Rect* rect) = 0;
+
+    // DwmGetWindowAttribute(DWMWA_EXTENDED_FRAME_BOUNDS), the visible frame without the
+    // invisible resize borders; falls back to GetWindowRect if DWM has no answer
+    virtual bool FrameRect(WindowId window, Rect* rect) = 0;
+
+    // SetWindowPos
+    virtual bool Place(const Placement& placement) = 0;
+
+    // BeginDeferWindowPos, one DeferWindowPos per placement, EndDeferWindowPos. Returns false
+    // if the transaction was dropped (nothing or only part of it may have been applied).
+    virtual bool PlaceBatch(const Placement* batch, size_t count) = 0;
+
+    // MonitorFromWindow / MonitorFromPoint (nearest monitor)
+    virtual MonitorId MonitorOfWindow(WindowId window) = 0;
+    virtual MonitorId MonitorAt(const Point& point) = 0;
+
+    // GetMonitorInfo
+    virtual bool QueryMonitor(MonitorId monitor, MonitorInfo* info) = 0;
+
+    // EnumDisplayMonitors
+    virtual void EnumerateMonitors(std::vector<MonitorId>* monitors) = 0;
+
+    // Focus border overlay placed right behind `app`.
+    // CreateBorder: CreateWindowExW, SetLayeredWindowAttributes, SetWindowPos, ShowWindow.
+    // MoveBorder: SetWindowPos, InvalidateRect. DestroyBorder: DestroyWindow.
+    virtual WindowId CreateBorder(WindowId app, const Rect& rect) = 0;
+    virtual void MoveBorder(WindowId border, WindowId app, const Rect& rect) = 0;
+    virtual void DestroyBorder(WindowId border) = 0;
+};
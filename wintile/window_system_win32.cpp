@@ -0,0 +1,277 @@
+#include "window_system_win32.h"
+
+#include <dwmapi.h>
+
+#include "timeline.h"
+#include "watchdog.h"
+
+// SetWindowPos flags for a placement
+static UINT PlacementSwpFlags(const Placement& p) {
+    UINT flags = SWP_NOZORDER | SWP_NOACTIVATE;
+    if (p.flags & PLACEMENT_SHOW) flags |= SWP_SHOWWINDOW;
+    if (p.flags & PLACEMENT_HIDE) flags |= SWP_HIDEWINDOW | SWP_NOMOVE | SWP_NOSIZE;
+    return flags;
+}
+
+bool Win32WindowSystem::CursorPosition(Point* point) {
+    WatchdogCall call("GetCursorPos");
+    POINT p;
+    if (!TIMELINE_CALL(GetCursorPos)(&p)) return false;
+    *point = { p.x, p.y };
+    return true;
+}
+
+bool Win32WindowSystem::MoveCursor(const Point& point) {
+    WatchdogCall call("SetCursorPos");
+    return TIMELINE_CALL(SetCursorPos)(point.x, point.y) != 0;
+}
+
+WindowId Win32WindowSystem::WindowAt(const Point& point) {
+    WatchdogCall call("WindowFromPoint");
+    POINT p = { point.x, point.y };
+    return ToWindowId(TIMELINE_CALL(WindowFromPoint)(p));
+}
+
+WindowId Win32WindowSystem::RootWindow(WindowId window) {
+    WatchdogCall call("GetAncestor", window);
+    return ToWindowId(TIMELINE_CALL(GetAncestor)(ToHwnd(window), GA_ROOT));
+}
+
+WindowId Win32WindowSystem::ForegroundWindow() {
+    WatchdogCall call("GetForegroundWindow");
+    return ToWindowId(TIMELINE_CALL(GetForegroundWindow)());
+}
+
+bool Win32WindowSystem::Activate(WindowId window) {
+    WatchdogCall call("SetForegroundWindow", window);
+    return TIMELINE_CALL(SetForegroundWindow)(ToHwnd(window)) != 0;
+}
+
+static BOOL CALLBACK CollectWindowProc(HWND hwnd, LPARAM lParam) {
+    reinterpret_cast<std::vector<WindowId>*>(lParam)->push_back(ToWindowId(hwnd));
+    return TRUE;
+}
+
+void Win32WindowSystem::EnumerateWindows(std::vector<WindowId>* windows) {
+    WatchdogCall call("EnumWindows");
+    TIMELINE_CALL(EnumWindows)(CollectWindowProc, reinterpret_cast<LPARAM>(windows));
+}
+
+bool Win32WindowSystem::IsAlive(WindowId window) {
+    WatchdogCall call("IsWindow", window);
+    return TIMELINE_CALL(IsWindow)(ToHwnd(window)) != 0;
+}
+
+bool Win32WindowSystem::IsVisible(WindowId window) {
+    WatchdogCall call("IsWindowVisible", window);
+    return TIMELINE_CALL(IsWindowVisible)(ToHwnd(window)) != 0;
+}
+
+bool Win32WindowSystem::IsMinimized(WindowId window) {
+    WatchdogCall call("IsIconic", window);
+    return TIMELINE_CALL(IsIconic)(ToHwnd(window)) != 0;
+}
+
+bool Win32WindowSystem::IsMaximized(WindowId window) {
+    WatchdogCall call("IsZoomed", window);
+    return TIMELINE_CALL(IsZoomed)(ToHwnd(window)) != 0;
+}
+
+bool Win32WindowSystem::ClassName(WindowId window, wchar_t* buffer, int size) {
+    WatchdogCall call("GetClassNameW", window);
+    return TIMELINE_CALL(GetClassNameW)(ToHwnd(window), buffer, size) != 0;
+}
+
+bool Win32WindowSystem::WindowTitle(WindowId window, wchar_t* buffer, int size) {
+    WatchdogCall call("GetWindowTextW", window);
+    if (size <= 0) return false;
+    // 0 is also the length of an empty title, so a failed call just reads as one
+    buffer[0] = L'\0';
+    TIMELINE_CALL(GetWindowTextW)(ToHwnd(window), buffer, size);
+    return true;
+}
+
+unsigned long Win32WindowSystem::ProcessId(WindowId window) {
+    WatchdogCall call("GetWindowThreadProcessId", window);
+    DWORD pid = 0;
+    TIMELINE_CALL(GetWindowThreadProcessId)(ToHwnd(window), &pid);
+    return pid;
+}
+
+bool Win32WindowSystem::ProcessImagePath(unsigned long pid, wchar_t* buffer, int size) {
+    WatchdogCall call("QueryFullProcessImageNameW");
+    HANDLE process = TIMELINE_CALL(OpenProcess)(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, pid);
+    if (!process) return false;
+    DWORD length = static_cast<DWORD>(size);
+    bool ok = TIMELINE_CALL(QueryFullProcessImageNameW)(process, 0, buffer, &length) != 0;
+
+    // Hold the handle until the process exits: an open handle keeps the id from being reused,
+    // and the wait reports the exit so the cached name is dropped in time
+    if (ok && exitWindow_ && processWatches_.find(pid) == processWatches_.end()) {
+        ProcessWatch* watch = new ProcessWatch{ process, NULL, pid, exitWindow_, exitMessage_ };
+        if (TIMELINE_CALL(RegisterWaitForSingleObject)(&watch->wait, process, OnProcessExit, watch, INFINITE,
+                                                       WT_EXECUTEONLYONCE)) {
+            processWatches_[pid] = watch;
+            return true;
+        }
+        delete watch;
+    }
+    CloseHandle(process);
+    return ok;
+}
+
+void CALLBACK Win32WindowSystem::OnProcessExit(void* context, BOOLEAN) {
+    // Thread pool thread: only post, the main thread owns the watch table
+    ProcessWatch* watch = static_cast<ProcessWatch*>(context);
+    PostMessage(watch->window, watch->message, watch->pid, reinterpret_cast<LPARAM>(watch));
+}
+
+void Win32WindowSystem::NotifyProcessExits(HWND window, UINT message) {
+    exitWindow_ = window;
+    exitMessage_ = message;
+}
+
+unsigned long Win32WindowSystem::ProcessExited(LPARAM lParam) {
+    ProcessWatch* watch = reinterpret_cast<ProcessWatch*>(lParam);
+    DWORD pid = watch->pid;
+    processWatches_.erase(pid);
+    // The callback has run (WT_EXECUTEONLYONCE), so the non-blocking unregister is enough
+    UnregisterWait(watch->wait);
+    CloseHandle(watch->process);
+    delete watch;
+    return pid;
+}
+
+void Win32WindowSystem::StopProcessWatches() {
+    for (auto& pair : processWatches_) {
+        UnregisterWaitEx(pair.second->wait, INVALID_HANDLE_VALUE);  // Waits for a running callback
+        CloseHandle(pair.second->process);
+        delete pair.second;
+    }
+    processWatches_.clear();
+    exitWindow_ = NULL;
+}
+
+unsigned long Win32WindowSystem::Style(WindowId window) {
+    WatchdogCall call("GetWindowLongW", window);
+    return static_cast<unsigned long>(TIMELINE_CALL(GetWindowLongW)(ToHwnd(window), GWL_STYLE));
+}
+
+unsigned long Win32WindowSystem::ExStyle(WindowId window) {
+    WatchdogCall call("GetWindowLongW", window);
+    return static_cast<unsigned long>(TIMELINE_CALL(GetWindowLongW)(ToHwnd(window), GWL_EXSTYLE));
+}
+
+// Cloaked windows (other virtual desktops, suspended UWP apps) are "visible" but not on screen
+bool Win32WindowSystem::IsCloaked(WindowId window) {
+    WatchdogCall call("DwmGetWindowAttribute", window);
+    DWORD cloaked = 0;
+    return SUCCEEDED(TIMELINE_CALL(DwmGetWindowAttribute)(ToHwnd(window), DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked != 0;
+}
+
+bool Win32WindowSystem::WindowRect(WindowId window, Rect* rect) {
+    WatchdogCall call("GetWindowRect", window);
+    RECT rc;
+    if (!TIMELINE_CALL(GetWindowRect)(ToHwnd(window), &rc)) return false;
+    *rect = ToRect(rc);
+    return true;
+}
+
+bool Win32WindowSystem::FrameRect(WindowId window, Rect* rect) {
+    WatchdogCall call("DwmGetWindowAttribute", window);
+    RECT rc;
+    HRESULT hr = TIMELINE_CALL(DwmGetWindowAttribute)(ToHwnd(window), DWMWA_EXTENDED_FRAME_BOUNDS, &rc, sizeof(RECT));
+    if (SUCCEEDED(hr)) {
+        *rect = ToRect(rc);
+        return true;
+    }
+    return WindowRect(window, rect);
+}
+
+bool Win32WindowSystem::Place(const Placement& p) {
+    WatchdogCall call("SetWindowPos", p.window);
+    return TIMELINE_CALL(SetWindowPos)(ToHwnd(p.window), NULL, p.rect.left, p.rect.top,
+                                       RectWidth(p.rect), RectHeight(p.rect), PlacementSwpFlags(p)) != 0;
+}
+
+bool Win32WindowSystem::PlaceBatch(const Placement* batch, size_t count) {
+    // EndDeferWindowPos does the moves, waiting on each target window
+    WatchdogCall call("EndDeferWindowPos", count ? batch[0].window : 0);
+    HDWP hdwp = TIMELINE_CALL(BeginDeferWindowPos)(static_cast<int>(count));
+    for (size_t i = 0; i < count && hdwp; ++i) {
+        const Placement& p = batch[i];
+        hdwp = TIMELINE_CALL(DeferWindowPos)(hdwp, ToHwnd(p.window), NULL, p.rect.left, p.rect.top,
+                                             RectWidth(p.rect), RectHeight(p.rect), PlacementSwpFlags(p));
+    }
+    return hdwp && TIMELINE_CALL(EndDeferWindowPos)(hdwp);
+}
+
+MonitorId Win32WindowSystem::MonitorOfWindow(WindowId window) {
+    WatchdogCall call("MonitorFromWindow", window);
+    return ToMonitorId(TIMELINE_CALL(MonitorFromWindow)(ToHwnd(window), MONITOR_DEFAULTTONEAREST));
+}
+
+MonitorId Win32WindowSystem::MonitorAt(const Point& point) {
+    WatchdogCall call("MonitorFromPoint");
+    POINT p = { point.x, point.y };
+    return ToMonitorId(TIMELINE_CALL(MonitorFromPoint)(p, MONITOR_DEFAULTTONEAREST));
+}
+
+bool Win32WindowSystem::QueryMonitor(MonitorId monitor, MonitorInfo* info) {
+    WatchdogCall call("GetMonitorInfoW");
+    MONITORINFO mi = { sizeof(mi) };
+    if (!TIMELINE_CALL(GetMonitorInfo)(ToHmonitor(monitor), &mi)) return false;
+    info->monitor = ToRect(mi.rcMonitor);
+    info->work = ToRect(mi.rcWork);
+    return true;
+}
+
+static BOOL CALLBACK CollectMonitorProc(HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData) {
+    reinterpret_cast<std::vector<MonitorId>*>(dwData)->push_back(ToMonitorId(hMonitor));
+    return TRUE;
+}
+
+void Win32WindowSystem::EnumerateMonitors(std::vector<MonitorId>* monitors) {
+    WatchdogCall call("EnumDisplayMonitors");
+    TIMELINE_CALL(EnumDisplayMonitors)(NULL, NULL, CollectMonitorProc, reinterpret_cast<LPARAM>(monitors));
+}
+
+WindowId Win32WindowSystem::CreateBorder(WindowId app, const Rect& rect) {
+    WatchdogCall call("CreateWindowExW", app);
+    // Create new border window without TOPMOST flag
+    HWND borderWindow = TIMELINE_CALL(CreateWindowExW)(
+        WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_NOACTIVATE | WS_EX_TOOLWINDOW,
+        BORDER_CLASS_NAME,
+        L"",
+        WS_POPUP,
+        rect.left, rect.top,
+        RectWidth(rect), RectHeight(rect),
+        NULL, NULL, instance_, NULL
+    );
+    if (!borderWindow) return 0;
+
+    // Use pure color-key transparency to ensure no darkening occurs
+    TIMELINE_CALL(SetLayeredWindowAttributes)(borderWindow, TRANSPARENT_COLOR, 255, LWA_COLORKEY);
+
+    // Position border window right behind the app window in Z-order
+    TIMELINE_CALL(SetWindowPos)(borderWindow, ToHwnd(app), 0, 0, 0, 0,
+                                SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+
+    TIMELINE_CALL(ShowWindow)(borderWindow, SW_SHOWNOACTIVATE);
+    return ToWindowId(borderWindow);
+}
+
+void Win32WindowSystem::MoveBorder(WindowId border, WindowId app, const Rect& rect) {
+    WatchdogCall call("SetWindowPos", border);
+    TIMELINE_CALL(SetWindowPos)(ToHwnd(border), ToHwnd(app),
+                                rect.left, rect.top, RectWidth(rect), RectHeight(rect),
+                                SWP_NOACTIVATE | SWP_SHOWWINDOW);
+
+    // Trigger repaint to update border color
+    TIMELINE_CALL(InvalidateRect)(ToHwnd(border), NULL, TRUE);
+}
+
+void Win32WindowSystem::DestroyBorder(WindowId border) {
+    WatchdogCall call("DestroyWindow", border);
+    TIMELINE_CALL(DestroyWindow)(ToHwnd(border));
+}
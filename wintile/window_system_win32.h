@@ -0,0 +1,91 @@
+#pragma once
+
+#include <windows.h>
+
+#include "window_system.h"
+
+#include <unordered_map>
+
+// Border window class (registered by the application) and its color key (border_color is
+// in the config)
+#define BORDER_CLASS_NAME L"WinTilerBorderClass"
+#define TRANSPARENT_COLOR RGB(255, 0, 255)  // Magenta for color-key transparency
+
+// Conversions between Win32 handles/rects and the portable types
+inline Rect ToRect(const RECT& rc) {
+    return { rc.left, rc.top, rc.right, rc.bottom };
+}
+
+inline HWND ToHwnd(WindowId window) {
+    return reinterpret_cast<HWND>(window);
+}
+
+inline WindowId ToWindowId(HWND hwnd) {
+    return reinterpret_cast<WindowId>(hwnd);
+}
+
+inline HMONITOR ToHmonitor(MonitorId monitor) {
+    return reinterpret_cast<HMONITOR>(monitor);
+}
+
+inline MonitorId ToMonitorId(HMONITOR monitor) {
+    return reinterpret_cast<MonitorId>(monitor);
+}
+
+// WindowSystem on top of user32 and dwmapi
+class Win32WindowSystem : public WindowSystem {
+public:
+    explicit Win32WindowSystem(HINSTANCE instance) : instance_(instance) {}
+
+    // Exits of the processes ProcessImagePath resolved are posted to `window` as `message`
+    // (wParam = process id, lParam = the watch); hand the lParam to ProcessExited, which
+    // closes the handle and returns the process id
+    void NotifyProcessExits(HWND window, UINT message);
+    unsigned long ProcessExited(LPARAM watch);
+    void StopProcessWatches();  // At exit, before the message loop is gone
+
+    bool CursorPosition(Point* point) override;
+    bool MoveCursor(const Point& point) override;
+    WindowId WindowAt(const Point& point) override;
+    WindowId RootWindow(WindowId window) override;
+    WindowId ForegroundWindow() override;
+    bool Activate(WindowId window) override;
+    void EnumerateWindows(std::vector<WindowId>* windows) override;
+    bool IsAlive(WindowId window) override;
+    bool IsVisible(WindowId window) override;
+    bool IsMinimized(WindowId window) override;
+    bool IsMaximized(WindowId window) override;
+    bool ClassName(WindowId window, wchar_t* buffer, int size) override;
+    bool WindowTitle(WindowId window, wchar_t* buffer, int size) override;
+    unsigned long ProcessId(WindowId window) override;
+    bool ProcessImagePath(unsigned long pid, wchar_t* buffer, int size) override;
+    unsigned long Style(WindowId window) override;
+    unsigned long ExStyle(WindowId window) override;
+    bool IsCloaked(WindowId window) override;
+    bool WindowRect(WindowId window, Rect* rect) override;
+    bool FrameRect(WindowId window, Rect* rect) override;
+    bool Place(const Placement& placement) override;
+    bool PlaceBatch(const Placement* batch, size_t count) override;
+    MonitorId MonitorOfWindow(WindowId window) override;
+    MonitorId MonitorAt(const Point& point) override;
+    bool QueryMonitor(MonitorId monitor, MonitorInfo* info) override;
+    void EnumerateMonitors(std::vector<MonitorId>* monitors) override;
+    WindowId CreateBorder(WindowId app, const Rect& rect) override;
+    void MoveBorder(WindowId border, WindowId app, const Rect& rect) override;
+    void DestroyBorder(WindowId border) override;
+
+private:
+    struct ProcessWatch {
+        HANDLE process;
+        HANDLE wait;
+        DWORD pid;
+        HWND window;
+        UINT message;
+    };
+    static void CALLBACK OnProcessExit(void* context, BOOLEAN timedOut);
+
+    HINSTANCE instance_;
+    HWND exitWindow_ = NULL;
+    UINT exitMessage_ = 0;
+    std::unordered_map<DWORD, ProcessWatch*> processWatches_;  // By process id
+};
@@ -0,0 +1,997 @@
+#include "window_system_xcb.h"
+
+#include "config.h"
+#include "watchdog.h"
+
+#ifdef WINTILE_XCB_RANDR
+#include <xcb/randr.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const char* const atomNames[ATOM_COUNT] = {
+    "_NET_SUPPORTING_WM_CHECK",
+    "_NET_CLIENT_LIST_STACKING",
+    "_NET_ACTIVE_WINDOW",
+    "_NET_CURRENT_DESKTOP",
+    "_NET_WORKAREA",
+    "_NET_WM_NAME",
+    "_NET_WM_PID",
+    "_NET_WM_DESKTOP",
+    "_NET_WM_STATE",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WM_STATE_MAXIMIZED_VERT",
+    "_NET_WM_STATE_MAXIMIZED_HORZ",
+    "_NET_WM_STATE_SKIP_TASKBAR",
+    "_NET_WM_WINDOW_TYPE",
+    "_NET_WM_WINDOW_TYPE_NORMAL",
+    "_NET_WM_WINDOW_TYPE_DIALOG",
+    "_NET_FRAME_EXTENTS",
+    "_NET_MOVERESIZE_WINDOW",
+    "WM_CHANGE_STATE",
+    "UTF8_STRING",
+};
+
+// ICCCM and EWMH constants xcb itself does not define (prefixed so xcb-icccm/xcb-ewmh cannot clash)
+#define ICCCM_ICONIC_STATE 3
+#define ICCCM_SIZE_HINT_MIN (1 << 4)    // WM_NORMAL_HINTS flags: PMinSize, PMaxSize
+#define ICCCM_SIZE_HINT_MAX (1 << 5)
+#define EWMH_MOVERESIZE_XYWH (0xF << 8)  // _NET_MOVERESIZE_WINDOW: x, y, width and height given
+#define EWMH_SOURCE_PAGER (2 << 12)      // Requests come from a pager-like tool, not the app
+#define EWMH_ALL_DESKTOPS 0xFFFFFFFF
+
+// Events selected on the root and on every client
+#define ROOT_EVENT_MASK \
+    (XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE)
+#define CLIENT_EVENT_MASK \
+    (XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_FOCUS_CHANGE)
+
+// Frames nest this deep at most (client, frame, decoration parents)
+#define XCB_MAX_FRAME_DEPTH 4
+
+// The 32-bit values of a property; 0 if it is missing or of another format
+static int Values32(const xcb_get_property_reply_t* reply, const std::uint32_t** values) {
+    if (!reply || reply->format != 32) return 0;
+    *values = static_cast<const std::uint32_t*>(xcb_get_property_value(reply));
+    return xcb_get_property_value_length(reply) / 4;
+}
+
+static std::uint32_t Value32(const xcb_get_property_reply_t* reply, std::uint32_t fallback) {
+    const std::uint32_t* values;
+    return Values32(reply, &values) > 0 ? values[0] : fallback;
+}
+
+static void DecodeLatin1(const char* text, size_t length, std::wstring* out) {
+    out->assign(length, L'\0');
+    for (size_t i = 0; i < length; ++i) (*out)[i] = static_cast<unsigned char>(text[i]);
+}
+
+// UTF-8 to UTF-32 (wchar_t is 32 bits here); bad sequences become U+FFFD
+static void DecodeUtf8(const char* text, size_t length, std::wstring* out) {
+    out->clear();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text);
+    const unsigned char* end = p + length;
+    while (p < end) {
+        unsigned c = *p++;
+        int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        if (c >= 0x80 && c < 0xC0) {
+            out->push_back(0xFFFD);
+            continue;
+        }
+        if (extra) c &= 0x3F >> extra;
+        for (; extra > 0 && p < end && (*p & 0xC0) == 0x80; --extra) c = (c << 6) | (*p++ & 0x3F);
+        out->push_back(extra ? 0xFFFD : static_cast<wchar_t>(c));
+    }
+}
+
+static bool CopyText(const std::wstring& text, wchar_t* buffer, int size) {
+    if (size <= 0) return false;
+    size_t count = std::min(text.size(), static_cast<size_t>(size - 1));
+    std::wmemcpy(buffer, text.data(), count);
+    buffer[count] = L'\0';
+    return true;
+}
+
+static long long OverlapArea(const Rect& a, const Rect& b) {
+    long width = std::min(a.right, b.right) - std::max(a.left, b.left);
+    long height = std::min(a.bottom, b.bottom) - std::max(a.top, b.top);
+    return width > 0 && height > 0 ? static_cast<long long>(width) * height : 0;
+}
+
+bool XcbWindowSystem::Connect(const char* display) {
+    Disconnect();
+    int screenNumber = 0;
+    connection_ = xcb_connect(display, &screenNumber);
+    if (xcb_connection_has_error(connection_)) {
+        xcb_disconnect(connection_);
+        connection_ = nullptr;
+        return false;
+    }
+    xcb_screen_iterator_t screens = xcb_setup_roots_iterator(xcb_get_setup(connection_));
+    for (int i = 0; i < screenNumber && screens.rem; ++i) xcb_screen_next(&screens);
+    screen_ = screens.data;
+    root_ = screen_->root;
+    rootSize_[0] = screen_->width_in_pixels;
+    rootSize_[1] = screen_->height_in_pixels;
+
+    // The atoms and the RandR extension in one round trip
+    xcb_intern_atom_cookie_t cookies[ATOM_COUNT];
+    for (int i = 0; i < ATOM_COUNT; ++i) {
+        cookies[i] = xcb_intern_atom(connection_, 0, static_cast<std::uint16_t>(std::strlen(atomNames[i])), atomNames[i]);
+    }
+#ifdef WINTILE_XCB_RANDR
+    xcb_prefetch_extension_data(connection_, &xcb_randr_id);
+#endif
+    {
+        WatchdogCall call("xcb_intern_atom");
+        roundTrips_ += 1;
+        for (int i = 0; i < ATOM_COUNT; ++i) {
+            xcb_intern_atom_reply_t* reply = xcb_intern_atom_reply(connection_, cookies[i], nullptr);
+            atoms_[i] = reply ? reply->atom : 0;
+            std::free(reply);
+        }
+    }
+
+#ifdef WINTILE_XCB_RANDR
+    // Monitors need RandR 1.5 (GetMonitors)
+    const xcb_query_extension_reply_t* randr = xcb_get_extension_data(connection_, &xcb_randr_id);
+    if (randr && randr->present) {
+        WatchdogCall call("xcb_randr_query_version");
+        roundTrips_ += 1;
+        xcb_randr_query_version_reply_t* version =
+            xcb_randr_query_version_reply(connection_, xcb_randr_query_version(connection_, 1, 5), nullptr);
+        if (version && (version->major_version > 1 || version->minor_version >= 5)) {
+            randrEvent_ = randr->first_event;
+            xcb_randr_select_input(connection_, root_, XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE);
+        }
+        std::free(version);
+    }
+#endif
+
+    std::uint32_t mask = ROOT_EVENT_MASK;
+    xcb_change_window_attributes(connection_, root_, XCB_CW_EVENT_MASK, &mask);
+    rootDirty_ = true;
+    monitorsDirty_ = true;
+    Refresh();
+    notes_.clear();
+    return true;
+}
+
+void XcbWindowSystem::Disconnect() {
+    if (!connection_) return;
+    for (xcb_window_t border : borders_) xcb_destroy_window(connection_, border);
+    xcb_flush(connection_);
+    xcb_disconnect(connection_);
+    connection_ = nullptr;
+    for (const auto& process : processFds_) close(process.second);
+    processFds_.clear();
+    clients_.clear();
+    frames_.clear();
+    stacking_.clear();
+    borders_.clear();
+    monitors_.clear();
+    active_ = 0;
+    wmWindow_ = 0;
+    randrEvent_ = 0;
+}
+
+int XcbWindowSystem::ConnectionFd() const {
+    return connection_ ? xcb_get_file_descriptor(connection_) : -1;
+}
+
+XcbWindowSystem::Client* XcbWindowSystem::FindClient(WindowId window) {
+    auto it = clients_.find(static_cast<xcb_window_t>(window));
+    return it != clients_.end() ? &it->second : nullptr;
+}
+
+Rect XcbWindowSystem::OuterRect(const Client& client) const {
+    return { client.rect.left - client.extents[0], client.rect.top - client.extents[2],
+             client.rect.right + client.extents[1], client.rect.bottom + client.extents[3] };
+}
+
+// Start caching a window and listening to its changes
+void XcbWindowSystem::Track(xcb_window_t window) {
+    if (clients_.count(window)) return;
+    clients_[window];
+    std::uint32_t mask = CLIENT_EVENT_MASK;
+    xcb_change_window_attributes(connection_, window, XCB_CW_EVENT_MASK, &mask);
+}
+
+void XcbWindowSystem::Forget(xcb_window_t window) {
+    auto it = clients_.find(window);
+    if (it == clients_.end()) return;
+    if (it->second.frame) frames_.erase(it->second.frame);
+    clients_.erase(it);
+    stacking_.erase(std::remove(stacking_.begin(), stacking_.end(), window), stacking_.end());
+    if (active_ == window) active_ = 0;
+}
+
+void XcbWindowSystem::Note(WindowEvent event, xcb_window_t window) {
+    notes_.push_back({ event, window });
+}
+
+void XcbWindowSystem::HandleEvent(const xcb_generic_event_t* event) {
+    std::uint8_t type = event->response_type & 0x7F;
+    if (randrEvent_ && type == randrEvent_) {
+        monitorsDirty_ = true;  // RRScreenChangeNotify
+        return;
+    }
+    switch (type) {
+        case XCB_CREATE_NOTIFY:
+            if (!wmWindow_) rootDirty_ = true;  // A new root child may be a client
+            break;
+        case XCB_DESTROY_NOTIFY: {
+            xcb_window_t window = reinterpret_cast<const xcb_destroy_notify_event_t*>(event)->window;
+            if (std::find(borders_.begin(), borders_.end(), window) != borders_.end()) break;
+            if (clients_.count(window)) {
+                Forget(window);
+                Note(WindowEvent::Destroyed, window);
+            }
+            if (!wmWindow_) rootDirty_ = true;
+            break;
+        }
+        case XCB_UNMAP_NOTIFY: {
+            Client* client = FindClient(reinterpret_cast<const xcb_unmap_notify_event_t*>(event)->window);
+            if (!client || !client->mapped) break;
+            client->mapped = false;
+            client->dirty = true;  // Iconified or withdrawn
+            Note(WindowEvent::Hidden, reinterpret_cast<const xcb_unmap_notify_event_t*>(event)->window);
+            break;
+        }
+        case XCB_MAP_NOTIFY: {
+            xcb_window_t window = reinterpret_cast<const xcb_map_notify_event_t*>(event)->window;
+            Client* client = FindClient(window);
+            if (!client) {
+                if (!wmWindow_) rootDirty_ = true;
+                break;
+            }
+            if (client->mapped) break;
+            client->mapped = true;
+            client->dirty = true;
+            Note(WindowEvent::Shown, window);
+            break;
+        }
+        case XCB_CONFIGURE_NOTIFY: {
+            const xcb_configure_notify_event_t* configure = reinterpret_cast<const xcb_configure_notify_event_t*>(event);
+            if (configure->window == root_) {
+                rootSize_[0] = configure->width;
+                rootSize_[1] = configure->height;
+                monitorsDirty_ = true;
+                break;
+            }
+            if (!wmWindow_) rootDirty_ = true;  // The stacking order may have changed
+            xcb_window_t window = configure->window;
+            auto frame = frames_.find(window);
+            if (frame != frames_.end() && frame->second != window) window = frame->second;
+            Client* client = FindClient(window);
+            if (!client) break;
+            // Synthetic events (ICCCM) and unparented windows give root coordinates; anything
+            // else is relative to a frame and read again
+            bool synthetic = (event->response_type & 0x80) != 0;
+            if (window == configure->window && (synthetic || client->frame == window)) {
+                client->rect = { configure->x, configure->y, configure->x + configure->width, configure->y + configure->height };
+            } else {
+                client->dirty = true;
+            }
+            Note(WindowEvent::Shown, window);
+            break;
+        }
+        case XCB_REPARENT_NOTIFY: {
+            const xcb_reparent_notify_event_t* reparent = reinterpret_cast<const xcb_reparent_notify_event_t*>(event);
+            if (Client* client = FindClient(reparent->window)) client->dirty = true;
+            if (!wmWindow_) rootDirty_ = true;
+            break;
+        }
+        case XCB_PROPERTY_NOTIFY: {
+            const xcb_property_notify_event_t* property = reinterpret_cast<const xcb_property_notify_event_t*>(event);
+            if (property->window == root_) {
+                xcb_atom_t atom = property->atom;
+                if (atom == atoms_[ATOM_NET_CLIENT_LIST_STACKING] || atom == atoms_[ATOM_NET_ACTIVE_WINDOW] ||
+                    atom == atoms_[ATOM_NET_CURRENT_DESKTOP] || atom == atoms_[ATOM_NET_WORKAREA] ||
+                    atom == atoms_[ATOM_NET_SUPPORTING_WM_CHECK]) {
+                    rootDirty_ = true;
+                }
+                break;
+            }
+            Client* client = FindClient(property->window);
+            if (!client) break;
+            client->dirty = true;
+            if (property->atom == XCB_ATOM_WM_NAME || property->atom == atoms_[ATOM_NET_WM_NAME]) {
+                Note(WindowEvent::Renamed, property->window);
+            } else if (property->atom == atoms_[ATOM_NET_WM_STATE]) {
+                Note(WindowEvent::Shown, property->window);  // Maximized, restored, iconified
+            }
+            break;
+        }
+        case XCB_FOCUS_IN:
+            if (!wmWindow_) rootDirty_ = true;  // Read the input focus again
+            break;
+        default:
+            break;  // Errors of requests on windows that died meanwhile, and the rest
+    }
+}
+
+void XcbWindowSystem::ProcessEvents(XcbEventHandler handler, XcbProcessExitHandler exited) {
+    if (!connection_) return;
+    notes_.clear();
+    while (xcb_generic_event_t* event = xcb_poll_for_event(connection_)) {
+        HandleEvent(event);
+        std::free(event);
+    }
+    Refresh();
+    if (handler) {
+        for (const PendingNote& note : notes_) handler(note.event, note.window);
+    }
+    PollProcessExits(exited);
+}
+
+bool XcbWindowSystem::TakeMonitorsChanged() {
+    bool changed = monitorsChanged_;
+    monitorsChanged_ = false;
+    return changed;
+}
+
+// One pipelined round for the root, the monitors and every dirty client, then one more per
+// level of frames to walk up and for clients the root's list brought in
+void XcbWindowSystem::Refresh() {
+    for (int round = 0; round < XCB_MAX_FRAME_DEPTH + 2 && connection_; ++round) {
+        bool root = rootDirty_;
+        bool monitors = monitorsDirty_ || root;
+        rootDirty_ = false;
+        monitorsDirty_ = false;
+
+        RootCookies rootCookies = {};
+        if (root) SendRootRequests(&rootCookies);
+#ifdef WINTILE_XCB_RANDR
+        xcb_randr_get_monitors_cookie_t monitorCookie = {};
+        if (monitors && randrEvent_) monitorCookie = xcb_randr_get_monitors(connection_, root_, 1);
+#endif
+        clientCookies_.clear();
+        walkCookies_.clear();
+        for (auto& pair : clients_) {
+            if (pair.second.dirty) {
+                SendClientRequests(pair.first, &pair.second);
+            } else if (pair.second.walk) {
+                walkCookies_.push_back({ pair.first, xcb_query_tree(connection_, pair.second.walk) });
+            }
+        }
+        if (!root && !monitors && clientCookies_.empty() && walkCookies_.empty()) break;
+
+        WatchdogCall call("xcb_refresh");
+        roundTrips_ += 1;
+        if (root) ReadRootReplies(rootCookies);
+        if (monitors) {
+            std::vector<Monitor> previous;
+            previous.swap(monitors_);
+#ifdef WINTILE_XCB_RANDR
+            if (randrEvent_) ReadMonitors(monitorCookie);
+#endif
+            if (monitors_.empty()) {
+                Monitor whole;
+                whole.id = 1;
+                whole.info.monitor = { 0, 0, rootSize_[0], rootSize_[1] };
+                monitors_.push_back(whole);
+            }
+            ApplyWorkArea();
+            if (!SameMonitors(previous)) monitorsChanged_ = true;
+        }
+        for (const ClientCookies& cookies : clientCookies_) ReadClientReplies(cookies);
+        for (const WalkCookie& walk : walkCookies_) {
+            xcb_query_tree_reply_t* tree = xcb_query_tree_reply(connection_, walk.tree, nullptr);
+            Client* client = FindClient(walk.window);
+            if (client) SetParent(walk.window, client, tree);
+            std::free(tree);
+        }
+    }
+}
+
+void XcbWindowSystem::SendRootRequests(RootCookies* cookies) {
+    cookies->wmCheck = xcb_get_property(connection_, 0, root_, atoms_[ATOM_NET_SUPPORTING_WM_CHECK], XCB_ATOM_WINDOW, 0, 1);
+    cookies->clients = xcb_get_property(connection_, 0, root_, atoms_[ATOM_NET_CLIENT_LIST_STACKING], XCB_ATOM_WINDOW, 0, 4096);
+    cookies->active = xcb_get_property(connection_, 0, root_, atoms_[ATOM_NET_ACTIVE_WINDOW], XCB_ATOM_WINDOW, 0, 1);
+    cookies->desktop = xcb_get_property(connection_, 0, root_, atoms_[ATOM_NET_CURRENT_DESKTOP], XCB_ATOM_CARDINAL, 0, 1);
+    cookies->workArea = xcb_get_property(connection_, 0, root_, atoms_[ATOM_NET_WORKAREA], XCB_ATOM_CARDINAL, 0, 4 * 64);
+    cookies->tree = xcb_query_tree(connection_, root_);
+    cookies->focus = xcb_get_input_focus(connection_);
+}
+
+void XcbWindowSystem::ReadRootReplies(const RootCookies& cookies) {
+    xcb_get_property_reply_t* wmCheck = xcb_get_property_reply(connection_, cookies.wmCheck, nullptr);
+    xcb_get_property_reply_t* clients = xcb_get_property_reply(connection_, cookies.clients, nullptr);
+    xcb_get_property_reply_t* active = xcb_get_property_reply(connection_, cookies.active, nullptr);
+    xcb_get_property_reply_t* desktop = xcb_get_property_reply(connection_, cookies.desktop, nullptr);
+    xcb_get_property_reply_t* workArea = xcb_get_property_reply(connection_, cookies.workArea, nullptr);
+    xcb_query_tree_reply_t* tree = xcb_query_tree_reply(connection_, cookies.tree, nullptr);
+    xcb_get_input_focus_reply_t* focus = xcb_get_input_focus_reply(connection_, cookies.focus, nullptr);
+
+    wmWindow_ = Value32(wmCheck, 0);
+    currentDesktop_ = Value32(desktop, 0);
+    const std::uint32_t* values;
+    int count = Values32(workArea, &values);
+    workArea_.assign(values, values + count);
+
+    // The client list, topmost first: the WM's stacking list (bottom to top), or the root's
+    // children (also bottom to top) on a bare server
+    listed_.clear();
+    if (wmWindow_) {
+        count = Values32(clients, &values);
+        for (int i = count - 1; i >= 0; --i) listed_.push_back(values[i]);
+    } else if (tree) {
+        const xcb_window_t* children = xcb_query_tree_children(tree);
+        for (int i = xcb_query_tree_children_length(tree) - 1; i >= 0; --i) {
+            if (std::find(borders_.begin(), borders_.end(), children[i]) == borders_.end()) listed_.push_back(children[i]);
+        }
+    }
+    for (xcb_window_t window : listed_) Track(window);
+    for (auto it = clients_.begin(); it != clients_.end();) {
+        if (std::find(listed_.begin(), listed_.end(), it->first) != listed_.end()) {
+            ++it;
+            continue;
+        }
+        // Withdrawn (or destroyed; its DestroyNotify reports that)
+        Note(WindowEvent::Hidden, it->first);
+        xcb_window_t window = it->first;
+        ++it;
+        Forget(window);
+    }
+    stacking_ = listed_;
+
+    xcb_window_t previous = active_;
+    if (wmWindow_) {
+        active_ = Value32(active, 0);
+    } else if (focus) {
+        auto frame = frames_.find(focus->focus);
+        active_ = clients_.count(focus->focus) ? focus->focus : frame != frames_.end() ? frame->second : 0;
+    }
+    if (active_ != previous) Note(WindowEvent::Foreground, 0);
+
+    std::free(wmCheck);
+    std::free(clients);
+    std::free(active);
+    std::free(desktop);
+    std::free(workArea);
+    std::free(tree);
+    std::free(focus);
+}
+
+#ifdef WINTILE_XCB_RANDR
+void XcbWindowSystem::ReadMonitors(xcb_randr_get_monitors_cookie_t cookie) {
+    xcb_randr_get_monitors_reply_t* reply = xcb_randr_get_monitors_reply(connection_, cookie, nullptr);
+    if (!reply) return;
+    for (xcb_randr_monitor_info_iterator_t it = xcb_randr_get_monitors_monitors_iterator(reply); it.rem;
+         xcb_randr_monitor_info_next(&it)) {
+        const xcb_randr_monitor_info_t* info = it.data;
+        Monitor monitor;
+        // The name atom stays the same while the output is connected
+        monitor.id = info->name ? info->name : monitors_.size() + 1;
+        monitor.info.monitor = { info->x, info->y, info->x + info->width, info->y + info->height };
+        if (info->primary) {
+            monitors_.insert(monitors_.begin(), monitor);
+        } else {
+            monitors_.push_back(monitor);
+        }
+    }
+    std::free(reply);
+}
+#endif
+
+// Work area of each monitor: the current desktop's _NET_WORKAREA clipped to it. EWMH has one
+// work area for the whole screen, so a panel on one monitor also trims the others' edges in line.
+void XcbWindowSystem::ApplyWorkArea() {
+    size_t base = static_cast<size_t>(currentDesktop_) * 4;
+    for (Monitor& monitor : monitors_) {
+        monitor.info.work = monitor.info.monitor;
+        if (base + 4 > workArea_.size()) continue;
+        Rect area = { static_cast<std::int32_t>(workArea_[base]), static_cast<std::int32_t>(workArea_[base + 1]),
+                      static_cast<std::int32_t>(workArea_[base] + workArea_[base + 2]),
+                      static_cast<std::int32_t>(workArea_[base + 1] + workArea_[base + 3]) };
+        Rect work = { std::max(area.left, monitor.info.monitor.left), std::max(area.top, monitor.info.monitor.top),
+                      std::min(area.right, monitor.info.monitor.right), std::min(area.bottom, monitor.info.monitor.bottom) };
+        if (!RectIsEmpty(work)) monitor.info.work = work;
+    }
+}
+
+bool XcbWindowSystem::SameMonitors(const std::vector<Monitor>& other) const {
+    if (other.size() != monitors_.size()) return false;
+    for (size_t i = 0; i < other.size(); ++i) {
+        if (other[i].id != monitors_[i].id || other[i].info.monitor != monitors_[i].info.monitor ||
+            other[i].info.work != monitors_[i].info.work) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void XcbWindowSystem::SendClientRequests(xcb_window_t window, Client* client) {
+    client->dirty = false;
+    ClientCookies cookies;
+    cookies.window = window;
+    cookies.geometry = xcb_get_geometry(connection_, window);
+    cookies.origin = xcb_translate_coordinates(connection_, window, root_, 0, 0);
+    cookies.attributes = xcb_get_window_attributes(connection_, window);
+    cookies.tree = xcb_query_tree(connection_, window);
+    struct {
+        xcb_atom_t atom;
+        xcb_atom_t type;
+        std::uint32_t length;
+    } const properties[PROPERTY_COUNT] = {
+        { XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 64 },
+        { atoms_[ATOM_NET_WM_NAME], atoms_[ATOM_UTF8_STRING], 256 },
+        { XCB_ATOM_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, 256 },
+        { atoms_[ATOM_NET_WM_PID], XCB_ATOM_CARDINAL, 1 },
+        { atoms_[ATOM_NET_WM_STATE], XCB_ATOM_ATOM, 32 },
+        { atoms_[ATOM_NET_WM_WINDOW_TYPE], XCB_ATOM_ATOM, 16 },
+        { atoms_[ATOM_NET_WM_DESKTOP], XCB_ATOM_CARDINAL, 1 },
+        { atoms_[ATOM_NET_FRAME_EXTENTS], XCB_ATOM_CARDINAL, 4 },
+        { XCB_ATOM_WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, 18 },
+    };
+    for (int i = 0; i < PROPERTY_COUNT; ++i) {
+        cookies.properties[i] =
+            xcb_get_property(connection_, 0, window, properties[i].atom, properties[i].type, 0, properties[i].length);
+    }
+    clientCookies_.push_back(cookies);
+}
+
+void XcbWindowSystem::ReadClientReplies(const ClientCookies& cookies) {
+    xcb_get_geometry_reply_t* geometry = xcb_get_geometry_reply(connection_, cookies.geometry, nullptr);
+    xcb_translate_coordinates_reply_t* origin = xcb_translate_coordinates_reply(connection_, cookies.origin, nullptr);
+    xcb_get_window_attributes_reply_t* attributes = xcb_get_window_attributes_reply(connection_, cookies.attributes, nullptr);
+    xcb_query_tree_reply_t* tree = xcb_query_tree_reply(connection_, cookies.tree, nullptr);
+    xcb_get_property_reply_t* properties[PROPERTY_COUNT];
+    for (int i = 0; i < PROPERTY_COUNT; ++i) {
+        properties[i] = xcb_get_property_reply(connection_, cookies.properties[i], nullptr);
+    }
+
+    Client* client = FindClient(cookies.window);
+    if (client && geometry && origin && attributes) {
+        client->rect = { origin->dst_x, origin->dst_y, origin->dst_x + geometry->width, origin->dst_y + geometry->height };
+        client->mapped = attributes->map_state != XCB_MAP_STATE_UNMAPPED;
+        client->overrideRedirect = attributes->override_redirect != 0;
+        client->inputOnly = attributes->_class == XCB_WINDOW_CLASS_INPUT_ONLY;
+        client->walk = 0;
+        SetParent(cookies.window, client, tree);
+
+        xcb_get_property_reply_t* name = properties[PROPERTY_CLASS];
+        const char* text = name ? static_cast<const char*>(xcb_get_property_value(name)) : nullptr;
+        int length = name ? xcb_get_property_value_length(name) : 0;
+        // "instance\0class\0": the class is the second string
+        const char* instanceEnd = text ? static_cast<const char*>(std::memchr(text, '\0', length)) : nullptr;
+        if (instanceEnd) {
+            const char* classBegin = instanceEnd + 1;
+            const char* classEnd = static_cast<const char*>(std::memchr(classBegin, '\0', text + length - classBegin));
+            DecodeLatin1(classBegin, (classEnd ? classEnd : text + length) - classBegin, &client->className);
+        } else {
+            client->className.clear();
+        }
+
+        xcb_get_property_reply_t* netName = properties[PROPERTY_NET_NAME];
+        xcb_get_property_reply_t* plainName = properties[PROPERTY_NAME];
+        if (netName && netName->format == 8 && xcb_get_property_value_length(netName) > 0) {
+            DecodeUtf8(static_cast<const char*>(xcb_get_property_value(netName)), xcb_get_property_value_length(netName), &client->title);
+        } else if (plainName && plainName->format == 8) {
+            const char* value = static_cast<const char*>(xcb_get_property_value(plainName));
+            int size = xcb_get_property_value_length(plainName);
+            if (plainName->type == atoms_[ATOM_UTF8_STRING]) {
+                DecodeUtf8(value, size, &client->title);
+            } else {
+                DecodeLatin1(value, size, &client->title);
+            }
+        } else {
+            client->title.clear();
+        }
+
+        client->pid = Value32(properties[PROPERTY_PID], 0);
+        client->desktop = Value32(properties[PROPERTY_DESKTOP], EWMH_ALL_DESKTOPS);
+
+        const std::uint32_t* values;
+        int count = Values32(properties[PROPERTY_STATE], &values);
+        bool vertical = false, horizontal = false;
+        client->hidden = client->skipTaskbar = false;
+        for (int i = 0; i < count; ++i) {
+            if (values[i] == atoms_[ATOM_NET_WM_STATE_HIDDEN]) client->hidden = true;
+            if (values[i] == atoms_[ATOM_NET_WM_STATE_MAXIMIZED_VERT]) vertical = true;
+            if (values[i] == atoms_[ATOM_NET_WM_STATE_MAXIMIZED_HORZ]) horizontal = true;
+            if (values[i] == atoms_[ATOM_NET_WM_STATE_SKIP_TASKBAR]) client->skipTaskbar = true;
+        }
+        client->maximized = vertical && horizontal;
+
+        // The first type is the preferred one; a window without one is normal
+        count = Values32(properties[PROPERTY_TYPE], &values);
+        client->normal = count == 0 || values[0] == atoms_[ATOM_NET_WM_WINDOW_TYPE_NORMAL] ||
+                         values[0] == atoms_[ATOM_NET_WM_WINDOW_TYPE_DIALOG];
+
+        count = Values32(properties[PROPERTY_EXTENTS], &values);
+        for (int i = 0; i < 4; ++i) client->extents[i] = count == 4 ? static_cast<long>(values[i]) : 0;
+
+        count = Values32(properties[PROPERTY_HINTS], &values);
+        bool hasMin = count >= 9 && (values[0] & ICCCM_SIZE_HINT_MIN);
+        bool hasMax = count >= 9 && (values[0] & ICCCM_SIZE_HINT_MAX);
+        client->minSize[0] = hasMin ? static_cast<long>(values[5]) : 0;
+        client->minSize[1] = hasMin ? static_cast<long>(values[6]) : 0;
+        client->maxSize[0] = hasMax ? static_cast<long>(values[7]) : 0;
+        client->maxSize[1] = hasMax ? static_cast<long>(values[8]) : 0;
+    } else if (client) {
+        // Gone already; its DestroyNotify is on the way
+        client->mapped = false;
+    }
+
+    std::free(geometry);
+    std::free(origin);
+    std::free(attributes);
+    std::free(tree);
+    for (int i = 0; i < PROPERTY_COUNT; ++i) std::free(properties[i]);
+}
+
+// One level of the walk up to the root's child (the frame)
+void XcbWindowSystem::SetParent(xcb_window_t window, Client* client, const xcb_query_tree_reply_t* tree) {
+    if (!tree) {
+        client->walk = 0;
+        return;
+    }
+    xcb_window_t asked = client->walk ? client->walk : window;
+    if (tree->parent == root_ || tree->parent == XCB_WINDOW_NONE) {
+        if (client->frame && client->frame != asked) frames_.erase(client->frame);
+        client->frame = asked;
+        client->walk = 0;
+        frames_[asked] = window;
+    } else {
+        client->walk = tree->parent;
+    }
+}
+
+// Process ids are not held on X, so their exits are watched through pidfds
+void XcbWindowSystem::PollProcessExits(XcbProcessExitHandler exited) {
+    if (processFds_.empty()) return;
+    pollFds_.clear();
+    pollPids_.clear();
+    for (const auto& process : processFds_) {
+        pollFds_.push_back({ process.second, POLLIN, 0 });
+        pollPids_.push_back(process.first);
+    }
+    if (poll(pollFds_.data(), pollFds_.size(), 0) <= 0) return;
+    for (size_t i = 0; i < pollFds_.size(); ++i) {
+        if (!pollFds_[i].revents) continue;
+        close(pollFds_[i].fd);
+        processFds_.erase(pollPids_[i]);
+        if (exited) exited(pollPids_[i]);
+    }
+}
+
+bool XcbWindowSystem::CursorPosition(Point* point) {
+    if (!connection_) return false;
+    WatchdogCall call("xcb_query_pointer");
+    roundTrips_ += 1;
+    xcb_query_pointer_reply_t* reply = xcb_query_pointer_reply(connection_, xcb_query_pointer(connection_, root_), nullptr);
+    if (!reply) return false;
+    *point = { reply->root_x, reply->root_y };
+    std::free(reply);
+    return true;
+}
+
+bool XcbWindowSystem::MoveCursor(const Point& point) {
+    if (!connection_) return false;
+    xcb_warp_pointer(connection_, XCB_WINDOW_NONE, root_, 0, 0, 0, 0, static_cast<std::int16_t>(point.x),
+                     static_cast<std::int16_t>(point.y));
+    xcb_flush(connection_);
+    return true;
+}
+
+// From the cached stacking order; our borders are not clients, so they are never hit
+WindowId XcbWindowSystem::WindowAt(const Point& point) {
+    for (xcb_window_t window : stacking_) {
+        const Client* client = FindClient(window);
+        if (client && client->mapped && !client->overrideRedirect && RectContains(OuterRect(*client), point)) {
+            return window;
+        }
+    }
+    return 0;
+}
+
+WindowId XcbWindowSystem::RootWindow(WindowId window) {
+    auto frame = frames_.find(static_cast<xcb_window_t>(window));
+    return frame != frames_.end() ? frame->second : window;
+}
+
+WindowId XcbWindowSystem::ForegroundWindow() {
+    return active_;
+}
+
+bool XcbWindowSystem::Activate(WindowId window) {
+    Client* client = FindClient(window);
+    if (!client) return false;
+    xcb_window_t id = static_cast<xcb_window_t>(window);
+    if (wmWindow_) {
+        std::uint32_t data[5] = { 2, XCB_CURRENT_TIME, active_, 0, 0 };  // From a pager
+        SendRootMessage(id, atoms_[ATOM_NET_ACTIVE_WINDOW], data);
+    } else {
+        // No WM to ask: raise and focus it here, and nothing reports it back
+        std::uint32_t above = XCB_STACK_MODE_ABOVE;
+        xcb_configure_window(connection_, id, XCB_CONFIG_WINDOW_STACK_MODE, &above);
+        xcb_set_input_focus(connection_, XCB_INPUT_FOCUS_POINTER_ROOT, id, XCB_CURRENT_TIME);
+        active_ = id;
+        stacking_.erase(std::remove(stacking_.begin(), stacking_.end(), id), stacking_.end());
+        stacking_.insert(stacking_.begin(), id);
+    }
+    xcb_flush(connection_);
+    return true;
+}
+
+void XcbWindowSystem::EnumerateWindows(std::vector<WindowId>* windows) {
+    for (xcb_window_t window : stacking_) {
+        const Client* client = FindClient(window);
+        if (client && !client->overrideRedirect && !client->inputOnly) windows->push_back(window);
+    }
+}
+
+bool XcbWindowSystem::IsAlive(WindowId window) {
+    return FindClient(window) != nullptr;
+}
+
+// Iconified windows count as visible, as minimized ones do on Windows
+bool XcbWindowSystem::IsVisible(WindowId window) {
+    const Client* client = FindClient(window);
+    return client && (client->mapped || client->hidden);
+}
+
+bool XcbWindowSystem::IsMinimized(WindowId window) {
+    const Client* client = FindClient(window);
+    return client && client->hidden;
+}
+
+bool XcbWindowSystem::IsMaximized(WindowId window) {
+    const Client* client = FindClient(window);
+    return client && client->maximized;
+}
+
+bool XcbWindowSystem::ClassName(WindowId window, wchar_t* buffer, int size) {
+    const Client* client = FindClient(window);
+    return client && CopyText(client->className, buffer, size);
+}
+
+bool XcbWindowSystem::WindowTitle(WindowId window, wchar_t* buffer, int size) {
+    const Client* client = FindClient(window);
+    return client && CopyText(client->title, buffer, size);
+}
+
+unsigned long XcbWindowSystem::ProcessId(WindowId window) {
+    const Client* client = FindClient(window);
+    return client ? client->pid : 0;
+}
+
+bool XcbWindowSystem::ProcessImagePath(unsigned long pid, wchar_t* buffer, int size) {
+    if (!pid) return false;
+    char link[32];
+    std::snprintf(link, sizeof(link), "/proc/%lu/exe", pid);
+    char path[4096];
+    ssize_t length = readlink(link, path, sizeof(path));
+    if (length <= 0 || length >= static_cast<ssize_t>(sizeof(path))) return false;
+#ifdef SYS_pidfd_open
+    if (!processFds_.count(pid)) {
+        int fd = static_cast<int>(syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0));
+        if (fd >= 0) processFds_[pid] = fd;
+    }
+#endif
+    std::wstring wide;
+    DecodeUtf8(path, static_cast<size_t>(length), &wide);
+    return CopyText(wide, buffer, size);
+}
+
+// Window types as Win32 styles: normal windows and dialogs have a caption, everything else
+// (docks, menus, tooltips, splashes, ...) is a popup tool window, as is anything kept off the
+// taskbar
+unsigned long XcbWindowSystem::Style(WindowId window) {
+    const Client* client = FindClient(window);
+    if (!client) return 0;
+    return client->normal ? WINDOW_STYLE_CAPTION : WINDOW_STYLE_POPUP;
+}
+
+unsigned long XcbWindowSystem::ExStyle(WindowId window) {
+    const Client* client = FindClient(window);
+    if (!client) return 0;
+    return !client->normal || client->skipTaskbar ? WINDOW_EXSTYLE_TOOLWINDOW : 0;
+}
+
+// On another desktop than the current one (and not on all of them)
+bool XcbWindowSystem::IsCloaked(WindowId window) {
+    const Client* client = FindClient(window);
+    return client && wmWindow_ && client->desktop != EWMH_ALL_DESKTOPS && client->desktop != currentDesktop_;
+}
+
+bool XcbWindowSystem::WindowRect(WindowId window, Rect* rect) {
+    const Client* client = FindClient(window);
+    if (!client) return false;
+    *rect = OuterRect(*client);
+    return true;
+}
+
+bool XcbWindowSystem::FrameRect(WindowId window, Rect* rect) {
+    return WindowRect(window, rect);
+}
+
+void XcbWindowSystem::SendRootMessage(xcb_window_t window, xcb_atom_t type, const std::uint32_t data[5]) {
+    xcb_client_message_event_t message = {};
+    message.response_type = XCB_CLIENT_MESSAGE;
+    message.format = 32;
+    message.window = window;
+    message.type = type;
+    std::memcpy(message.data.data32, data, sizeof(message.data.data32));
+    xcb_send_event(connection_, 0, root_, XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY,
+                   reinterpret_cast<const char*>(&message));
+}
+
+// Queue one placement; false if the window is neither a client nor one of our borders
+bool XcbWindowSystem::Queue(const Placement& p) {
+    xcb_window_t window = static_cast<xcb_window_t>(p.window);
+    Client* client = FindClient(p.window);
+    if (!client) {
+        if (std::find(borders_.begin(), borders_.end(), window) == borders_.end()) return false;
+        if (p.flags & PLACEMENT_HIDE) {
+            xcb_unmap_window(connection_, window);
+        } else if (p.flags & PLACEMENT_SHOW) {
+            xcb_map_window(connection_, window);
+        }
+        return true;
+    }
+
+    if (p.flags & PLACEMENT_HIDE) {
+        if (wmWindow_) {
+            std::uint32_t data[5] = { ICCCM_ICONIC_STATE, 0, 0, 0, 0 };
+            SendRootMessage(window, atoms_[ATOM_WM_CHANGE_STATE], data);
+            client->hidden = true;
+        } else {
+            xcb_unmap_window(connection_, window);
+        }
+        client->mapped = false;
+        return true;
+    }
+
+    // The frame goes to the rect; the client gets what is inside the decorations, held to its
+    // size hints. The cache takes the result now, as the tiler reads it straight back.
+    long width = RectWidth(p.rect) - client->extents[0] - client->extents[1];
+    long height = RectHeight(p.rect) - client->extents[2] - client->extents[3];
+    if (client->maxSize[0]) width = std::min(width, client->maxSize[0]);
+    if (client->maxSize[1]) height = std::min(height, client->maxSize[1]);
+    width = std::max(width, std::max(client->minSize[0], 1L));
+    height = std::max(height, std::max(client->minSize[1], 1L));
+    long x = p.rect.left + client->extents[0];
+    long y = p.rect.top + client->extents[2];
+    client->rect = { x, y, x + width, y + height };
+
+    if (wmWindow_) {
+        std::uint32_t data[5] = { XCB_GRAVITY_STATIC | EWMH_MOVERESIZE_XYWH | EWMH_SOURCE_PAGER, static_cast<std::uint32_t>(x),
+                                  static_cast<std::uint32_t>(y), static_cast<std::uint32_t>(width),
+                                  static_cast<std::uint32_t>(height) };
+        SendRootMessage(window, atoms_[ATOM_NET_MOVERESIZE_WINDOW], data);
+    } else {
+        std::uint32_t values[4] = { static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y),
+                                    static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height) };
+        xcb_configure_window(connection_, window,
+                             XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
+    }
+    if (p.flags & PLACEMENT_SHOW) {
+        xcb_map_window(connection_, window);  // Also de-iconifies (ICCCM)
+        client->mapped = true;
+        client->hidden = false;
+    }
+    return true;
+}
+
+bool XcbWindowSystem::Place(const Placement& placement) {
+    if (!connection_) return false;
+    bool queued = Queue(placement);
+    xcb_flush(connection_);
+    return queued;
+}
+
+// No replies, so the batch is one write; X has no transaction to drop. False if a window is
+// not known (the tiler then places each on its own, as after a dropped DeferWindowPos).
+bool XcbWindowSystem::PlaceBatch(const Placement* batch, size_t count) {
+    if (!connection_) return false;
+    bool queued = true;
+    for (size_t i = 0; i < count; ++i) queued = Queue(batch[i]) && queued;
+    xcb_flush(connection_);
+    return queued;
+}
+
+MonitorId XcbWindowSystem::MonitorOfWindow(WindowId window) {
+    const Client* client = FindClient(window);
+    if (!client) return monitors_.empty() ? 0 : monitors_[0].id;
+    Rect rect = OuterRect(*client);
+    MonitorId best = 0;
+    long long bestArea = 0;
+    for (const Monitor& monitor : monitors_) {
+        long long area = OverlapArea(rect, monitor.info.monitor);
+        if (area > bestArea) {
+            best = monitor.id;
+            bestArea = area;
+        }
+    }
+    return best ? best : MonitorAt({ rect.left + RectWidth(rect) / 2, rect.top + RectHeight(rect) / 2 });
+}
+
+// The monitor containing the point, or the nearest one
+MonitorId XcbWindowSystem::MonitorAt(const Point& point) {
+    MonitorId best = 0;
+    long long bestDistance = -1;
+    for (const Monitor& monitor : monitors_) {
+        const Rect& r = monitor.info.monitor;
+        long long dx = point.x < r.left ? r.left - point.x : (point.x >= r.right ? point.x - r.right + 1 : 0);
+        long long dy = point.y < r.top ? r.top - point.y : (point.y >= r.bottom ? point.y - r.bottom + 1 : 0);
+        long long distance = dx * dx + dy * dy;
+        if (bestDistance < 0 || distance < bestDistance) {
+            best = monitor.id;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+bool XcbWindowSystem::QueryMonitor(MonitorId monitor, MonitorInfo* info) {
+    for (const Monitor& m : monitors_) {
+        if (m.id == monitor) {
+            *info = m.info;
+            return true;
+        }
+    }
+    return false;
+}
+
+void XcbWindowSystem::EnumerateMonitors(std::vector<MonitorId>* monitors) {
+    for (const Monitor& monitor : monitors_) monitors->push_back(monitor.id);
+}
+
+// An override-redirect window in the border color, stacked right below the app's frame so
+// only the ring around it shows
+WindowId XcbWindowSystem::CreateBorder(WindowId app, const Rect& rect) {
+    if (!connection_) return 0;
+    const Client* client = FindClient(app);
+    xcb_window_t border = xcb_generate_id(connection_);
+    std::uint32_t values[2] = { CurrentConfig().borderColor, 1 };
+    xcb_create_window(connection_, XCB_COPY_FROM_PARENT, border, root_, static_cast<std::int16_t>(rect.left),
+                      static_cast<std::int16_t>(rect.top), static_cast<std::uint16_t>(std::max(RectWidth(rect), 1L)),
+                      static_cast<std::uint16_t>(std::max(RectHeight(rect), 1L)), 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      screen_->root_visual, XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT, values);
+    borders_.push_back(border);
+    if (client && client->frame) {
+        std::uint32_t stack[2] = { client->frame, XCB_STACK_MODE_BELOW };
+        xcb_configure_window(connection_, border, XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE, stack);
+    }
+    xcb_map_window(connection_, border);
+    xcb_flush(connection_);
+    return border;
+}
+
+void XcbWindowSystem::MoveBorder(WindowId border, WindowId app, const Rect& rect) {
+    if (!connection_) return;
+    xcb_window_t window = static_cast<xcb_window_t>(border);
+    const Client* client = FindClient(app);
+    std::uint32_t values[6] = { static_cast<std::uint32_t>(rect.left), static_cast<std::uint32_t>(rect.top),
+                                static_cast<std::uint32_t>(std::max(RectWidth(rect), 1L)),
+                                static_cast<std::uint32_t>(std::max(RectHeight(rect), 1L)),
+                                client && client->frame ? client->frame : 0, XCB_STACK_MODE_BELOW };
+    std::uint16_t mask = XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
+    if (values[4]) mask |= XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE;
+    xcb_configure_window(connection_, window, mask, values);
+
+    // The color may have changed with the config
+    std::uint32_t color = CurrentConfig().borderColor;
+    xcb_change_window_attributes(connection_, window, XCB_CW_BACK_PIXEL, &color);
+    xcb_clear_area(connection_, 0, window, 0, 0, 0, 0);
+    xcb_map_window(connection_, window);
+    xcb_flush(connection_);
+}
+
+void XcbWindowSystem::DestroyBorder(WindowId border) {
+    if (!connection_) return;
+    xcb_window_t window = static_cast<xcb_window_t>(border);
+    xcb_destroy_window(connection_, window);
+    borders_.erase(std::remove(borders_.begin(), borders_.end(), window), borders_.end());
+    xcb_flush(connection_);
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+// WindowSystem on an X server through XCB, for EWMH window managers (and bare servers such as
+// Xvfb, where it manages the root's children itself).
+//
+// The backend keeps a cache of every client window fed by events: geometry, frame extents,
+// size hints, class, title, pid, state, type and desktop, plus the stacking order, the
+// active window, the monitors (RandR) and their work areas (_NET_WORKAREA). The tiler's
+// queries are answered from it without a server round trip. Whatever events invalidated is
+// fetched again in ProcessEvents with every request pipelined, so a burst costs one round trip
+// (two when windows were reparented). Placements, activation, cursor moves and the border
+// overlay are requests without replies. A hotkey snap thus makes one round trip, the
+// QueryPointer behind CursorPosition; commands on a given window make none.
+//
+// WindowRect is the frame (client plus _NET_FRAME_EXTENTS) and FrameRect the same, as X has no
+// invisible resize borders. A placement updates the cache right away, clamped to the window's
+// WM_NORMAL_HINTS, so the tiler's read-back learns size limits without waiting for the
+// server; the ConfigureNotify that follows corrects it.
+
+#include "event_queue.h"
+#include "window_system.h"
+
+#include <xcb/xcb.h>
+#ifdef WINTILE_XCB_RANDR
+#include <xcb/randr.h>
+#endif
+
+#include <poll.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Receives what the tiler should hear about, after the cache is up to date
+typedef void (*XcbEventHandler)(WindowEvent event, WindowId window);
+
+// A process whose executable ProcessImagePath resolved has exited
+typedef void (*XcbProcessExitHandler)(unsigned long pid);
+
+enum XcbAtom {
+    ATOM_NET_SUPPORTING_WM_CHECK,
+    ATOM_NET_CLIENT_LIST_STACKING,
+    ATOM_NET_ACTIVE_WINDOW,
+    ATOM_NET_CURRENT_DESKTOP,
+    ATOM_NET_WORKAREA,
+    ATOM_NET_WM_NAME,
+    ATOM_NET_WM_PID,
+    ATOM_NET_WM_DESKTOP,
+    ATOM_NET_WM_STATE,
+    ATOM_NET_WM_STATE_HIDDEN,
+    ATOM_NET_WM_STATE_MAXIMIZED_VERT,
+    ATOM_NET_WM_STATE_MAXIMIZED_HORZ,
+    ATOM_NET_WM_STATE_SKIP_TASKBAR,
+    ATOM_NET_WM_WINDOW_TYPE,
+    ATOM_NET_WM_WINDOW_TYPE_NORMAL,
+    ATOM_NET_WM_WINDOW_TYPE_DIALOG,
+    ATOM_NET_FRAME_EXTENTS,
+    ATOM_NET_MOVERESIZE_WINDOW,
+    ATOM_WM_CHANGE_STATE,
+    ATOM_UTF8_STRING,
+    ATOM_COUNT
+};
+
+class XcbWindowSystem : public WindowSystem {
+public:
+    XcbWindowSystem() = default;
+    XcbWindowSystem(const XcbWindowSystem&) = delete;
+    XcbWindowSystem& operator=(const XcbWindowSystem&) = delete;
+    ~XcbWindowSystem() { Disconnect(); }
+
+    // Connect to `display` (null: $DISPLAY), select the events and load the cache. False if
+    // there is no server.
+    bool Connect(const char* display);
+    void Disconnect();
+    bool Connected() const { return connection_ != nullptr; }
+
+    // Readable when events are waiting; poll it, then call ProcessEvents
+    int ConnectionFd() const;
+
+    // Read every waiting event, refresh what they invalidated in one pipelined pass and report
+    // the changes; process exits go to `exited` (may be null)
+    void ProcessEvents(XcbEventHandler handler, XcbProcessExitHandler exited);
+
+    // True once after the monitors or their work areas changed (call RefreshMonitorCache)
+    bool TakeMonitorsChanged();
+
+    // A window manager answers _NET_SUPPORTING_WM_CHECK; without one, the root's mapped
+    // children are the clients and the backend moves and focuses them itself
+    bool HasWindowManager() const { return wmWindow_ != 0; }
+
+    // Server round trips so far; each is one pipelined group of requests and its replies
+    long long RoundTrips() const { return roundTrips_; }
+
+    xcb_connection_t* Connection() const { return connection_; }
+    xcb_window_t Root() const { return root_; }
+
+    bool CursorPosition(Point* point) override;
+    bool MoveCursor(const Point& point) override;
+    WindowId WindowAt(const Point& point) override;
+    WindowId RootWindow(WindowId window) override;
+    WindowId ForegroundWindow() override;
+    bool Activate(WindowId window) override;
+    void EnumerateWindows(std::vector<WindowId>* windows) override;
+    bool IsAlive(WindowId window) override;
+    bool IsVisible(WindowId window) override;
+    bool IsMinimized(WindowId window) override;
+    bool IsMaximized(WindowId window) override;
+    bool ClassName(WindowId window, wchar_t* buffer, int size) override;
+    bool WindowTitle(WindowId window, wchar_t* buffer, int size) override;
+    unsigned long ProcessId(WindowId window) override;
+    bool ProcessImagePath(unsigned long pid, wchar_t* buffer, int size) override;
+    unsigned long Style(WindowId window) override;
+    unsigned long ExStyle(WindowId window) override;
+    bool IsCloaked(WindowId window) override;
+    bool WindowRect(WindowId window, Rect* rect) override;
+    bool FrameRect(WindowId window, Rect* rect) override;
+    bool Place(const Placement& placement) override;
+    bool PlaceBatch(const Placement* batch, size_t count) override;
+    MonitorId MonitorOfWindow(WindowId window) override;
+    MonitorId MonitorAt(const Point& point) override;
+    bool QueryMonitor(MonitorId monitor, MonitorInfo* info) override;
+    void EnumerateMonitors(std::vector<MonitorId>* monitors) override;
+    WindowId CreateBorder(WindowId app, const Rect& rect) override;
+    void MoveBorder(WindowId border, WindowId app, const Rect& rect) override;
+    void DestroyBorder(WindowId border) override;
+
+private:
+    // Everything cached per client window
+    struct Client {
+        xcb_window_t frame = 0;      // Its child of the root: the WM's frame, or itself
+        Rect rect = {};              // Client area, root coordinates
+        long extents[4] = {};        // _NET_FRAME_EXTENTS: left, right, top, bottom
+        long minSize[2] = {};        // WM_NORMAL_HINTS, 0 = none
+        long maxSize[2] = {};
+        bool mapped = false;
+        bool hidden = false;         // _NET_WM_STATE_HIDDEN (iconified)
+        bool maximized = false;      // Maximized both ways
+        bool skipTaskbar = false;
+        bool normal = true;          // _NET_WM_WINDOW_TYPE is normal or dialog (or unset)
+        bool overrideRedirect = false;  // Menus and tooltips on a bare server
+        bool inputOnly = false;
+        std::uint32_t desktop = 0xFFFFFFFF;
+        unsigned long pid = 0;
+        std::wstring className;
+        std::wstring title;
+        bool dirty = true;           // Fetch again in the next refresh
+        xcb_window_t walk = 0;       // Refresh: ancestor whose parent is asked next
+    };
+
+    struct Monitor {
+        MonitorId id;
+        MonitorInfo info;
+    };
+
+    // Properties fetched per client
+    enum ClientProperty {
+        PROPERTY_CLASS,
+        PROPERTY_NET_NAME,
+        PROPERTY_NAME,
+        PROPERTY_PID,
+        PROPERTY_STATE,
+        PROPERTY_TYPE,
+        PROPERTY_DESKTOP,
+        PROPERTY_EXTENTS,
+        PROPERTY_HINTS,
+        PROPERTY_COUNT
+    };
+
+    // Requests of one client in a refresh
+    struct ClientCookies {
+        xcb_window_t window;
+        xcb_get_geometry_cookie_t geometry;
+        xcb_translate_coordinates_cookie_t origin;
+        xcb_get_window_attributes_cookie_t attributes;
+        xcb_query_tree_cookie_t tree;
+        xcb_get_property_cookie_t properties[PROPERTY_COUNT];
+    };
+
+    // Requests of the root's state in a refresh
+    struct RootCookies {
+        xcb_get_property_cookie_t wmCheck;
+        xcb_get_property_cookie_t clients;
+        xcb_get_property_cookie_t active;
+        xcb_get_property_cookie_t desktop;
+        xcb_get_property_cookie_t workArea;
+        xcb_query_tree_cookie_t tree;
+        xcb_get_input_focus_cookie_t focus;
+    };
+
+    // A frame walk step in flight
+    struct WalkCookie {
+        xcb_window_t window;
+        xcb_query_tree_cookie_t tree;
+    };
+
+    // Events seen in one ProcessEvents, reported after its refresh
+    struct PendingNote {
+        WindowEvent event;
+        xcb_window_t window;
+    };
+
+    Client* FindClient(WindowId window);
+    Rect OuterRect(const Client& client) const;
+    void Track(xcb_window_t window);
+    void Forget(xcb_window_t window);
+    void Note(WindowEvent event, xcb_window_t window);
+    void HandleEvent(const xcb_generic_event_t* event);
+
+    // Fetch the root's state, the monitors and every client that is dirty, one pipelined
+    // round trip per pass
+    void Refresh();
+    void SendRootRequests(RootCookies* cookies);
+    void ReadRootReplies(const RootCookies& cookies);
+#ifdef WINTILE_XCB_RANDR
+    void ReadMonitors(xcb_randr_get_monitors_cookie_t cookie);
+#endif
+    void ApplyWorkArea();
+    bool SameMonitors(const std::vector<Monitor>& other) const;
+    void SendClientRequests(xcb_window_t window, Client* client);
+    void ReadClientReplies(const ClientCookies& cookies);
+    void SetParent(xcb_window_t window, Client* client, const xcb_query_tree_reply_t* tree);
+
+    bool Queue(const Placement& placement);
+    void SendRootMessage(xcb_window_t window, xcb_atom_t type, const std::uint32_t data[5]);
+    void PollProcessExits(XcbProcessExitHandler exited);
+
+    xcb_connection_t* connection_ = nullptr;
+    xcb_screen_t* screen_ = nullptr;
+    xcb_window_t root_ = 0;
+    long rootSize_[2] = {};
+    xcb_atom_t atoms_[ATOM_COUNT] = {};
+    xcb_window_t wmWindow_ = 0;
+    std::uint8_t randrEvent_ = 0;  // First RandR event code, 0 without RandR 1.5
+
+    std::unordered_map<xcb_window_t, Client> clients_;
+    std::unordered_map<xcb_window_t, xcb_window_t> frames_;  // Frame to client
+    std::vector<xcb_window_t> stacking_;  // Clients, topmost first
+    std::vector<xcb_window_t> borders_;   // Our overlays; their events are ours
+    xcb_window_t active_ = 0;
+    std::uint32_t currentDesktop_ = 0;
+    std::vector<std::uint32_t> workArea_;  // _NET_WORKAREA, four values per desktop
+    std::vector<Monitor> monitors_;
+
+    bool rootDirty_ = true;
+    bool monitorsDirty_ = true;
+    bool monitorsChanged_ = false;
+    long long roundTrips_ = 0;
+
+    std::vector<PendingNote> notes_;
+
+    // Scratch of a refresh pass, kept for its capacity
+    std::vector<ClientCookies> clientCookies_;
+    std::vector<WalkCookie> walkCookies_;
+    std::vector<xcb_window_t> listed_;
+
+    // Process ids whose executable was resolved, with a pidfd to see them exit
+    std::unordered_map<unsigned long, int> processFds_;
+    std::vector<pollfd> pollFds_;
+    std::vector<unsigned long> pollPids_;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+// Fixed-capacity map from WindowId to a per-window record. Records sit in one dense array, so
+// iterating touches only live entries, and are found through an open-addressing index with
+// linear probing. All storage is part of the object: nothing allocates after construction.
+// Erase moves the last record into the freed spot, which invalidates pointers to it.
+
+#include "layout.h"
+
+#include <cstddef>
+#include <cstdint>
+
+template <typename Record, size_t Capacity>
+class WindowTable {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    WindowTable() { Clear(); }
+
+    void Clear() {
+        for (size_t i = 0; i < SLOT_COUNT; ++i) slots_[i] = 0;
+        for (size_t i = 0; i < count_; ++i) records_[i] = Record();
+        count_ = 0;
+    }
+
+    size_t Size() const { return count_; }
+    bool Full() const { return count_ == Capacity; }
+
+    // Dense access, valid for i < Size()
+    WindowId WindowAt(size_t i) const { return windows_[i]; }
+    Record& RecordAt(size_t i) { return records_[i]; }
+
+    Record* Find(WindowId window) {
+        size_t slot = FindSlot(window);
+        return slots_[slot] ? &records_[slots_[slot] - 1] : nullptr;
+    }
+
+    // The window's record, a default one if it has none yet; nullptr when the table is full
+    Record* Insert(WindowId window) {
+        size_t slot = FindSlot(window);
+        if (slots_[slot]) return &records_[slots_[slot] - 1];
+        if (count_ == Capacity) return nullptr;
+
+        windows_[count_] = window;
+        records_[count_] = Record();
+        slots_[slot] = static_cast<std::uint32_t>(++count_);
+        return &records_[count_ - 1];
+    }
+
+    bool Erase(WindowId window) {
+        size_t slot = FindSlot(window);
+        if (!slots_[slot]) return false;
+        size_t index = slots_[slot] - 1;
+
+        // Backward-shift deletion: pull later entries of the probe run into the hole so
+        // lookups never need tombstones
+        size_t hole = slot;
+        size_t next = (slot + 1) & SLOT_MASK;
+        while (slots_[next]) {
+            size_t home = Home(windows_[slots_[next] - 1]);
+            if (((next - home) & SLOT_MASK) >= ((next - hole) & SLOT_MASK)) {
+                slots_[hole] = slots_[next];
+                hole = next;
+            }
+            next = (next + 1) & SLOT_MASK;
+        }
+        slots_[hole] = 0;
+
+        // Fill the gap in the dense array with the last record
+        size_t last = count_ - 1;
+        if (index != last) {
+            slots_[FindSlot(windows_[last])] = static_cast<std::uint32_t>(index + 1);
+            windows_[index] = windows_[last];
+            records_[index] = records_[last];
+        }
+        records_[last] = Record();
+        --count_;
+        return true;
+    }
+
+private:
+    // Half-full at most, so probe runs stay short
+    static const size_t SLOT_COUNT = Capacity * 2;
+    static const size_t SLOT_MASK = SLOT_COUNT - 1;
+
+    static size_t Home(WindowId window) {
+        // Handles are small, often aligned integers; spread them with a Fibonacci hash
+        std::uint64_t hash = static_cast<std::uint64_t>(window) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(hash >> 32) & SLOT_MASK;
+    }
+
+    // Slot holding `window`, or the empty slot where it would go
+    size_t FindSlot(WindowId window) const {
+        size_t slot = Home(window);
+        while (slots_[slot] && windows_[slots_[slot] - 1] != window) {
+            slot = (slot + 1) & SLOT_MASK;
+        }
+        return slot;
+    }
+
+    WindowId windows_[Capacity] = {};
+    Record records_[Capacity];
+    std::uint32_t slots_[SLOT_COUNT];  // Dense index + 1, 0 = empty
+    size_t count_ = 0;
+};
@@ -0,0 +1,91 @@
+#include "workspace.h"
+
+#include <algorithm>
+
+static bool IsValidWorkspace(int index) {
+    return index >= 0 && index < WORKSPACE_COUNT;
+}
+
+static void RemoveMember(std::vector<WorkspaceMember>& members, WindowId window) {
+    members.erase(std::remove_if(members.begin(), members.end(),
+                                 [window](const WorkspaceMember& m) { return m.window == window; }),
+                  members.end());
+}
+
+void CaptureActiveWorkspace(MonitorWorkspaces& workspaces, const WorkspaceMember* shown, size_t count) {
+    // A window the app re-showed on its own now lives on the active workspace
+    for (int i = 0; i < WORKSPACE_COUNT; ++i) {
+        if (i == workspaces.active) continue;
+        for (size_t j = 0; j < count; ++j) {
+            RemoveMember(workspaces.members[i], shown[j].window);
+        }
+    }
+    workspaces.members[workspaces.active].assign(shown, shown + count);
+}
+
+bool BuildWorkspaceSwitch(MonitorWorkspaces& workspaces, int target, WindowId border, std::vector<Placement>* batch) {
+    if (!IsValidWorkspace(target) || target == workspaces.active) return false;
+
+    const std::vector<WorkspaceMember>& outgoing = workspaces.members[workspaces.active];
+    const std::vector<WorkspaceMember>& incoming = workspaces.members[target];
+    batch->reserve(batch->size() + outgoing.size() + incoming.size() + 1);
+
+    for (const WorkspaceMember& m : outgoing) {
+        Placement hide;
+        hide.window = m.window;
+        hide.rect = m.rect;
+        hide.flags = PLACEMENT_HIDE;
+        batch->push_back(hide);
+    }
+    if (border) {
+        Placement hide;
+        hide.window = border;
+        hide.rect = Rect();
+        hide.flags = PLACEMENT_HIDE;
+        batch->push_back(hide);
+    }
+    for (const WorkspaceMember& m : incoming) {
+        Placement show;
+        show.window = m.window;
+        show.rect = m.rect;
+        show.flags = PLACEMENT_SHOW;
+        batch->push_back(show);
+    }
+
+    workspaces.active = target;
+    return true;
+}
+
+bool MoveToWorkspace(MonitorWorkspaces& workspaces, const WorkspaceMember& member, int target, Placement* hide) {
+    if (!IsValidWorkspace(target) || target == workspaces.active) return false;
+
+    for (int i = 0; i < WORKSPACE_COUNT; ++i) {
+        RemoveMember(workspaces.members[i], member.window);
+    }
+    // Newest arrival goes on top of the target workspace
+    workspaces.members[target].insert(workspaces.members[target].begin(), member);
+
+    hide->window = member.window;
+    hide->rect = member.rect;
+    hide->flags = PLACEMENT_HIDE;
+    return true;
+}
+
+void RemoveFromWorkspaces(MonitorWorkspaces& workspaces, WindowId window) {
+    for (int i = 0; i < WORKSPACE_COUNT; ++i) {
+        RemoveMember(workspaces.members[i], window);
+    }
+}
+
+void BuildShowAllHidden(const MonitorWorkspaces& workspaces, std::vector<Placement>* batch) {
+    for (int i = 0; i < WORKSPACE_COUNT; ++i) {
+        if (i == workspaces.active) continue;
+        for (const WorkspaceMember& m : workspaces.members[i]) {
+            Placement show;
+            show.window = m.window;
+            show.rect = m.rect;
+            show.flags = PLACEMENT_SHOW;
+            batch->push_back(show);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "layout.h"
+
+#include <cstddef>
+#include <vector>
+
+// Virtual workspaces per monitor
+#define WORKSPACE_COUNT 4
+
+// A window of a workspace with the state and rect it is restored to
+struct WorkspaceMember {
+    WindowId window;
+    WindowState state;
+    Rect rect;
+};
+
+// The workspaces of one monitor. Only the active workspace's windows are shown; the members
+// of the others are hidden and restored at their saved rects when switched to.
+struct MonitorWorkspaces {
+    std::vector<WorkspaceMember> members[WORKSPACE_COUNT];
+    int active = 0;
+};
+
+// Record the windows currently shown on the monitor as the active workspace's members
+// (topmost first), dropping them from every other workspace.
+void CaptureActiveWorkspace(MonitorWorkspaces& workspaces, const WorkspaceMember* shown, size_t count);
+
+// Build the single batch that switches to `target`: hide the active members and `border`
+// (if any), show the target's members at their saved rects. Makes `target` active.
+// Returns false if `target` is already active or out of range.
+bool BuildWorkspaceSwitch(MonitorWorkspaces& workspaces, int target, WindowId border, std::vector<Placement>* batch);
+
+// Move a shown window of the active workspace to workspace `target` and fill `hide` with the
+// placement that hides it. Returns false if `target` is the active workspace or out of range.
+bool MoveToWorkspace(MonitorWorkspaces& workspaces, const WorkspaceMember& member, int target, Placement* hide);
+
+// Forget a window in every workspace (e.g. it was destroyed)
+void RemoveFromWorkspaces(MonitorWorkspaces& workspaces, WindowId window);
+
+// Append placements showing the members of every inactive workspace, e.g. before exiting
+void BuildShowAllHidden(const MonitorWorkspaces& workspaces, std::vector<Placement>* batch);